@@ -27,6 +27,8 @@ interface ArchicadMessage {
   jobId?: string;
   status?: string;
   progress?: number;
+  position?: number;
+  queueDepth?: number;
   message?: string;
   error?: string;
   plnPath?: string;
@@ -35,6 +37,22 @@ interface ArchicadMessage {
     outputPath?: string;
     fileName?: string;
   };
+  protocol?: number;
+  ready?: boolean;
+  capabilities?: string[];
+  running?: number;
+  queued?: number;
+}
+
+/**
+ * What the plugin advertised in its last hello/ready message
+ */
+export interface ArchicadWorkerState {
+  ready: boolean;
+  protocol: number;
+  capabilities: string[];
+  running: number;
+  queued: number;
 }
 
 /**
@@ -54,6 +72,8 @@ interface ArchicadCommand {
 class ArchicadPluginManager {
   private archicadSocket: WebSocket | null = null;
   private connected = false;
+  private worker: ArchicadWorkerState | null = null;
+  private readyWaiters: Array<(ready: boolean) => void> = [];
 
   /**
    * Registers an Archicad plugin WebSocket connection
@@ -61,6 +81,7 @@ class ArchicadPluginManager {
   registerArchicadConnection(socket: WebSocket): void {
     this.archicadSocket = socket;
     this.connected = true;
+    this.worker = null;
 
     console.log('✓ Archicad plugin connected');
 
@@ -105,10 +126,19 @@ class ArchicadPluginManager {
           console.log('Archicad plugin acknowledged connection');
           break;
 
+        case 'hello':
+        case 'ready':
+          this.handleWorkerHello(message);
+          break;
+
         case 'conversion_started':
           this.handleConversionStarted(message);
           break;
 
+        case 'queued':
+          this.handleConversionQueued(message);
+          break;
+
         case 'progress':
         case 'conversion_progress':
           this.handleConversionProgress(message);
@@ -148,6 +178,35 @@ class ArchicadPluginManager {
     }
   }
 
+  /**
+   * Handles the greeting sent on connect and the ready announcement
+   */
+  private handleWorkerHello(message: ArchicadMessage): void {
+    this.worker = {
+      ready: message.ready ?? message.type === 'ready',
+      protocol: message.protocol ?? 0,
+      capabilities: message.capabilities ?? [],
+      running: message.running ?? 0,
+      queued: message.queued ?? message.queueDepth ?? 0,
+    };
+
+    console.log(
+      `Archicad worker ${this.worker.ready ? 'ready' : 'starting'} (queued: ${this.worker.queued})`,
+    );
+
+    if (this.worker.ready) {
+      this.resolveReadyWaiters(true);
+    }
+  }
+
+  private resolveReadyWaiters(ready: boolean): void {
+    const waiters = this.readyWaiters;
+    this.readyWaiters = [];
+    for (const resolve of waiters) {
+      resolve(ready);
+    }
+  }
+
   /**
    * Handles conversion started notification
    */
@@ -162,6 +221,21 @@ class ArchicadPluginManager {
     );
   }
 
+  /**
+   * Handles queue acknowledgements and queue position updates
+   */
+  private handleConversionQueued(message: ArchicadMessage): void {
+    if (!message.jobId) return;
+
+    wsManager.updateProgress(
+      message.jobId,
+      0,
+      ConversionStatus.QUEUED,
+      message.message ||
+        `Waiting in Archicad queue (position ${message.position ?? '?'})`,
+    );
+  }
+
   /**
    * Handles conversion progress updates
    */
@@ -232,6 +306,8 @@ class ArchicadPluginManager {
     console.log('Archicad plugin disconnected');
     this.archicadSocket = null;
     this.connected = false;
+    this.worker = null;
+    this.resolveReadyWaiters(false);
   }
 
   /**
@@ -262,12 +338,14 @@ class ArchicadPluginManager {
     jobId: string,
     plnPath: string,
     outputPath?: string,
+    priority?: number,
   ): boolean {
     return this.sendCommand({
       command: 'start_conversion',
       jobId,
       plnPath,
       outputPath,
+      priority,
     });
   }
 
@@ -298,6 +376,44 @@ class ArchicadPluginManager {
     return this.connected;
   }
 
+  /**
+   * Checks if the connected plugin announced that it can run jobs
+   */
+  isReady(): boolean {
+    return this.connected && this.worker?.ready === true;
+  }
+
+  /**
+   * Last hello/ready state of the connected plugin, if any
+   */
+  getWorkerState(): ArchicadWorkerState | null {
+    return this.worker;
+  }
+
+  /**
+   * Resolves true once the plugin is ready, false on disconnect or timeout
+   */
+  waitUntilReady(timeoutMs = 30000): Promise<boolean> {
+    if (this.isReady()) {
+      return Promise.resolve(true);
+    }
+    if (!this.connected) {
+      return Promise.resolve(false);
+    }
+
+    return new Promise((resolve) => {
+      const timer = setTimeout(() => {
+        this.readyWaiters = this.readyWaiters.filter((w) => w !== waiter);
+        resolve(false);
+      }, timeoutMs);
+      const waiter = (ready: boolean) => {
+        clearTimeout(timer);
+        resolve(ready);
+      };
+      this.readyWaiters.push(waiter);
+    });
+  }
+
   /**
    * Maps Archicad status strings to Node.js ConversionStatus enum
    */
@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ArtifactProcessor.hpp"
+#include "FileHash.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/crc.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <cctype>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+namespace zlib = boost::beast::zlib;
+
+// Bytes read from the output file per step
+static const size_t kBlockSize = 1 << 20;
+
+// Largest entry a ZIP without ZIP64 records can describe
+static const uint64_t kMaxZipEntryBytes = 0xFFFFFFFFull;
+
+// General purpose flags: sizes follow the data (bit 3), UTF-8 name (bit 11)
+static const uint16_t kZipFlags = 0x0008 | 0x0800;
+static const uint16_t kZipVersion = 20;
+static const uint16_t kZipDeflate = 8;
+
+// Helpers to append little-endian ZIP fields
+static void Put16(std::string& out, uint16_t value)
+{
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+static void Put32(std::string& out, uint32_t value)
+{
+    Put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    Put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// Current local time in MS-DOS format, as ZIP headers store it
+static void DosDateTime(uint16_t& date, uint16_t& time)
+{
+    std::time_t seconds = std::time(nullptr);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    int year = local.tm_year + 1900 < 1980 ? 1980 : local.tm_year + 1900;
+    date = static_cast<uint16_t>(((year - 1980) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+    time = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+}
+
+// Helper to format a duration with one decimal
+static std::string FormatMilliseconds(double value)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.1f", value);
+    return text;
+}
+
+// Compress one block (or finish the stream) and append the output to the archive
+static bool Deflate(zlib::deflate_stream& stream, const char* data, size_t length, zlib::Flush flush,
+                    std::vector<char>& buffer, std::ofstream& out, uint64_t& written)
+{
+    zlib::z_params params;
+    params.next_in = data;
+    params.avail_in = length;
+
+    for (;;) {
+        params.next_out = buffer.data();
+        params.avail_out = buffer.size();
+
+        boost::system::error_code ec;
+        stream.write(params, flush, ec);
+
+        size_t produced = buffer.size() - params.avail_out;
+        out.write(buffer.data(), static_cast<std::streamsize>(produced));
+        written += produced;
+
+        if (ec == zlib::error::end_of_stream) {
+            return true;
+        }
+        if (ec && ec != zlib::error::need_buffers) {
+            return false;
+        }
+        if (flush != zlib::Flush::finish && params.avail_in == 0 && params.avail_out != 0) {
+            return true;
+        }
+    }
+}
+
+std::string ArtifactResult::ToJson() const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("size", size);
+    if (!sha256.empty()) {
+        writer.Field("sha256", sha256);
+    }
+    if (!compressedPath.empty()) {
+        writer.Field("compressedPath", compressedPath)
+              .Field("compressedSize", compressedSize);
+    }
+    writer.Key("durationMs").Raw(FormatMilliseconds(durationMs));
+    if (!error.empty()) {
+        writer.Field("error", error);
+    }
+    writer.EndObject();
+    return writer.ToString();
+}
+
+ArtifactProcessor::ArtifactProcessor()
+    : m_abort(false)
+    , m_running(false)
+    , m_busy(false)
+{
+}
+
+ArtifactProcessor::~ArtifactProcessor()
+{
+    Stop();
+}
+
+void ArtifactProcessor::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+
+    m_abort = false;
+    m_running = true;
+    m_thread = std::thread(&ArtifactProcessor::Run, this);
+}
+
+void ArtifactProcessor::Stop()
+{
+    std::deque<Task> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_abort = true;
+        dropped.swap(m_tasks);
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (Task& task : dropped) {
+        ArtifactResult result;
+        result.error = "Post-processing cancelled, the plugin is shutting down";
+        if (task.done) {
+            task.done(result);
+        }
+    }
+}
+
+bool ArtifactProcessor::Submit(const std::string& path, const ArtifactOptions& options, Callback done)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return false;
+        }
+        m_tasks.push_back(Task{ path, options, std::move(done) });
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+size_t ArtifactProcessor::GetPending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tasks.size() + (m_busy ? 1 : 0);
+}
+
+void ArtifactProcessor::Run()
+{
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_running || !m_tasks.empty(); });
+            if (!m_running) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            m_busy = true;
+        }
+
+        ArtifactResult result;
+        Process(task.path, task.options, result, &m_abort);
+        if (result.success) {
+            LOG_INFO("✓ Post-processed " << task.path << " (" << result.size << " bytes, "
+                     << result.durationMs << " ms)");
+        } else {
+            LOG_WARN("✗ Post-processing failed for " << task.path << ": " << result.error);
+        }
+
+        if (task.done) {
+            task.done(result);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = false;
+    }
+}
+
+std::string ArtifactProcessor::CompressedPathFor(const std::string& path)
+{
+    fs::path file = fs::u8path(path);
+    std::string extension = file.extension().u8string();
+    for (char& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (extension == ".ifc") {
+        file.replace_extension(".ifczip");
+        return file.u8string();
+    }
+    return path + ".ifczip";
+}
+
+void ArtifactProcessor::Process(const std::string& path, const ArtifactOptions& options,
+                                ArtifactResult& result, const std::atomic<bool>* abort)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto finish = [&result, start](bool success, const std::string& error) {
+        result.success = success;
+        result.error = error;
+        result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    fs::path input = fs::u8path(path);
+    std::error_code ec;
+    result.size = fs::file_size(input, ec);
+    std::ifstream file(input, std::ios::binary);
+    if (ec || !file) {
+        result.size = 0;
+        finish(false, "Cannot read output file " + path);
+        return;
+    }
+
+    bool compress = options.compress;
+    std::string sizeError;
+    if (compress && result.size >= kMaxZipEntryBytes) {
+        compress = false;
+        sizeError = "Output is too large for IFCZIP (4 GiB limit), left uncompressed";
+    }
+
+    std::string zipPath;
+    std::string partPath;
+    std::ofstream zip;
+    std::string entryName = input.filename().u8string();
+    uint16_t dosDate = 0;
+    uint16_t dosTime = 0;
+    if (compress) {
+        zipPath = CompressedPathFor(path);
+        partPath = zipPath + ".part";
+        zip.open(fs::u8path(partPath), std::ios::binary | std::ios::trunc);
+        if (!zip) {
+            finish(false, "Cannot create " + partPath);
+            return;
+        }
+
+        // Local file header; CRC and sizes follow in the data descriptor
+        DosDateTime(dosDate, dosTime);
+        std::string header;
+        Put32(header, 0x04034b50);
+        Put16(header, kZipVersion);
+        Put16(header, kZipFlags);
+        Put16(header, kZipDeflate);
+        Put16(header, dosTime);
+        Put16(header, dosDate);
+        Put32(header, 0);
+        Put32(header, 0);
+        Put32(header, 0);
+        Put16(header, static_cast<uint16_t>(entryName.size()));
+        Put16(header, 0);
+        header += entryName;
+        zip.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    auto discardPart = [&]() {
+        if (compress) {
+            zip.close();
+            std::error_code removeError;
+            fs::remove(fs::u8path(partPath), removeError);
+        }
+    };
+
+    // One pass over the file feeds the hash, the CRC and the compressor
+    Sha256 hash;
+    boost::crc_32_type crc;
+    zlib::deflate_stream deflater;
+    deflater.reset(6, 15, 8, zlib::Strategy::normal);
+    std::vector<char> block(kBlockSize);
+    std::vector<char> deflated(kBlockSize);
+    uint64_t compressedBytes = 0;
+
+    while (file) {
+        if (abort != nullptr && abort->load()) {
+            discardPart();
+            finish(false, "Post-processing aborted");
+            return;
+        }
+
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0) {
+            break;
+        }
+
+        if (options.checksum) {
+            hash.Update(block.data(), got);
+        }
+        if (compress) {
+            crc.process_bytes(block.data(), got);
+            if (!Deflate(deflater, block.data(), got, zlib::Flush::none, deflated, zip, compressedBytes)) {
+                discardPart();
+                finish(false, "Compression failed");
+                return;
+            }
+        }
+    }
+
+    if (file.bad()) {
+        discardPart();
+        finish(false, "Error reading output file " + path);
+        return;
+    }
+
+    if (options.checksum) {
+        result.sha256 = hash.FinalHex();
+    }
+
+    if (compress) {
+        if (!Deflate(deflater, nullptr, 0, zlib::Flush::finish, deflated, zip, compressedBytes) ||
+            compressedBytes >= kMaxZipEntryBytes) {
+            discardPart();
+            finish(false, "Compression failed");
+            return;
+        }
+
+        uint32_t crcValue = crc.checksum();
+        uint32_t localHeaderSize = static_cast<uint32_t>(30 + entryName.size());
+        uint32_t centralOffset = static_cast<uint32_t>(localHeaderSize + compressedBytes + 16);
+
+        std::string trailer;
+        Put32(trailer, 0x08074b50);                 // Data descriptor
+        Put32(trailer, crcValue);
+        Put32(trailer, static_cast<uint32_t>(compressedBytes));
+        Put32(trailer, static_cast<uint32_t>(result.size));
+
+        std::string central;
+        Put32(central, 0x02014b50);                 // Central directory header
+        Put16(central, kZipVersion);
+        Put16(central, kZipVersion);
+        Put16(central, kZipFlags);
+        Put16(central, kZipDeflate);
+        Put16(central, dosTime);
+        Put16(central, dosDate);
+        Put32(central, crcValue);
+        Put32(central, static_cast<uint32_t>(compressedBytes));
+        Put32(central, static_cast<uint32_t>(result.size));
+        Put16(central, static_cast<uint16_t>(entryName.size()));
+        Put16(central, 0);
+        Put16(central, 0);
+        Put16(central, 0);
+        Put16(central, 0);
+        Put32(central, 0);
+        Put32(central, 0);
+        central += entryName;
+
+        trailer += central;
+        Put32(trailer, 0x06054b50);                 // End of central directory
+        Put16(trailer, 0);
+        Put16(trailer, 0);
+        Put16(trailer, 1);
+        Put16(trailer, 1);
+        Put32(trailer, static_cast<uint32_t>(central.size()));
+        Put32(trailer, centralOffset);
+        Put16(trailer, 0);
+
+        zip.write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+        zip.close();
+        if (!zip) {
+            discardPart();
+            finish(false, "Cannot write " + partPath);
+            return;
+        }
+
+        fs::rename(fs::u8path(partPath), fs::u8path(zipPath), ec);
+        if (ec) {
+            discardPart();
+            finish(false, "Cannot rename " + partPath + ": " + ec.message());
+            return;
+        }
+
+        result.compressedPath = zipPath;
+        result.compressedSize = fs::file_size(fs::u8path(zipPath), ec);
+
+        if (options.removeOriginal) {
+            file.close();
+            fs::remove(input, ec);
+        }
+    }
+
+    finish(sizeError.empty(), sizeError);
+}
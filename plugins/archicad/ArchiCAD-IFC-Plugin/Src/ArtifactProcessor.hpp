@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARTIFACT_PROCESSOR_HPP
+#define ARTIFACT_PROCESSOR_HPP
+
+#include <string>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Post-processing requested for a job's output file
+ */
+struct ArtifactOptions {
+    bool checksum = false;          // SHA-256 of the written file
+    bool compress = false;          // IFCZIP next to the written file
+    bool removeOriginal = false;    // Delete the written file once the IFCZIP exists
+
+    bool Any() const { return checksum || compress; }
+};
+
+/**
+ * @brief Outcome of post-processing one output file
+ */
+struct ArtifactResult {
+    bool success = false;
+    std::string error;
+    uint64_t size = 0;              // Bytes of the written file
+    std::string sha256;             // Hex digest ("" unless requested)
+    std::string compressedPath;     // IFCZIP path ("" unless requested)
+    uint64_t compressedSize = 0;
+    double durationMs = 0.0;
+
+    /**
+     * @brief The result as a JSON object, sent as "artifact" on completion
+     *
+     * @code
+     * { "size": 52428800, "sha256": "...", "compressedPath": "C:/out/model.ifczip",
+     *   "compressedSize": 7340032, "durationMs": 812.4 }
+     * @endcode
+     */
+    std::string ToJson() const;
+};
+
+/**
+ * @brief Hashes and compresses finished output files on a worker thread
+ *
+ * Each file is read once: every block goes through SHA-256 and, when
+ * compression is requested, through CRC-32 and raw deflate into a
+ * single-entry ZIP archive (IFCZIP, the buildingSMART container for IFC).
+ * The archive is streamed (sizes in a data descriptor), written as
+ * "<name>.ifczip.part" and renamed when complete. Files of 4 GiB and more
+ * are not compressed (no ZIP64).
+ *
+ * Files are processed one at a time in submission order, so the Archicad
+ * main thread can go on with the next job while a large IFC is packed.
+ */
+class ArtifactProcessor {
+public:
+    typedef std::function<void(const ArtifactResult&)> Callback;
+
+    ArtifactProcessor();
+    ~ArtifactProcessor();
+
+    ArtifactProcessor(const ArtifactProcessor&) = delete;
+    ArtifactProcessor& operator=(const ArtifactProcessor&) = delete;
+
+    /**
+     * @brief Start the worker thread
+     */
+    void Start();
+
+    /**
+     * @brief Abort the current file and stop the worker thread
+     *
+     * Files still waiting get their callback with an error, on the calling
+     * thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Queue a file for post-processing
+     * @param path UTF-8 path of the written file
+     * @param options What to produce
+     * @param done Called on the worker thread when the file is finished
+     * @return false if the processor is not running
+     */
+    bool Submit(const std::string& path, const ArtifactOptions& options, Callback done);
+
+    /**
+     * @brief Files waiting or being processed
+     */
+    size_t GetPending() const;
+
+    /**
+     * @brief Process a file on the calling thread
+     * @param abort Checked between blocks, may be nullptr
+     */
+    static void Process(const std::string& path, const ArtifactOptions& options,
+                        ArtifactResult& result, const std::atomic<bool>* abort = nullptr);
+
+    /**
+     * @brief IFCZIP path for an output file ("model.ifc" -> "model.ifczip")
+     */
+    static std::string CompressedPathFor(const std::string& path);
+
+private:
+    struct Task {
+        std::string path;
+        ArtifactOptions options;
+        Callback done;
+    };
+
+    void Run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Task> m_tasks;
+    std::thread m_thread;
+    std::atomic<bool> m_abort;
+    bool m_running;
+    bool m_busy;
+};
+
+#endif // ARTIFACT_PROCESSOR_HPP
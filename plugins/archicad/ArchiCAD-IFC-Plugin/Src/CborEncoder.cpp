@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CborEncoder.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+// CBOR major types (RFC 8949, section 3.1)
+enum : uint8_t {
+    kMajorUnsigned = 0,
+    kMajorNegative = 1,
+    kMajorText = 3,
+    kMajorArray = 4,
+    kMajorMap = 5
+};
+
+// Major type and argument in the shortest form
+static void WriteHead(std::string& out, uint8_t major, uint64_t argument)
+{
+    uint8_t type = static_cast<uint8_t>(major << 5);
+
+    if (argument < 24) {
+        out.push_back(static_cast<char>(type | argument));
+        return;
+    }
+
+    int bytes;
+    if (argument <= 0xFF) {
+        out.push_back(static_cast<char>(type | 24));
+        bytes = 1;
+    } else if (argument <= 0xFFFF) {
+        out.push_back(static_cast<char>(type | 25));
+        bytes = 2;
+    } else if (argument <= 0xFFFFFFFFull) {
+        out.push_back(static_cast<char>(type | 26));
+        bytes = 4;
+    } else {
+        out.push_back(static_cast<char>(type | 27));
+        bytes = 8;
+    }
+
+    // Big-endian
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<char>((argument >> (i * 8)) & 0xFF));
+    }
+}
+
+static void WriteText(std::string& out, const std::string& text)
+{
+    WriteHead(out, kMajorText, text.size());
+    out.append(text);
+}
+
+static void WriteFloat(std::string& out, double number)
+{
+    float single = static_cast<float>(number);
+
+    if (static_cast<double>(single) == number || number != number) {
+        uint32_t bits;
+        std::memcpy(&bits, &single, sizeof(bits));
+        out.push_back(static_cast<char>(0xFA));
+        for (int i = 3; i >= 0; --i) {
+            out.push_back(static_cast<char>((bits >> (i * 8)) & 0xFF));
+        }
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    out.push_back(static_cast<char>(0xFB));
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<char>((bits >> (i * 8)) & 0xFF));
+    }
+}
+
+void EncodeCbor(const JsonValue& value, std::string& out)
+{
+    switch (value.GetType()) {
+        case JsonValue::Type::Null:
+            out.push_back(static_cast<char>(0xF6));
+            break;
+
+        case JsonValue::Type::Bool:
+            out.push_back(static_cast<char>(value.AsBool() ? 0xF5 : 0xF4));
+            break;
+
+        case JsonValue::Type::Number:
+            if (value.IsInteger()) {
+                int64_t integer = value.AsInt();
+                if (integer >= 0) {
+                    WriteHead(out, kMajorUnsigned, static_cast<uint64_t>(integer));
+                } else {
+                    // -1 - n, computed without overflowing INT64_MIN
+                    WriteHead(out, kMajorNegative, static_cast<uint64_t>(-(integer + 1)));
+                }
+            } else {
+                WriteFloat(out, value.AsNumber());
+            }
+            break;
+
+        case JsonValue::Type::String:
+            WriteText(out, value.AsString());
+            break;
+
+        case JsonValue::Type::Array:
+            WriteHead(out, kMajorArray, value.Size());
+            for (size_t i = 0; i < value.Size(); ++i) {
+                EncodeCbor(value.At(i), out);
+            }
+            break;
+
+        case JsonValue::Type::Object:
+            WriteHead(out, kMajorMap, value.Size());
+            for (size_t i = 0; i < value.Size(); ++i) {
+                WriteText(out, value.KeyAt(i));
+                EncodeCbor(value.At(i), out);
+            }
+            break;
+    }
+}
+
+bool JsonToCbor(const std::string& json, std::string& out, std::string& error)
+{
+    JsonValue value;
+    if (!JsonParser::Parse(json, value, error)) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(json.size());
+    EncodeCbor(value, out);
+    return true;
+}
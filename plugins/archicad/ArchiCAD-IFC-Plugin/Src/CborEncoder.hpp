@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CBOR_ENCODER_HPP
+#define CBOR_ENCODER_HPP
+
+#include "JsonParser.hpp"
+
+#include <string>
+
+/**
+ * @brief Append a value to a buffer as CBOR (RFC 8949)
+ *
+ * Integers use the shortest head; other numbers are written as single
+ * precision floats when that is exact and as doubles otherwise. Objects
+ * become maps with text keys, in document order.
+ */
+void EncodeCbor(const JsonValue& value, std::string& out);
+
+/**
+ * @brief Convert a JSON document to CBOR
+ * @param json UTF-8 JSON text
+ * @param out Receives the CBOR bytes
+ * @param error Receives the parse error on failure
+ * @return false if json is not valid JSON
+ */
+bool JsonToCbor(const std::string& json, std::string& out, std::string& error);
+
+#endif // CBOR_ENCODER_HPP
@@ -16,61 +16,650 @@
  */
 
 #include "ConversionHandler.hpp"
+#include "FileHash.hpp"
+#include "TranslatorCache.hpp"
+#include "ProcessStats.hpp"
+#include "Logger.hpp"
 #include "APIEnvir.h"
 #include "ACAPinc.h"
 #include "DGModule.hpp"
 #include "File.hpp"
 #include <ctime>
-#include <iostream>
 #include <thread>
 #include <chrono>
+#include <filesystem>
+#include <algorithm>
 
 // Static member initialization
 std::string ConversionHandler::s_currentJobId = "";
 bool ConversionHandler::s_conversionInProgress = false;
-bool ConversionHandler::s_shouldCancel = false;
 
-// Helper function to open a blank template
+std::mutex ConversionHandler::s_cancelMutex;
+std::string ConversionHandler::s_cancelJobId;
+
+JobQueue ConversionHandler::s_jobQueue;
+ConversionHandler::JobDispatcher ConversionHandler::s_dispatcher;
+ConversionHandler::JobEventCallback ConversionHandler::s_onJobEvent;
+std::thread ConversionHandler::s_schedulerThread;
+std::mutex ConversionHandler::s_schedulerMutex;
+std::condition_variable ConversionHandler::s_schedulerCv;
+bool ConversionHandler::s_schedulerStop = false;
+
+ResultCache ConversionHandler::s_resultCache;
+JobMetrics ConversionHandler::s_metrics;
+MemoryPolicy ConversionHandler::s_memoryPolicy;
+JobCostModel ConversionHandler::s_costModel;
+JobStager ConversionHandler::s_stager;
+std::map<std::string, ConversionHandler::CacheLookup> ConversionHandler::s_cacheLookups;
+std::map<std::string, ConversionHandler::CacheStore> ConversionHandler::s_cacheCandidates;
+std::set<std::string> ConversionHandler::s_cacheHits;
+std::vector<ConversionHandler::CacheStore> ConversionHandler::s_cacheStores;
+
+bool ConversionHandler::s_warmSession = true;
+bool ConversionHandler::s_sessionReusable = false;
+bool ConversionHandler::s_holdingJobModel = false;
+
+// Upper bound for waiting on Archicad to report the project as closed
+static const int kCloseWaitTimeoutMs = 5000;
+static const int kCloseWaitPollMs = 10;
+
+// Helper to describe everything besides the input file and the translator
+// that shapes a job's output; part of the result cache key. Keep in sync
+// with the export parameters used in ConvertPlnToIfc/ConvertIfcToPln.
+static void DescribeJobOutput(const ConversionJob& job, std::string& kind, std::string& options)
+{
+    if (job.type == JobType::PlnToIfc) {
+        kind = "pln-to-ifc";
+        options = job.filter.IsEmpty()
+            ? "subType=IFC;elements=entire-project;boundingBox=0"
+            : "subType=IFC;elements=filtered[" + DescribeElementFilter(job.filter) + "];boundingBox=0";
+    } else {
+        kind = "ifc-to-pln";
+        options = "useStoredLib=1";
+    }
+}
+
+// Helper to check whether Archicad has a project open
+static bool IsProjectOpen()
+{
+    API_ProjectInfo projectInfo;
+    BNZeroMemory(&projectInfo, sizeof(API_ProjectInfo));
+
+    GSErrCode err = ACAPI_ProjectOperation_Project(&projectInfo);
+
+    delete projectInfo.location;
+    delete projectInfo.location_team;
+    delete projectInfo.projectPath;
+    delete projectInfo.projectName;
+
+    return err == NoError;
+}
+
+// Helper to close the current project and wait until Archicad reports it closed
+static void CloseProjectAndWait(const char* context)
+{
+    try {
+        GSErrCode closeErr = ACAPI_ProjectOperation_Close();
+        TranslatorCache::Invalidate();
+        if (closeErr == APIERR_REFUSEDCMD) {
+            // APIERR_REFUSEDCMD means no project is open, which is OK
+            return;
+        }
+        if (closeErr != NoError) {
+            LOG_WARN("Could not close project (" << context << "). Code: " << closeErr);
+            return;
+        }
+
+        // Poll instead of sleeping a fixed time; the close is normally
+        // finished by the time the call returns
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kCloseWaitTimeoutMs);
+        while (IsProjectOpen()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                LOG_WARN("Project still open " << kCloseWaitTimeoutMs << "ms after close (" << context << ")");
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kCloseWaitPollMs));
+        }
+
+        LOG_INFO("✓ Project closed (" << context << ")");
+    } catch (...) {
+        LOG_WARN("Exception while closing project (" << context << ")");
+    }
+}
+
+// Helper to open a blank template
 static void OpenBlankTemplate()
 {
-    std::cout << "Opening blank template..." << std::endl;
+    LOG_INFO("Opening blank template...");
 
     try {
         API_NewProjectPars newProjectPars;
         BNZeroMemory(&newProjectPars, sizeof(API_NewProjectPars));
 
         GSErrCode err = ACAPI_ProjectOperation_NewProject(&newProjectPars);
+        TranslatorCache::Invalidate();
         if (err != NoError) {
-            std::cerr << "Warning: Could not open blank template. Code: " << err << std::endl;
+            LOG_WARN("Could not open blank template. Code: " << err);
         } else {
-            std::cout << "✓ Blank template opened" << std::endl;
+            LOG_INFO("✓ Blank template opened");
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception opening blank template: " << e.what());
+    } catch (...) {
+        LOG_ERROR("Unknown exception opening blank template");
+    }
+}
+
+// Helper to open a project file; exceptions are reported through exceptionMsg
+static GSErrCode TryOpenProject(API_FileOpenPars& openPars, std::string& exceptionMsg)
+{
+    try {
+        return ACAPI_ProjectOperation_Open(&openPars);
+    } catch (const std::exception& e) {
+        exceptionMsg = e.what();
+    } catch (...) {
+        exceptionMsg = "Unknown exception";
+    }
+    return APIERR_GENERAL;
+}
+
+// Helper to open a job's input file. In a warm session the file is opened
+// over the previous job's model without closing it first.
+static GSErrCode OpenJobProject(API_FileOpenPars& openPars, bool swapped, std::string& exceptionMsg)
+{
+    GSErrCode err = TryOpenProject(openPars, exceptionMsg);
+
+    // Opening over the previous job's model was refused: fall back to the
+    // cold path once
+    if (err != NoError && exceptionMsg.empty() && swapped) {
+        LOG_WARN("Could not open over the current project (code " << err << "), closing it first");
+        CloseProjectAndWait("retry open");
+        err = TryOpenProject(openPars, exceptionMsg);
+    }
+
+    return err;
+}
+
+// Helper to open a job's input file (.pln for PlnToIfc, .ifc for IfcToPln)
+static bool OpenInputFile(JobType type, const std::string& inputPath, bool swapped, std::string& errorMsg)
+{
+    bool ifc = (type == JobType::IfcToPln);
+
+    API_FileOpenPars openPars;
+    BNZeroMemory(&openPars, sizeof(API_FileOpenPars));
+    if (ifc) {
+        // Exactly like LoadIFCFile() does
+        openPars.fileTypeID = APIFType_IfcFile;
+        openPars.useStoredLib = true;  // Use stored library (like menu does)
+        openPars.libGiven = false;      // Library not explicitly given (like menu does)
+    } else {
+        openPars.fileTypeID = APIFType_PlanFile;
+    }
+    openPars.file = new IO::Location(GS::UniString(inputPath.c_str()));
+
+    std::string openException;
+    GSErrCode err = OpenJobProject(openPars, swapped, openException);
+    TranslatorCache::Invalidate();
+
+    delete openPars.file;
+
+    if (!openException.empty()) {
+        errorMsg = (ifc ? "Exception opening IFC: " : "Exception opening project: ") + openException;
+    } else if (err != NoError) {
+        errorMsg = (ifc ? "Error opening IFC file. Code: " : "Error opening .pln file. Code: ") + std::to_string(err);
+    } else {
+        return true;
+    }
+
+    LOG_ERROR(errorMsg);
+    return false;
+}
+
+// Helper to pick an IFC export translator of the open project by name; an
+// empty name selects the project's first translator
+static bool ResolveIfcTranslator(const std::string& name, API_IFCTranslatorIdentifier& translator, std::string& errorMsg)
+{
+    return TranslatorCache::Resolve(name, translator, errorMsg);
+}
+
+// Helper to map a filter type name (see ElementFilterTypeNames) to its element type
+static bool FilterTypeToElemType(const std::string& name, API_ElemTypeID& typeID)
+{
+    static const std::map<std::string, API_ElemTypeID> types = {
+        {"wall", API_WallID}, {"column", API_ColumnID}, {"beam", API_BeamID},
+        {"slab", API_SlabID}, {"roof", API_RoofID}, {"shell", API_ShellID},
+        {"mesh", API_MeshID}, {"morph", API_MorphID}, {"door", API_DoorID},
+        {"window", API_WindowID}, {"skylight", API_SkylightID}, {"opening", API_OpeningID},
+        {"object", API_ObjectID}, {"lamp", API_LampID}, {"zone", API_ZoneID},
+        {"stair", API_StairID}, {"railing", API_RailingID}, {"curtainwall", API_CurtainWallID}
+    };
+
+    auto it = types.find(name);
+    if (it == types.end()) {
+        return false;
+    }
+    typeID = it->second;
+    return true;
+}
+
+// Helper to collect the open project's elements matching a filter. Fails if
+// a layer does not exist or nothing matches, so an empty IFC is never written
+static bool CollectFilteredElements(const ElementFilter& filter, GS::Array<API_Guid>& elements, std::string& errorMsg)
+{
+    elements.Clear();
+
+    // Layer names to attribute indices
+    std::vector<API_AttributeIndex> layers;
+    for (const std::string& name : filter.layers) {
+        GS::UniString layerName(name.c_str());
+        API_Attr_Head attrHead;
+        BNZeroMemory(&attrHead, sizeof(API_Attr_Head));
+        attrHead.typeID = API_LayerID;
+        attrHead.uniStringNamePtr = &layerName;
+        if (ACAPI_Attribute_Search(&attrHead) != NoError) {
+            errorMsg = "Error: Layer '" + name + "' not found in project";
+            LOG_ERROR(errorMsg);
+            return false;
+        }
+        layers.push_back(attrHead.index);
+    }
+
+    // Candidates: the listed GUIDs, elements of the listed types, or everything
+    GS::Array<API_Guid> candidates;
+    if (!filter.guids.empty()) {
+        for (const std::string& guid : filter.guids) {
+            candidates.Push(APIGuidFromString(guid.c_str()));
+        }
+    } else if (!filter.elementTypes.empty()) {
+        for (const std::string& name : filter.elementTypes) {
+            API_ElemTypeID typeID;
+            if (!FilterTypeToElemType(name, typeID)) {
+                errorMsg = "Error: Unknown element type in filter: " + name;
+                LOG_ERROR(errorMsg);
+                return false;
+            }
+            GS::Array<API_Guid> ofType;
+            if (ACAPI_Element_GetElemList(API_ElemType(typeID), &ofType) == NoError) {
+                for (const API_Guid& guid : ofType) {
+                    candidates.Push(guid);
+                }
+            }
+        }
+    } else {
+        ACAPI_Element_GetElemList(API_ElemType(API_ZombieElemID), &candidates);
+    }
+
+    for (const API_Guid& guid : candidates) {
+        API_Elem_Head elemHead;
+        BNZeroMemory(&elemHead, sizeof(API_Elem_Head));
+        elemHead.guid = guid;
+        // Unknown (or malformed) GUIDs have no header
+        if (ACAPI_Element_GetHeader(&elemHead) != NoError) {
+            continue;
         }
+
+        if (!filter.storeys.empty() &&
+            std::find(filter.storeys.begin(), filter.storeys.end(), elemHead.floorInd) == filter.storeys.end()) {
+            continue;
+        }
+        if (!layers.empty() && std::find(layers.begin(), layers.end(), elemHead.layer) == layers.end()) {
+            continue;
+        }
+        if (!filter.guids.empty() && !filter.elementTypes.empty()) {
+            bool typeMatches = false;
+            for (const std::string& name : filter.elementTypes) {
+                API_ElemTypeID typeID;
+                if (FilterTypeToElemType(name, typeID) && elemHead.type.typeID == typeID) {
+                    typeMatches = true;
+                    break;
+                }
+            }
+            if (!typeMatches) {
+                continue;
+            }
+        }
+        if (filter.modifiedSince != 0 && elemHead.modiStamp <= filter.modifiedSince) {
+            continue;
+        }
+
+        elements.Push(guid);
+    }
+
+    if (elements.IsEmpty()) {
+        errorMsg = "Error: No elements match the export filter";
+        LOG_ERROR(errorMsg);
+        return false;
+    }
+
+    LOG_INFO("Filtered IFC export: " << elements.GetSize() << " of " << candidates.GetSize() << " elements");
+    return true;
+}
+
+// Helper to save the open project as IFC (same as ExportProjectAsIFC). With
+// a filter only the matching elements are exported
+static bool SaveProjectAsIfc(const API_IFCTranslatorIdentifier& translator, const std::string& outputPath,
+                             const ElementFilter& filter, std::string& errorMsg)
+{
+    GS::Array<API_Guid> elements;
+    if (!filter.IsEmpty() && !CollectFilteredElements(filter, elements, errorMsg)) {
+        return false;
+    }
+
+    API_SavePars_Ifc ifcPars;
+    ifcPars.subType = API_IFC;
+    ifcPars.translatorIdentifier = translator;
+    ifcPars.elementsToIfcExport = API_EntireProject;
+    // A non-null set narrows the export to those elements
+    ifcPars.elementsSet = filter.IsEmpty() ? nullptr : &elements;
+    ifcPars.includeBoundingBoxGeometry = false;
+    ifcPars.filler_1 = nullptr;
+    ifcPars.filler_2 = nullptr;
+
+    API_FileSavePars savePars;
+    BNZeroMemory(&savePars, sizeof(API_FileSavePars));
+    savePars.fileTypeID = APIFType_IfcFile;
+    savePars.file = new IO::Location(GS::UniString(outputPath.c_str()));
+
+    GSErrCode saveErr = NoError;
+    try {
+        saveErr = ACAPI_ProjectOperation_Save(&savePars, &ifcPars);
     } catch (const std::exception& e) {
-        std::cerr << "Exception opening blank template: " << e.what() << std::endl;
+        errorMsg = std::string("Exception saving IFC: ") + e.what();
     } catch (...) {
-        std::cerr << "Unknown exception opening blank template" << std::endl;
+        errorMsg = "Unknown exception saving IFC";
     }
+
+    delete savePars.file;
+
+    if (errorMsg.empty() && saveErr != NoError) {
+        errorMsg = "Error saving IFC file. Code: " + std::to_string(saveErr);
+    }
+    if (!errorMsg.empty()) {
+        LOG_ERROR(errorMsg);
+        return false;
+    }
+    return true;
+}
+
+// Helper to save the open project as .pln
+static bool SaveProjectAsPln(const std::string& outputPath, std::string& errorMsg)
+{
+    API_FileSavePars savePars;
+    BNZeroMemory(&savePars, sizeof(API_FileSavePars));
+    savePars.fileTypeID = APIFType_PlanFile;
+    savePars.file = new IO::Location(GS::UniString(outputPath.c_str()));
+
+    GSErrCode saveErr = NoError;
+    try {
+        saveErr = ACAPI_ProjectOperation_Save(&savePars);
+    } catch (const std::exception& e) {
+        errorMsg = std::string("Exception saving PLN: ") + e.what();
+    } catch (...) {
+        errorMsg = "Unknown exception saving PLN";
+    }
+
+    delete savePars.file;
+
+    if (errorMsg.empty() && saveErr != NoError) {
+        errorMsg = "Error saving PLN file. Code: " + std::to_string(saveErr);
+    }
+    if (!errorMsg.empty()) {
+        LOG_ERROR(errorMsg);
+        return false;
+    }
+    return true;
+}
+
+bool ConversionHandler::BeginJobSession()
+{
+    bool swap = s_warmSession && s_sessionReusable;
+    if (!swap) {
+        JobMetrics::Clock::time_point closeStart = JobMetrics::Clock::now();
+        CloseProjectAndWait("before job");
+        s_metrics.Record(s_currentJobId, JobStage::Close, closeStart);
+    }
+
+    // Until the job finishes cleanly the open project may be modified
+    s_sessionReusable = false;
+    s_holdingJobModel = false;
+    return swap;
+}
+
+void ConversionHandler::EndJobSession(bool success)
+{
+    bool moreJobsQueued = s_jobQueue.GetQueuedCount() > 0;
+
+    // Warm session: keep the (unmodified) model open, the next job opens its
+    // own file over it
+    if (s_warmSession && success && moreJobsQueued) {
+        s_sessionReusable = true;
+        s_holdingJobModel = true;
+        LOG_INFO("✓ Keeping session warm for next job");
+        return;
+    }
+
+    // ALWAYS close the project otherwise (success or failure)
+    // This ensures consecutive conversions can work properly
+    JobMetrics::Clock::time_point cleanupStart = JobMetrics::Clock::now();
+    CloseProjectAndWait("cleanup");
+    s_metrics.Record(s_currentJobId, JobStage::Cleanup, cleanupStart);
+    s_sessionReusable = false;
+    s_holdingJobModel = false;
+
+    // Open a blank template so WebSocket stays responsive and user doesn't
+    // see the converted project; deferred while more jobs are waiting
+    if (!moreJobsQueued) {
+        JobMetrics::Clock::time_point templateStart = JobMetrics::Clock::now();
+        OpenBlankTemplate();
+        s_metrics.Record(s_currentJobId, JobStage::BlankTemplate, templateStart);
+    }
+}
+
+void ConversionHandler::ReleaseSession()
+{
+    if (!s_holdingJobModel || s_jobQueue.HasRunningJob() || s_jobQueue.GetQueuedCount() > 0) {
+        return;
+    }
+
+    LOG_INFO("Queue drained, releasing warm session");
+    s_holdingJobModel = false;
+    s_sessionReusable = false;
+    CloseProjectAndWait("release");
+    OpenBlankTemplate();
+}
+
+void ConversionHandler::DetachSession()
+{
+    s_sessionReusable = false;
+    s_holdingJobModel = false;
+}
+
+void ConversionHandler::DeepCleanup()
+{
+    LOG_INFO("Deep cleanup: resetting the project state...");
+
+    // A model kept warm is closed as well; the next job opens its file cold
+    s_sessionReusable = false;
+    s_holdingJobModel = false;
+    CloseProjectAndWait("deep cleanup");
+
+    try {
+        API_NewProjectPars newProjectPars;
+        BNZeroMemory(&newProjectPars, sizeof(API_NewProjectPars));
+        newProjectPars.newAndReset = true;
+
+        GSErrCode err = ACAPI_ProjectOperation_NewProject(&newProjectPars);
+        TranslatorCache::Invalidate();
+        if (err != NoError) {
+            LOG_WARN("Could not open a reset project. Code: " << err);
+        }
+    } catch (...) {
+        LOG_ERROR("Exception opening a reset project");
+    }
+
+    ReleaseFreeMemory();
+}
+
+void ConversionHandler::ConfigureResultCache(const std::string& directory, uint64_t maxBytes)
+{
+    std::string cacheDir = directory;
+    if (cacheDir.empty()) {
+        std::error_code ec;
+        std::filesystem::path tempDir = std::filesystem::temp_directory_path(ec);
+        if (ec) {
+            LOG_WARN("Result cache disabled: no temp directory");
+            s_resultCache.Close();
+            return;
+        }
+        cacheDir = (tempDir / "ifc-plugin-result-cache").u8string();
+    }
+
+    if (!s_resultCache.Open(cacheDir, maxBytes)) {
+        LOG_INFO("Result cache disabled");
+    }
+}
+
+bool ConversionHandler::TryServeFromCache(const ConversionJob& job)
+{
+    // Batches are not cached as a whole; LoadIfc has no output file
+    if ((job.type != JobType::PlnToIfc && job.type != JobType::IfcToPln) || !s_resultCache.IsEnabled()) {
+        return false;
+    }
+
+    std::string inputHash;
+    if (!Sha256::HashFile(job.inputPath, inputHash)) {
+        // Let the conversion report the unreadable input
+        return false;
+    }
+
+    std::string kind, options;
+    DescribeJobOutput(job, kind, options);
+
+    // The translator a name stands for is only known once the project is
+    // open: PLN -> IFC looks the result up before the export instead
+    if (job.type == JobType::PlnToIfc) {
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        s_cacheLookups[job.jobId] = CacheLookup{ inputHash, kind, options };
+        return false;
+    }
+
+    std::string key = ResultCache::MakeKey(inputHash, kind, std::string(), options);
+
+    if (s_resultCache.Fetch(key, job.outputPath)) {
+        LOG_INFO("✓ Result cache hit for job " << job.jobId);
+        {
+            std::lock_guard<std::mutex> lock(s_schedulerMutex);
+            s_cacheHits.insert(job.jobId);
+        }
+        // The Done event reports the result like a job that ran and finishes it
+        if (s_onJobEvent) {
+            s_onJobEvent(job, JobState::Done, 0, "Served from result cache");
+        } else {
+            FinishJob(job.jobId, JobState::Done);
+        }
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(s_schedulerMutex);
+    s_cacheCandidates[job.jobId] = CacheStore{ key, job.outputPath };
+    return false;
+}
+
+bool ConversionHandler::ServeExportFromCache(const std::string& jobId, const std::string& translatorName,
+                                             const std::string& outputPath)
+{
+    CacheLookup lookup;
+    {
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        auto it = s_cacheLookups.find(jobId);
+        if (it == s_cacheLookups.end()) {
+            return false;
+        }
+        lookup = it->second;
+        s_cacheLookups.erase(it);
+    }
+
+    std::string translator = TranslatorCache::Identify(translatorName);
+    if (translator.empty()) {
+        return false;
+    }
+
+    std::string key = ResultCache::MakeKey(lookup.inputHash, lookup.kind, translator, lookup.options);
+    if (s_resultCache.Fetch(key, outputPath)) {
+        LOG_INFO("✓ Result cache hit for job " << jobId);
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        s_cacheHits.insert(jobId);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(s_schedulerMutex);
+    s_cacheCandidates[jobId] = CacheStore{ key, outputPath };
+    return false;
+}
+
+void ConversionHandler::ConfigureStaging(const StagingOptions& options)
+{
+    s_stager.Stop();
+    s_stager.Start(options);
+}
+
+void ConversionHandler::PrefetchQueued()
+{
+    size_t depth = s_stager.GetPrefetchDepth();
+    if (depth == 0) {
+        return;
+    }
+
+    // Queued jobs come back in the order the scheduler will pick them
+    std::vector<ConversionJob> queued = s_jobQueue.GetQueuedJobs();
+    for (size_t i = 0; i < queued.size() && i < depth; ++i) {
+        s_stager.Prefetch(queued[i]);
+    }
+}
+
+void ConversionHandler::SetWarmSession(bool enabled)
+{
+    s_warmSession = enabled;
+}
+
+bool ConversionHandler::IsWarmSession()
+{
+    return s_warmSession;
 }
 
 bool ConversionHandler::ConvertPlnToIfc(
     const std::string& jobId,
     const std::string& plnPath,
     const std::string& outputPath,
-    ProgressCallback onProgress
+    const std::string& translatorName,
+    const ElementFilter& filter,
+    ProgressCallback onProgress,
+    GS::ProcessControl* processControl
 )
 {
     // Check if another conversion is running
     if (s_conversionInProgress) {
-        std::cerr << "Another conversion is already in progress" << std::endl;
+        LOG_WARN("Another conversion is already in progress");
         if (onProgress) {
             onProgress(0, "Error: Another conversion is already in progress");
         }
         return false;
     }
 
-    s_conversionInProgress = true;
-    s_currentJobId = jobId;
-    s_shouldCancel = false;
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = true;
+        s_currentJobId = jobId;
+    }
+    s_metrics.JobStarted(jobId, JobType::PlnToIfc);
+
+    // Cancelled between dispatch and start: leave Archicad untouched
+    if (ShouldStop(jobId, processControl, "before start")) {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+        return false;
+    }
 
     bool success = false;
 
@@ -83,29 +672,22 @@ bool ConversionHandler::ConvertPlnToIfc(
         IO::File plnFile(plnFileLocation);
         if (plnFile.GetStatus() != NoError) {
             std::string errorMsg = "Error: Cannot access .pln file";
-            std::cerr << errorMsg << " Path: " << plnPath << std::endl;
+            LOG_ERROR(errorMsg << " Path: " << plnPath);
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
             goto error;
         }
 
-        // Progress: 20% - Closing current project if open
+        // Progress: 20% - Closing current project if open (skipped in a warm session)
         if (onProgress) {
-            onProgress(20, "Closing current project");
+            onProgress(20, s_warmSession && s_sessionReusable ? "Reusing open session" : "Closing current project");
         }
 
-        // Try to close any open project first to avoid conflicts
-        try {
-            GSErrCode closeErr = ACAPI_ProjectOperation_Close();
-            if (closeErr != NoError && closeErr != APIERR_REFUSEDCMD) {
-                // APIERR_REFUSEDCMD means no project is open, which is OK
-                std::cerr << "Warning: Could not close current project. Code: " << closeErr << std::endl;
-            }
-            // Give ArchiCAD time to fully close the project
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        } catch (...) {
-            std::cerr << "Warning: Exception while closing project" << std::endl;
+        bool swapped = BeginJobSession();
+
+        if (ShouldStop(jobId, processControl, "after close")) {
+            goto error;
         }
 
         // Progress: 30% - Opening .pln project
@@ -114,40 +696,18 @@ bool ConversionHandler::ConvertPlnToIfc(
         }
 
         // Open the .pln file - same way as LoadIFCFile() does
-        API_FileOpenPars openPars;
-        BNZeroMemory(&openPars, sizeof(API_FileOpenPars));
-        openPars.fileTypeID = APIFType_PlanFile;
-        openPars.file = new IO::Location(plnFileLocation);
-
-        GSErrCode err = NoError;
-        try {
-            err = ACAPI_ProjectOperation_Open(&openPars);
-        } catch (const std::exception& e) {
-            delete openPars.file;
-            std::string errorMsg = std::string("Exception opening project: ") + e.what();
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
-            goto error;
-        } catch (...) {
-            delete openPars.file;
-            std::string errorMsg = "Unknown exception opening project";
-            std::cerr << errorMsg << std::endl;
+        std::string errorMsg;
+        JobMetrics::Clock::time_point openStart = JobMetrics::Clock::now();
+        bool opened = OpenInputFile(JobType::PlnToIfc, plnPath, swapped, errorMsg);
+        s_metrics.Record(jobId, JobStage::Open, openStart);
+        if (!opened) {
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
             goto error;
         }
 
-        delete openPars.file;
-
-        if (err != NoError) {
-            std::string errorMsg = "Error opening .pln file. Code: " + std::to_string(err);
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
+        if (ShouldStop(jobId, processControl, "after open")) {
             goto error;
         }
 
@@ -156,72 +716,42 @@ bool ConversionHandler::ConvertPlnToIfc(
             onProgress(50, "Preparing IFC export");
         }
 
-        // Get available IFC translators
-        GS::Array<API_IFCTranslatorIdentifier> ifcTranslators;
-        GSErrCode translatorErr = ACAPI_IFC_GetIFCExportTranslatorsList(ifcTranslators);
-
-        if (translatorErr != NoError || ifcTranslators.IsEmpty()) {
-            std::string errorMsg = "Error: No IFC translators available";
+        // Pick the requested IFC translator
+        API_IFCTranslatorIdentifier translator;
+        JobMetrics::Clock::time_point lookupStart = JobMetrics::Clock::now();
+        bool resolved = ResolveIfcTranslator(translatorName, translator, errorMsg);
+        s_metrics.Record(jobId, JobStage::TranslatorLookup, lookupStart);
+        if (!resolved) {
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
             goto error;
         }
 
-        // Progress: 70% - Exporting to IFC
-        if (onProgress) {
-            onProgress(70, "Exporting to IFC");
+        if (ShouldStop(jobId, processControl, "before save")) {
+            goto error;
         }
 
-        // Setup IFC export parameters (same as ExportProjectAsIFC)
-        API_SavePars_Ifc ifcPars;
-        ifcPars.subType = API_IFC;
-        ifcPars.translatorIdentifier = ifcTranslators[0];
-        ifcPars.elementsToIfcExport = API_EntireProject;
-        ifcPars.elementsSet = nullptr;
-        ifcPars.includeBoundingBoxGeometry = false;
-        ifcPars.filler_1 = nullptr;
-        ifcPars.filler_2 = nullptr;
-
-        // Setup save parameters
-        GS::UniString outputPathUni(outputPath.c_str());
-        IO::Location outputLocation(outputPathUni);
-
-        API_FileSavePars savePars;
-        BNZeroMemory(&savePars, sizeof(API_FileSavePars));
-        savePars.fileTypeID = APIFType_IfcFile;
-        savePars.file = new IO::Location(outputLocation);
-
-        GSErrCode saveErr = NoError;
-        try {
-            saveErr = ACAPI_ProjectOperation_Save(&savePars, &ifcPars);
-        } catch (const std::exception& e) {
-            delete savePars.file;
-            std::string errorMsg = std::string("Exception saving IFC: ") + e.what();
-            std::cerr << errorMsg << std::endl;
+        // Same input, resolved translator and options as an earlier export
+        if (ServeExportFromCache(jobId, translatorName, outputPath)) {
             if (onProgress) {
-                onProgress(0, errorMsg);
+                onProgress(70, "Served from result cache");
             }
-            goto error;
-        } catch (...) {
-            delete savePars.file;
-            std::string errorMsg = "Unknown exception saving IFC";
-            std::cerr << errorMsg << std::endl;
+        } else {
+            // Progress: 70% - Exporting to IFC
             if (onProgress) {
-                onProgress(0, errorMsg);
+                onProgress(70, "Exporting to IFC");
             }
-            goto error;
-        }
 
-        delete savePars.file;
-
-        if (saveErr != NoError) {
-            std::string errorMsg = "Error saving IFC file. Code: " + std::to_string(saveErr);
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
+            JobMetrics::Clock::time_point saveStart = JobMetrics::Clock::now();
+            bool saved = SaveProjectAsIfc(translator, outputPath, filter, errorMsg);
+            s_metrics.Record(jobId, JobStage::Save, saveStart);
+            if (!saved) {
+                if (onProgress) {
+                    onProgress(0, errorMsg);
+                }
+                goto error;
             }
-            goto error;
         }
 
         // Progress: 100% - Completed
@@ -229,42 +759,31 @@ bool ConversionHandler::ConvertPlnToIfc(
             onProgress(100, "Conversion completed successfully");
         }
 
-        std::cout << "✓ Conversion completed: " << outputPath << std::endl;
+        LOG_INFO("✓ Conversion completed: " << outputPath);
         success = true;
 
     } catch (const std::exception& e) {
-        std::cerr << "✗ Conversion failed: " << e.what() << std::endl;
+        LOG_ERROR("✗ Conversion failed: " << e.what());
         if (onProgress) {
             onProgress(0, std::string("Error: ") + e.what());
         }
     } catch (...) {
-        std::cerr << "✗ Conversion failed: Unknown exception" << std::endl;
+        LOG_ERROR("✗ Conversion failed: Unknown exception");
         if (onProgress) {
             onProgress(0, "Error: Unknown exception");
         }
     }
 
 error:
-    // ALWAYS close the project after conversion (success or failure)
-    // This ensures consecutive conversions can work properly
-    try {
-        GSErrCode closeErr = ACAPI_ProjectOperation_Close();
-        if (closeErr != NoError && closeErr != APIERR_REFUSEDCMD) {
-            std::cerr << "Warning: Could not close project in cleanup. Code: " << closeErr << std::endl;
-        } else {
-            std::cout << "✓ Project closed in cleanup" << std::endl;
-        }
-    } catch (...) {
-        std::cerr << "Warning: Exception while closing project in cleanup" << std::endl;
-    }
-
-    // Open a blank template so WebSocket stays responsive
-    // and user doesn't see the converted project
-    OpenBlankTemplate();
+    // Close the project, or keep it warm when more jobs are waiting
+    EndJobSession(success);
 
     // Reset state
-    s_conversionInProgress = false;
-    s_currentJobId = "";
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+    }
 
     return success;
 }
@@ -273,21 +792,33 @@ bool ConversionHandler::ConvertIfcToPln(
     const std::string& jobId,
     const std::string& ifcPath,
     const std::string& outputPath,
-    ProgressCallback onProgress
+    ProgressCallback onProgress,
+    GS::ProcessControl* processControl
 )
 {
     // Check if another conversion is running
     if (s_conversionInProgress) {
-        std::cerr << "Another conversion is already in progress" << std::endl;
+        LOG_WARN("Another conversion is already in progress");
         if (onProgress) {
             onProgress(0, "Error: Another conversion is already in progress");
         }
         return false;
     }
 
-    s_conversionInProgress = true;
-    s_currentJobId = jobId;
-    s_shouldCancel = false;
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = true;
+        s_currentJobId = jobId;
+    }
+    s_metrics.JobStarted(jobId, JobType::IfcToPln);
+
+    // Cancelled between dispatch and start: leave Archicad untouched
+    if (ShouldStop(jobId, processControl, "before start")) {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+        return false;
+    }
 
     bool success = false;
 
@@ -300,27 +831,22 @@ bool ConversionHandler::ConvertIfcToPln(
         IO::File ifcFile(ifcFileLocation);
         if (ifcFile.GetStatus() != NoError) {
             std::string errorMsg = "Error: Cannot access IFC file";
-            std::cerr << errorMsg << " Path: " << ifcPath << std::endl;
+            LOG_ERROR(errorMsg << " Path: " << ifcPath);
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
             goto ifc_error;
         }
 
-        // Progress: 20% - Closing current project
+        // Progress: 20% - Closing current project (skipped in a warm session)
         if (onProgress) {
-            onProgress(20, "Closing current project");
+            onProgress(20, s_warmSession && s_sessionReusable ? "Reusing open session" : "Closing current project");
         }
 
-        // Close any open project first
-        try {
-            GSErrCode closeErr = ACAPI_ProjectOperation_Close();
-            if (closeErr != NoError && closeErr != APIERR_REFUSEDCMD) {
-                std::cerr << "Warning: Could not close current project. Code: " << closeErr << std::endl;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        } catch (...) {
-            std::cerr << "Warning: Exception while closing project" << std::endl;
+        bool swapped = BeginJobSession();
+
+        if (ShouldStop(jobId, processControl, "after close")) {
+            goto ifc_error;
         }
 
         // Progress: 40% - Loading IFC file
@@ -329,42 +855,18 @@ bool ConversionHandler::ConvertIfcToPln(
         }
 
         // Open IFC file - exactly like LoadIFCFile() does
-        API_FileOpenPars openPars;
-        BNZeroMemory(&openPars, sizeof(API_FileOpenPars));
-        openPars.fileTypeID = APIFType_IfcFile;
-        openPars.useStoredLib = true;  // Use stored library (like menu does)
-        openPars.libGiven = false;      // Library not explicitly given (like menu does)
-        openPars.file = new IO::Location(ifcFileLocation);
-
-        GSErrCode err = NoError;
-        try {
-            err = ACAPI_ProjectOperation_Open(&openPars);
-        } catch (const std::exception& e) {
-            delete openPars.file;
-            std::string errorMsg = std::string("Exception opening IFC: ") + e.what();
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
-            goto ifc_error;
-        } catch (...) {
-            delete openPars.file;
-            std::string errorMsg = "Unknown exception opening IFC";
-            std::cerr << errorMsg << std::endl;
+        std::string errorMsg;
+        JobMetrics::Clock::time_point openStart = JobMetrics::Clock::now();
+        bool opened = OpenInputFile(JobType::IfcToPln, ifcPath, swapped, errorMsg);
+        s_metrics.Record(jobId, JobStage::Open, openStart);
+        if (!opened) {
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
             goto ifc_error;
         }
 
-        delete openPars.file;
-
-        if (err != NoError) {
-            std::string errorMsg = "Error opening IFC file. Code: " + std::to_string(err);
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
+        if (ShouldStop(jobId, processControl, "after open")) {
             goto ifc_error;
         }
 
@@ -374,40 +876,10 @@ bool ConversionHandler::ConvertIfcToPln(
         }
 
         // Save as PLN
-        GS::UniString outputPathUni(outputPath.c_str());
-        IO::Location outputLocation(outputPathUni);
-
-        API_FileSavePars savePars;
-        BNZeroMemory(&savePars, sizeof(API_FileSavePars));
-        savePars.fileTypeID = APIFType_PlanFile;
-        savePars.file = new IO::Location(outputLocation);
-
-        GSErrCode saveErr = NoError;
-        try {
-            saveErr = ACAPI_ProjectOperation_Save(&savePars);
-        } catch (const std::exception& e) {
-            delete savePars.file;
-            std::string errorMsg = std::string("Exception saving PLN: ") + e.what();
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
-            goto ifc_error;
-        } catch (...) {
-            delete savePars.file;
-            std::string errorMsg = "Unknown exception saving PLN";
-            std::cerr << errorMsg << std::endl;
-            if (onProgress) {
-                onProgress(0, errorMsg);
-            }
-            goto ifc_error;
-        }
-
-        delete savePars.file;
-
-        if (saveErr != NoError) {
-            std::string errorMsg = "Error saving PLN file. Code: " + std::to_string(saveErr);
-            std::cerr << errorMsg << std::endl;
+        JobMetrics::Clock::time_point saveStart = JobMetrics::Clock::now();
+        bool saved = SaveProjectAsPln(outputPath, errorMsg);
+        s_metrics.Record(jobId, JobStage::Save, saveStart);
+        if (!saved) {
             if (onProgress) {
                 onProgress(0, errorMsg);
             }
@@ -419,86 +891,566 @@ bool ConversionHandler::ConvertIfcToPln(
             onProgress(100, "Conversion completed successfully");
         }
 
-        std::cout << "✓ IFC to PLN conversion completed: " << outputPath << std::endl;
+        LOG_INFO("✓ IFC to PLN conversion completed: " << outputPath);
         success = true;
 
     } catch (const std::exception& e) {
-        std::cerr << "✗ IFC to PLN conversion failed: " << e.what() << std::endl;
+        LOG_ERROR("✗ IFC to PLN conversion failed: " << e.what());
         if (onProgress) {
             onProgress(0, std::string("Error: ") + e.what());
         }
     } catch (...) {
-        std::cerr << "✗ IFC to PLN conversion failed: Unknown exception" << std::endl;
+        LOG_ERROR("✗ IFC to PLN conversion failed: Unknown exception");
         if (onProgress) {
             onProgress(0, "Error: Unknown exception");
         }
     }
 
 ifc_error:
-    // ALWAYS close the project after conversion (success or failure)
-    // This ensures consecutive conversions can work properly
-    try {
-        GSErrCode closeErr = ACAPI_ProjectOperation_Close();
-        if (closeErr != NoError && closeErr != APIERR_REFUSEDCMD) {
-            std::cerr << "Warning: Could not close project in cleanup. Code: " << closeErr << std::endl;
-        } else {
-            std::cout << "✓ Project closed in cleanup" << std::endl;
+    // Close the project, or keep it warm when more jobs are waiting
+    EndJobSession(success);
+
+    // Reset state
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+    }
+
+    return success;
+}
+
+bool ConversionHandler::ConvertBatch(
+    const std::string& jobId,
+    const std::vector<BatchItem>& items,
+    BatchItemCallback onItem,
+    ProgressCallback onProgress,
+    GS::ProcessControl* processControl
+)
+{
+    // Check if another conversion is running
+    if (s_conversionInProgress) {
+        LOG_WARN("Another conversion is already in progress");
+        if (onProgress) {
+            onProgress(0, "Error: Another conversion is already in progress");
         }
-    } catch (...) {
-        std::cerr << "Warning: Exception while closing project in cleanup" << std::endl;
+        return false;
     }
 
-    // Open a blank template so WebSocket stays responsive
-    // and user doesn't see the converted project
-    OpenBlankTemplate();
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = true;
+        s_currentJobId = jobId;
+    }
+    s_metrics.JobStarted(jobId, JobType::Batch);
+
+    const size_t total = items.size();
+    bool allSucceeded = true;
+    bool stopped = false;
+    bool sessionStarted = false;
+    bool modelReusable = false;     // Open model is unmodified and can be opened over
+    std::string openInput;          // PLN currently open, for repeated exports
+
+    for (size_t i = 0; i < total; ++i) {
+        const BatchItem& item = items[i];
+        std::string errorMsg;
+        bool itemDone = false;
+
+        // Cancelled before the first item leaves Archicad untouched
+        if (!stopped && ShouldStop(jobId, processControl, i == 0 ? "before start" : "between items")) {
+            stopped = true;
+        }
+        if (stopped) {
+            allSucceeded = false;
+            if (onItem) {
+                onItem(i, item, JobState::Cancelled, "Cancelled");
+            }
+            continue;
+        }
+
+        const int itemStart = static_cast<int>(i * 100 / total);
+        const std::string counter = "[" + std::to_string(i + 1) + "/" + std::to_string(total) + "] ";
+
+        try {
+            // Another export of the PLN that is already open needs no reopen
+            bool reuseOpen = item.type == JobType::PlnToIfc && modelReusable && item.inputPath == openInput;
+
+            if (!reuseOpen) {
+                bool swapped;
+                if (!sessionStarted) {
+                    swapped = BeginJobSession();
+                    sessionStarted = true;
+                } else {
+                    // Inside a batch the model is always opened over, unless
+                    // the previous item left it in an unknown state
+                    swapped = modelReusable;
+                    if (!swapped) {
+                        JobMetrics::Clock::time_point closeStart = JobMetrics::Clock::now();
+                        CloseProjectAndWait("batch item");
+                        s_metrics.Record(jobId, JobStage::Close, closeStart);
+                    }
+                }
+                modelReusable = false;
+                openInput.clear();
+
+                if (onProgress) {
+                    onProgress(itemStart, counter + "Opening " + (item.sourcePath.empty() ? item.inputPath : item.sourcePath));
+                }
+
+                JobMetrics::Clock::time_point openStart = JobMetrics::Clock::now();
+                bool opened = OpenInputFile(item.type, item.inputPath, swapped, errorMsg);
+                s_metrics.Record(jobId, JobStage::Open, openStart);
+                if (!opened) {
+                    goto item_done;
+                }
+                if (item.type == JobType::PlnToIfc) {
+                    openInput = item.inputPath;
+                }
+
+                if (ShouldStop(jobId, processControl, "after open")) {
+                    stopped = true;
+                    goto item_done;
+                }
+            }
+
+            if (onProgress) {
+                std::string via = item.translator.empty() ? std::string() : " (" + item.translator + ")";
+                onProgress(itemStart, counter + "Saving " + item.outputPath + via);
+            }
+
+            if (item.type == JobType::PlnToIfc) {
+                API_IFCTranslatorIdentifier translator;
+                JobMetrics::Clock::time_point lookupStart = JobMetrics::Clock::now();
+                bool resolved = ResolveIfcTranslator(item.translator, translator, errorMsg);
+                s_metrics.Record(jobId, JobStage::TranslatorLookup, lookupStart);
+                if (resolved) {
+                    JobMetrics::Clock::time_point saveStart = JobMetrics::Clock::now();
+                    itemDone = SaveProjectAsIfc(translator, item.outputPath, item.filter, errorMsg);
+                    s_metrics.Record(jobId, JobStage::Save, saveStart);
+                }
+            } else {
+                JobMetrics::Clock::time_point saveStart = JobMetrics::Clock::now();
+                itemDone = SaveProjectAsPln(item.outputPath, errorMsg);
+                s_metrics.Record(jobId, JobStage::Save, saveStart);
+                // The open project is now the saved .pln
+                openInput.clear();
+            }
+
+        } catch (const std::exception& e) {
+            errorMsg = std::string("Error: ") + e.what();
+            LOG_ERROR("✗ Batch item failed: " << e.what());
+        } catch (...) {
+            errorMsg = "Error: Unknown exception";
+            LOG_ERROR("✗ Batch item failed: Unknown exception");
+        }
+
+    item_done:
+        // Opened but not saved (error, or cancelled after open): the model
+        // may be half-loaded, close it before the next item
+        modelReusable = itemDone;
+        if (!itemDone) {
+            allSucceeded = false;
+            openInput.clear();
+        }
+
+        if (onItem) {
+            if (itemDone) {
+                onItem(i, item, JobState::Done, std::string());
+            } else if (stopped) {
+                onItem(i, item, JobState::Cancelled, "Cancelled");
+            } else {
+                onItem(i, item, JobState::Failed, errorMsg);
+            }
+        }
+
+        if (itemDone) {
+            LOG_INFO("✓ Batch item " << (i + 1) << "/" << total << " completed: " << item.outputPath);
+        }
+    }
+
+    // Close the project, or keep it warm when more jobs are waiting
+    if (sessionStarted) {
+        EndJobSession(modelReusable);
+    }
+
+    if (onProgress) {
+        onProgress(100, allSucceeded ? "Batch completed successfully" :
+                        stopped ? "Batch cancelled" : "Batch finished with errors");
+    }
 
     // Reset state
-    s_conversionInProgress = false;
-    s_currentJobId = "";
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+    }
 
-    return success;
+    return allSucceeded;
+}
+
+JobQueue::EnqueueResult ConversionHandler::SubmitJob(const ConversionJob& job, size_t& position)
+{
+    // The scheduler orders jobs by their predicted cost
+    ConversionJob costed = job;
+    if (costed.type != JobType::Batch && costed.inputBytes == 0) {
+        costed.inputBytes = JobCostModel::FileBytes(costed.inputPath);
+    }
+    costed.predictedMs = s_costModel.Predict(costed);
+
+    JobQueue::EnqueueResult result = s_jobQueue.Enqueue(costed, position);
+
+    if (result == JobQueue::EnqueueResult::Accepted) {
+        LOG_INFO("Job queued: " << job.jobId << " (position " << position << ", predicted "
+                 << static_cast<int64_t>(costed.predictedMs) << " ms)");
+        {
+            // Take the scheduler lock so the wake-up cannot be lost
+            std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        }
+        s_schedulerCv.notify_one();
+        PrefetchQueued();
+    }
+
+    return result;
+}
+
+void ConversionHandler::StartScheduler(JobDispatcher dispatcher, JobEventCallback onJobEvent)
+{
+    if (s_schedulerThread.joinable()) {
+        return;
+    }
+
+    s_dispatcher = dispatcher;
+    s_onJobEvent = onJobEvent;
+    s_schedulerStop = false;
+    s_schedulerThread = std::thread(&ConversionHandler::SchedulerLoop);
+
+    LOG_INFO("✓ Conversion scheduler started");
+}
+
+void ConversionHandler::StopScheduler()
+{
+    if (!s_schedulerThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        s_schedulerStop = true;
+    }
+    s_schedulerCv.notify_all();
+
+    s_schedulerThread.join();
+
+    // Queued jobs, and one handed to the main thread that has not started,
+    // will not run: their submitters (and the job registry) are told so
+    std::vector<ConversionJob> dropped = s_jobQueue.GetQueuedJobs();
+    ConversionJob running;
+    if (s_jobQueue.GetRunningJob(running)) {
+        dropped.insert(dropped.begin(), running);
+    }
+
+    s_stager.Stop();
+    s_jobQueue.Clear();
+    s_cacheLookups.clear();
+    s_cacheCandidates.clear();
+    s_cacheHits.clear();
+    s_cacheStores.clear();
+
+    if (s_onJobEvent) {
+        for (const ConversionJob& job : dropped) {
+            s_metrics.JobFinished(job.jobId);
+            s_onJobEvent(job, JobState::Cancelled, 0, "Conversion scheduler stopped");
+        }
+    }
+    LOG_INFO("✓ Conversion scheduler stopped" << (dropped.empty() ? "" : " (" + std::to_string(dropped.size()) + " jobs dropped)"));
+}
+
+void ConversionHandler::FinishJob(const std::string& jobId, JobState finalState)
+{
+    bool success = (finalState == JobState::Done);
+
+    bool servedFromCache = false;
+    {
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        servedFromCache = s_cacheHits.erase(jobId) > 0;
+        s_cacheLookups.erase(jobId);
+    }
+
+    // Teach the cost model with jobs that really ran (not cache hits or
+    // jobs cancelled on the way); batches mix types and are left out
+    ConversionJob finished;
+    double runMs = 0.0;
+    if (s_jobQueue.Finish(jobId, finalState, &finished) && success && !servedFromCache &&
+        finished.type != JobType::Batch && s_metrics.GetRunTime(jobId, runMs)) {
+        s_costModel.Observe(finished.type, finished.inputBytes, finished.entityCount, runMs);
+    }
+    s_metrics.JobFinished(jobId);
+    s_stager.Release(jobId);
+
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        if (s_cancelJobId == jobId) {
+            s_cancelJobId = "";
+        }
+    }
+
+    {
+        // Successful results are copied into the cache by the scheduler
+        // thread, off the main thread
+        std::lock_guard<std::mutex> lock(s_schedulerMutex);
+        auto candidate = s_cacheCandidates.find(jobId);
+        if (candidate != s_cacheCandidates.end()) {
+            if (success) {
+                s_cacheStores.push_back(candidate->second);
+            }
+            s_cacheCandidates.erase(candidate);
+        }
+    }
+    s_schedulerCv.notify_one();
+}
+
+JobMetrics& ConversionHandler::GetMetrics()
+{
+    return s_metrics;
+}
+
+MemoryPolicy& ConversionHandler::GetMemoryPolicy()
+{
+    return s_memoryPolicy;
+}
+
+void ConversionHandler::ConfigureScheduling(SchedulingPolicy policy, double aging,
+                                            const std::map<std::string, double>& tenantWeights)
+{
+    s_jobQueue.SetPolicy(policy, aging);
+    for (const auto& weight : tenantWeights) {
+        s_jobQueue.SetTenantWeight(weight.first, weight.second);
+    }
+    LOG_INFO("Scheduling policy: " << SchedulingPolicyToString(policy));
+}
+
+bool ConversionHandler::GetJobEta(const std::string& jobId, double& etaMs)
+{
+    return s_jobQueue.GetEta(jobId, etaMs);
+}
+
+bool ConversionHandler::GetJobState(const std::string& jobId, JobState& state, size_t& position)
+{
+    return s_jobQueue.GetState(jobId, state, position);
+}
+
+size_t ConversionHandler::GetQueueDepth()
+{
+    return s_jobQueue.GetQueuedCount();
+}
+
+bool ConversionHandler::HasRunningJob()
+{
+    return s_jobQueue.HasRunningJob();
+}
+
+void ConversionHandler::SchedulerLoop()
+{
+    while (true) {
+        ConversionJob job;
+        bool haveJob = false;
+        std::vector<CacheStore> stores;
+
+        {
+            std::unique_lock<std::mutex> lock(s_schedulerMutex);
+            s_schedulerCv.wait(lock, [] {
+                return s_schedulerStop || !s_cacheStores.empty() ||
+                       (!s_jobQueue.HasRunningJob() && s_jobQueue.GetQueuedCount() > 0);
+            });
+
+            if (s_schedulerStop) {
+                return;
+            }
+
+            stores.swap(s_cacheStores);
+            haveJob = s_jobQueue.PopNext(job);
+        }
+
+        // Dispatch first, then fill the cache while Archicad works
+        if (haveJob) {
+            DispatchNext(job);
+        }
+
+        for (const CacheStore& store : stores) {
+            if (s_resultCache.Store(store.key, store.resultPath)) {
+                LOG_INFO("✓ Cached result " << store.resultPath);
+            }
+        }
+    }
+}
+
+void ConversionHandler::DispatchNext(const ConversionJob& queuedJob)
+{
+    s_metrics.JobDispatched(queuedJob);
+    NotifyQueuePositions();
+    PrefetchQueued();
+
+    // Usually staged while the previous job ran; a missing input or an
+    // output directory that cannot be created fails here, off the main thread
+    ConversionJob job = queuedJob;
+    std::string stageError;
+    JobMetrics::Clock::time_point stageStart = JobMetrics::Clock::now();
+    if (!IsCancelRequested(job.jobId) && !s_stager.Acquire(queuedJob, job, stageError)) {
+        s_jobQueue.Finish(job.jobId, JobState::Failed);
+        s_metrics.JobFinished(job.jobId);
+        s_stager.Release(job.jobId);
+        LOG_ERROR("Scheduler: job " << job.jobId << " failed: " << stageError);
+        if (s_onJobEvent) {
+            s_onJobEvent(job, JobState::Failed, 0, stageError);
+        }
+        return;
+    }
+    s_metrics.Record(job.jobId, JobStage::Staging, stageStart);
+
+    // A cache hit finishes the job here; the scheduler loop then moves on
+    // to the next one without waiting
+    if (!IsCancelRequested(job.jobId) && TryServeFromCache(job)) {
+        return;
+    }
+
+    // Cancelled right after it left the queue (or while its input was
+    // being hashed): finish it without involving Archicad
+    if (IsCancelRequested(job.jobId)) {
+        FinishJob(job.jobId, JobState::Cancelled);
+        if (s_onJobEvent) {
+            s_onJobEvent(job, JobState::Cancelled, 0, "Conversion cancelled");
+        }
+        return;
+    }
+
+    LOG_INFO("Scheduler: dispatching job " << job.jobId);
+
+    std::string error;
+    bool dispatched = false;
+    try {
+        dispatched = s_dispatcher ? s_dispatcher(job, error) : false;
+    } catch (const std::exception& e) {
+        error = std::string("Dispatch exception: ") + e.what();
+    } catch (...) {
+        error = "Unknown dispatch exception";
+    }
+
+    // On success the job finishes itself on the main thread (FinishJob),
+    // which wakes us up for the next one.
+    if (!dispatched && s_jobQueue.Finish(job.jobId, JobState::Failed)) {
+        s_metrics.JobFinished(job.jobId);
+        s_stager.Release(job.jobId);
+        {
+            std::lock_guard<std::mutex> lock(s_schedulerMutex);
+            s_cacheLookups.erase(job.jobId);
+            s_cacheCandidates.erase(job.jobId);
+        }
+
+        if (error.empty()) {
+            error = "Failed to dispatch job";
+        }
+        LOG_ERROR("Scheduler: job " << job.jobId << " failed: " << error);
+        if (s_onJobEvent) {
+            s_onJobEvent(job, JobState::Failed, 0, error);
+        }
+    }
+}
+
+void ConversionHandler::NotifyQueuePositions()
+{
+    if (!s_onJobEvent) {
+        return;
+    }
+
+    std::vector<ConversionJob> queued = s_jobQueue.GetQueuedJobs();
+    for (size_t i = 0; i < queued.size(); ++i) {
+        s_onJobEvent(queued[i], JobState::Queued, i + 1,
+                     "Waiting in queue (position " + std::to_string(i + 1) + ")");
+    }
 }
 
 bool ConversionHandler::CancelConversion(const std::string& jobId)
 {
-    if (!s_conversionInProgress || s_currentJobId != jobId) {
+    if (s_jobQueue.CancelQueued(jobId)) {
+        LOG_INFO("Queued job cancelled: " << jobId);
+        s_stager.Release(jobId);
+        NotifyQueuePositions();
+        return true;
+    }
+
+    // A dispatched job may not have reached the main thread yet, so look at
+    // the queue's running job as well as the conversion in progress
+    JobState state;
+    size_t position = 0;
+    bool running = s_jobQueue.GetState(jobId, state, position) && state == JobState::Running;
+
+    std::lock_guard<std::mutex> lock(s_cancelMutex);
+    if (!running && (!s_conversionInProgress || s_currentJobId != jobId)) {
+        return false;
+    }
+
+    s_cancelJobId = jobId;
+    LOG_INFO("Cancellation requested for job: " << jobId);
+    return true;
+}
+
+bool ConversionHandler::IsCancelRequested(const std::string& jobId)
+{
+    std::lock_guard<std::mutex> lock(s_cancelMutex);
+    return !jobId.empty() && s_cancelJobId == jobId;
+}
+
+bool ConversionHandler::ShouldStop(const std::string& jobId, GS::ProcessControl* processControl, const char* stage)
+{
+    // The Add-On command's process control covers callers of the HTTP JSON API
+    if (processControl != nullptr && processControl->IsCanceled()) {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_cancelJobId = jobId;
+    }
+
+    if (!IsCancelRequested(jobId)) {
         return false;
     }
 
-    s_shouldCancel = true;
-    std::cout << "Cancellation requested for job: " << jobId << std::endl;
+    LOG_INFO("Job " << jobId << " cancelled (" << stage << ")");
     return true;
 }
 
 bool ConversionHandler::IsConversionInProgress(const std::string& jobId)
 {
+    std::lock_guard<std::mutex> lock(s_cancelMutex);
     return s_conversionInProgress && (s_currentJobId == jobId);
 }
 
 void ConversionHandler::Cleanup()
 {
-    std::cout << "ConversionHandler::Cleanup() - Starting cleanup..." << std::endl;
+    LOG_INFO("ConversionHandler::Cleanup() - Starting cleanup...");
 
     // Try to close any open project
     try {
         GSErrCode closeErr = ACAPI_ProjectOperation_Close();
         if (closeErr != NoError && closeErr != APIERR_REFUSEDCMD) {
-            std::cerr << "Warning: Could not close project during cleanup. Code: " << closeErr << std::endl;
+            LOG_WARN("Could not close project during cleanup. Code: " << closeErr);
         } else if (closeErr == NoError) {
-            std::cout << "✓ Project closed during cleanup" << std::endl;
+            LOG_INFO("✓ Project closed during cleanup");
         } else {
-            std::cout << "✓ No project was open (cleanup)" << std::endl;
+            LOG_INFO("✓ No project was open (cleanup)");
         }
     } catch (const std::exception& e) {
-        std::cerr << "Exception during project close: " << e.what() << std::endl;
+        LOG_ERROR("Exception during project close: " << e.what());
     } catch (...) {
-        std::cerr << "Unknown exception during project close" << std::endl;
+        LOG_ERROR("Unknown exception during project close");
     }
 
     // Reset state
-    s_conversionInProgress = false;
-    s_currentJobId = "";
-    s_shouldCancel = false;
+    {
+        std::lock_guard<std::mutex> lock(s_cancelMutex);
+        s_conversionInProgress = false;
+        s_currentJobId = "";
+        s_cancelJobId = "";
+    }
+    s_sessionReusable = false;
+    s_holdingJobModel = false;
 
-    std::cout << "✓ ConversionHandler cleanup completed" << std::endl;
+    LOG_INFO("✓ ConversionHandler cleanup completed");
 }
@@ -18,14 +18,34 @@
 #ifndef CONVERSION_HANDLER_HPP
 #define CONVERSION_HANDLER_HPP
 
+#include "JobQueue.hpp"
+#include "ResultCache.hpp"
+#include "JobMetrics.hpp"
+#include "JobCostModel.hpp"
+#include "MemoryPolicy.hpp"
+#include "JobStager.hpp"
 #include <string>
+#include <vector>
+#include <map>
+#include <set>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace GS {
+    class ProcessControl;
+}
 
 /**
  * @brief Handles conversion operations for Archicad
  *
  * This class manages the conversion of .pln files to IFC format
  * and provides progress callbacks.
+ *
+ * Jobs submitted with SubmitJob() are held in a bounded priority queue and
+ * handed to the dispatcher one at a time by a scheduler thread, so bursts
+ * of requests wait their turn instead of being rejected.
  */
 class ConversionHandler {
 public:
@@ -36,13 +56,198 @@ public:
      */
     typedef std::function<void(int progress, const std::string& message)> ProgressCallback;
 
+    /**
+     * @brief Hands a job over to the Archicad main thread
+     * @param job Job to run (already marked Running)
+     * @param error Receives a description if the job could not be dispatched
+     * @return true once the job was handed over, false if dispatch failed
+     *
+     * Called on the scheduler thread and must not wait for the job to run;
+     * the job reports its outcome later through FinishJob().
+     */
+    typedef std::function<bool(const ConversionJob& job, std::string& error)> JobDispatcher;
+
+    /**
+     * @brief Notification about a job the scheduler changed
+     * @param job The job
+     * @param state New state (Queued for position changes)
+     * @param position 1-based queue position when Queued, 0 otherwise
+     * @param message Human-readable description
+     *
+     * Done is only sent for result-cache hits, before the job is finished:
+     * the callback reports the output and calls FinishJob().
+     */
+    typedef std::function<void(const ConversionJob& job, JobState state, size_t position, const std::string& message)> JobEventCallback;
+
+    /**
+     * @brief Notification about a finished batch item
+     * @param index 0-based position of the item in the batch
+     * @param item The item
+     * @param state Done, Failed or Cancelled
+     * @param error Failure reason, empty on success
+     */
+    typedef std::function<void(size_t index, const BatchItem& item, JobState state, const std::string& error)> BatchItemCallback;
+
+    /**
+     * @brief Queue a job for execution
+     * @param job Job to queue
+     * @param position Receives the 1-based queue position on success
+     * @return Accepted, or the reason the job was rejected
+     */
+    static JobQueue::EnqueueResult SubmitJob(const ConversionJob& job, size_t& position);
+
+    /**
+     * @brief Start the scheduler thread that drains the job queue
+     * @param dispatcher Function that runs a job on the main thread
+     * @param onJobEvent Called when a job's queue position or state changes
+     */
+    static void StartScheduler(JobDispatcher dispatcher, JobEventCallback onJobEvent);
+
+    /**
+     * @brief Stop the scheduler thread and drop queued jobs
+     *
+     * Dropped jobs, including one dispatched to the main thread that has
+     * not started, are reported Cancelled through the job event callback.
+     * StartScheduler() can start it again.
+     */
+    static void StopScheduler();
+
+    /**
+     * @brief Record the outcome of a running job
+     * @param jobId Job identifier
+     * @param finalState Done, Failed or Cancelled
+     *
+     * Called from the Add-On commands once a job has finished on the main thread.
+     */
+    static void FinishJob(const std::string& jobId, JobState finalState);
+
+    /**
+     * @brief Look up a job's state in the queue
+     * @param jobId Job identifier
+     * @param state Receives the state
+     * @param position Receives the 1-based queue position (0 unless Queued)
+     * @return false if the job is unknown
+     */
+    static bool GetJobState(const std::string& jobId, JobState& state, size_t& position);
+
+    /**
+     * @brief Stage timings of running jobs and rolling statistics
+     *
+     * Jobs are timed from the moment the scheduler picks them up (or the
+     * Add-On command starts them) until FinishJob().
+     */
+    static JobMetrics& GetMetrics();
+
+    /**
+     * @brief Per-job memory samples and the cleanup/recycle thresholds
+     */
+    static MemoryPolicy& GetMemoryPolicy();
+
+    /**
+     * @brief Number of jobs waiting in the queue (excluding the running one)
+     */
+    static size_t GetQueueDepth();
+
+    /**
+     * @brief Check whether a queued job is currently running
+     */
+    static bool HasRunningJob();
+
+    /**
+     * @brief Set up the conversion result cache
+     * @param directory UTF-8 cache directory ("" for a folder in the temp directory)
+     * @param maxBytes Size limit in bytes; 0 disables the cache
+     *
+     * Before a conversion is dispatched, the scheduler hashes its input and
+     * looks the result up in the cache; a hit is placed at the job's output
+     * path and completed without opening Archicad. Successful conversions
+     * are added to the cache.
+     */
+    static void ConfigureResultCache(const std::string& directory, uint64_t maxBytes);
+
+    /**
+     * @brief Start the threads that prepare queued jobs
+     * @param options Staging mode, scratch directory, threads and prefetch depth
+     *
+     * While a job runs, the next jobs in scheduling order have their inputs
+     * checked (and copied to local scratch when they are on a network
+     * share) and their output directories created, so the main thread only
+     * receives jobs it can open. Without this, jobs are prepared on the
+     * scheduler thread when they leave the queue.
+     */
+    static void ConfigureStaging(const StagingOptions& options);
+
+    /**
+     * @brief Enable or disable warm sessions
+     * @param enabled true to keep the model open between queued jobs
+     *
+     * In a warm session a successful job leaves its (unmodified) model open
+     * while more jobs are queued, and the next job opens its file over it
+     * instead of closing the project first. The blank template is only
+     * opened once the queue is empty. Failed jobs always close the project.
+     */
+    static void SetWarmSession(bool enabled);
+
+    /**
+     * @brief Choose how queued jobs of the same priority are ordered
+     * @param policy Fifo, ShortestFirst or FairShare
+     * @param aging ShortestFirst: ms taken off a prediction per ms waited
+     * @param tenantWeights FairShare: share per tenant, others weigh 1
+     *
+     * Run times are predicted by a JobCostModel that learns from every job
+     * that completes on the main thread.
+     */
+    static void ConfigureScheduling(SchedulingPolicy policy, double aging,
+                                    const std::map<std::string, double>& tenantWeights);
+
+    /**
+     * @brief Predicted time until a queued or running job finishes
+     * @return false if the job is not in the queue
+     */
+    static bool GetJobEta(const std::string& jobId, double& etaMs);
+
+    /**
+     * @brief Check whether warm sessions are enabled
+     */
+    static bool IsWarmSession();
+
+    /**
+     * @brief Close a model kept warm once no jobs are left
+     *
+     * Must be called on the main thread. Does nothing while jobs are queued
+     * or running, or when no model is held.
+     */
+    static void ReleaseSession();
+
+    /**
+     * @brief Forget about a model kept warm without closing it
+     *
+     * Used when the open project is handed to the user (LoadIfc), so it is
+     * never closed or opened over on the plugin's behalf.
+     */
+    static void DetachSession();
+
+    /**
+     * @brief Reset Archicad's project state to bring memory use down
+     *
+     * Must be called on the main thread between jobs. Closes the open
+     * project (including a model kept warm), opens a new project with reset
+     * settings, which drops the previous project's libraries and caches, and
+     * returns freed heap to the system.
+     */
+    static void DeepCleanup();
+
     /**
      * @brief Convert .pln file to IFC format
      * @param jobId Unique job identifier
      * @param plnPath Path to input .pln file
      * @param outputPath Path for output IFC file
+     * @param translatorName IFC export translator of the project, matched by
+     *        name ignoring case; "" uses the project's first translator
+     * @param filter Elements to export; an empty filter exports the entire project
      * @param onProgress Progress callback function
-     * @return true if conversion succeeded, false otherwise
+     * @param processControl Archicad process control to poll for cancellation (optional)
+     * @return true if conversion succeeded, false otherwise (see IsCancelRequested)
      * 
      * NOTE: Due to Archicad API limitations, this function cannot automatically
      * open PLN files. The user must open the PLN file manually first.
@@ -52,7 +257,10 @@ public:
         const std::string& jobId,
         const std::string& plnPath,
         const std::string& outputPath,
-        ProgressCallback onProgress = nullptr
+        const std::string& translatorName = std::string(),
+        const ElementFilter& filter = ElementFilter(),
+        ProgressCallback onProgress = nullptr,
+        GS::ProcessControl* processControl = nullptr
     );
 
     /**
@@ -74,22 +282,61 @@ public:
      * @param ifcPath Path to input IFC file
      * @param outputPath Path for output .pln file
      * @param onProgress Progress callback function
-     * @return true if conversion succeeded, false otherwise
+     * @param processControl Archicad process control to poll for cancellation (optional)
+     * @return true if conversion succeeded, false otherwise (see IsCancelRequested)
      */
     static bool ConvertIfcToPln(
         const std::string& jobId,
         const std::string& ifcPath,
         const std::string& outputPath,
-        ProgressCallback onProgress = nullptr
+        ProgressCallback onProgress = nullptr,
+        GS::ProcessControl* processControl = nullptr
+    );
+
+    /**
+     * @brief Run several conversions back to back in one session
+     * @param jobId Unique job identifier of the batch
+     * @param items Conversions to run, in order
+     * @param onItem Called after each item (optional)
+     * @param onProgress Overall progress callback (optional)
+     * @param processControl Archicad process control to poll for cancellation (optional)
+     * @return true if every item succeeded
+     *
+     * Each item's input is opened over the previous item's model instead of
+     * closing the project in between, and consecutive PLN -> IFC items with
+     * the same input reuse the open model for every export (one open, one
+     * save per translator). A failed item
+     * does not stop the batch; a cancelled batch reports the remaining
+     * items as Cancelled.
+     */
+    static bool ConvertBatch(
+        const std::string& jobId,
+        const std::vector<BatchItem>& items,
+        BatchItemCallback onItem = nullptr,
+        ProgressCallback onProgress = nullptr,
+        GS::ProcessControl* processControl = nullptr
     );
 
     /**
-     * @brief Cancel ongoing conversion
+     * @brief Cancel a queued or ongoing conversion
      * @param jobId Job identifier to cancel
-     * @return true if cancelled, false if not found or already completed
+     * @return true if cancelled (or cancellation was requested), false if
+     *         not found or already completed
+     *
+     * Queued jobs are removed from the queue without touching Archicad. A
+     * running job is asked to stop; it checks between stages (after close,
+     * after open, before translator lookup, before save) and finishes as
+     * Cancelled. A stage already in progress, such as the save itself, runs
+     * to completion first.
      */
     static bool CancelConversion(const std::string& jobId);
 
+    /**
+     * @brief Check whether cancellation was requested for a running job
+     * @param jobId Job identifier
+     */
+    static bool IsCancelRequested(const std::string& jobId);
+
     /**
      * @brief Check if a conversion is in progress
      * @param jobId Job identifier to check
@@ -113,9 +360,93 @@ public:
     static void Cleanup();
 
 private:
+    static void SchedulerLoop();
+    static void DispatchNext(const ConversionJob& job);
+    static void NotifyQueuePositions();
+    static void PrefetchQueued();
+
+    /**
+     * @brief Complete a job from the result cache
+     *
+     * PLN -> IFC jobs are only prepared here (input hash, options): their
+     * key needs the translator of the opened project, see ServeExportFromCache().
+     *
+     * @return true if the job was served; otherwise its cache key is
+     *         remembered so FinishJob() can store the result
+     */
+    static bool TryServeFromCache(const ConversionJob& job);
+
+    /**
+     * @brief Place a cached IFC export at outputPath (main thread, project open)
+     *
+     * Keys on the translator the name resolved to in the open project, not
+     * on the name (TranslatorCache::Identify()).
+     *
+     * @return true on a hit: the export can be skipped; otherwise the key is
+     *         remembered so FinishJob() can store the result
+     */
+    static bool ServeExportFromCache(const std::string& jobId, const std::string& translatorName,
+                                     const std::string& outputPath);
+
+    struct CacheLookup {
+        std::string inputHash;
+        std::string kind;
+        std::string options;
+    };
+
+    struct CacheStore {
+        std::string key;
+        std::string resultPath;
+    };
+
+    /**
+     * @brief Prepare Archicad for the next job's input file
+     * @return true if the file will be opened over a model kept warm
+     */
+    static bool BeginJobSession();
+
+    /**
+     * @brief Close the job's model or keep it warm for the next job
+     * @param success true if the job completed successfully
+     */
+    static void EndJobSession(bool success);
+
+    /**
+     * @brief Cancellation checkpoint between conversion stages
+     * @param jobId Running job
+     * @param processControl Archicad process control, may be nullptr
+     * @param stage Stage name for the log
+     * @return true if the job should stop now
+     */
+    static bool ShouldStop(const std::string& jobId, GS::ProcessControl* processControl, const char* stage);
+
+    static JobQueue s_jobQueue;
+    static JobDispatcher s_dispatcher;
+    static JobEventCallback s_onJobEvent;
+    static std::thread s_schedulerThread;
+    static std::mutex s_schedulerMutex;
+    static std::condition_variable s_schedulerCv;
+    static bool s_schedulerStop;
+
+    static ResultCache s_resultCache;
+    static JobMetrics s_metrics;
+    static MemoryPolicy s_memoryPolicy;
+    static JobCostModel s_costModel;
+    static JobStager s_stager;
+    static std::map<std::string, CacheLookup> s_cacheLookups;     // jobId -> PLN -> IFC key parts before the open
+    static std::map<std::string, CacheStore> s_cacheCandidates;   // jobId -> key of the running job
+    static std::set<std::string> s_cacheHits;                      // Jobs served from the cache
+    static std::vector<CacheStore> s_cacheStores;                  // Finished results to copy into the cache
+
+    static bool s_warmSession;          // Keep models open between queued jobs
+    static bool s_sessionReusable;      // Open model is unmodified and can be opened over
+    static bool s_holdingJobModel;      // A finished job's model is still open
+
     static std::string s_currentJobId;
     static bool s_conversionInProgress;
-    static bool s_shouldCancel;
+
+    static std::mutex s_cancelMutex;
+    static std::string s_cancelJobId;   // Running job asked to stop, guarded by s_cancelMutex
 };
 
 #endif // CONVERSION_HANDLER_HPP
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ElementFilter.hpp"
+#include "JsonParser.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+bool ElementFilter::IsEmpty() const
+{
+    return storeys.empty() && layers.empty() && elementTypes.empty() && guids.empty() && modifiedSince == 0;
+}
+
+const std::vector<std::string>& ElementFilterTypeNames()
+{
+    static const std::vector<std::string> names = {
+        "wall", "column", "beam", "slab", "roof", "shell", "mesh", "morph",
+        "door", "window", "skylight", "opening", "object", "lamp", "zone",
+        "stair", "railing", "curtainwall"
+    };
+    return names;
+}
+
+static std::string ToLower(std::string text)
+{
+    for (char& c : text) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+// Helper to read an array of non-empty strings
+static bool ReadStrings(const JsonValue& filter, const char* key, std::vector<std::string>& out, std::string& error)
+{
+    const JsonValue* list = filter.Find(key);
+    if (list == nullptr) {
+        return true;
+    }
+    if (!list->IsArray()) {
+        error = std::string("filter.") + key + " must be an array";
+        return false;
+    }
+
+    for (size_t i = 0; i < list->Size(); ++i) {
+        const JsonValue& item = list->At(i);
+        if (!item.IsString() || item.AsString().empty()) {
+            error = std::string("filter.") + key + " must contain non-empty strings";
+            return false;
+        }
+        out.push_back(item.AsString());
+    }
+    return true;
+}
+
+bool ParseElementFilter(const JsonValue& value, ElementFilter& filter, std::string& error)
+{
+    filter = ElementFilter();
+
+    if (value.IsNull()) {
+        return true;
+    }
+    if (!value.IsObject()) {
+        error = "filter must be an object";
+        return false;
+    }
+
+    const JsonValue* storeys = value.Find("storeys");
+    if (storeys != nullptr) {
+        if (!storeys->IsArray()) {
+            error = "filter.storeys must be an array";
+            return false;
+        }
+        for (size_t i = 0; i < storeys->Size(); ++i) {
+            if (!storeys->At(i).IsNumber()) {
+                error = "filter.storeys must contain storey indices";
+                return false;
+            }
+            filter.storeys.push_back(static_cast<int>(storeys->At(i).AsInt()));
+        }
+    }
+
+    if (!ReadStrings(value, "layers", filter.layers, error) ||
+        !ReadStrings(value, "elementTypes", filter.elementTypes, error) ||
+        !ReadStrings(value, "guids", filter.guids, error)) {
+        return false;
+    }
+
+    const std::vector<std::string>& known = ElementFilterTypeNames();
+    for (std::string& type : filter.elementTypes) {
+        type = ToLower(type);
+        if (std::find(known.begin(), known.end(), type) == known.end()) {
+            error = "Unknown element type in filter: " + type;
+            return false;
+        }
+    }
+
+    const JsonValue* modifiedSince = value.Find("modifiedSince");
+    if (modifiedSince != nullptr) {
+        if (!modifiedSince->IsNumber() || modifiedSince->AsInt() < 0) {
+            error = "filter.modifiedSince must be a non-negative number";
+            return false;
+        }
+        filter.modifiedSince = static_cast<uint64_t>(modifiedSince->AsInt());
+    }
+
+    return true;
+}
+
+std::string DescribeElementFilter(const ElementFilter& filter)
+{
+    if (filter.IsEmpty()) {
+        return std::string();
+    }
+
+    std::vector<int> storeys = filter.storeys;
+    std::vector<std::string> layers = filter.layers;
+    std::vector<std::string> types = filter.elementTypes;
+    std::vector<std::string> guids = filter.guids;
+    std::sort(storeys.begin(), storeys.end());
+    std::sort(layers.begin(), layers.end());
+    std::sort(types.begin(), types.end());
+    for (std::string& guid : guids) {
+        guid = ToLower(guid);
+    }
+    std::sort(guids.begin(), guids.end());
+
+    // Values are length-prefixed so no name can imitate a separator
+    std::string text;
+    auto append = [&text](const char* category, const std::vector<std::string>& values) {
+        text += category;
+        text += '=';
+        for (const std::string& value : values) {
+            text += std::to_string(value.size()) + ':' + value;
+        }
+        text += ';';
+    };
+
+    text += "storeys=";
+    for (int storey : storeys) {
+        text += std::to_string(storey) + ',';
+    }
+    text += ';';
+    append("layers", layers);
+    append("types", types);
+    append("guids", guids);
+    text += "modifiedSince=" + std::to_string(filter.modifiedSince);
+    return text;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELEMENT_FILTER_HPP
+#define ELEMENT_FILTER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class JsonValue;
+
+/**
+ * @brief Subset of a model to export, from a request's "filter" object
+ *
+ * Categories combine with AND, values inside a category with OR; an empty
+ * category does not restrict the export. An empty filter exports the
+ * entire project.
+ *
+ * @code
+ * "filter": {
+ *   "storeys": [0, 1],
+ *   "layers": ["Structural - Bearing"],
+ *   "elementTypes": ["wall", "slab"],
+ *   "guids": ["3F2504E0-4F89-11D3-9A0C-0305E82C3301"],
+ *   "modifiedSince": 1234
+ * }
+ * @endcode
+ */
+struct ElementFilter {
+    std::vector<int> storeys;               // Storey (floor) indices
+    std::vector<std::string> layers;        // Layer names
+    std::vector<std::string> elementTypes;  // Lower-case type names, see ElementFilterTypeNames()
+    std::vector<std::string> guids;         // Element GUIDs
+    uint64_t modifiedSince = 0;             // Only elements with a modification stamp above this
+
+    bool IsEmpty() const;
+};
+
+/**
+ * @brief Element type names accepted in "elementTypes"
+ */
+const std::vector<std::string>& ElementFilterTypeNames();
+
+/**
+ * @brief Read a filter object
+ * @param value The "filter" member of a request
+ * @param filter Receives the filter
+ * @param error Receives a description on failure
+ * @return false if the filter is malformed or names an unknown element type
+ */
+bool ParseElementFilter(const JsonValue& value, ElementFilter& filter, std::string& error);
+
+/**
+ * @brief Canonical text form of a filter, "" for an empty one
+ *
+ * Equal filters give equal text regardless of value order; used in the
+ * result cache key.
+ */
+std::string DescribeElementFilter(const ElementFilter& filter);
+
+#endif // ELEMENT_FILTER_HPP
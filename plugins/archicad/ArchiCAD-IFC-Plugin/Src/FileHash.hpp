@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILE_HASH_HPP
+#define FILE_HASH_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Incremental SHA-256
+ *
+ * Used to identify file contents (result cache keys, integrity hashes), not
+ * for anything security related.
+ */
+class Sha256 {
+public:
+    Sha256();
+
+    /**
+     * @brief Feed more data into the hash
+     */
+    void Update(const void* data, size_t length);
+
+    /**
+     * @brief Finish the hash
+     * @return Lower-case hex digest (64 characters)
+     *
+     * The object must not be updated again afterwards.
+     */
+    std::string FinalHex();
+
+    /**
+     * @brief Hash a whole file
+     * @param path UTF-8 file path
+     * @param hexDigest Receives the lower-case hex digest
+     * @return false if the file could not be read
+     */
+    static bool HashFile(const std::string& path, std::string& hexDigest);
+
+    /**
+     * @brief Hash a string
+     * @return Lower-case hex digest
+     */
+    static std::string HashString(const std::string& data);
+
+private:
+    void Transform(const uint8_t block[64]);
+
+    uint32_t m_state[8];
+    uint8_t m_buffer[64];
+    size_t m_bufferLength;
+    uint64_t m_totalLength;
+};
+
+#endif // FILE_HASH_HPP
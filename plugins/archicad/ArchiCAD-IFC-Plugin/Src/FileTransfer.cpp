@@ -0,0 +1,1127 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FileTransfer.hpp"
+#include "FileHash.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+// Size of the chunks the server sends and suggests to clients
+static const size_t kChunkSize = 256 * 1024;
+
+// Unacknowledged bytes allowed in flight, per transfer and direction
+static const uint64_t kWindowBytes = 8 * kChunkSize;
+
+// How often the worker looks for new bytes in live outputs
+static const int kFollowPollMs = 200;
+
+// Read size of the worker, for hashing and following
+static const size_t kWorkerReadBytes = 1024 * 1024;
+
+// Hash the first `length` bytes of a file
+static bool HashFilePrefix(const std::string& path, uint64_t length, Sha256& hash)
+{
+    std::ifstream file(fs::u8path(path), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> buffer(kWorkerReadBytes);
+    while (length > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(buffer.size(), length));
+        file.read(buffer.data(), static_cast<std::streamsize>(chunk));
+        if (static_cast<size_t>(file.gcount()) != chunk) {
+            return false;
+        }
+        hash.Update(buffer.data(), chunk);
+        length -= chunk;
+    }
+    return true;
+}
+
+// Replace anything that is not safe in a file name (including separators)
+static std::string SanitizeName(const std::string& value)
+{
+    std::string name = value;
+    for (char& c : name) {
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    c == '.' || c == '_' || c == '-';
+        if (!safe) {
+            c = '_';
+        }
+    }
+
+    if (name.empty() || name == "." || name == "..") {
+        name = "file";
+    }
+    return name;
+}
+
+// File name part of a client-supplied name, made safe
+static std::string SanitizeComponent(const std::string& value)
+{
+    size_t slash = value.find_last_of("/\\");
+    return SanitizeName(slash == std::string::npos ? value : value.substr(slash + 1));
+}
+
+std::string MakeChunkFrame(const std::string& transferId, uint64_t offset, const char* data, size_t length)
+{
+    std::string frame;
+    frame.reserve(2 + transferId.size() + 8 + length);
+    frame.push_back(static_cast<char>(kChunkFrameMarker));
+    frame.push_back(static_cast<char>(transferId.size()));
+    frame.append(transferId);
+    for (int i = 7; i >= 0; --i) {
+        frame.push_back(static_cast<char>((offset >> (i * 8)) & 0xFF));
+    }
+    frame.append(data, length);
+    return frame;
+}
+
+bool ParseChunkFrame(const std::string& frame, std::string& transferId, uint64_t& offset,
+                     const char*& data, size_t& length)
+{
+    if (frame.size() < 2 || static_cast<uint8_t>(frame[0]) != kChunkFrameMarker) {
+        return false;
+    }
+
+    size_t idLength = static_cast<uint8_t>(frame[1]);
+    size_t header = 2 + idLength + 8;
+    if (idLength == 0 || frame.size() < header) {
+        return false;
+    }
+
+    transferId.assign(frame, 2, idLength);
+    offset = 0;
+    for (size_t i = 2 + idLength; i < header; ++i) {
+        offset = (offset << 8) | static_cast<uint8_t>(frame[i]);
+    }
+    data = frame.data() + header;
+    length = frame.size() - header;
+    return true;
+}
+
+FileTransferManager::FileTransferManager()
+    : m_maxFileBytes(0)
+    , m_ttlHours(0)
+    , m_stopping(false)
+    , m_generation(0)
+{
+}
+
+FileTransferManager::~FileTransferManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+bool FileTransferManager::Open(const std::string& directory, uint64_t maxFileBytes, int ttlHours)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_directory.clear();
+    m_uploads.clear();
+    m_downloads.clear();
+    m_maxFileBytes = maxFileBytes;
+    m_ttlHours = ttlHours;
+
+    if (directory.empty() || maxFileBytes == 0) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path root = fs::u8path(directory);
+    fs::create_directories(root, ec);
+    if (!fs::is_directory(root, ec)) {
+        LOG_ERROR("✗ Transfer staging directory unusable: " << directory);
+        return false;
+    }
+
+    m_directory = root.lexically_normal().u8string();
+    SweepExpiredLocked();
+
+    LOG_INFO("✓ File transfers staged in " << m_directory);
+    return true;
+}
+
+bool FileTransferManager::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_directory.empty();
+}
+
+void FileTransferManager::SetSenders(TextSender sendText, BinarySender sendBinary)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sendText = sendText;
+    m_sendBinary = sendBinary;
+}
+
+void FileTransferManager::HandleCommand(const WebSocketCommand& command)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_directory.empty()) {
+        SendError(command.sessionId, command.body.GetString({ "transferId", "transfer_id" }), "File transfer is disabled");
+        return;
+    }
+
+    switch (command.type) {
+        case CommandType::UploadBegin:
+            BeginUploadLocked(command);
+            break;
+        case CommandType::Download:
+            BeginDownloadLocked(command);
+            break;
+        case CommandType::DownloadAck:
+            AckDownloadLocked(command);
+            break;
+        case CommandType::CancelTransfer:
+            CancelLocked(command);
+            break;
+        default:
+            break;
+    }
+}
+
+void FileTransferManager::BeginUploadLocked(const WebSocketCommand& command)
+{
+    std::string transferId = command.body.GetString({ "transferId", "transfer_id" });
+    std::string fileName = command.body.GetString({ "fileName", "file_name" });
+    int64_t size = command.body.GetInt("size", -1);
+    std::string sha256 = command.body.GetString({ "sha256" });
+
+    if (transferId.empty() || transferId.size() > 255 || fileName.empty() || size < 0) {
+        SendError(command.sessionId, transferId, "upload_begin requires transferId, fileName and size");
+        return;
+    }
+    if (static_cast<uint64_t>(size) > m_maxFileBytes) {
+        SendError(command.sessionId, transferId, "File is larger than the transfer limit");
+        return;
+    }
+
+    SweepExpiredLocked();
+
+    auto it = m_uploads.find(transferId);
+    if (it != m_uploads.end() && (it->second.size != static_cast<uint64_t>(size) || it->second.fileName != fileName)) {
+        // Same id, different file: start over
+        it->second.file.reset();
+        std::error_code ec;
+        fs::remove(fs::u8path(it->second.partPath), ec);
+        m_uploads.erase(it);
+        it = m_uploads.end();
+    }
+
+    if (it == m_uploads.end()) {
+        std::error_code ec;
+        fs::path dir = fs::u8path(TransferDirLocked(transferId));
+        fs::create_directories(dir, ec);
+
+        Upload upload;
+        upload.fileName = fileName;
+        upload.size = static_cast<uint64_t>(size);
+        upload.finalPath = (dir / fs::u8path(SanitizeComponent(fileName))).u8string();
+        upload.partPath = upload.finalPath + ".part";
+        upload.generation = ++m_generation;
+
+        // Resume from what an earlier connection (or plugin run) left behind;
+        // a finished file is only trusted when the client gives its digest
+        fs::path finalPath = fs::u8path(upload.finalPath);
+        fs::path partPath = fs::u8path(upload.partPath);
+        if (!sha256.empty() && fs::is_regular_file(finalPath, ec) && fs::file_size(finalPath, ec) == upload.size) {
+            upload.received = upload.size;
+            upload.complete = true;
+        } else if (fs::is_regular_file(partPath, ec)) {
+            upload.received = fs::file_size(partPath, ec);
+            if (ec || upload.received > upload.size) {
+                fs::remove(partPath, ec);
+                upload.received = 0;
+            }
+        }
+
+        it = m_uploads.emplace(transferId, std::move(upload)).first;
+    }
+
+    Upload& upload = it->second;
+    upload.sha256 = sha256;
+
+    // What an earlier run left on disk is hashed on the worker first; chunks
+    // received in this run were hashed as they arrived
+    bool needsHash = upload.complete ? upload.digest.empty() : upload.hashed < upload.received;
+    if (needsHash) {
+        upload.sessionId = command.sessionId;
+        if (!upload.verifying) {
+            upload.verifying = true;
+            QueueUploadHashLocked(transferId, upload);
+        }
+        return;
+    }
+
+    ContinueUploadLocked(transferId, upload, command.sessionId);
+}
+
+void FileTransferManager::ContinueUploadLocked(const std::string& transferId, Upload& upload, uint64_t sessionId)
+{
+    if (upload.complete) {
+        FinishUploadLocked(transferId, upload, sessionId);
+        return;
+    }
+
+    if (!upload.file) {
+        upload.file = std::make_unique<std::ofstream>(fs::u8path(upload.partPath), std::ios::binary | std::ios::app);
+        if (!*upload.file) {
+            upload.file.reset();
+            SendError(sessionId, transferId, "Cannot create staging file");
+            return;
+        }
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "upload_ready")
+          .Field("transferId", transferId)
+          .Field("offset", upload.received)
+          .Field("chunkSize", kChunkSize)
+          .Field("window", kWindowBytes)
+          .EndObject();
+    SendText(sessionId, writer.ToPayload());
+
+    LOG_INFO("Upload " << transferId << ": " << upload.fileName << " (" << upload.size << " bytes, from " << upload.received << ")");
+
+    if (upload.received == upload.size) {
+        FinishUploadLocked(transferId, upload, sessionId);
+    }
+}
+
+void FileTransferManager::QueueUploadHashLocked(const std::string& transferId, const Upload& upload)
+{
+    std::string path = upload.complete ? upload.finalPath : upload.partPath;
+    uint64_t length = upload.complete ? upload.size : upload.received;
+    uint64_t generation = upload.generation;
+
+    QueueTaskLocked([this, transferId, path, length, generation]() {
+        Sha256 hash;
+        bool ok = HashFilePrefix(path, length, hash);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_uploads.find(transferId);
+        if (it == m_uploads.end() || it->second.generation != generation) {
+            return;     // Cancelled or restarted meanwhile
+        }
+
+        Upload& upload = it->second;
+        upload.verifying = false;
+        std::error_code ec;
+        if (upload.complete) {
+            if (!ok) {
+                fs::remove(fs::u8path(upload.finalPath), ec);
+                uint64_t sessionId = upload.sessionId;
+                m_uploads.erase(it);
+                SendError(sessionId, transferId, "Staged file does not match, upload it again");
+                return;
+            }
+            upload.digest = hash.FinalHex();
+        } else if (ok) {
+            upload.hash = hash;
+            upload.hashed = length;
+        } else {
+            // An unreadable partial file: start over
+            upload.file.reset();
+            fs::remove(fs::u8path(upload.partPath), ec);
+            upload.received = 0;
+            upload.hash = Sha256();
+            upload.hashed = 0;
+        }
+        ContinueUploadLocked(transferId, upload, upload.sessionId);
+    });
+}
+
+void FileTransferManager::HandleChunk(uint64_t sessionId, const std::string& frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string transferId;
+    uint64_t offset = 0;
+    const char* data = nullptr;
+    size_t length = 0;
+    if (!ParseChunkFrame(frame, transferId, offset, data, length)) {
+        SendError(sessionId, "", "Malformed chunk frame");
+        return;
+    }
+
+    auto it = m_uploads.find(transferId);
+    if (it == m_uploads.end() || it->second.complete || !it->second.file) {
+        SendError(sessionId, transferId, "No upload in progress for this transferId");
+        return;
+    }
+
+    Upload& upload = it->second;
+
+    JsonWriter ack;
+    ack.BeginObject()
+       .Field("type", "upload_ack")
+       .Field("transferId", transferId);
+
+    // Out of order (e.g. resent after a reconnect): tell the client where we are
+    if (offset != upload.received) {
+        ack.Field("offset", upload.received).EndObject();
+        SendText(sessionId, ack.ToPayload());
+        return;
+    }
+
+    if (length > upload.size - upload.received) {
+        SendError(sessionId, transferId, "Chunk runs past the announced size");
+        return;
+    }
+
+    upload.file->write(data, static_cast<std::streamsize>(length));
+    if (!*upload.file) {
+        upload.file.reset();
+        SendError(sessionId, transferId, "Failed writing staging file");
+        return;
+    }
+    upload.hash.Update(data, length);
+    upload.hashed += length;
+    upload.received += length;
+
+    if (upload.received == upload.size) {
+        FinishUploadLocked(transferId, upload, sessionId);
+        return;
+    }
+
+    ack.Field("offset", upload.received).EndObject();
+    SendText(sessionId, ack.ToPayload());
+}
+
+void FileTransferManager::FinishUploadLocked(const std::string& transferId, Upload& upload, uint64_t sessionId)
+{
+    std::error_code ec;
+
+    if (!upload.complete) {
+        upload.file.reset();
+
+        // Kept, so a failed rename can be retried without hashing again
+        if (upload.digest.empty()) {
+            upload.digest = upload.hash.FinalHex();
+        }
+        if (!upload.sha256.empty() && upload.sha256 != upload.digest) {
+            fs::path partPath = fs::u8path(upload.partPath);
+            fs::remove(partPath, ec);
+            fs::remove(partPath.parent_path(), ec);     // Only when empty
+            m_uploads.erase(transferId);
+            SendError(sessionId, transferId, "Checksum mismatch, upload discarded");
+            return;
+        }
+
+        fs::rename(fs::u8path(upload.partPath), fs::u8path(upload.finalPath), ec);
+        if (ec) {
+            SendError(sessionId, transferId, "Cannot finalize staging file: " + ec.message());
+            return;
+        }
+        upload.complete = true;
+    } else if (!upload.sha256.empty() && upload.sha256 != upload.digest) {
+        // A file left from an earlier run that does not match: upload again
+        fs::remove(fs::u8path(upload.finalPath), ec);
+        m_uploads.erase(transferId);
+        SendError(sessionId, transferId, "Staged file does not match, upload it again");
+        return;
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "upload_complete")
+          .Field("transferId", transferId)
+          .Field("fileName", upload.fileName)
+          .Field("size", upload.size)
+          .Field("sha256", upload.digest)
+          .EndObject();
+    SendText(sessionId, writer.ToPayload());
+
+    LOG_INFO("✓ Upload " << transferId << " complete (" << upload.size << " bytes)");
+}
+
+void FileTransferManager::BeginDownloadLocked(const WebSocketCommand& command)
+{
+    std::string transferId = command.body.GetString({ "transferId", "transfer_id" });
+    if (transferId.empty()) {
+        transferId = command.jobId;
+    }
+    int64_t offset = command.body.GetInt("offset", 0);
+
+    auto it = m_downloads.find(transferId);
+    if (it == m_downloads.end()) {
+        SendError(command.sessionId, transferId, "No download for this transferId");
+        return;
+    }
+
+    Download& download = it->second;
+    if (offset < 0 || static_cast<uint64_t>(offset) > download.size) {
+        SendError(command.sessionId, transferId, "Offset is past the end of the file");
+        return;
+    }
+
+    // A new request takes the download over (e.g. after a reconnect)
+    download.file.reset();
+    download.sessionId = command.sessionId;
+    download.sent = static_cast<uint64_t>(offset);
+    download.acked = static_cast<uint64_t>(offset);
+
+    // Hashed on the worker rather than when the job finished; download_begin
+    // follows. A live output is hashed by the worker as it follows it
+    if (download.hashing) {
+        return;
+    }
+    if (!download.live && download.sha256.empty()) {
+        download.hashing = true;
+        std::string path = download.path;
+        uint64_t size = download.size;
+        uint64_t generation = download.generation;
+        QueueTaskLocked([this, transferId, path, size, generation]() {
+            Sha256 hash;
+            bool ok = HashFilePrefix(path, size, hash);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_downloads.find(transferId);
+            if (it == m_downloads.end() || it->second.generation != generation) {
+                return;
+            }
+
+            Download& download = it->second;
+            download.hashing = false;
+            if (!ok) {
+                if (download.sessionId != 0) {
+                    SendError(download.sessionId, transferId, "Cannot read file for download");
+                    download.sessionId = 0;
+                }
+                return;
+            }
+            download.sha256 = hash.FinalHex();
+            StartDownloadLocked(it);
+        });
+        return;
+    }
+
+    StartDownloadLocked(it);
+}
+
+void FileTransferManager::StartDownloadLocked(std::map<std::string, Download>::iterator it)
+{
+    const std::string& transferId = it->first;
+    Download& download = it->second;
+    if (download.sessionId == 0) {
+        return;     // The client went away while the file was hashed
+    }
+
+    // A live output may not exist yet: PumpLocked() opens it once it has entities
+    if (!download.live || download.size > 0) {
+        download.file = std::make_unique<std::ifstream>(fs::u8path(download.path), std::ios::binary);
+        if (!*download.file) {
+            download.file.reset();
+            SendError(download.sessionId, transferId, "Cannot open file for download");
+            download.sessionId = 0;
+            return;
+        }
+        download.file->seekg(static_cast<std::streamoff>(download.sent));
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "download_begin")
+          .Field("transferId", transferId)
+          .Field("fileName", download.fileName)
+          .Field("size", download.size)
+          .Field("sha256", download.sha256)
+          .Field("offset", download.sent)
+          .Field("chunkSize", kChunkSize)
+          .Field("window", kWindowBytes);
+    if (download.live) {
+        writer.Field("live", true);
+    }
+    writer.EndObject();
+    SendText(download.sessionId, writer.ToPayload());
+
+    ContinueDownloadLocked(it);
+}
+
+void FileTransferManager::PumpLocked(const std::string& transferId, Download& download)
+{
+    // A live output is opened once its first entities are written
+    if (!download.file && download.live && download.sessionId != 0 && download.sent < download.size) {
+        download.file = std::make_unique<std::ifstream>(fs::u8path(download.path), std::ios::binary);
+        if (!*download.file) {
+            download.file.reset();
+            return;
+        }
+        download.file->seekg(static_cast<std::streamoff>(download.sent));
+    }
+
+    std::vector<char> buffer;
+
+    while (download.file && download.sent < download.size && download.sent - download.acked < kWindowBytes) {
+        // Chunks of a live output end on entity boundaries
+        uint64_t end = std::min<uint64_t>(download.sent + kChunkSize, download.size);
+        auto cut = std::upper_bound(download.cuts.begin(), download.cuts.end(), download.sent);
+        if (cut != download.cuts.end() && *cut < end) {
+            end = *cut;
+        }
+
+        size_t length = static_cast<size_t>(end - download.sent);
+        buffer.resize(length);
+        download.file->read(buffer.data(), static_cast<std::streamsize>(length));
+        if (static_cast<size_t>(download.file->gcount()) != length) {
+            download.file.reset();
+            SendError(download.sessionId, transferId, "Failed reading file for download");
+            download.sessionId = 0;
+            return;
+        }
+
+        if (m_sendBinary) {
+            m_sendBinary(download.sessionId,
+                         std::make_shared<const std::string>(MakeChunkFrame(transferId, download.sent, buffer.data(), length)));
+        }
+        download.sent += length;
+    }
+}
+
+void FileTransferManager::AckDownloadLocked(const WebSocketCommand& command)
+{
+    std::string transferId = command.body.GetString({ "transferId", "transfer_id" });
+    if (transferId.empty()) {
+        transferId = command.jobId;
+    }
+
+    auto it = m_downloads.find(transferId);
+    if (it == m_downloads.end() || it->second.sessionId != command.sessionId) {
+        return;
+    }
+
+    Download& download = it->second;
+    int64_t offset = command.body.GetInt("offset", -1);
+    if (offset >= 0 && static_cast<uint64_t>(offset) >= download.acked && static_cast<uint64_t>(offset) <= download.sent) {
+        download.acked = static_cast<uint64_t>(offset);
+    }
+
+    ContinueDownloadLocked(it);
+}
+
+void FileTransferManager::ContinueDownloadLocked(std::map<std::string, Download>::iterator it)
+{
+    const std::string& transferId = it->first;
+    Download& download = it->second;
+    if (download.sessionId == 0 || download.hashing) {
+        return;
+    }
+
+    // A live output is not complete before its export is
+    if (download.live || download.acked < download.size) {
+        PumpLocked(transferId, download);
+        return;
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "download_complete")
+          .Field("transferId", transferId)
+          .Field("size", download.size)
+          .Field("sha256", download.sha256)
+          .EndObject();
+    SendText(download.sessionId, writer.ToPayload());
+
+    LOG_INFO("✓ Download " << transferId << " complete (" << download.size << " bytes)");
+
+    // The client has every byte: the staged copy is no longer needed
+    download.file.reset();
+    RemoveDownloadFileLocked(download);
+    m_downloads.erase(it);
+}
+
+void FileTransferManager::RemoveDownloadFileLocked(const Download& download)
+{
+    std::error_code ec;
+    fs::path path = fs::u8path(download.path);
+    fs::remove(path, ec);
+    fs::remove(path.parent_path(), ec);                 // Only when empty
+    fs::remove(path.parent_path().parent_path(), ec);   // The transfer, when its upload is gone too
+}
+
+void FileTransferManager::CancelLocked(const WebSocketCommand& command)
+{
+    std::string transferId = command.body.GetString({ "transferId", "transfer_id" });
+
+    // Aborts an upload in progress, or releases a finished one
+    auto upload = m_uploads.find(transferId);
+    if (upload != m_uploads.end()) {
+        upload->second.file.reset();
+        std::error_code ec;
+        fs::path partPath = fs::u8path(upload->second.partPath);
+        fs::remove(partPath, ec);
+        fs::remove(fs::u8path(upload->second.finalPath), ec);
+        fs::remove(partPath.parent_path(), ec);     // Only when empty
+        m_uploads.erase(upload);
+    }
+
+    auto download = m_downloads.find(transferId);
+    if (download != m_downloads.end() && download->second.sessionId == command.sessionId) {
+        download->second.file.reset();
+        download->second.sessionId = 0;
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "transfer_cancelled")
+          .Field("transferId", transferId)
+          .EndObject();
+    SendText(command.sessionId, writer.ToPayload());
+}
+
+void FileTransferManager::SessionClosed(uint64_t sessionId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& entry : m_downloads) {
+        if (entry.second.sessionId == sessionId) {
+            entry.second.file.reset();
+            entry.second.sessionId = 0;
+        }
+    }
+}
+
+bool FileTransferManager::GetUpload(const std::string& transferId, std::string& path, std::string& fileName,
+                                    std::string& error) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_uploads.find(transferId);
+    if (it == m_uploads.end()) {
+        error = "Unknown upload '" + transferId + "'";
+        return false;
+    }
+    if (!it->second.complete) {
+        error = "Upload '" + transferId + "' is not complete";
+        return false;
+    }
+
+    path = it->second.finalPath;
+    fileName = it->second.fileName;
+    return true;
+}
+
+std::string FileTransferManager::PrepareOutput(const std::string& transferId, const std::string& fileName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_directory.empty()) {
+        return std::string();
+    }
+
+    std::error_code ec;
+    fs::path dir = fs::u8path(TransferDirLocked(transferId)) / "output";
+    fs::create_directories(dir, ec);
+    if (ec) {
+        LOG_ERROR("✗ Cannot create output staging directory: " << ec.message());
+        return std::string();
+    }
+    return (dir / fs::u8path(SanitizeComponent(fileName))).u8string();
+}
+
+bool FileTransferManager::OfferDownload(const std::string& transferId, const std::string& path, std::string& description)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Only staged files are served: a client must not be able to read
+    // arbitrary paths off the Archicad machine
+    std::string normalized = fs::u8path(path).lexically_normal().u8string();
+    if (m_directory.empty() || normalized.compare(0, m_directory.size(), m_directory) != 0) {
+        return false;
+    }
+
+    std::error_code ec;
+    auto live = m_downloads.find(transferId);
+    if (live != m_downloads.end() && live->second.live && live->second.path == normalized) {
+        // The export is done: the worker reads the rest, then size and
+        // sha256 are final
+        uint64_t size = fs::file_size(fs::u8path(normalized), ec);
+        if (ec) {
+            LOG_ERROR("✗ Cannot offer " << normalized << " for download: " << ec.message());
+            return false;
+        }
+        live->second.writerDone = true;
+        m_workCv.notify_all();
+
+        JsonWriter writer;
+        writer.BeginObject()
+              .Field("transferId", transferId)
+              .Field("fileName", live->second.fileName)
+              .Field("size", size)
+              .EndObject();
+        description = writer.ToString();
+        return true;
+    }
+
+    Download download;
+    download.path = normalized;
+    download.fileName = fs::u8path(normalized).filename().u8string();
+    download.generation = ++m_generation;
+    download.size = fs::file_size(fs::u8path(normalized), ec);
+    if (ec) {
+        LOG_ERROR("✗ Cannot offer " << normalized << " for download: " << ec.message());
+        return false;
+    }
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("transferId", transferId)
+          .Field("fileName", download.fileName)
+          .Field("size", download.size)
+          .EndObject();
+    description = writer.ToString();
+
+    m_downloads[transferId] = std::move(download);
+    return true;
+}
+
+bool FileTransferManager::OfferLiveDownload(const std::string& transferId, const std::string& path, std::string& description)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string normalized = fs::u8path(path).lexically_normal().u8string();
+    if (m_directory.empty() || normalized.compare(0, m_directory.size(), m_directory) != 0) {
+        return false;
+    }
+
+    // Left by an earlier run of the job: it must not be streamed as the new one
+    std::error_code ec;
+    fs::remove(fs::u8path(normalized), ec);
+
+    Download download;
+    download.path = normalized;
+    download.fileName = fs::u8path(normalized).filename().u8string();
+    download.live = true;
+    download.generation = ++m_generation;
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("transferId", transferId)
+          .Field("fileName", download.fileName)
+          .Field("size", 0)
+          .Field("live", true)
+          .EndObject();
+    description = writer.ToString();
+
+    m_downloads[transferId] = std::move(download);
+    StartWorkerLocked();
+    m_workCv.notify_all();
+    return true;
+}
+
+void FileTransferManager::WithdrawDownload(const std::string& transferId, const std::string& reason)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_downloads.find(transferId);
+    if (it == m_downloads.end()) {
+        return;
+    }
+
+    if (it->second.sessionId != 0) {
+        SendError(it->second.sessionId, transferId, reason);
+    }
+    it->second.file.reset();
+    RemoveDownloadFileLocked(it->second);
+    m_downloads.erase(it);
+}
+
+void FileTransferManager::QueueTaskLocked(std::function<void()> task)
+{
+    m_tasks.push_back(std::move(task));
+    StartWorkerLocked();
+    m_workCv.notify_all();
+}
+
+void FileTransferManager::StartWorkerLocked()
+{
+    if (!m_worker.joinable()) {
+        m_worker = std::thread(&FileTransferManager::WorkerLoop, this);
+    }
+}
+
+namespace {
+
+// Worker-side state of one live output; only the worker thread uses it
+struct LiveScan {
+    uint64_t generation = 0;
+    uint64_t scanned = 0;           // Bytes read and hashed so far
+    uint64_t lastBoundary = 0;      // End of the last complete entity
+    uint64_t lastCut = 0;           // Last boundary handed out as a chunk cut
+    bool inString = false;          // Inside a '...' STEP string ('' toggles twice)
+    bool restarted = false;         // The file was rewritten from the start
+    bool missing = false;           // The file does not exist (yet)
+    std::vector<uint64_t> cuts;     // New cuts, not yet published
+    Sha256 hash;
+};
+
+// Reads what was appended to a live output since the last call. Entities
+// end at a ';' outside a string; cuts are the last boundary before each
+// chunk-sized step, so that chunks hold whole entities
+// @return true once every byte currently in the file has been read
+bool ScanLiveOutput(const std::string& path, LiveScan& scan, std::vector<char>& buffer)
+{
+    std::error_code ec;
+    uint64_t size = fs::file_size(fs::u8path(path), ec);
+    scan.missing = static_cast<bool>(ec);
+    if (ec) {
+        return false;
+    }
+
+    if (size < scan.scanned) {
+        uint64_t generation = scan.generation;
+        scan = LiveScan();
+        scan.generation = generation;
+        scan.restarted = true;
+    }
+    if (size == scan.scanned) {
+        return true;
+    }
+
+    std::ifstream file(fs::u8path(path), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.seekg(static_cast<std::streamoff>(scan.scanned));
+
+    while (scan.scanned < size) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), size - scan.scanned));
+        file.read(buffer.data(), static_cast<std::streamsize>(length));
+        size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0) {
+            break;
+        }
+
+        scan.hash.Update(buffer.data(), got);
+        for (size_t i = 0; i < got; ++i) {
+            if (buffer[i] == '\'') {
+                scan.inString = !scan.inString;
+            } else if (buffer[i] == ';' && !scan.inString) {
+                uint64_t boundary = scan.scanned + i + 1;
+                if (boundary - scan.lastCut > kChunkSize) {
+                    // An entity larger than a chunk is cut after it
+                    scan.lastCut = scan.lastBoundary > scan.lastCut ? scan.lastBoundary : boundary;
+                    scan.cuts.push_back(scan.lastCut);
+                }
+                scan.lastBoundary = boundary;
+            }
+        }
+        scan.scanned += got;
+
+        if (got < length) {
+            break;
+        }
+    }
+    return scan.scanned == size;
+}
+
+} // namespace
+
+void FileTransferManager::WorkerLoop()
+{
+    struct Target {
+        std::string transferId;
+        std::string path;
+        uint64_t generation;
+        bool writerDone;
+    };
+
+    std::map<std::string, LiveScan> scans;
+    std::vector<char> buffer(kWorkerReadBytes);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        // Hashing first: a client waits for the reply
+        if (!m_tasks.empty()) {
+            std::function<void()> task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+            continue;
+        }
+
+        std::vector<Target> targets;
+        for (const auto& entry : m_downloads) {
+            if (entry.second.live) {
+                targets.push_back({ entry.first, entry.second.path, entry.second.generation, entry.second.writerDone });
+            }
+        }
+        if (targets.empty()) {
+            scans.clear();
+            m_workCv.wait(lock);
+            continue;
+        }
+
+        // The files are read without the lock: commands and acks go on meanwhile
+        lock.unlock();
+        std::map<std::string, LiveScan> current;
+        std::vector<bool> complete;
+        for (const Target& target : targets) {
+            LiveScan& scan = current[target.transferId];
+            auto previous = scans.find(target.transferId);
+            if (previous != scans.end() && previous->second.generation == target.generation) {
+                scan = std::move(previous->second);
+            } else {
+                scan.generation = target.generation;
+            }
+            // writerDone was read before the file: nothing is appended after it
+            complete.push_back(ScanLiveOutput(target.path, scan, buffer) && target.writerDone);
+        }
+        scans.swap(current);
+        lock.lock();
+
+        for (size_t i = 0; i < targets.size(); ++i) {
+            const Target& target = targets[i];
+            auto it = m_downloads.find(target.transferId);
+            if (it == m_downloads.end() || !it->second.live || it->second.generation != target.generation) {
+                continue;
+            }
+
+            LiveScan& scan = scans[target.transferId];
+            Download& download = it->second;
+            if (scan.restarted) {
+                scan.restarted = false;
+                download.cuts.clear();
+                download.size = 0;
+                if (download.sessionId != 0 && download.sent > 0) {
+                    SendError(download.sessionId, target.transferId, "Output was rewritten while streaming; download it again");
+                    download.file.reset();
+                    download.sessionId = 0;
+                }
+                download.sent = 0;
+                download.acked = 0;
+            }
+            download.cuts.insert(download.cuts.end(), scan.cuts.begin(), scan.cuts.end());
+            scan.cuts.clear();
+
+            if (target.writerDone && scan.missing) {
+                LOG_ERROR("✗ Live output " << download.path << " was never written");
+                if (download.sessionId != 0) {
+                    SendError(download.sessionId, target.transferId, "Output was not written");
+                }
+                m_downloads.erase(it);
+                scans.erase(target.transferId);
+                continue;
+            }
+
+            if (complete[i]) {
+                if (scan.lastBoundary > scan.lastCut) {
+                    download.cuts.push_back(scan.lastBoundary);
+                }
+                download.size = scan.scanned;
+                download.sha256 = scan.hash.FinalHex();
+                download.live = false;
+                scans.erase(target.transferId);
+                LOG_INFO("✓ Live output " << target.transferId << " written (" << download.size << " bytes)");
+            } else {
+                download.size = scan.lastCut;
+            }
+            ContinueDownloadLocked(it);
+        }
+
+        m_workCv.wait_for(lock, std::chrono::milliseconds(kFollowPollMs), [this] { return m_stopping || !m_tasks.empty(); });
+    }
+}
+
+void FileTransferManager::SweepExpiredLocked()
+{
+    if (m_ttlHours <= 0 || m_directory.empty()) {
+        return;
+    }
+
+    auto cutoff = fs::file_time_type::clock::now() - std::chrono::hours(m_ttlHours);
+
+    std::error_code ec;
+    std::vector<fs::path> expired;
+    for (fs::directory_iterator it(fs::u8path(m_directory), ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory(ec)) {
+            continue;
+        }
+
+        // A transfer is as old as the newest file in it
+        fs::file_time_type newest = it->last_write_time(ec);
+        for (fs::recursive_directory_iterator file(it->path(), ec), last; !ec && file != last; file.increment(ec)) {
+            fs::file_time_type time = file->last_write_time(ec);
+            if (!ec && time > newest) {
+                newest = time;
+            }
+        }
+        if (newest < cutoff) {
+            expired.push_back(it->path());
+        }
+    }
+
+    for (const fs::path& dir : expired) {
+        std::string prefix = dir.u8string();
+        bool inUse = false;
+        for (const auto& entry : m_uploads) {
+            inUse = inUse || entry.second.finalPath.compare(0, prefix.size(), prefix) == 0;
+        }
+        for (const auto& entry : m_downloads) {
+            inUse = inUse || entry.second.path.compare(0, prefix.size(), prefix) == 0;
+        }
+        if (!inUse) {
+            fs::remove_all(dir, ec);
+            LOG_INFO("Removed expired transfer " << prefix);
+        }
+    }
+}
+
+std::string FileTransferManager::TransferDirLocked(const std::string& transferId) const
+{
+    // Sanitizing can map different ids to one name; the hash keeps them apart
+    std::string name = SanitizeName(transferId) + "-" + Sha256::HashString(transferId).substr(0, 8);
+    return (fs::u8path(m_directory) / fs::u8path(name)).u8string();
+}
+
+void FileTransferManager::SendText(uint64_t sessionId, JsonPayload payload)
+{
+    if (m_sendText && sessionId != 0) {
+        m_sendText(sessionId, std::move(payload));
+    }
+}
+
+void FileTransferManager::SendError(uint64_t sessionId, const std::string& transferId, const std::string& error)
+{
+    LOG_WARN("Transfer " << transferId << ": " << error);
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "transfer_error")
+          .Field("transferId", transferId)
+          .Field("error", error)
+          .EndObject();
+    SendText(sessionId, writer.ToPayload());
+}
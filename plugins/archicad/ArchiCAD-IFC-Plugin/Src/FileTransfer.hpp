@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILE_TRANSFER_HPP
+#define FILE_TRANSFER_HPP
+
+#include "WebSocketCommand.hpp"
+#include "JsonWriter.hpp"
+#include "FileHash.hpp"
+
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief First byte of a binary file-chunk frame
+ *
+ * Chunk frame layout (both directions):
+ *   [0x01][L: 1 byte][transferId: L bytes][offset: 8 bytes, big-endian][data]
+ *
+ * CBOR messages always start with a map head (0xA0-0xBF), so a client that
+ * negotiated CBOR can tell the two apart by the first byte.
+ */
+const uint8_t kChunkFrameMarker = 0x01;
+
+/**
+ * @brief Build a chunk frame
+ */
+std::string MakeChunkFrame(const std::string& transferId, uint64_t offset, const char* data, size_t length);
+
+/**
+ * @brief Split a chunk frame into its parts
+ * @return false if the frame is malformed
+ */
+bool ParseChunkFrame(const std::string& frame, std::string& transferId, uint64_t& offset,
+                     const char*& data, size_t& length);
+
+/**
+ * @brief Chunked file upload and download over the WebSocket
+ *
+ * Lets the backend run on another machine than Archicad: inputs are
+ * uploaded into a local staging directory and outputs are streamed back,
+ * one chunk at a time, so no file is ever held in memory whole.
+ *
+ * Uploads: upload_begin announces the file (name, size, optional sha256)
+ * and is answered with the offset to start from, so an interrupted upload
+ * resumes where it stopped. Each chunk is acknowledged once written; the
+ * client keeps at most "window" bytes unacknowledged. The upload is checked
+ * against its sha256 when the last byte arrives; chunks are hashed as they
+ * are written.
+ *
+ * Downloads: finished outputs are offered under a transfer id (the job id).
+ * download starts (or resumes, from an offset) a transfer; the server
+ * keeps at most "window" unacknowledged bytes in flight and the client
+ * acknowledges with download_ack. Staged outputs are deleted after the last
+ * byte has been acknowledged; uploads stay until cancel_transfer releases
+ * them or they expire.
+ *
+ * Live downloads: an IFC output can be offered before the export starts.
+ * The worker thread reads the file as Archicad writes it and only makes
+ * complete STEP entities available, so every chunk frame ends on an entity
+ * boundary; size and sha256 are final once the export is done.
+ *
+ * Whole files (downloads, resumed or left-over uploads) are hashed on the
+ * worker thread too, never on the command thread under the lock: the
+ * reply follows once the digest is known.
+ *
+ * Thread-safe; no Archicad API use.
+ */
+class FileTransferManager {
+public:
+    using TextSender = std::function<void(uint64_t sessionId, JsonPayload payload)>;
+    using BinarySender = std::function<void(uint64_t sessionId, JsonPayload frame)>;
+
+    FileTransferManager();
+    ~FileTransferManager();
+
+    /**
+     * @brief Enable transfers
+     * @param directory UTF-8 staging directory, created if missing
+     * @param maxFileBytes Largest upload accepted
+     * @param ttlHours Staged files untouched for longer are deleted (0 keeps them)
+     * @return false if the directory is unusable
+     */
+    bool Open(const std::string& directory, uint64_t maxFileBytes, int ttlHours);
+
+    bool IsEnabled() const;
+
+    /**
+     * @brief Set how replies and chunk frames reach a session
+     */
+    void SetSenders(TextSender sendText, BinarySender sendBinary);
+
+    /**
+     * @brief Handle upload_begin, download, download_ack or cancel_transfer
+     */
+    void HandleCommand(const WebSocketCommand& command);
+
+    /**
+     * @brief Handle a binary frame from a session
+     */
+    void HandleChunk(uint64_t sessionId, const std::string& frame);
+
+    /**
+     * @brief Forget a lost session's downloads (they can be resumed later)
+     */
+    void SessionClosed(uint64_t sessionId);
+
+    /**
+     * @brief Path of a completed upload
+     * @param fileName Receives the uploaded file's name
+     * @return false (with error set) if there is no such completed upload
+     */
+    bool GetUpload(const std::string& transferId, std::string& path, std::string& fileName, std::string& error) const;
+
+    /**
+     * @brief Staging path for a job output that will be streamed back
+     * @return "" if transfers are disabled or the directory cannot be created
+     */
+    std::string PrepareOutput(const std::string& transferId, const std::string& fileName);
+
+    /**
+     * @brief Offer a finished file for download
+     * @param transferId Id the client downloads it by (usually the job id)
+     * @param path UTF-8 path of the file
+     * @param description Receives {"transferId","fileName","size"} as JSON
+     * @return false if the file is not in the staging directory or unreadable
+     *
+     * Cheap enough for the main thread: the file is hashed on the worker
+     * thread when the download starts.
+     */
+    bool OfferDownload(const std::string& transferId, const std::string& path, std::string& description);
+
+    /**
+     * @brief Offer an IFC output for download while it is still being written
+     * @param transferId Id the client downloads it by (the job id)
+     * @param path UTF-8 path the export will write, in the staging directory
+     * @param description Receives {"transferId","fileName","size":0,"live":true} as JSON
+     * @return false if the path is not in the staging directory
+     *
+     * A file already at the path is removed first. OfferDownload() on the
+     * same path marks the export finished; WithdrawDownload() drops it.
+     */
+    bool OfferLiveDownload(const std::string& transferId, const std::string& path, std::string& description);
+
+    /**
+     * @brief Drop an offered download whose job failed, deleting the file
+     * @param reason Sent as a transfer_error to a client downloading it
+     */
+    void WithdrawDownload(const std::string& transferId, const std::string& reason);
+
+private:
+    struct Upload {
+        std::string fileName;
+        std::string partPath;       // Written while incomplete
+        std::string finalPath;      // Renamed to once verified
+        std::string sha256;         // Expected digest, "" if not given
+        uint64_t size = 0;
+        uint64_t received = 0;
+        bool complete = false;
+        std::unique_ptr<std::ofstream> file;
+        Sha256 hash;                // Of the first `hashed` bytes, fed as chunks arrive
+        uint64_t hashed = 0;
+        std::string digest;         // Of the complete file, "" until known
+        bool verifying = false;     // The worker hashes what is already on disk
+        uint64_t sessionId = 0;     // Answered once the worker is done
+        uint64_t generation = 0;    // Tells a restarted upload from the old one
+    };
+
+    struct Download {
+        std::string path;
+        std::string fileName;
+        std::string sha256;         // Computed when first downloaded
+        uint64_t size = 0;
+        uint64_t sessionId = 0;     // 0 while nobody is downloading
+        uint64_t sent = 0;          // Next offset to send
+        uint64_t acked = 0;         // Bytes the client confirmed
+        std::unique_ptr<std::ifstream> file;
+        bool hashing = false;       // The worker computes sha256; download_begin waits
+        bool live = false;          // Still being written: size is the last entity boundary
+        bool writerDone = false;    // Live: the export finished, the worker scans the rest
+        uint64_t generation = 0;    // Tells a re-offered output from the old one
+        std::vector<uint64_t> cuts; // Live: entity boundaries chunks are cut at, ascending
+    };
+
+    void BeginUploadLocked(const WebSocketCommand& command);
+    void BeginDownloadLocked(const WebSocketCommand& command);
+    void AckDownloadLocked(const WebSocketCommand& command);
+    void CancelLocked(const WebSocketCommand& command);
+    void ContinueUploadLocked(const std::string& transferId, Upload& upload, uint64_t sessionId);
+    void FinishUploadLocked(const std::string& transferId, Upload& upload, uint64_t sessionId);
+    void QueueUploadHashLocked(const std::string& transferId, const Upload& upload);
+    void StartDownloadLocked(std::map<std::string, Download>::iterator it);
+    void PumpLocked(const std::string& transferId, Download& download);
+    void ContinueDownloadLocked(std::map<std::string, Download>::iterator it);
+    void RemoveDownloadFileLocked(const Download& download);
+    void QueueTaskLocked(std::function<void()> task);
+    void StartWorkerLocked();
+    void WorkerLoop();
+    void SweepExpiredLocked();
+    std::string TransferDirLocked(const std::string& transferId) const;
+
+    void SendText(uint64_t sessionId, JsonPayload payload);
+    void SendError(uint64_t sessionId, const std::string& transferId, const std::string& error);
+
+    mutable std::mutex m_mutex;
+    std::string m_directory;
+    uint64_t m_maxFileBytes;
+    int m_ttlHours;
+    std::map<std::string, Upload> m_uploads;
+    std::map<std::string, Download> m_downloads;
+    TextSender m_sendText;
+    BinarySender m_sendBinary;
+
+    // Hashing and live-output following, off the command thread
+    std::thread m_worker;
+    std::condition_variable m_workCv;
+    std::deque<std::function<void()>> m_tasks;    // Run without the lock
+    bool m_stopping;
+    uint64_t m_generation;
+};
+
+#endif // FILE_TRANSFER_HPP
@@ -25,6 +25,7 @@ void ExportProjectAsIFC ();
 #ifdef WEBSOCKET_ENABLED
 void StartWebSocketServer ();
 void StopWebSocketServer ();
+void AutoStartWebSocketServer ();
 #endif
 
 #endif
@@ -28,181 +28,563 @@
 #include "ConversionHandler.hpp"
 #include "ConversionCommand.hpp"
 #include "ProgressWindow.hpp"
+#include "MainThreadChannel.hpp"
+#include "WorkerRegistration.hpp"
+#include "ArtifactProcessor.hpp"
+#include "IfcPreflight.hpp"
+#include "TranslatorCache.hpp"
+#include "ProcessStats.hpp"
+#include "Logger.hpp"
 #include <memory>
-#include <iostream>
-#include <Windows.h>
+#include <map>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <atomic>
 
-// Helper para debug que aparece no Visual Studio
-static void DebugLog(const std::string& message) {
-    std::stringstream ss;
-    ss << "[ARCHICAD] " << message << "\n";
-    OutputDebugStringA(ss.str().c_str());
-    std::cout << ss.str();  // Também manda para cout
-}
-
-// Helper para escapar strings para JSON (converte \ em \\)
-static std::string EscapeJsonString(const std::string& str) {
-    std::string escaped;
-    for (char c : str) {
-        if (c == '\\') {
-            escaped += "\\\\";
-        } else if (c == '"') {
-            escaped += "\\\"";
-        } else {
-            escaped += c;
+// Global WebSocket server instance
+static std::unique_ptr<ArchicadWebSocketServer> g_wsServer;
+
+// Announces this instance to a worker coordinator (ARCHICAD_COORDINATOR_URL)
+static std::unique_ptr<WorkerRegistration> g_workerRegistration;
+
+// Hashes/compresses finished outputs off the main thread
+static std::unique_ptr<ArtifactProcessor> g_artifactProcessor;
+
+// Checks IFC inputs before they are queued (ARCHICAD_IFC_PREFLIGHT=0 disables it)
+static std::unique_ptr<IfcPreflightWorker> g_ifcPreflight;
+static bool g_ifcPreflightEnabled = true;
+
+// Archicad version reported by CheckEnvironment, advertised to the coordinator
+static std::string g_archicadVersion;
+
+// Settings from the ARCHICAD_PLUGIN_CONFIG file, used where the environment
+// does not set them
+static std::map<std::string, std::string> g_pluginConfig;
+static std::string g_pluginConfigError;
+
+// Headless workers (ARCHICAD_PLUGIN_HEADLESS=1) never open a dialog
+static bool g_headless = false;
+
+// Set once Archicad's event loop runs jobs posted to the main thread
+static std::atomic<bool> g_workerReady(false);
+
+// Helper to read a string setting: the environment first, then the config file
+static std::string GetEnvString(const char* name)
+{
+    const char* value = std::getenv(name);
+    if (value != nullptr) {
+        return std::string(value);
+    }
+
+    auto it = g_pluginConfig.find(name);
+    return it != g_pluginConfig.end() ? it->second : std::string();
+}
+
+// Helper to read an integer setting
+static int GetEnvInt(const char* name, int defaultValue)
+{
+    std::string value = GetEnvString(name);
+    if (value.empty()) {
+        return defaultValue;
+    }
+
+    try {
+        return std::stoi(value);
+    } catch (...) {
+        return defaultValue;
+    }
+}
+
+// Load ARCHICAD_PLUGIN_CONFIG, a JSON object whose members are named like the
+// environment variables: { "ARCHICAD_PLUGIN_AUTOSTART": 1, "ARCHICAD_PLUGIN_WS_PORT": 8090 }.
+// Runs before the logger exists, so problems are kept for StartLogger to report.
+static void LoadPluginConfig()
+{
+    g_pluginConfig.clear();
+    g_pluginConfigError.clear();
+
+    const char* path = std::getenv("ARCHICAD_PLUGIN_CONFIG");
+    if (path == nullptr || *path == '\0') {
+        return;
+    }
+
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file) {
+        g_pluginConfigError = std::string("cannot read ") + path;
+        return;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+
+    JsonValue config;
+    std::string error;
+    if (!JsonParser::Parse(text.str(), config, error) || !config.IsObject()) {
+        g_pluginConfigError = std::string(path) + ": " + (error.empty() ? "not a JSON object" : error);
+        return;
+    }
+
+    for (size_t i = 0; i < config.Size(); ++i) {
+        const JsonValue& value = config.At(i);
+        if (value.IsString()) {
+            g_pluginConfig[config.KeyAt(i)] = value.AsString();
+        } else if (value.IsBool()) {
+            g_pluginConfig[config.KeyAt(i)] = value.AsBool() ? "1" : "0";
+        } else if (value.IsInteger()) {
+            g_pluginConfig[config.KeyAt(i)] = std::to_string(value.AsInt());
+        } else if (value.IsNumber()) {
+            g_pluginConfig[config.KeyAt(i)] = std::to_string(value.AsNumber());
         }
     }
-    return escaped;
 }
 
-// Global WebSocket server instance
-static std::unique_ptr<ArchicadWebSocketServer> g_wsServer;
+// Headless workers come up on their own (ARCHICAD_PLUGIN_AUTOSTART defaults to it)
+static bool IsAutoStartEnabled()
+{
+    return GetEnvInt("ARCHICAD_PLUGIN_AUTOSTART", g_headless ? 1 : 0) != 0;
+}
 
+// Configure the logger from ARCHICAD_LOG_* (level, rotating file, payload limit)
+static void StartLogger()
+{
+    LoggerConfig config;
+    std::string levelName = GetEnvString("ARCHICAD_LOG_LEVEL");
+    bool knownLevel = levelName.empty() || LogLevelFromString(levelName, config.level);
+
+    config.filePath = GetEnvString("ARCHICAD_LOG_FILE");
+    int fileMegabytes = GetEnvInt("ARCHICAD_LOG_FILE_MB", 10);
+    config.maxFileBytes = fileMegabytes > 0 ? static_cast<uint64_t>(fileMegabytes) << 20 : config.maxFileBytes;
+    config.maxFiles = GetEnvInt("ARCHICAD_LOG_FILES", 5);
+    int payloadLimit = GetEnvInt("ARCHICAD_LOG_PAYLOAD_LIMIT", 512);
+    config.payloadLimit = payloadLimit > 0 ? static_cast<size_t>(payloadLimit) : config.payloadLimit;
+
+    Logger::Start(config);
+    if (!knownLevel) {
+        LOG_WARN("Unknown ARCHICAD_LOG_LEVEL '" << levelName << "', using info");
+    }
+    if (!g_pluginConfigError.empty()) {
+        LOG_WARN("Ignoring plugin config file: " << g_pluginConfigError);
+    } else if (!g_pluginConfig.empty()) {
+        LOG_INFO("✓ Plugin config loaded (" << g_pluginConfig.size() << " settings)");
+    }
+}
 
-// Implementação do comando de conversão
-GS::ObjectState ConversionCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+// Configure the job order from ARCHICAD_SCHEDULING (fifo, sjf, fair),
+// ARCHICAD_SCHEDULING_AGING and ARCHICAD_TENANT_WEIGHTS ("tenant:weight,...")
+static void ConfigureScheduling()
 {
-    DebugLog("[MAIN THREAD] ========================================");
-    DebugLog("[MAIN THREAD] ConversionCommand::Execute() called!!!");
-    DebugLog("[MAIN THREAD] ========================================");
+    // Submission order unless a deployment opts into sjf or fair
+    SchedulingPolicy policy = SchedulingPolicy::Fifo;
+    std::string policyName = GetEnvString("ARCHICAD_SCHEDULING");
+    if (!policyName.empty() && !SchedulingPolicyFromString(policyName, policy)) {
+        LOG_WARN("Unknown ARCHICAD_SCHEDULING '" << policyName << "', using fifo");
+    }
 
-    // Extrai os parâmetros recebidos
-    GS::UniString jobId, plnPath, outputPath;
-    parameters.Get("jobId", jobId);
-    parameters.Get("plnPath", plnPath);
-    parameters.Get("outputPath", outputPath);
+    double aging = 1.0;
+    std::string agingText = GetEnvString("ARCHICAD_SCHEDULING_AGING");
+    if (!agingText.empty()) {
+        try {
+            aging = std::stod(agingText);
+        } catch (...) {
+            LOG_WARN("Invalid ARCHICAD_SCHEDULING_AGING '" << agingText << "', using 1");
+        }
+    }
+
+    std::map<std::string, double> weights;
+    std::string weightList = GetEnvString("ARCHICAD_TENANT_WEIGHTS");
+    size_t start = 0;
+    while (start < weightList.size()) {
+        size_t comma = weightList.find(',', start);
+        std::string entry = weightList.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t colon = entry.rfind(':');
+        if (colon != std::string::npos) {
+            try {
+                weights[entry.substr(0, colon)] = std::stod(entry.substr(colon + 1));
+            } catch (...) {
+                LOG_WARN("Invalid ARCHICAD_TENANT_WEIGHTS entry '" << entry << "'");
+            }
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+
+    ConversionHandler::ConfigureScheduling(policy, aging, weights);
+}
+
+// Configure input staging from ARCHICAD_STAGE_INPUTS (never, remote, always),
+// ARCHICAD_STAGING_DIR, ARCHICAD_STAGING_THREADS and ARCHICAD_PREFETCH_DEPTH
+static void ConfigureStaging()
+{
+    StagingOptions options;
+    std::string mode = GetEnvString("ARCHICAD_STAGE_INPUTS");
+    if (mode == "never" || mode == "0") {
+        options.mode = StagingMode::Never;
+    } else if (mode == "always") {
+        options.mode = StagingMode::Always;
+    } else if (!mode.empty() && mode != "remote" && mode != "1") {
+        LOG_WARN("Unknown ARCHICAD_STAGE_INPUTS '" << mode << "', using remote");
+    }
 
-    DebugLog("[MAIN THREAD] Converting: " + std::string(plnPath.ToCStr().Get()) + " -> " + std::string(outputPath.ToCStr().Get()));
+    options.directory = GetEnvString("ARCHICAD_STAGING_DIR");
+    options.threads = static_cast<size_t>(std::min(std::max(GetEnvInt("ARCHICAD_STAGING_THREADS", 2), 1), 16));
+    options.prefetchDepth = static_cast<size_t>(std::max(GetEnvInt("ARCHICAD_PREFETCH_DEPTH", 2), 0));
+
+    ConversionHandler::ConfigureStaging(options);
+}
+
+// Current worker state, as advertised to the coordinator
+static WorkerInfo GetWorkerInfo()
+{
+    WorkerInfo info;
+    info.workerId = GetEnvString("ARCHICAD_WORKER_ID");
+    info.host = GetEnvString("ARCHICAD_WORKER_HOST");
+    info.port = g_wsServer ? g_wsServer->GetPort() : 0;
+    info.capacity = 1;  // Archicad holds a single project at a time
+    info.archicadVersion = g_archicadVersion;
+    info.running = ConversionHandler::HasRunningJob() ? 1 : 0;
+    info.queued = ConversionHandler::GetQueueDepth();
+    info.recycle = ConversionHandler::GetMemoryPolicy().IsRecycleRequested();
+    if (info.recycle) {
+        info.recycleReason = ConversionHandler::GetMemoryPolicy().GetRecycleReason();
+    }
+    return info;
+}
+
+// Greeting a backend gets on connect ("hello"), on request, and once the
+// worker becomes ready ("ready"): what this instance can do and how busy it is
+static std::string FormatHello(const char* type)
+{
+    WorkerInfo info = GetWorkerInfo();
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", type)
+          .Field("protocol", 1)
+          .Field("workerId", info.workerId)
+          .Field("port", info.port)
+          .Field("archicadVersion", info.archicadVersion)
+          .Field("ready", g_workerReady.load())
+          .Field("headless", g_headless)
+          .Field("capacity", info.capacity)
+          .Field("running", info.running)
+          .Field("queued", info.queued)
+          .Field("queueDepth", info.queued)
+          .Field("recycle", info.recycle);
+
+    writer.Key("capabilities").BeginArray();
+    for (const char* capability : { "pln_to_ifc", "ifc_to_pln", "load_ifc", "batch", "exports",
+                                    "filter", "checksum", "ifczip", "subscribe", "metrics", "benchmark", "resume" }) {
+        writer.String(capability);
+    }
+    if (g_ifcPreflightEnabled) {
+        writer.String("preflight");
+    }
+    if (g_wsServer && g_wsServer->GetTransfers().IsEnabled()) {
+        writer.String("transfer");
+        writer.String("live_output");
+    }
+    writer.EndArray();
+
+    writer.EndObject();
+    return writer.ToString();
+}
+
+
+// Sends the completion of a post-processed output (on the artifact worker thread)
+static void ReportArtifact(const std::string& jobId, JobType type, const std::string& outputPath,
+                           const std::string& timings, const std::string& memory, const ArtifactResult& result)
+{
+    ConversionHandler::GetMetrics().RecordSample(type, JobStage::PostProcess, result.durationMs);
+
+    if (g_wsServer) {
+        // A staged output is offered as the IFCZIP when there is one
+        std::string download;
+        g_wsServer->GetTransfers().OfferDownload(
+            jobId, result.compressedPath.empty() ? outputPath : result.compressedPath, download);
+        g_wsServer->SendCompletion(jobId, outputPath, timings, download, result.ToJson(), memory);
+    }
+}
+
+// Reports a finished conversion via WebSocket and releases its queue slot
+static void ReportJobOutcome(const std::string& jobId, JobType type, const std::string& outputPath, bool success,
+                             const ArtifactOptions& artifact, const std::string& error = std::string())
+{
+    JobState finalState = JobState::Done;
+    if (!success) {
+        finalState = ConversionHandler::IsCancelRequested(jobId) ? JobState::Cancelled : JobState::Failed;
+    }
+
+    // The job's project is closed by now; its memory goes out with the completion
+    JobMemory jobMemory = ConversionHandler::GetMemoryPolicy().JobFinished(jobId);
+    std::string memory = jobMemory.valid ? jobMemory.ToJson() : std::string();
+
+    // Post-processing runs on its own thread: release the queue slot first so
+    // the main thread can go on with the next job, then send the completion
+    // once the output is hashed/compressed
+    if (finalState == JobState::Done && artifact.Any() && g_artifactProcessor) {
+        std::string timings = ConversionHandler::GetMetrics().FormatJobTimings(jobId);
+        ConversionHandler::FinishJob(jobId, finalState);
+
+        bool submitted = g_artifactProcessor->Submit(outputPath, artifact,
+            [jobId, type, outputPath, timings, memory](const ArtifactResult& result) {
+                ReportArtifact(jobId, type, outputPath, timings, memory, result);
+            });
+        if (!submitted && g_wsServer) {
+            std::string download;
+            g_wsServer->GetTransfers().OfferDownload(jobId, outputPath, download);
+            g_wsServer->SendCompletion(jobId, outputPath, timings, download, std::string(), memory);
+        }
+        return;
+    }
+
+    if (g_wsServer) {
+        switch (finalState) {
+            case JobState::Done: {
+                // Outputs written to the transfer staging area can be downloaded
+                std::string download;
+                g_wsServer->GetTransfers().OfferDownload(jobId, outputPath, download);
+                g_wsServer->SendCompletion(jobId, outputPath, ConversionHandler::GetMetrics().FormatJobTimings(jobId),
+                                           download, std::string(), memory);
+                break;
+            }
+            case JobState::Cancelled:
+                // A live output that was being downloaded goes with it
+                g_wsServer->GetTransfers().WithdrawDownload(jobId, "Conversion cancelled");
+                g_wsServer->SendProgress(jobId, 0, "cancelled", "Conversion cancelled");
+                break;
+            default:
+                g_wsServer->GetTransfers().WithdrawDownload(jobId, "Conversion failed");
+                g_wsServer->SendError(jobId, error.empty() ? "Conversion failed" : error);
+                break;
+        }
+    }
+
+    // Release the queue slot so the scheduler can dispatch the next job
+    ConversionHandler::FinishJob(jobId, finalState);
+}
+
+// Runs a PLN -> IFC job on the main thread and reports the result via WebSocket
+static bool RunPlnToIfcJob(const std::string& jobId, const std::string& plnPath, const std::string& outputPath,
+                           const std::string& translator, const ElementFilter& filter,
+                           const ArtifactOptions& artifact, bool liveOutput,
+                           GS::ProcessControl* processControl = nullptr)
+{
+    LOG_INFO("[MAIN THREAD] Converting: " << plnPath << " -> " << outputPath);
+
+    // The IFC cannot be exported to a pipe: the client follows the file
+    // instead, and can download (and validate) it while it is written
+    if (liveOutput && g_wsServer) {
+        std::string download;
+        if (g_wsServer->GetTransfers().OfferLiveDownload(jobId, outputPath, download)) {
+            g_wsServer->SendOutputStream(jobId, download);
+        }
+    }
 
     // Show progress window
     ProgressWindow::Show("PLN to IFC Conversion", "Starting conversion...");
-    ProgressWindow::SetJobId(jobId.ToCStr().Get());
+    ProgressWindow::SetJobId(jobId);
+
+    // Last stage error, sent with the job's error event
+    std::string error;
 
     // Chama a lógica de conversão
     bool success = ConversionHandler::ConvertPlnToIfc(
-        jobId.ToCStr().Get(),
-        plnPath.ToCStr().Get(),
-        outputPath.ToCStr().Get(),
-        [jobId](int progress, const std::string& message) {
+        jobId,
+        plnPath,
+        outputPath,
+        translator,
+        filter,
+        [jobId, &error](int progress, const std::string& message) {
             // Update progress window
             ProgressWindow::UpdateProgress(progress, message);
 
-            // Send WebSocket progress
+            // A stage never ends the job: the completion or error sent by
+            // ReportJobOutcome() is its final event, and must still reach
+            // the job's subscribers
+            if (progress == 0) {
+                error = message;
+            }
             if (g_wsServer) {
-                std::string status = (progress == 0) ? "error" : (progress == 100) ? "completed" : "processing";
-                g_wsServer->SendProgress(jobId.ToCStr().Get(), progress, status, message);
+                g_wsServer->SendStageProgress(jobId, progress, message);
             }
-        }
+        },
+        processControl
     );
 
     // Close progress window
     ProgressWindow::Close();
 
-    // Retorna resultado
-    GS::ObjectState result;
-    result.Add("success", success);
-    result.Add("jobId", jobId);
-
-    if (success && g_wsServer) {
-        g_wsServer->SendCompletion(jobId.ToCStr().Get(), outputPath.ToCStr().Get());
-    } else if (!success && g_wsServer) {
-        g_wsServer->SendError(jobId.ToCStr().Get(), "Conversion failed");
-    }
+    ReportJobOutcome(jobId, JobType::PlnToIfc, outputPath, success, artifact, error);
 
-    return result;
+    return success;
 }
 
-// Implementação do comando de conversão IFC -> PLN
-GS::ObjectState ConvertIfcToPlnCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+// Runs an IFC -> PLN job on the main thread and reports the result via WebSocket
+static bool RunIfcToPlnJob(const std::string& jobId, const std::string& ifcPath, const std::string& outputPath,
+                           const ArtifactOptions& artifact, GS::ProcessControl* processControl = nullptr)
 {
-    DebugLog("[MAIN THREAD] ========================================");
-    DebugLog("[MAIN THREAD] ConvertIfcToPlnCommand::Execute() called!!!");
-    DebugLog("[MAIN THREAD] ========================================");
-
-    // Extrai os parâmetros recebidos
-    GS::UniString jobId, ifcPath, outputPath;
-    parameters.Get("jobId", jobId);
-    parameters.Get("ifcPath", ifcPath);
-    parameters.Get("outputPath", outputPath);
-
-    DebugLog("[MAIN THREAD] Converting: " + std::string(ifcPath.ToCStr().Get()) + " -> " + std::string(outputPath.ToCStr().Get()));
+    LOG_INFO("[MAIN THREAD] Converting: " << ifcPath << " -> " << outputPath);
 
     // Show progress window
     ProgressWindow::Show("IFC to PLN Conversion", "Starting conversion...");
-    ProgressWindow::SetJobId(jobId.ToCStr().Get());
+    ProgressWindow::SetJobId(jobId);
+
+    // Last stage error, sent with the job's error event
+    std::string error;
 
     // Chama a lógica de conversão IFC -> PLN
     bool success = ConversionHandler::ConvertIfcToPln(
-        jobId.ToCStr().Get(),
-        ifcPath.ToCStr().Get(),
-        outputPath.ToCStr().Get(),
-        [jobId](int progress, const std::string& message) {
+        jobId,
+        ifcPath,
+        outputPath,
+        [jobId, &error](int progress, const std::string& message) {
             // Update progress window
             ProgressWindow::UpdateProgress(progress, message);
 
-            // Send WebSocket progress
+            // A stage never ends the job: the completion or error sent by
+            // ReportJobOutcome() is its final event, and must still reach
+            // the job's subscribers
+            if (progress == 0) {
+                error = message;
+            }
             if (g_wsServer) {
-                std::string status = (progress == 0) ? "error" : (progress == 100) ? "completed" : "processing";
-                g_wsServer->SendProgress(jobId.ToCStr().Get(), progress, status, message);
+                g_wsServer->SendStageProgress(jobId, progress, message);
             }
-        }
+        },
+        processControl
     );
 
     // Close progress window
     ProgressWindow::Close();
 
-    // Retorna resultado
-    GS::ObjectState result;
-    result.Add("success", success);
-    result.Add("jobId", jobId);
+    ReportJobOutcome(jobId, JobType::IfcToPln, outputPath, success, artifact, error);
+
+    return success;
+}
 
-    if (success && g_wsServer) {
-        g_wsServer->SendCompletion(jobId.ToCStr().Get(), outputPath.ToCStr().Get());
-    } else if (!success && g_wsServer) {
-        g_wsServer->SendError(jobId.ToCStr().Get(), "Conversion failed");
+// Runs a batch of conversions in one session and reports each item via WebSocket
+static bool RunBatchJob(const std::string& jobId, const std::vector<BatchItem>& items,
+                        std::vector<BatchItemReport>& reports, GS::ProcessControl* processControl = nullptr)
+{
+    LOG_INFO("[MAIN THREAD] Running batch " << jobId << " (" << items.size() << " items)");
+
+    ProgressWindow::Show("Batch Conversion", "Starting batch...");
+    ProgressWindow::SetJobId(jobId);
+
+    reports.assign(items.size(), BatchItemReport());
+    for (size_t i = 0; i < items.size(); ++i) {
+        reports[i].inputPath = items[i].sourcePath.empty() ? items[i].inputPath : items[i].sourcePath;
+        reports[i].outputPath = items[i].outputPath;
+        reports[i].translator = items[i].translator;
+        reports[i].status = JobStateToString(JobState::Queued);
     }
 
-    return result;
+    bool success = ConversionHandler::ConvertBatch(
+        jobId,
+        items,
+        [jobId, &reports](size_t index, const BatchItem& item, JobState state, const std::string& error) {
+            BatchItemReport& report = reports[index];
+            report.status = JobStateToString(state);
+            report.error = error;
+
+            if (g_wsServer) {
+                g_wsServer->SendBatchItem(jobId, index, reports.size(), report);
+            }
+        },
+        [jobId](int progress, const std::string& message) {
+            ProgressWindow::UpdateProgress(progress, message);
+
+            // The summary is the batch's final event
+            if (g_wsServer) {
+                g_wsServer->SendStageProgress(jobId, progress, message);
+            }
+        },
+        processControl
+    );
+
+    ProgressWindow::Close();
+
+    JobState finalState = JobState::Done;
+    if (!success) {
+        finalState = ConversionHandler::IsCancelRequested(jobId) ? JobState::Cancelled : JobState::Failed;
+    }
+
+    if (g_wsServer) {
+        g_wsServer->SendBatchSummary(jobId, JobStateToString(finalState), reports,
+                                     ConversionHandler::GetMetrics().FormatJobTimings(jobId));
+    }
+
+    // Release the queue slot so the scheduler can dispatch the next job
+    ConversionHandler::FinishJob(jobId, finalState);
+
+    return success;
 }
 
-// Implementação do comando simples de Load IFC - cópia exata do menu
-GS::ObjectState LoadIfcCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+// Pre-flight for Add-On commands, which are already on the main thread;
+// still far cheaper than letting Archicad fail on a broken file
+static bool PreflightOnMainThread(const std::string& jobId, const std::string& ifcPath, std::string& errorMsg)
 {
-    DebugLog("[MAIN THREAD] ========================================");
-    DebugLog("[MAIN THREAD] LoadIfcCommand::Execute() called!!!");
-    DebugLog("[MAIN THREAD] ========================================");
+    if (!g_ifcPreflightEnabled) {
+        return true;
+    }
 
-    // Extrai o caminho do IFC
-    GS::UniString jobId, ifcPath;
-    parameters.Get("jobId", jobId);
-    parameters.Get("ifcPath", ifcPath);
+    IfcPreflightReport report;
+    if (IfcPreflight::Scan(ifcPath, report)) {
+        return true;
+    }
+
+    errorMsg = "IFC pre-flight failed: " + report.error;
+    LOG_WARN("[MAIN THREAD] " << errorMsg << " (" << ifcPath << ")");
+    if (g_wsServer) {
+        g_wsServer->SendPreflight(jobId, false, report.ToJson());
+        g_wsServer->SendError(jobId, errorMsg);
+    }
+    return false;
+}
 
-    DebugLog("[MAIN THREAD] Loading IFC: " + std::string(ifcPath.ToCStr().Get()));
+// Loads an IFC file on the main thread - cópia exata do menu
+static bool RunLoadIfcJob(const std::string& jobId, const std::string& ifcPath, std::string& errorMsg)
+{
+    LOG_INFO("[MAIN THREAD] Loading IFC: " << ifcPath);
 
     bool success = false;
-    std::string errorMsg;
+
+    // Cancelled before it reached the main thread
+    if (ConversionHandler::IsCancelRequested(jobId)) {
+        if (g_wsServer) {
+            g_wsServer->SendProgress(jobId, 0, "cancelled", "Load cancelled");
+        }
+        ConversionHandler::FinishJob(jobId, JobState::Cancelled);
+        return false;
+    }
+
+    ConversionHandler::GetMetrics().JobStarted(jobId, JobType::LoadIfc);
 
     try {
         // Converter para IO::Location - exatamente como o menu faz
         IO::Location ifcFileLocation;
-        ifcFileLocation.Set(ifcPath);
+        ifcFileLocation.Set(GS::UniString(ifcPath.c_str()));
 
         // Log do caminho completo após conversão
-        DebugLog("[MAIN THREAD] Location set to: " + std::string(ifcFileLocation.ToDisplayText().ToCStr().Get()));
-        DebugLog("[MAIN THREAD] Location status: " + std::to_string(ifcFileLocation.GetStatus()));
+        LOG_DEBUG("[MAIN THREAD] Location set to: " << ifcFileLocation.ToDisplayText().ToCStr().Get());
+        LOG_DEBUG("[MAIN THREAD] Location status: " << ifcFileLocation.GetStatus());
 
         // Verificar se arquivo existe
         if (ifcFileLocation.GetStatus() != NoError) {
             errorMsg = "IFC file not found!";
-            DebugLog("[MAIN THREAD] " + errorMsg);
+            LOG_ERROR("[MAIN THREAD] " << errorMsg);
             goto load_error;
         }
 
         IO::File ifcFile(ifcFileLocation);
         if (ifcFile.GetStatus() != NoError) {
             errorMsg = "Cannot access IFC file. Please check if the file exists and you have permission to read it.";
-            DebugLog("[MAIN THREAD] " + errorMsg);
+            LOG_ERROR("[MAIN THREAD] " << errorMsg);
             goto load_error;
         }
 
@@ -215,38 +597,246 @@ GS::ObjectState LoadIfcCommand::Execute(const GS::ObjectState& parameters, GS::P
         openPars.libGiven = false;
         openPars.file = new IO::Location(ifcFileLocation);
 
-        DebugLog("[MAIN THREAD] Calling ACAPI_ProjectOperation_Open...");
+        // The loaded model belongs to the user from now on
+        ConversionHandler::DetachSession();
+
+        LOG_DEBUG("[MAIN THREAD] Calling ACAPI_ProjectOperation_Open...");
+        JobMetrics::Clock::time_point openStart = JobMetrics::Clock::now();
         GSErrCode err = ACAPI_ProjectOperation_Open(&openPars);
+        ConversionHandler::GetMetrics().Record(jobId, JobStage::Open, openStart);
         
         delete openPars.file;
 
         if (err != NoError) {
             errorMsg = "Error opening IFC file. Error code: " + std::to_string(err);
-            DebugLog("[MAIN THREAD] " + errorMsg);
+            LOG_ERROR("[MAIN THREAD] " << errorMsg);
             goto load_error;
         }
 
-        DebugLog("[MAIN THREAD] IFC file opened successfully!");
+        LOG_INFO("[MAIN THREAD] IFC file opened successfully!");
         success = true;
 
     } catch (const std::exception& e) {
         errorMsg = std::string("Exception: ") + e.what();
-        DebugLog("[MAIN THREAD] " + errorMsg);
+        LOG_ERROR("[MAIN THREAD] " << errorMsg);
     } catch (...) {
         errorMsg = "Unknown exception";
-        DebugLog("[MAIN THREAD] " + errorMsg);
+        LOG_ERROR("[MAIN THREAD] " << errorMsg);
     }
 
 load_error:
     // Enviar resultado via WebSocket
     if (g_wsServer) {
         if (success) {
-            g_wsServer->SendProgress(jobId.ToCStr().Get(), 100, "completed", "IFC file loaded successfully");
+            g_wsServer->SendProgress(jobId, 100, "completed", "IFC file loaded successfully");
         } else {
-            g_wsServer->SendError(jobId.ToCStr().Get(), errorMsg);
+            g_wsServer->SendError(jobId, errorMsg);
         }
     }
 
+    // Release the queue slot so the scheduler can dispatch the next job
+    ConversionHandler::FinishJob(jobId, success ? JobState::Done : JobState::Failed);
+
+    return success;
+}
+
+// Reads an optional "filter" object of Add-On command parameters:
+// { "storeys": [Int], "layers": [String], "elementTypes": [String], "guids": [String], "modifiedSince": Int }
+static void ReadFilterParameter(const GS::ObjectState& parameters, ElementFilter& filter)
+{
+    if (!parameters.Contains("filter")) {
+        return;
+    }
+
+    GS::ObjectState filterState;
+    parameters.Get("filter", filterState);
+
+    GS::Array<Int32> storeys;
+    filterState.Get("storeys", storeys);
+    for (Int32 storey : storeys) {
+        filter.storeys.push_back(storey);
+    }
+
+    auto readStrings = [&filterState](const char* key, std::vector<std::string>& out) {
+        GS::Array<GS::UniString> values;
+        filterState.Get(key, values);
+        for (const GS::UniString& value : values) {
+            out.push_back(value.ToCStr().Get());
+        }
+    };
+    readStrings("layers", filter.layers);
+    readStrings("elementTypes", filter.elementTypes);
+    readStrings("guids", filter.guids);
+
+    Int64 modifiedSince = 0;
+    filterState.Get("modifiedSince", modifiedSince);
+    filter.modifiedSince = modifiedSince > 0 ? static_cast<uint64_t>(modifiedSince) : 0;
+}
+
+// Implementação do comando de conversão
+GS::ObjectState ConversionCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+{
+    LOG_DEBUG("[MAIN THREAD] ConversionCommand::Execute() called");
+
+    // Extrai os parâmetros recebidos
+    GS::UniString jobId, plnPath, outputPath, translator;
+    parameters.Get("jobId", jobId);
+    parameters.Get("plnPath", plnPath);
+    parameters.Get("outputPath", outputPath);
+    parameters.Get("translator", translator);
+
+    ElementFilter filter;
+    ReadFilterParameter(parameters, filter);
+
+    GS::ObjectState result;
+    result.Add("jobId", jobId);
+
+    // Fan-out: "exports": [{ "translator": "...", "outputPath": "..." }, ...]
+    // opens the project once and saves once per translator
+    if (parameters.Contains("exports")) {
+        GS::Array<GS::ObjectState> exportStates;
+        parameters.Get("exports", exportStates);
+
+        std::vector<BatchItem> items;
+        for (const GS::ObjectState& exportState : exportStates) {
+            GS::UniString exportTranslator, exportPath;
+            exportState.Get("translator", exportTranslator);
+            exportState.Get("outputPath", exportPath);
+
+            BatchItem item;
+            item.type = JobType::PlnToIfc;
+            item.inputPath = plnPath.ToCStr().Get();
+            item.outputPath = exportPath.ToCStr().Get();
+            item.translator = exportTranslator.ToCStr().Get();
+            item.filter = filter;
+            ReadFilterParameter(exportState, item.filter);
+            items.push_back(item);
+        }
+
+        std::vector<BatchItemReport> reports;
+        bool success = RunBatchJob(jobId.ToCStr().Get(), items, reports, &processControl);
+
+        GS::Array<GS::ObjectState> exportResults;
+        for (const BatchItemReport& report : reports) {
+            GS::ObjectState exportResult;
+            exportResult.Add("outputPath", GS::UniString(report.outputPath.c_str()));
+            exportResult.Add("translator", GS::UniString(report.translator.c_str()));
+            exportResult.Add("status", GS::UniString(report.status.c_str()));
+            if (!report.error.empty()) {
+                exportResult.Add("error", GS::UniString(report.error.c_str()));
+            }
+            exportResults.Push(exportResult);
+        }
+
+        result.Add("success", success);
+        result.Add("exports", exportResults);
+        return result;
+    }
+
+    bool success = RunPlnToIfcJob(jobId.ToCStr().Get(), plnPath.ToCStr().Get(), outputPath.ToCStr().Get(),
+                                  translator.ToCStr().Get(), filter, ArtifactOptions(), false, &processControl);
+
+    // Retorna resultado
+    result.Add("success", success);
+
+    return result;
+}
+
+// Implementação do comando de conversão IFC -> PLN
+GS::ObjectState ConvertIfcToPlnCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+{
+    LOG_DEBUG("[MAIN THREAD] ConvertIfcToPlnCommand::Execute() called");
+
+    // Extrai os parâmetros recebidos
+    GS::UniString jobId, ifcPath, outputPath;
+    parameters.Get("jobId", jobId);
+    parameters.Get("ifcPath", ifcPath);
+    parameters.Get("outputPath", outputPath);
+
+    std::string errorMsg;
+    bool success = PreflightOnMainThread(jobId.ToCStr().Get(), ifcPath.ToCStr().Get(), errorMsg) &&
+                   RunIfcToPlnJob(jobId.ToCStr().Get(), ifcPath.ToCStr().Get(), outputPath.ToCStr().Get(),
+                                  ArtifactOptions(), &processControl);
+
+    // Retorna resultado
+    GS::ObjectState result;
+    result.Add("success", success);
+    result.Add("jobId", jobId);
+    if (!errorMsg.empty()) {
+        result.Add("error", GS::UniString(errorMsg.c_str()));
+    }
+
+    return result;
+}
+
+// Implementação do comando de conversão em lote
+GS::ObjectState ConvertBatchCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+{
+    LOG_DEBUG("[MAIN THREAD] ConvertBatchCommand::Execute() called");
+
+    // Extrai os parâmetros recebidos
+    GS::UniString jobId;
+    GS::Array<GS::ObjectState> itemStates;
+    parameters.Get("jobId", jobId);
+    parameters.Get("items", itemStates);
+
+    std::vector<BatchItem> items;
+    for (const GS::ObjectState& itemState : itemStates) {
+        GS::UniString plnPath, ifcPath, outputPath, translator;
+        itemState.Get("plnPath", plnPath);
+        itemState.Get("ifcPath", ifcPath);
+        itemState.Get("outputPath", outputPath);
+        itemState.Get("translator", translator);
+
+        BatchItem item;
+        item.type = plnPath.IsEmpty() ? JobType::IfcToPln : JobType::PlnToIfc;
+        item.inputPath = (plnPath.IsEmpty() ? ifcPath : plnPath).ToCStr().Get();
+        item.outputPath = outputPath.ToCStr().Get();
+        item.translator = translator.ToCStr().Get();
+        ReadFilterParameter(itemState, item.filter);
+        items.push_back(item);
+    }
+
+    std::vector<BatchItemReport> reports;
+    bool success = RunBatchJob(jobId.ToCStr().Get(), items, reports, &processControl);
+
+    // Retorna resultado
+    GS::Array<GS::ObjectState> itemResults;
+    for (const BatchItemReport& report : reports) {
+        GS::ObjectState itemResult;
+        itemResult.Add("outputPath", GS::UniString(report.outputPath.c_str()));
+        if (!report.translator.empty()) {
+            itemResult.Add("translator", GS::UniString(report.translator.c_str()));
+        }
+        itemResult.Add("status", GS::UniString(report.status.c_str()));
+        if (!report.error.empty()) {
+            itemResult.Add("error", GS::UniString(report.error.c_str()));
+        }
+        itemResults.Push(itemResult);
+    }
+
+    GS::ObjectState result;
+    result.Add("success", success);
+    result.Add("jobId", jobId);
+    result.Add("items", itemResults);
+
+    return result;
+}
+
+// Implementação do comando simples de Load IFC - cópia exata do menu
+GS::ObjectState LoadIfcCommand::Execute(const GS::ObjectState& parameters, GS::ProcessControl& processControl) const
+{
+    LOG_DEBUG("[MAIN THREAD] LoadIfcCommand::Execute() called");
+
+    // Extrai o caminho do IFC
+    GS::UniString jobId, ifcPath;
+    parameters.Get("jobId", jobId);
+    parameters.Get("ifcPath", ifcPath);
+
+    std::string errorMsg;
+    bool success = PreflightOnMainThread(jobId.ToCStr().Get(), ifcPath.ToCStr().Get(), errorMsg) &&
+                   RunLoadIfcJob(jobId.ToCStr().Get(), ifcPath.ToCStr().Get(), errorMsg);
+
     // Retornar resultado
     GS::ObjectState result;
     result.Add("success", success);
@@ -257,9 +847,77 @@ load_error:
 
     return result;
 }
+
+// Acts on the memory policy's decision after a job (main thread): a deep
+// cleanup first, and a recycle request once memory stays too high
+static void ApplyMemoryPolicy(const std::string& jobId)
+{
+    MemoryPolicy& policy = ConversionHandler::GetMemoryPolicy();
+
+    // Jobs that did not report through ReportJobOutcome (load, batch) are sampled here
+    policy.JobFinished(jobId);
+
+    MemoryAction action = policy.TakePendingAction();
+    if (action == MemoryAction::DeepCleanup) {
+        ProcessMemory before;
+        GetProcessMemory(before);
+        ConversionHandler::DeepCleanup();
+        action = policy.CleanupDone(before.rssBytes);
+    }
+
+    if (action == MemoryAction::Recycle) {
+        LOG_WARN("Memory policy: asking to recycle this worker (" << policy.GetRecycleReason() << ")");
+        if (g_wsServer) {
+            g_wsServer->BroadcastMessage(FormatWorkerInfo(GetWorkerInfo(), "worker_recycle"));
+        }
+    }
+}
+
+// Runs a queued job - EXECUTADO NA THREAD PRINCIPAL (via MainThreadChannel)
+static void RunJobOnMainThread(const ConversionJob& job)
+{
+    // A doorbell that failed earlier may deliver a job the scheduler already
+    // gave up on; only run jobs that are still marked as running.
+    JobState state;
+    size_t position = 0;
+    if (!ConversionHandler::GetJobState(job.jobId, state, position) || state != JobState::Running) {
+        LOG_INFO("[MAIN THREAD] Skipping stale job " << job.jobId);
+        ConversionHandler::ReleaseSession();
+        return;
+    }
+
+    LOG_INFO("[MAIN THREAD] Running job " << job.jobId << " (" << JobTypeToCommandName(job.type) << ")");
+
+    ConversionHandler::GetMemoryPolicy().JobStarted(job.jobId);
+
+    switch (job.type) {
+        case JobType::PlnToIfc:
+            RunPlnToIfcJob(job.jobId, job.inputPath, job.outputPath, job.translator, job.filter, job.artifact,
+                           job.liveOutput);
+            break;
+        case JobType::IfcToPln:
+            RunIfcToPlnJob(job.jobId, job.inputPath, job.outputPath, job.artifact);
+            break;
+        case JobType::LoadIfc:
+            {
+                std::string errorMsg;
+                RunLoadIfcJob(job.jobId, job.inputPath, errorMsg);
+            }
+            break;
+        case JobType::Batch:
+            {
+                std::vector<BatchItemReport> reports;
+                RunBatchJob(job.jobId, job.items, reports);
+            }
+            break;
+    }
+
+    ApplyMemoryPolicy(job.jobId);
+}
 #endif
 
 
+
 enum APITestMenu {
 	LoadIFCFileMenuItem = 1,
 	SaveProjectAsPLNMenuItem,
@@ -312,6 +970,19 @@ API_AddonType CheckEnvironment (API_EnvirParams* envir)
 	RSGetIndString (&envir->addOnInfo.name, IFC_TO_ARCHICAD_ADDON_NAME, 1, ACAPI_GetOwnResModule ());
 	RSGetIndString (&envir->addOnInfo.description, IFC_TO_ARCHICAD_ADDON_NAME, 2, ACAPI_GetOwnResModule ());
 
+#ifdef WEBSOCKET_ENABLED
+	g_archicadVersion = std::to_string (envir->serverInfo.mainVersion) + "." +
+	                    std::to_string (envir->serverInfo.releaseVersion) + "." +
+	                    std::to_string (envir->serverInfo.buildNum);
+
+	// Auto-start needs Initialize to run at startup, not on first menu use
+	LoadPluginConfig ();
+	g_headless = GetEnvInt ("ARCHICAD_PLUGIN_HEADLESS", 0) != 0;
+	if (IsAutoStartEnabled ()) {
+		return APIAddon_Preload;
+	}
+#endif
+
 	return APIAddon_Normal;
 }
 
@@ -328,6 +999,10 @@ GSErrCode RegisterInterface (void)
 	// Register WebSocket submenu
 	err = ACAPI_MenuItem_RegisterMenu (IFCAPI_WEBSOCKET_MENU_STRINGS, IFCAPI_WEBSOCKET_MENU_PROMPT_STRINGS, MenuCode_UserDef, MenuFlag_InsertIntoSame);
 	DBASSERT (err == NoError);
+
+	// Register the doorbell service used to hand jobs to the main thread
+	err = MainThreadChannel::Register ();
+	DBASSERT (err == NoError);
 #endif
 
 	return err;
@@ -347,14 +1022,38 @@ GSErrCode Initialize (void)
 	err = ACAPI_MenuItem_InstallMenuHandler (IFCAPI_WEBSOCKET_MENU_STRINGS, MenuCommandHandler);
 	DBASSERT (err == NoError);
 
+    LoadPluginConfig();
+    g_headless = GetEnvInt("ARCHICAD_PLUGIN_HEADLESS", 0) != 0;
+    StartLogger();
+
+    // In-process channel used by the scheduler to run jobs on the main thread
+    err = MainThreadChannel::Install();
+    if (err == NoError) {
+        LOG_INFO("MainThreadChannel installed successfully");
+    } else {
+        LOG_ERROR("Failed to install MainThreadChannel. Error: " << err);
+    }
+
+    // Cache IFC export translators per project instead of listing them on
+    // every export. The first listing is done once Initialize returns, so
+    // Archicad's IFC module is loaded before the first job arrives.
+    err = TranslatorCache::Install();
+    if (err == NoError) {
+        MainThreadChannel::Post([]() {
+            TranslatorCache::Prewarm();
+        });
+    } else {
+        LOG_WARN("Could not watch project events, IFC translators will not be cached. Error: " << err);
+    }
+
     // Registrar o command handler para a conversão PLN -> IFC
     err = ACAPI_AddOnAddOnCommunication_InstallAddOnCommandHandler(
         GS::Owner<API_AddOnCommand>(new ConversionCommand())
     );
     if (err == NoError) {
-        std::cout << "ConversionCommand (PLN->IFC) registered successfully" << std::endl;
+        LOG_INFO("ConversionCommand (PLN->IFC) registered successfully");
     } else {
-        std::cerr << "Failed to register ConversionCommand. Error: " << err << std::endl;
+        LOG_ERROR("Failed to register ConversionCommand. Error: " << err);
     }
 
     // Registrar o command handler para a conversão IFC -> PLN
@@ -362,9 +1061,19 @@ GSErrCode Initialize (void)
         GS::Owner<API_AddOnCommand>(new ConvertIfcToPlnCommand())
     );
     if (err == NoError) {
-        std::cout << "ConvertIfcToPlnCommand (IFC->PLN) registered successfully" << std::endl;
+        LOG_INFO("ConvertIfcToPlnCommand (IFC->PLN) registered successfully");
     } else {
-        std::cerr << "Failed to register ConvertIfcToPlnCommand. Error: " << err << std::endl;
+        LOG_ERROR("Failed to register ConvertIfcToPlnCommand. Error: " << err);
+    }
+
+    // Registrar o command handler para conversões em lote
+    err = ACAPI_AddOnAddOnCommunication_InstallAddOnCommandHandler(
+        GS::Owner<API_AddOnCommand>(new ConvertBatchCommand())
+    );
+    if (err == NoError) {
+        LOG_INFO("ConvertBatchCommand (batch) registered successfully");
+    } else {
+        LOG_ERROR("Failed to register ConvertBatchCommand. Error: " << err);
     }
 
     // Registrar comando simples de Load IFC (cópia exata do menu)
@@ -372,9 +1081,15 @@ GSErrCode Initialize (void)
         GS::Owner<API_AddOnCommand>(new LoadIfcCommand())
     );
     if (err == NoError) {
-        std::cout << "LoadIfcCommand (Simple IFC Load) registered successfully" << std::endl;
+        LOG_INFO("LoadIfcCommand (Simple IFC Load) registered successfully");
     } else {
-        std::cerr << "Failed to register LoadIfcCommand. Error: " << err << std::endl;
+        LOG_ERROR("Failed to register LoadIfcCommand. Error: " << err);
+    }
+
+    // Unattended workers start listening without the menu command
+    if (IsAutoStartEnabled()) {
+        ACAPI_KeepInMemory(true);
+        AutoStartWebSocketServer();
     }
 #endif
 
@@ -385,14 +1100,29 @@ GSErrCode Initialize (void)
 GSErrCode FreeData (void)
 {
 #ifdef WEBSOCKET_ENABLED
-	// Cleanup any pending conversions and close projects
+	// Files waiting for their pre-flight scan never reach the queue
+	g_ifcPreflight.reset();
+
+	// Drop queued jobs, then cleanup any pending conversions and close projects
+	ConversionHandler::StopScheduler();
+	MainThreadChannel::Shutdown();
 	ConversionHandler::Cleanup();
 
+	// Outputs still being packed get an error completion while the server is up
+	if (g_artifactProcessor) {
+		g_artifactProcessor->Stop();
+	}
+	g_artifactProcessor.reset();
+
 	// Stop WebSocket server on plugin unload
+	g_workerRegistration.reset();
 	if (g_wsServer && g_wsServer->IsRunning()) {
 		g_wsServer->Stop();
 	}
 	g_wsServer.reset();
+
+	// Flush buffered log lines before the add-on is unloaded
+	Logger::Stop();
 #endif
 
 	return NoError;
@@ -400,359 +1130,758 @@ GSErrCode FreeData (void)
 
 #ifdef WEBSOCKET_ENABLED
 
-// WebSocket command handler - EXECUTADO NA THREAD DO WEBSOCKET
-void HandleWebSocketCommand(const std::string& command, const std::string& jobId, const std::string& payload)
-{
-	std::cout << "===============================================" << std::endl;
-	std::cout << "HandleWebSocketCommand CALLED!" << std::endl;
-	std::cout << "Command: '" << command << "'" << std::endl;
-	std::cout << "JobId: '" << jobId << "'" << std::endl;
-	std::cout << "Payload length: " << payload.length() << std::endl;
-	std::cout << "===============================================" << std::endl;
-	
-	DebugLog("[WEBSOCKET THREAD] ========================================");
-	DebugLog("[WEBSOCKET THREAD] Received command: " + command + " (job: " + jobId + ")");
-	DebugLog("[WEBSOCKET THREAD] ========================================");
-	
-	if (command == "start_conversion") {
-		// Extract paths from JSON - supports both plnPath/pln_path and ifcPath/ifc_path
-		std::string inputPath;
-		std::string outputPath;
-		bool isPlnToIfc = false;  // Will be determined from which field is present
-
-		DebugLog("[WEBSOCKET THREAD] Payload received: " + payload);
-
-		// Try to extract plnPath or pln_path (PLN -> IFC conversion)
-		size_t plnPos = payload.find("\"plnPath\"");
-		if (plnPos == std::string::npos) {
-			plnPos = payload.find("\"pln_path\"");
-		}
-		
-		if (plnPos != std::string::npos) {
-			size_t colonPos = payload.find(":", plnPos);
-			size_t quoteStart = payload.find("\"", colonPos);
-			size_t quoteEnd = payload.find("\"", quoteStart + 1);
-			if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-				inputPath = payload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-				isPlnToIfc = true;
-				DebugLog("[WEBSOCKET THREAD] Detected PLN -> IFC conversion");
-			}
-		}
+// Job dispatcher - EXECUTADO NA THREAD DO SCHEDULER
+// Hands the job to the main thread and returns immediately; the job reports
+// its own outcome through ConversionHandler::FinishJob().
+static bool DispatchJob(const ConversionJob& job, std::string& error)
+{
+	LOG_INFO("[SCHEDULER THREAD] Dispatching " << JobTypeToCommandName(job.type) << " for job " << job.jobId);
+
+	bool posted = MainThreadChannel::Post([job]() {
+		RunJobOnMainThread(job);
+	});
+
+	if (!posted) {
+		error = "Failed to hand job over to the Archicad main thread";
+	}
+	return posted;
+}
+
+// Scheduler notifications -> WebSocket clients
+// A job the scheduler finished without the main thread never reaches
+// EndJobSession: once the queue is drained, the model the previous job kept
+// warm for it is released here
+static void ReleaseSessionWhenDrained()
+{
+	if (!ConversionHandler::HasRunningJob() && ConversionHandler::GetQueueDepth() == 0) {
+		MainThreadChannel::Post([]() {
+			ConversionHandler::ReleaseSession();
+		});
+	}
+}
 
-		// If plnPath not found, try ifcPath or ifc_path (IFC -> PLN conversion)
-		if (inputPath.empty()) {
-			size_t ifcPos = payload.find("\"ifcPath\"");
-			if (ifcPos == std::string::npos) {
-				ifcPos = payload.find("\"ifc_path\"");
+static void OnJobEvent(const ConversionJob& job, JobState state, size_t position, const std::string& message)
+{
+	switch (state) {
+		case JobState::Queued:
+			if (g_wsServer) {
+				g_wsServer->SendQueued(job.jobId, position, ConversionHandler::GetQueueDepth());
 			}
-			
-			if (ifcPos != std::string::npos) {
-				size_t colonPos = payload.find(":", ifcPos);
-				size_t quoteStart = payload.find("\"", colonPos);
-				size_t quoteEnd = payload.find("\"", quoteStart + 1);
-				if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-					inputPath = payload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-					isPlnToIfc = false;
-					DebugLog("[WEBSOCKET THREAD] Detected IFC -> PLN conversion");
-				}
+			return;
+		case JobState::Done:
+			// A result-cache hit: completed the same way as a job that ran (download
+			// offer, timings, checksum/IFCZIP post-processing), which also finishes it
+			ReportJobOutcome(job.jobId, job.type, job.outputPath, true, job.artifact);
+			break;
+		case JobState::Failed:
+			// Staging or dispatch failed
+			if (g_wsServer) {
+				g_wsServer->SendError(job.jobId, message);
+			}
+			break;
+		case JobState::Cancelled:
+			// Cancelled before it was dispatched
+			if (g_wsServer) {
+				g_wsServer->SendProgress(job.jobId, 0, "cancelled", message);
 			}
+			break;
+		default:
+			return;
+	}
+
+	// Every finished job reported here was finished off the main thread
+	ReleaseSessionWhenDrained();
+}
+
+// Reads the optional post-processing members of start_conversion:
+// "checksum": true adds the output's SHA-256, "compress": "ifczip" packs an
+// IFC output into an IFCZIP; both run after the job released the main thread
+static bool ReadArtifactOptions(const JsonValue& body, JobType type, ArtifactOptions& options, std::string& error)
+{
+	options.checksum = body.GetBool("checksum");
+
+	std::string compress = body.GetString({ "compress" });
+	if (compress.empty() || compress == "none") {
+		return true;
+	}
+	if (compress != "ifczip") {
+		error = "Unsupported compress format '" + compress + "' (supported: ifczip)";
+		return false;
+	}
+	if (type != JobType::PlnToIfc) {
+		error = "compress applies to IFC outputs only";
+		return false;
+	}
+
+	options.compress = true;
+	return true;
+}
+
+// Upper bound for items in one start_batch
+static const size_t kMaxBatchItems = 256;
+
+// Reads the optional "filter" member of a request or item; a filter only
+// applies to PLN -> IFC
+static bool ReadFilter(const JsonValue& body, JobType type, ElementFilter& filter, std::string& error)
+{
+	const JsonValue* value = body.Find("filter");
+	if (value == nullptr) {
+		return true;
+	}
+	if (type != JobType::PlnToIfc && !value->IsNull()) {
+		error = "filter is only supported for PLN -> IFC";
+		return false;
+	}
+	return ParseElementFilter(*value, filter, error);
+}
+
+// Reads start_batch items: [{ "plnPath" | "ifcPath": "...", "outputPath": "..." }, ...]
+static bool ParseBatchItems(const JsonValue& body, std::vector<BatchItem>& items, std::string& error)
+{
+	const JsonValue* list = body.Find("items");
+	if (list == nullptr || !list->IsArray() || list->Size() == 0) {
+		error = "Missing items array";
+		return false;
+	}
+	if (list->Size() > kMaxBatchItems) {
+		error = "Too many items in batch (maximum " + std::to_string(kMaxBatchItems) + ")";
+		return false;
+	}
+
+	for (size_t i = 0; i < list->Size(); ++i) {
+		const JsonValue& entry = list->At(i);
+		BatchItem item;
+
+		std::string plnPath = entry.GetString({ "plnPath", "pln_path" });
+		if (!plnPath.empty()) {
+			item.type = JobType::PlnToIfc;
+			item.inputPath = plnPath;
+		} else {
+			item.type = JobType::IfcToPln;
+			item.inputPath = entry.GetString({ "ifcPath", "ifc_path" });
 		}
+		item.outputPath = entry.GetString({ "outputPath", "output_path" });
+		item.translator = entry.GetString({ "translator" });
 
-		// Extract outputPath or output_path
-		size_t outPos = payload.find("\"outputPath\"");
-		if (outPos == std::string::npos) {
-			outPos = payload.find("\"output_path\"");
+		if (item.inputPath.empty() || item.outputPath.empty()) {
+			error = "Item " + std::to_string(i) + ": missing input path (pln_path or ifc_path) or output_path";
+			return false;
 		}
-		
-		if (outPos != std::string::npos) {
-			size_t colonPos = payload.find(":", outPos);
-			size_t quoteStart = payload.find("\"", colonPos);
-			size_t quoteEnd = payload.find("\"", quoteStart + 1);
-			if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-				outputPath = payload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-			}
+
+		std::string filterError;
+		if (!ReadFilter(entry, item.type, item.filter, filterError)) {
+			error = "Item " + std::to_string(i) + ": " + filterError;
+			return false;
+		}
+		items.push_back(item);
+	}
+	return true;
+}
+
+// Reads start_conversion fan-out exports: [{ "translator": "...", "outputPath": "..." }, ...];
+// an export without its own filter uses the request's
+static bool ParseExportItems(const JsonValue& body, const std::string& plnPath, const ElementFilter& filter,
+							 std::vector<BatchItem>& items, std::string& error)
+{
+	const JsonValue* list = body.Find("exports");
+	if (list == nullptr || !list->IsArray() || list->Size() == 0) {
+		error = "exports must be a non-empty array";
+		return false;
+	}
+	if (list->Size() > kMaxBatchItems) {
+		error = "Too many exports (maximum " + std::to_string(kMaxBatchItems) + ")";
+		return false;
+	}
+
+	for (size_t i = 0; i < list->Size(); ++i) {
+		const JsonValue& entry = list->At(i);
+		BatchItem item;
+		item.type = JobType::PlnToIfc;
+		item.inputPath = plnPath;
+		item.outputPath = entry.GetString({ "outputPath", "output_path" });
+		item.translator = entry.GetString({ "translator" });
+		item.filter = filter;
+
+		if (item.outputPath.empty()) {
+			error = "Export " + std::to_string(i) + ": missing output_path";
+			return false;
+		}
+
+		std::string filterError;
+		if (!ReadFilter(entry, item.type, item.filter, filterError)) {
+			error = "Export " + std::to_string(i) + ": " + filterError;
+			return false;
 		}
+		items.push_back(item);
+	}
+	return true;
+}
+
+// True for IFC file names (.ifc, .ifczip, .ifcxml), case-insensitive
+static bool IsIfcFileName(const std::string& fileName)
+{
+	size_t dot = fileName.find_last_of('.');
+	if (dot == std::string::npos) {
+		return false;
+	}
 
-		DebugLog("[WEBSOCKET THREAD] Extracted inputPath: '" + inputPath + "'");
-		DebugLog("[WEBSOCKET THREAD] Extracted outputPath: '" + outputPath + "'");
-		DebugLog("[WEBSOCKET THREAD] Conversion direction: " + std::string(isPlnToIfc ? "PLN->IFC" : "IFC->PLN"));
+	std::string extension = fileName.substr(dot);
+	for (char& c : extension) {
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+	return extension == ".ifc" || extension == ".ifczip" || extension == ".ifcxml";
+}
+
+// Rejects a claimed submission (see ArchicadWebSocketServer::ClaimSubmission)
+static void RejectSubmission(const std::string& jobId, const std::string& error)
+{
+	if (g_wsServer) {
+		g_wsServer->RejectSubmission(jobId, error);
+	}
+}
+
+// Queues a job and acknowledges it to the client immediately
+static void SubmitJobAndAcknowledge(const ConversionJob& job)
+{
+	size_t position = 0;
+	JobQueue::EnqueueResult result = ConversionHandler::SubmitJob(job, position);
+
+	if (!g_wsServer) {
+		return;
+	}
+
+	switch (result) {
+		case JobQueue::EnqueueResult::Accepted:
+			g_wsServer->SendQueued(job.jobId, position, ConversionHandler::GetQueueDepth());
+			break;
+		case JobQueue::EnqueueResult::Duplicate:
+			RejectSubmission(job.jobId, "Job is already queued or running");
+			break;
+		case JobQueue::EnqueueResult::QueueFull:
+			RejectSubmission(job.jobId, "Conversion queue is full, try again later");
+			break;
+	}
+}
 
-		if (inputPath.empty() || outputPath.empty()) {
-			DebugLog("[WEBSOCKET THREAD] ERROR: Missing paths!");
+// Queues an IFC -> PLN or Load IFC job once its input passed the pre-flight
+// scan, which runs on its own thread; a rejected file never reaches the
+// main thread. Other jobs are queued right away.
+static void SubmitAfterPreflight(const ConversionJob& job)
+{
+	bool ifcInput = job.type == JobType::IfcToPln || job.type == JobType::LoadIfc;
+	bool scanning = ifcInput && g_ifcPreflight && g_ifcPreflight->Submit(job.inputPath,
+		[job](const IfcPreflightReport& report) {
 			if (g_wsServer) {
-				g_wsServer->SendError(jobId, "Missing input path (pln_path or ifc_path) and output_path");
+				g_wsServer->SendPreflight(job.jobId, report.ok, report.ToJson());
+			}
+			if (!report.ok) {
+				RejectSubmission(job.jobId, "IFC pre-flight failed: " + report.error);
+				return;
 			}
-			return;
-		}
 
-        // Call appropriate command via HTTP based on conversion direction
-        DebugLog("[WEBSOCKET THREAD] Calling command via HTTP on main thread...");
+			ConversionJob checked = job;
+			checked.inputBytes = report.size;
+			checked.entityCount = report.entityCount;
+			SubmitJobAndAcknowledge(checked);
+		});
 
-        try {
-            // Get the HTTP port
-            UShort httpPort = 0;
-            GSErrCode err = ACAPI_Command_GetHttpConnectionPort(&httpPort);
-            if (err != NoError) {
-                DebugLog("[WEBSOCKET THREAD] Failed to get HTTP port. Error: " + std::to_string(err));
-                if (g_wsServer) {
-                    g_wsServer->SendError(jobId, "Failed to get HTTP port. Error: " + std::to_string(err));
-                }
-                return;
-            }
+	if (!scanning) {
+		SubmitJobAndAcknowledge(job);
+	}
+}
 
-            DebugLog("[WEBSOCKET THREAD] HTTP port: " + std::to_string(httpPort));
-
-            // Build HTTP request JSON - select command based on conversion direction
-            // Escape paths for JSON
-            std::string escapedInputPath = EscapeJsonString(inputPath);
-            std::string escapedOutputPath = EscapeJsonString(outputPath);
-
-            std::string commandName = isPlnToIfc ? "ConvertPlnToIfc" : "ConvertIfcToPln";
-            std::string inputParamName = isPlnToIfc ? "plnPath" : "ifcPath";
-
-            std::string requestJson = "{"
-                "\"command\": \"API.ExecuteAddOnCommand\","
-                "\"parameters\": {"
-                    "\"addOnCommandId\": {"
-                        "\"commandNamespace\": \"IFCPlugin\","
-                        "\"commandName\": \"" + commandName + "\""
-                    "},"
-                    "\"addOnCommandParameters\": {"
-                        "\"jobId\": \"" + jobId + "\","
-                        "\"" + inputParamName + "\": \"" + escapedInputPath + "\","
-                        "\"outputPath\": \"" + escapedOutputPath + "\""
-                    "}"
-                "}"
-            "}";
-
-            DebugLog("[WEBSOCKET THREAD] Request JSON: " + requestJson);
-
-            // Make HTTP POST request using Boost.Beast (we already have it linked)
-            // This will cause Execute() to run on ArchiCAD's main thread
-            try {
-                net::io_context ioc;
-                tcp::resolver resolver(ioc);
-                tcp::socket socket(ioc);
-
-                // Connect to localhost:httpPort
-                auto const results = resolver.resolve("127.0.0.1", std::to_string(httpPort));
-                net::connect(socket, results.begin(), results.end());
-
-                // Build HTTP POST request
-                std::string httpRequest =
-                    "POST / HTTP/1.1\r\n"
-                    "Host: 127.0.0.1:" + std::to_string(httpPort) + "\r\n"
-                    "Content-Type: application/json;charset=utf-8\r\n"
-                    "Content-Length: " + std::to_string(requestJson.length()) + "\r\n"
-                    "Connection: close\r\n"
-                    "\r\n" +
-                    requestJson;
-
-                // Send HTTP request
-                net::write(socket, net::buffer(httpRequest));
-
-                // Read HTTP response
-                beast::flat_buffer buffer;
-                beast::error_code ec;
-
-                // Read until socket closes
-                while (true) {
-                    char buf[1024];
-                    size_t bytes = socket.read_some(net::buffer(buf), ec);
-                    if (ec == net::error::eof) break;
-                    if (ec) throw beast::system_error{ec};
-
-                    std::cout.write(buf, bytes);
-                }
-
-                socket.shutdown(tcp::socket::shutdown_both, ec);
-
-                DebugLog("[WEBSOCKET THREAD] HTTP request sent successfully");
-
-            } catch (const std::exception& e) {
-                DebugLog("[WEBSOCKET THREAD] HTTP request failed: " + std::string(e.what()));
-                if (g_wsServer) {
-                    g_wsServer->SendError(jobId, std::string("HTTP request failed: ") + e.what());
-                }
-            }
+// WebSocket command handler - EXECUTADO NA THREAD DE COMANDOS do servidor
+// (never on an I/O thread, so a slow command does not stall other sessions)
+void HandleWebSocketCommand(const WebSocketCommand& command)
+{
+	const std::string& jobId = command.jobId;
 
-        } catch (const std::exception& e) {
-            DebugLog("[WEBSOCKET THREAD] Exception: " + std::string(e.what()));
-            if (g_wsServer) {
-                g_wsServer->SendError(jobId, std::string("Exception: ") + e.what());
-            }
-        }
+	LOG_DEBUG("[COMMAND THREAD] Received command: " << command.name << " (job: " << jobId << ")");
 
-	} else if (command == "cancel_job") {
-		bool cancelled = ConversionHandler::CancelConversion(jobId);
-		if (cancelled && g_wsServer) {
-			g_wsServer->SendProgress(jobId, 0, "cancelled", "Conversion cancelled");
-		}
+	switch (command.type) {
+		case CommandType::StartConversion: {
+			if (g_wsServer && !g_wsServer->ClaimSubmission(command)) {
+				break;
+			}
 
-	} else if (command == "get_status") {
-		if (g_wsServer) {
-			std::string status = ConversionHandler::IsConversionInProgress(jobId) ?
-			                     "processing" : "idle";
-			g_wsServer->SendProgress(jobId, 0, status, "Plugin ready");
-		}
-	
-	} else if (command == "load_ifc") {
-		// Comando simples para carregar IFC - igual ao menu
-		std::string ifcPath;
-
-		DebugLog("[WEBSOCKET THREAD] Load IFC command received");
-
-		// Extract ifcPath
-		size_t ifcPos = payload.find("\"ifcPath\"");
-		if (ifcPos != std::string::npos) {
-			size_t colonPos = payload.find(":", ifcPos);
-			size_t quoteStart = payload.find("\"", colonPos);
-			size_t quoteEnd = payload.find("\"", quoteStart + 1);
-			if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-				ifcPath = payload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
+			ConversionJob job;
+			job.jobId = jobId;
+			job.priority = command.priority;
+			job.tenant = command.tenant;
+
+			// plnPath/pln_path means PLN -> IFC, ifcPath/ifc_path means IFC -> PLN;
+			// an uploaded input (inputTransfer) goes by its file extension
+			std::string inputTransfer = command.body.GetString({ "inputTransfer", "input_transfer" });
+			std::string inputName;
+			if (!inputTransfer.empty()) {
+				std::string error;
+				if (!g_wsServer || !g_wsServer->GetTransfers().GetUpload(inputTransfer, job.inputPath, inputName, error)) {
+					LOG_WARN("[COMMAND THREAD] " << error);
+					if (g_wsServer) {
+						RejectSubmission(jobId, error);
+					}
+					return;
+				}
+				job.type = IsIfcFileName(inputName) ? JobType::IfcToPln : JobType::PlnToIfc;
+			} else if (!command.plnPath.empty()) {
+				job.type = JobType::PlnToIfc;
+				job.inputPath = command.plnPath;
+			} else {
+				job.type = JobType::IfcToPln;
+				job.inputPath = command.ifcPath;
 			}
-		}
+			job.outputPath = command.outputPath;
+
+			// streamOutput: write to the staging area and offer the result for download
+			bool fanOut = command.body.Find("exports") != nullptr;
+			bool streamRequested = command.body.GetBool("streamOutput") || command.body.GetBool("stream_output");
+			bool streamOutput = job.outputPath.empty() && streamRequested && !fanOut;
+			if (streamOutput) {
+				if (inputName.empty()) {
+					inputName = job.inputPath.substr(job.inputPath.find_last_of("/\\") + 1);
+				}
+				std::string baseName = inputName.substr(0, inputName.find_last_of('.'));
+				job.outputPath = g_wsServer->GetTransfers().PrepareOutput(
+					jobId, baseName + (job.type == JobType::PlnToIfc ? ".ifc" : ".pln"));
+			}
+			job.translator = command.body.GetString({ "translator" });
 
-		DebugLog("[WEBSOCKET THREAD] Extracted ifcPath: '" + ifcPath + "'");
+			std::string artifactError;
+			if (!ReadArtifactOptions(command.body, job.type, job.artifact, artifactError)) {
+				LOG_WARN("[COMMAND THREAD] " << artifactError);
+				if (g_wsServer) {
+					RejectSubmission(jobId, artifactError);
+				}
+				return;
+			}
+			// A streamed output is delivered as the IFCZIP alone
+			job.artifact.removeOriginal = job.artifact.compress && streamOutput;
+			// liveOutput: the IFC can be downloaded while it is written (not with compress,
+			// which replaces the file once it is done)
+			job.liveOutput = streamOutput && job.type == JobType::PlnToIfc && !job.artifact.compress &&
+				(command.body.GetBool("liveOutput") || command.body.GetBool("live_output"));
+
+			std::string filterError;
+			if (!ReadFilter(command.body, job.type, job.filter, filterError)) {
+				LOG_WARN("[COMMAND THREAD] " << filterError);
+				if (g_wsServer) {
+					RejectSubmission(jobId, filterError);
+				}
+				return;
+			}
 
-		if (ifcPath.empty()) {
-			DebugLog("[WEBSOCKET THREAD] ERROR: Missing ifcPath!");
-			if (g_wsServer) {
-				g_wsServer->SendError(jobId, "Missing ifcPath parameter");
+			// Fan-out: one PLN, one IFC per requested translator. It runs as a
+			// batch, whose outputs are neither post-processed nor streamed
+			if (fanOut) {
+				std::string error;
+				if (job.artifact.Any() || streamRequested) {
+					error = "exports cannot be combined with checksum, compress or streamOutput";
+				} else if (job.type != JobType::PlnToIfc) {
+					error = "exports requires pln_path";
+				} else {
+					ParseExportItems(command.body, job.inputPath, job.filter, job.items, error);
+				}
+				if (!error.empty()) {
+					LOG_WARN("[COMMAND THREAD] " << error);
+					if (g_wsServer) {
+						RejectSubmission(jobId, error);
+					}
+					return;
+				}
+
+				job.type = JobType::Batch;
+				LOG_INFO("[COMMAND THREAD] Fan-out export: '" << job.inputPath << "' -> " << job.items.size() << " outputs");
+				SubmitJobAndAcknowledge(job);
+				break;
 			}
-			return;
+
+			LOG_INFO("[COMMAND THREAD] " << JobTypeToCommandName(job.type) << ": '" << job.inputPath << "' -> '" << job.outputPath << "'");
+
+			if (job.inputPath.empty() || job.outputPath.empty()) {
+				LOG_WARN("[COMMAND THREAD] Missing paths!");
+				if (g_wsServer) {
+					RejectSubmission(jobId, "Missing input path (pln_path or ifc_path) and output_path");
+				}
+				return;
+			}
+
+			SubmitAfterPreflight(job);
+			break;
 		}
 
-		// Chamar comando via HTTP
-		DebugLog("[WEBSOCKET THREAD] Calling LoadIfc command via HTTP...");
+		case CommandType::StartBatch: {
+			if (g_wsServer && !g_wsServer->ClaimSubmission(command)) {
+				break;
+			}
 
-		try {
-			UShort httpPort = 0;
-			GSErrCode err = ACAPI_Command_GetHttpConnectionPort(&httpPort);
-			if (err != NoError) {
-				DebugLog("[WEBSOCKET THREAD] Failed to get HTTP port");
+			ConversionJob job;
+			job.jobId = jobId;
+			job.type = JobType::Batch;
+			job.priority = command.priority;
+			job.tenant = command.tenant;
+
+			std::string error;
+			if (!ParseBatchItems(command.body, job.items, error)) {
+				LOG_WARN("[COMMAND THREAD] " << error);
 				if (g_wsServer) {
-					g_wsServer->SendError(jobId, "Failed to get HTTP port");
+					RejectSubmission(jobId, error);
 				}
 				return;
 			}
 
-			DebugLog("[WEBSOCKET THREAD] HTTP port: " + std::to_string(httpPort));
-
-			// Escapar path para JSON
-			std::string escapedIfcPath = EscapeJsonString(ifcPath);
-
-			// Montar request JSON
-			std::string requestJson = "{"
-				"\"command\": \"API.ExecuteAddOnCommand\","
-				"\"parameters\": {"
-					"\"addOnCommandId\": {"
-						"\"commandNamespace\": \"IFCPlugin\","
-						"\"commandName\": \"LoadIfc\""
-					"},"
-					"\"addOnCommandParameters\": {"
-						"\"jobId\": \"" + jobId + "\","
-						"\"ifcPath\": \"" + escapedIfcPath + "\""
-					"}"
-				"}"
-			"}";
-
-			DebugLog("[WEBSOCKET THREAD] Request JSON: " + requestJson);
-
-			// Fazer HTTP POST
-			try {
-				net::io_context ioc;
-				tcp::resolver resolver(ioc);
-				tcp::socket socket(ioc);
-
-				auto const results = resolver.resolve("127.0.0.1", std::to_string(httpPort));
-				net::connect(socket, results.begin(), results.end());
-
-				std::string httpRequest =
-					"POST / HTTP/1.1\r\n"
-					"Host: 127.0.0.1:" + std::to_string(httpPort) + "\r\n"
-					"Content-Type: application/json;charset=utf-8\r\n"
-					"Content-Length: " + std::to_string(requestJson.length()) + "\r\n"
-					"Connection: close\r\n"
-					"\r\n" +
-					requestJson;
-
-				net::write(socket, net::buffer(httpRequest));
-
-				// Ler resposta
-				beast::flat_buffer buffer;
-				beast::error_code ec;
-
-				while (true) {
-					char buf[1024];
-					size_t bytes = socket.read_some(net::buffer(buf), ec);
-					if (ec == net::error::eof) break;
-					if (ec) throw beast::system_error{ec};
-					std::cout.write(buf, bytes);
+			LOG_INFO("[COMMAND THREAD] Batch: " << job.items.size() << " items");
+
+			SubmitJobAndAcknowledge(job);
+			break;
+		}
+
+		case CommandType::CancelJob: {
+			bool cancelled = ConversionHandler::CancelConversion(jobId);
+			if (cancelled && g_wsServer) {
+				// A queued job is gone right away; a running one reports
+				// "cancelled" itself once it reaches the next checkpoint
+				JobState state;
+				size_t position = 0;
+				if (ConversionHandler::GetJobState(jobId, state, position) && state == JobState::Running) {
+					g_wsServer->SendProgress(jobId, 0, "processing", "Cancellation requested");
+				} else {
+					g_wsServer->SendProgress(jobId, 0, "cancelled", "Conversion cancelled");
 				}
+			}
 
-				socket.shutdown(tcp::socket::shutdown_both, ec);
+			// Cancelling the last queued job may leave a warm model open
+			if (cancelled) {
+				ReleaseSessionWhenDrained();
+			}
+			break;
+		}
 
-				DebugLog("[WEBSOCKET THREAD] HTTP request sent successfully");
+		case CommandType::GetStatus:
+			if (g_wsServer) {
+				JobState state;
+				size_t position = 0;
+				JobRecord record;
+				bool claimed = g_wsServer->GetJobRegistry().Find(jobId, record);
+				bool queued = ConversionHandler::GetJobState(jobId, state, position);
+				if (claimed && record.finished) {
+					// Replays the terminal event, with its output path and timings
+					g_wsServer->SendToSession(command.sessionId, record.lastEvent);
+				} else if (queued && state == JobState::Queued) {
+					g_wsServer->SendQueued(jobId, position, ConversionHandler::GetQueueDepth());
+				} else if (claimed) {
+					// Running, in pre-flight or post-processing: its terminal
+					// event is still to come, so nothing final is sent here
+					if (record.lastEvent) {
+						g_wsServer->SendToSession(command.sessionId, record.lastEvent);
+					} else {
+						g_wsServer->SendProgress(jobId, 0, "processing", "Checking the input file");
+					}
+				} else if (queued) {
+					g_wsServer->SendProgress(jobId, state == JobState::Done ? 100 : 0, JobStateToString(state), "Job status");
+				} else {
+					g_wsServer->SendProgress(jobId, 0, "idle", "Plugin ready");
+				}
+			}
+			break;
 
-			} catch (const std::exception& e) {
-				DebugLog("[WEBSOCKET THREAD] HTTP request failed: " + std::string(e.what()));
-				if (g_wsServer) {
-					g_wsServer->SendError(jobId, std::string("HTTP request failed: ") + e.what());
+		case CommandType::Hello:
+			// Health check: answered from the command thread, so a reply
+			// also shows that commands are being processed
+			if (g_wsServer) {
+				g_wsServer->SendToSession(command.sessionId, FormatHello("hello"));
+			}
+			break;
+
+		case CommandType::GetWorkerInfo:
+			if (g_wsServer) {
+				g_wsServer->SendToSession(command.sessionId, FormatWorkerInfo(GetWorkerInfo(), "worker_info"));
+			}
+			break;
+
+		case CommandType::Benchmark:
+			// Benchmark driver (Tools/Benchmark): "begin" clears the stage
+			// statistics, "sample" reports memory, "end" adds the statistics
+			if (g_wsServer) {
+				std::string action = command.body.GetString({ "action" }, "sample");
+				if (action == "begin") {
+					ConversionHandler::GetMetrics().ResetStatistics();
+				}
+
+				ProcessMemory memory;
+				GetProcessMemory(memory);
+
+				JsonWriter writer;
+				writer.BeginObject()
+					  .Field("type", "benchmark")
+					  .Field("action", action)
+					  .Field("archicadVersion", g_archicadVersion)
+					  .Field("warmSession", ConversionHandler::IsWarmSession())
+					  .Field("running", ConversionHandler::HasRunningJob())
+					  .Field("queued", ConversionHandler::GetQueueDepth())
+					  .Key("process").Raw(memory.ToJson());
+				if (action == "end") {
+					writer.Key("metrics").Raw(ConversionHandler::GetMetrics().FormatJson(g_wsServer->GetQueueStats().ToJson(),
+					                                                                         ConversionHandler::GetMemoryPolicy().FormatJson()));
 				}
+				writer.EndObject();
+				g_wsServer->SendToSession(command.sessionId, writer.ToPayload());
 			}
+			break;
 
-		} catch (const std::exception& e) {
-			DebugLog("[WEBSOCKET THREAD] Exception: " + std::string(e.what()));
+		case CommandType::GetMetrics:
 			if (g_wsServer) {
-				g_wsServer->SendError(jobId, std::string("Exception: ") + e.what());
+				// "format": "prometheus" wraps the text exposition format for scrapers
+				if (command.body.GetString({ "format" }) == "prometheus") {
+					JsonWriter writer;
+					writer.BeginObject()
+						  .Field("type", "metrics")
+						  .Field("format", "prometheus")
+						  .Field("text", ConversionHandler::GetMetrics().FormatPrometheus() + g_wsServer->GetQueueStats().ToPrometheus() +
+						                  ConversionHandler::GetMemoryPolicy().FormatPrometheus())
+						  .EndObject();
+					g_wsServer->SendToSession(command.sessionId, writer.ToPayload());
+				} else {
+					g_wsServer->SendToSession(command.sessionId, ConversionHandler::GetMetrics().FormatJson(g_wsServer->GetQueueStats().ToJson(),
+					                                                                                         ConversionHandler::GetMemoryPolicy().FormatJson()));
+				}
+			}
+			break;
+
+		case CommandType::LoadIfc: {
+			// Comando simples para carregar IFC - igual ao menu
+			if (g_wsServer && !g_wsServer->ClaimSubmission(command)) {
+				break;
+			}
+
+			ConversionJob job;
+			job.jobId = jobId;
+			job.type = JobType::LoadIfc;
+			job.priority = command.priority;
+			job.tenant = command.tenant;
+			job.inputPath = command.ifcPath;
+
+			LOG_INFO("[COMMAND THREAD] Load IFC: '" << job.inputPath << "'");
+
+			if (job.inputPath.empty()) {
+				LOG_WARN("[COMMAND THREAD] Missing ifcPath!");
+				if (g_wsServer) {
+					RejectSubmission(jobId, "Missing ifcPath parameter");
+				}
+				return;
 			}
+
+			SubmitAfterPreflight(job);
+			break;
 		}
+
+		default:
+			LOG_INFO("[COMMAND THREAD] Ignoring unsupported command: " << command.name);
+			break;
 	}
 }
 
-void StartWebSocketServer()
+// Helper to tell the user about the server; headless workers only log
+static void ShowServerNotice(bool error, const std::string& title, const std::string& message, const std::string& detail)
 {
-	if (g_wsServer && g_wsServer->IsRunning()) {
-		DGAlert(DG_INFORMATION, GS::UniString("Info"),
-		        GS::UniString("WebSocket server is already running"),
-		        GS::UniString(), GS::UniString("OK"));
-		return;
+	if (error) {
+		LOG_ERROR(message << (detail.empty() ? "" : ": ") << detail);
+	} else {
+		LOG_INFO(message);
+	}
+
+	if (!g_headless) {
+		DGAlert(error ? DG_ERROR : DG_INFORMATION, GS::UniString(title.c_str()),
+		        GS::UniString(message.c_str()), GS::UniString(detail.c_str()),
+		        GS::UniString("OK"));
 	}
+}
 
+// Start the server and everything behind it (menu command or auto-start)
+static bool LaunchWebSocketServer(std::string& error)
+{
 	if (!g_wsServer) {
 		g_wsServer = std::make_unique<ArchicadWebSocketServer>();
 		g_wsServer->SetCommandCallback(HandleWebSocketCommand);
+		g_wsServer->SetEtaProvider(ConversionHandler::GetJobEta);
+		g_wsServer->SetHelloProvider([]() { return FormatHello("hello"); });
 	}
 
-	bool started = g_wsServer->Start(8081);
+	// Threads running the sessions' socket I/O (commands have their own thread)
+	g_wsServer->SetThreadCount(static_cast<size_t>(std::max(GetEnvInt("ARCHICAD_PLUGIN_WS_THREADS", 2), 1)));
+
+	// permessage-deflate for remote backends; small frames skip it
+	WebSocketCompression compression;
+	compression.enabled = GetEnvInt("ARCHICAD_PLUGIN_WS_DEFLATE", 1) != 0;
+	compression.minMessageBytes = static_cast<size_t>(std::max(GetEnvInt("ARCHICAD_PLUGIN_WS_DEFLATE_MIN_BYTES", 256), 0));
+	compression.level = std::min(std::max(GetEnvInt("ARCHICAD_PLUGIN_WS_DEFLATE_LEVEL", 6), 0), 9);
+	g_wsServer->SetCompression(compression);
+
+	// Bounded write queues: a client saturated above the high watermark for
+	// ARCHICAD_PLUGIN_WS_SATURATED_MS is disconnected, one that reaches four
+	// times the watermark (bytes or frames) at once
+	SessionQueueLimits queueLimits;
+	int queueMegabytes = GetEnvInt("ARCHICAD_PLUGIN_WS_QUEUE_MB", 8);
+	if (queueMegabytes > 0) {
+		queueLimits.highWatermarkBytes = static_cast<size_t>(queueMegabytes) << 20;
+		queueLimits.lowWatermarkBytes = queueLimits.highWatermarkBytes / 4;
+	}
+	queueLimits.maxFrames = static_cast<size_t>(std::max(GetEnvInt("ARCHICAD_PLUGIN_WS_QUEUE_FRAMES", 4096), 16));
+	queueLimits.saturatedTimeoutMs = std::max(GetEnvInt("ARCHICAD_PLUGIN_WS_SATURATED_MS", 10000), 0);
+	queueLimits.hardLimitBytes = queueLimits.highWatermarkBytes * 4;
+	queueLimits.hardLimitFrames = queueLimits.maxFrames * 4;
+	g_wsServer->SetQueueLimits(queueLimits);
+
+	// Job progress reaches clients at most ARCHICAD_PROGRESS_RATE_HZ times a second (0: every update)
+	g_wsServer->SetProgressRate(std::max(GetEnvInt("ARCHICAD_PROGRESS_RATE_HZ", 10), 0));
+
+	// Finished jobs kept for resubmissions and "resume" after a reconnect
+	g_wsServer->GetJobRegistry().SetMaxFinished(static_cast<size_t>(std::max(GetEnvInt("ARCHICAD_JOB_REGISTRY_SIZE", 512), 0)));
+
+	// Result cache: ARCHICAD_RESULT_CACHE_MB=0 disables it
+	int cacheMegabytes = GetEnvInt("ARCHICAD_RESULT_CACHE_MB", 2048);
+	ConversionHandler::ConfigureResultCache(GetEnvString("ARCHICAD_RESULT_CACHE_DIR"),
+	                                        cacheMegabytes > 0 ? static_cast<uint64_t>(cacheMegabytes) << 20 : 0);
+
+	// Memory policy: deep cleanup above ARCHICAD_MEMORY_CLEANUP_MB, recycle
+	// request above ARCHICAD_RECYCLE_RSS_MB or after ARCHICAD_RECYCLE_AFTER_JOBS (0 disables each)
+	MemoryPolicyConfig memoryConfig;
+	memoryConfig.deepCleanupBytes = static_cast<uint64_t>(std::max(GetEnvInt("ARCHICAD_MEMORY_CLEANUP_MB", 0), 0)) << 20;
+	memoryConfig.recycleBytes = static_cast<uint64_t>(std::max(GetEnvInt("ARCHICAD_RECYCLE_RSS_MB", 0), 0)) << 20;
+	memoryConfig.recycleAfterJobs = static_cast<uint64_t>(std::max(GetEnvInt("ARCHICAD_RECYCLE_AFTER_JOBS", 0), 0));
+	ConversionHandler::GetMemoryPolicy().Configure(memoryConfig);
+	if (memoryConfig.deepCleanupBytes || memoryConfig.recycleBytes || memoryConfig.recycleAfterJobs) {
+		LOG_INFO("✓ Memory policy: cleanup " << (memoryConfig.deepCleanupBytes >> 20) << " MB, recycle "
+		         << (memoryConfig.recycleBytes >> 20) << " MB / " << memoryConfig.recycleAfterJobs << " jobs");
+	}
 
-	if (started) {
-		DGAlert(DG_INFORMATION, GS::UniString("Success"),
-		        GS::UniString("✓ WebSocket server started on port 8081"),
-		        GS::UniString("Listening for connections from backend"),
-		        GS::UniString("OK"));
+	// Chunked uploads/downloads, so the backend needs no shared disk:
+	// ARCHICAD_TRANSFER_MAX_MB=0 disables them
+	int transferMegabytes = GetEnvInt("ARCHICAD_TRANSFER_MAX_MB", 4096);
+	std::string transferDir = GetEnvString("ARCHICAD_TRANSFER_DIR");
+	if (transferDir.empty()) {
+		std::error_code ec;
+		std::filesystem::path tempDir = std::filesystem::temp_directory_path(ec);
+		if (!ec) {
+			transferDir = (tempDir / "ifc-plugin-transfers").u8string();
+		}
+	}
+	g_wsServer->GetTransfers().Open(transferDir,
+	                                transferMegabytes > 0 ? static_cast<uint64_t>(transferMegabytes) << 20 : 0,
+	                                GetEnvInt("ARCHICAD_TRANSFER_TTL_HOURS", 24));
+
+	// IFC pre-flight: ARCHICAD_IFC_SCHEMAS lists the accepted schemas
+	g_ifcPreflightEnabled = GetEnvInt("ARCHICAD_IFC_PREFLIGHT", 1) != 0;
+	std::string schemas = GetEnvString("ARCHICAD_IFC_SCHEMAS");
+	if (!schemas.empty()) {
+		IfcPreflight::SetSupportedSchemas(schemas);
+	}
+	if (!g_ifcPreflightEnabled) {
+		g_ifcPreflight.reset();
+	} else if (!g_ifcPreflight) {
+		g_ifcPreflight = std::make_unique<IfcPreflightWorker>();
+		g_ifcPreflight->Start();
+	}
+
+	// Post-processing of outputs (start_conversion "checksum"/"compress")
+	if (!g_artifactProcessor) {
+		g_artifactProcessor = std::make_unique<ArtifactProcessor>();
+	}
+	g_artifactProcessor->Start();
+
+	// Warm sessions are on unless ARCHICAD_WARM_SESSION=0
+	ConversionHandler::SetWarmSession(GetEnvInt("ARCHICAD_WARM_SESSION", 1) != 0);
+	ConfigureScheduling();
+	ConfigureStaging();
+	ConversionHandler::StartScheduler(DispatchJob, OnJobEvent);
+
+	// Several Archicad instances can share a machine: start at the configured
+	// port and take the first free one within ARCHICAD_PLUGIN_WS_PORT_SPAN.
+	// ARCHICAD_PLUGIN_WS_BIND restricts the interface (e.g. 127.0.0.1).
+	int basePort = GetEnvInt("ARCHICAD_PLUGIN_WS_PORT", 8081);
+	int portSpan = GetEnvInt("ARCHICAD_PLUGIN_WS_PORT_SPAN", 10);
+	if (portSpan < 1) {
+		portSpan = 1;
+	}
+	std::string bindAddress = GetEnvString("ARCHICAD_PLUGIN_WS_BIND");
+
+	bool started = false;
+	for (int port = basePort; port < basePort + portSpan && !started; ++port) {
+		started = g_wsServer->Start(port, bindAddress);
+	}
+
+	if (!started) {
+		error = "Check if a port in " + std::to_string(basePort) + "-" + std::to_string(basePort + portSpan - 1) +
+		        (bindAddress.empty() ? std::string() : " on " + bindAddress) + " is available";
+		return false;
+	}
+
+	std::string coordinatorUrl = GetEnvString("ARCHICAD_COORDINATOR_URL");
+	if (!coordinatorUrl.empty()) {
+		g_workerRegistration = std::make_unique<WorkerRegistration>();
+		g_workerRegistration->Start(coordinatorUrl, GetWorkerInfo);
+	}
+
+	// Jobs run from the event loop, which during auto-start is still
+	// starting up: announce readiness once a task posted now has run
+	if (!g_workerReady) {
+		MainThreadChannel::Post([]() {
+			g_workerReady = true;
+			LOG_INFO("✓ Worker ready");
+			if (g_wsServer) {
+				g_wsServer->BroadcastMessage(FormatHello("ready"));
+			}
+		});
+	}
+
+	return true;
+}
+
+void StartWebSocketServer()
+{
+	if (g_wsServer && g_wsServer->IsRunning()) {
+		ShowServerNotice(false, "Info", "WebSocket server is already running", std::string());
+		return;
+	}
+
+	std::string error;
+	if (LaunchWebSocketServer(error)) {
+		ShowServerNotice(false, "Success", "✓ WebSocket server started on port " + std::to_string(g_wsServer->GetPort()),
+		                 "Listening for connections from backend");
 	} else {
-		DGAlert(DG_ERROR, GS::UniString("Error"),
-		        GS::UniString("✗ Failed to start WebSocket server"),
-		        GS::UniString("Check if port 8081 is available"),
-		        GS::UniString("OK"));
+		ShowServerNotice(true, "Error", "✗ Failed to start WebSocket server", error);
+	}
+}
+
+void AutoStartWebSocketServer()
+{
+	std::string error;
+	if (LaunchWebSocketServer(error)) {
+		LOG_INFO("✓ WebSocket server auto-started on port " << g_wsServer->GetPort() << (g_headless ? " (headless)" : ""));
+	} else {
+		LOG_ERROR("✗ Failed to auto-start WebSocket server: " << error);
 	}
 }
 
 void StopWebSocketServer()
 {
 	if (!g_wsServer || !g_wsServer->IsRunning()) {
-		DGAlert(DG_INFORMATION, GS::UniString("Info"),
-		        GS::UniString("WebSocket server is not running"),
-		        GS::UniString(), GS::UniString("OK"));
+		ShowServerNotice(false, "Info", "WebSocket server is not running", std::string());
 		return;
 	}
 
+	// Everything LaunchWebSocketServer() started goes with the server, in
+	// the order FreeData() stops it: queued jobs are reported cancelled and
+	// outputs still being packed get an error completion while clients are
+	// still connected
+	g_ifcPreflight.reset();
+	ConversionHandler::StopScheduler();
+	if (g_artifactProcessor) {
+		g_artifactProcessor->Stop();
+	}
+
+	g_workerRegistration.reset();
 	g_wsServer->Stop();
 
-	DGAlert(DG_INFORMATION, GS::UniString("Success"),
-	        GS::UniString("✓ WebSocket server stopped"),
-	        GS::UniString(), GS::UniString("OK"));
+	ShowServerNotice(false, "Success", "✓ WebSocket server stopped", std::string());
 }
 #endif
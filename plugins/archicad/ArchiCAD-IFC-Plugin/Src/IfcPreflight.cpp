@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "IfcPreflight.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Static member initialization
+std::mutex IfcPreflight::s_schemaMutex;
+std::vector<std::string> IfcPreflight::s_schemas = { "IFC2X3", "IFC4", "IFC4X3" };
+
+// The HEADER section is looked for this far into the file
+static const size_t kHeaderSearchBytes = 1 << 20;
+
+static const char kStepMagic[] = "ISO-10303-21;";
+static const char kStepTrailer[] = "END-ISO-10303-21;";
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path, std::string& error)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(std::filesystem::u8path(path).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            error = "Cannot open IFC file (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) {
+            error = "Cannot read IFC file size";
+            return false;
+        }
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        if (m_size == 0) {
+            return true;
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            error = "Cannot map IFC file (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        m_fd = open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            error = std::string("Cannot open IFC file: ") + std::strerror(errno);
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(m_fd, &info) != 0) {
+            error = "Cannot read IFC file size";
+            return false;
+        }
+        m_size = static_cast<uint64_t>(info.st_size);
+        if (m_size == 0) {
+            return true;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+        }
+#endif
+        if (m_data == nullptr) {
+            error = "Cannot map IFC file";
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data != nullptr) {
+            munmap(const_cast<char*>(m_data), static_cast<size_t>(m_size));
+        }
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const char* Data() const { return m_data; }
+    uint64_t Size() const { return m_size; }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    const char* m_data = nullptr;
+    uint64_t m_size = 0;
+};
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool IsNameChar(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static std::string ToUpper(std::string text)
+{
+    for (char& c : text) {
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+    }
+    return text;
+}
+
+// Helper to find a keyword in [begin, end)
+static const char* Find(const char* begin, const char* end, const char* keyword)
+{
+    std::string_view haystack(begin, static_cast<size_t>(end - begin));
+    size_t found = haystack.find(keyword);
+    return found == std::string_view::npos ? nullptr : begin + found;
+}
+
+// Reads the top-level arguments of "KEYWORD(...)": strings are unquoted,
+// anything else (lists, $, *) is kept as written
+static bool ReadStepArguments(const char* p, const char* end, std::vector<std::string>& args)
+{
+    while (p < end && *p != '(') {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+    ++p;
+
+    std::string current;
+    int depth = 0;
+    while (p < end) {
+        char c = *p++;
+        if (c == '\'') {
+            // '' is an escaped quote inside a STEP string
+            while (p < end) {
+                if (*p == '\'') {
+                    if (p + 1 < end && p[1] == '\'') {
+                        current.push_back('\'');
+                        p += 2;
+                        continue;
+                    }
+                    ++p;
+                    break;
+                }
+                current.push_back(*p++);
+            }
+        } else if (c == '(') {
+            ++depth;
+            current.push_back(c);
+        } else if (c == ')') {
+            if (depth == 0) {
+                args.push_back(current);
+                return true;
+            }
+            --depth;
+            current.push_back(c);
+        } else if (c == ',' && depth == 0) {
+            args.push_back(current);
+            current.clear();
+        } else if (!IsSpace(c) || depth > 0) {
+            current.push_back(c);
+        }
+    }
+    return false;
+}
+
+// Helper to format a duration with one decimal
+static std::string FormatMilliseconds(double value)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.1f", value);
+    return text;
+}
+
+std::string IfcPreflightReport::ToJson(size_t maxTypes) const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("ok", ok)
+          .Field("size", size);
+    if (!error.empty()) {
+        writer.Field("error", error);
+    }
+    if (compressed) {
+        writer.Field("compressed", true);
+    }
+    if (!schema.empty()) {
+        writer.Field("schema", schema);
+    }
+    if (!fileName.empty()) {
+        writer.Field("fileName", fileName);
+    }
+    if (!originatingSystem.empty()) {
+        writer.Field("originatingSystem", originatingSystem);
+    }
+    if (entityCount > 0) {
+        writer.Field("entities", entityCount);
+        writer.Key("types").BeginObject();
+        for (size_t i = 0; i < entityTypes.size() && i < maxTypes; ++i) {
+            writer.Field(entityTypes[i].first.c_str(), entityTypes[i].second);
+        }
+        writer.EndObject();
+    }
+    writer.Key("durationMs").Raw(FormatMilliseconds(durationMs));
+    writer.EndObject();
+    return writer.ToString();
+}
+
+void IfcPreflight::SetSupportedSchemas(const std::string& schemas)
+{
+    std::vector<std::string> names;
+    size_t start = 0;
+    while (start <= schemas.size()) {
+        size_t comma = schemas.find(',', start);
+        std::string name = schemas.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        name.erase(std::remove_if(name.begin(), name.end(), IsSpace), name.end());
+        if (!name.empty()) {
+            names.push_back(ToUpper(name));
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+
+    std::lock_guard<std::mutex> lock(s_schemaMutex);
+    s_schemas.swap(names);
+}
+
+bool IfcPreflight::IsSupportedSchema(const std::string& schema)
+{
+    std::string upper = ToUpper(schema);
+
+    std::lock_guard<std::mutex> lock(s_schemaMutex);
+    if (s_schemas.empty()) {
+        return true;
+    }
+    for (const std::string& name : s_schemas) {
+        if (upper == name || upper.compare(0, name.size() + 1, name + "_") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IfcPreflight::Scan(const std::string& path, IfcPreflightReport& report)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto finish = [&report, start](const std::string& error) {
+        report.ok = error.empty();
+        report.error = error;
+        report.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report.ok;
+    };
+
+    report = IfcPreflightReport();
+
+    MappedFile file;
+    std::string error;
+    if (!file.Open(path, error)) {
+        return finish(error);
+    }
+
+    report.size = file.Size();
+    if (report.size == 0) {
+        return finish("IFC file is empty");
+    }
+
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+
+    // IFCZIP: Archicad unpacks it itself
+    if (file.Size() >= 4 && std::memcmp(begin, "PK\x03\x04", 4) == 0) {
+        report.compressed = true;
+        return finish(std::string());
+    }
+
+    // Header: "ISO-10303-21;" then HEADER; ... ENDSEC;
+    const char* p = begin;
+    if (file.Size() >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3;
+    }
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    size_t magicLength = sizeof(kStepMagic) - 1;
+    if (static_cast<size_t>(end - p) < magicLength || std::memcmp(p, kStepMagic, magicLength) != 0) {
+        return finish("Not an IFC file (no ISO-10303-21 header)");
+    }
+
+    const char* searchEnd = begin + std::min<uint64_t>(file.Size(), kHeaderSearchBytes);
+    const char* header = Find(p, searchEnd, "HEADER;");
+    const char* headerEnd = header != nullptr ? Find(header, searchEnd, "ENDSEC;") : nullptr;
+    if (headerEnd == nullptr) {
+        return finish("IFC file has no HEADER section");
+    }
+
+    std::vector<std::string> args;
+    const char* schema = Find(header, headerEnd, "FILE_SCHEMA");
+    if (schema == nullptr || !ReadStepArguments(schema, headerEnd, args) || args.empty()) {
+        return finish("IFC HEADER has no FILE_SCHEMA");
+    }
+    // FILE_SCHEMA(('IFC4')) - the schema list is a single argument
+    std::string schemaList = args[0];
+    size_t first = schemaList.find_first_not_of("(");
+    if (first != std::string::npos) {
+        report.schema = ToUpper(schemaList.substr(first, schemaList.find_first_of(",)", first) - first));
+    }
+    if (report.schema.empty()) {
+        return finish("IFC HEADER has no FILE_SCHEMA");
+    }
+
+    // FILE_NAME(name, time_stamp, author, organization, preprocessor, originating_system, authorization)
+    args.clear();
+    const char* fileName = Find(header, headerEnd, "FILE_NAME");
+    if (fileName != nullptr && ReadStepArguments(fileName, headerEnd, args)) {
+        report.fileName = args.size() > 0 ? args[0] : std::string();
+        report.originatingSystem = args.size() > 5 ? args[5] : std::string();
+    }
+
+    if (!IsSupportedSchema(report.schema)) {
+        return finish("Unsupported IFC schema '" + report.schema + "'");
+    }
+
+    // Trailer: a truncated export stops somewhere in DATA
+    const char* last = end;
+    while (last > headerEnd && (IsSpace(last[-1]) || last[-1] == '\0')) {
+        --last;
+    }
+    size_t trailerLength = sizeof(kStepTrailer) - 1;
+    if (static_cast<size_t>(last - headerEnd) < trailerLength ||
+        std::memcmp(last - trailerLength, kStepTrailer, trailerLength) != 0) {
+        return finish("IFC file is truncated (no END-ISO-10303-21; trailer)");
+    }
+    const char* trailer = last - trailerLength;
+
+    const char* data = Find(headerEnd, std::min(trailer, headerEnd + kHeaderSearchBytes), "DATA;");
+    if (data == nullptr) {
+        return finish("IFC file has no DATA section");
+    }
+
+    // Entities: lines starting with "#<id>=TYPE(". memchr finds the line
+    // breaks (vectorized in the C runtimes we build with), so only the
+    // first few bytes of a line are looked at one by one.
+    std::unordered_map<std::string_view, uint64_t> counts;
+    const char* line = data + 5;
+    while (line < trailer) {
+        const char* next = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(trailer - line)));
+        const char* lineEnd = next != nullptr ? next : trailer;
+
+        const char* c = line;
+        while (c < lineEnd && (*c == ' ' || *c == '\t')) {
+            ++c;
+        }
+        if (c < lineEnd && *c == '#') {
+            ++c;
+            while (c < lineEnd && *c >= '0' && *c <= '9') {
+                ++c;
+            }
+            while (c < lineEnd && (*c == ' ' || *c == '\t')) {
+                ++c;
+            }
+            if (c < lineEnd && *c == '=') {
+                ++c;
+                while (c < lineEnd && (*c == ' ' || *c == '\t')) {
+                    ++c;
+                }
+                const char* name = c;
+                while (c < lineEnd && IsNameChar(*c)) {
+                    ++c;
+                }
+                if (c > name) {
+                    ++counts[std::string_view(name, static_cast<size_t>(c - name))];
+                    ++report.entityCount;
+                }
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+
+    report.entityTypes.reserve(counts.size());
+    for (const auto& entry : counts) {
+        report.entityTypes.emplace_back(ToUpper(std::string(entry.first)), entry.second);
+    }
+    std::sort(report.entityTypes.begin(), report.entityTypes.end(),
+              [](const std::pair<std::string, uint64_t>& a, const std::pair<std::string, uint64_t>& b) {
+                  return a.second != b.second ? a.second > b.second : a.first < b.first;
+              });
+
+    if (report.entityCount == 0) {
+        return finish("IFC DATA section has no entities");
+    }
+    return finish(std::string());
+}
+
+IfcPreflightWorker::IfcPreflightWorker()
+    : m_running(false)
+{
+}
+
+IfcPreflightWorker::~IfcPreflightWorker()
+{
+    Stop();
+}
+
+void IfcPreflightWorker::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&IfcPreflightWorker::Run, this);
+}
+
+void IfcPreflightWorker::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_tasks.clear();
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool IfcPreflightWorker::Submit(const std::string& path, Callback done)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return false;
+        }
+        m_tasks.emplace_back(path, std::move(done));
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void IfcPreflightWorker::Run()
+{
+    for (;;) {
+        std::pair<std::string, Callback> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_running || !m_tasks.empty(); });
+            if (!m_running) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        IfcPreflightReport report;
+        IfcPreflight::Scan(task.first, report);
+        if (report.ok) {
+            LOG_DEBUG("✓ Pre-flight " << task.first << ": " << report.schema << ", "
+                      << report.entityCount << " entities (" << report.durationMs << " ms)");
+        } else {
+            LOG_WARN("✗ Pre-flight rejected " << task.first << ": " << report.error);
+        }
+
+        if (task.second) {
+            task.second(report);
+        }
+    }
+}
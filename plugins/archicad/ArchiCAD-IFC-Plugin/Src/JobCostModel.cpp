@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JobCostModel.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+// Samples a type needs before its fit replaces the first guess
+static const uint64_t kMinSamples = 3;
+
+// First guess: open + save of a typical project
+static const double kPriorBaseMs = 10000.0;
+static const double kPriorMsPerMegabyte = 500.0;
+
+// Ridge term that keeps the fit solvable while a feature never varies
+// (PLN inputs have no entity count)
+static const double kRidge = 1e-3;
+
+static const double kMinPredictionMs = 100.0;
+
+JobCostModel::JobCostModel(double decay)
+    : m_decay(decay > 0.0 && decay <= 1.0 ? decay : 1.0)
+{
+}
+
+void JobCostModel::Features(uint64_t inputBytes, uint64_t entityCount, double x[3])
+{
+    x[0] = 1.0;
+    x[1] = static_cast<double>(inputBytes) / (1024.0 * 1024.0);
+    x[2] = static_cast<double>(entityCount) / 1000.0;
+}
+
+double JobCostModel::Predict(JobType type, uint64_t inputBytes, uint64_t entityCount) const
+{
+    double x[3];
+    Features(inputBytes, entityCount, x);
+
+    Fit fit;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_fits.find(type);
+        if (it != m_fits.end()) {
+            fit = it->second;
+        }
+    }
+
+    if (fit.samples < kMinSamples) {
+        return std::max(kPriorBaseMs + kPriorMsPerMegabyte * x[1], kMinPredictionMs);
+    }
+
+    // Solve (XtX + ridge) c = Xty by Gaussian elimination with partial pivoting
+    double a[3][4];
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            a[row][col] = fit.xtx[row][col] + (row == col && row > 0 ? kRidge * fit.xtx[0][0] : 0.0);
+        }
+        a[row][3] = fit.xty[row];
+    }
+    for (int col = 0; col < 3; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < 3; ++row) {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (std::fabs(a[pivot][col]) < 1e-12) {
+            continue;
+        }
+        for (int k = 0; k < 4; ++k) {
+            std::swap(a[col][k], a[pivot][k]);
+        }
+        for (int row = 0; row < 3; ++row) {
+            if (row != col) {
+                double factor = a[row][col] / a[col][col];
+                for (int k = col; k < 4; ++k) {
+                    a[row][k] -= factor * a[col][k];
+                }
+            }
+        }
+    }
+
+    double prediction = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        double coefficient = std::fabs(a[i][i]) < 1e-12 ? 0.0 : a[i][3] / a[i][i];
+        prediction += coefficient * x[i];
+    }
+
+    // A fit over few, similar inputs can extrapolate below zero; fall back
+    // to the weighted mean run time then
+    if (!std::isfinite(prediction) || prediction <= 0.0) {
+        prediction = fit.xty[0] / fit.xtx[0][0];
+    }
+    return std::max(prediction, kMinPredictionMs);
+}
+
+double JobCostModel::Predict(const ConversionJob& job) const
+{
+    if (job.type == JobType::Batch) {
+        double total = 0.0;
+        for (const BatchItem& item : job.items) {
+            total += Predict(item.type, FileBytes(item.inputPath), 0);
+        }
+        return std::max(total, kMinPredictionMs);
+    }
+
+    uint64_t bytes = job.inputBytes > 0 ? job.inputBytes : FileBytes(job.inputPath);
+    return Predict(job.type, bytes, job.entityCount);
+}
+
+void JobCostModel::Observe(JobType type, uint64_t inputBytes, uint64_t entityCount, double runMs)
+{
+    if (!(runMs > 0.0) || !std::isfinite(runMs)) {
+        return;
+    }
+
+    double x[3];
+    Features(inputBytes, entityCount, x);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Fit& fit = m_fits[type];
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            fit.xtx[row][col] = fit.xtx[row][col] * m_decay + x[row] * x[col];
+        }
+        fit.xty[row] = fit.xty[row] * m_decay + x[row] * runMs;
+    }
+    ++fit.samples;
+}
+
+uint64_t JobCostModel::GetSampleCount(JobType type) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_fits.find(type);
+    return it != m_fits.end() ? it->second.samples : 0;
+}
+
+uint64_t JobCostModel::FileBytes(const std::string& path)
+{
+    if (path.empty()) {
+        return 0;
+    }
+
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(std::filesystem::u8path(path), ec);
+    return ec ? 0 : size;
+}
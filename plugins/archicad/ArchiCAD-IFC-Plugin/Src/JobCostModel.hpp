@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_COST_MODEL_HPP
+#define JOB_COST_MODEL_HPP
+
+#include "JobQueue.hpp"
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Predicts how long a job will run from the size of its input
+ *
+ * One linear model per job type,
+ * ms = base + perMegabyte * MB + perThousandEntities * (entities / 1000),
+ * fitted by least squares over the jobs that really ran on the main thread.
+ * Older runs fade out (exponential decay), so the model follows changes in
+ * the machine or Archicad version. Until a type has a few samples the
+ * prediction is a conservative first guess. Thread-safe.
+ */
+class JobCostModel {
+public:
+    /**
+     * @param decay Weight kept by older samples on each new one (0..1]
+     */
+    explicit JobCostModel(double decay = 0.98);
+
+    /**
+     * @brief Predicted run time in milliseconds (never below 100 ms)
+     * @param entityCount IFC entity instances, 0 if unknown
+     */
+    double Predict(JobType type, uint64_t inputBytes, uint64_t entityCount) const;
+
+    /**
+     * @brief Predicted run time of a job; a batch adds up its items
+     *
+     * Inputs of unknown size are looked up on disk.
+     */
+    double Predict(const ConversionJob& job) const;
+
+    /**
+     * @brief Learn from a finished job
+     * @param runMs Time it spent on the main thread
+     */
+    void Observe(JobType type, uint64_t inputBytes, uint64_t entityCount, double runMs);
+
+    /**
+     * @brief Samples learned for a job type
+     */
+    uint64_t GetSampleCount(JobType type) const;
+
+    /**
+     * @brief Size of a file in bytes, 0 if it cannot be read
+     */
+    static uint64_t FileBytes(const std::string& path);
+
+private:
+    // Normal equations of the weighted least-squares fit
+    struct Fit {
+        double xtx[3][3] = {};
+        double xty[3] = {};
+        uint64_t samples = 0;
+    };
+
+    static void Features(uint64_t inputBytes, uint64_t entityCount, double x[3]);
+
+    mutable std::mutex m_mutex;
+    double m_decay;
+    std::map<JobType, Fit> m_fits;
+};
+
+#endif // JOB_COST_MODEL_HPP
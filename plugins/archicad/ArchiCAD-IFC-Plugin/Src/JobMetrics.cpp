@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JobMetrics.hpp"
+#include "JsonWriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+const char* JobStageToString(JobStage stage)
+{
+    switch (stage) {
+        case JobStage::QueueWait:        return "queue_wait";
+        case JobStage::Staging:          return "staging";
+        case JobStage::Dispatch:         return "dispatch";
+        case JobStage::Close:            return "close";
+        case JobStage::Open:             return "open";
+        case JobStage::TranslatorLookup: return "translator_lookup";
+        case JobStage::Save:             return "save";
+        case JobStage::Cleanup:          return "cleanup";
+        case JobStage::BlankTemplate:    return "blank_template";
+        case JobStage::PostProcess:      return "post_process";
+        case JobStage::Total:            return "total";
+        case JobStage::Count:            break;
+    }
+    return "unknown";
+}
+
+// Helper to name a job type in metric labels
+static const char* JobTypeLabel(JobType type)
+{
+    switch (type) {
+        case JobType::PlnToIfc: return "pln_to_ifc";
+        case JobType::IfcToPln: return "ifc_to_pln";
+        case JobType::LoadIfc:  return "load_ifc";
+        case JobType::Batch:    return "batch";
+    }
+    return "unknown";
+}
+
+// Helper to format a number with a fixed number of decimals
+static std::string FormatNumber(double value, int decimals)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+static double MillisecondsSince(JobMetrics::Clock::time_point start, JobMetrics::Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+JobMetrics::JobMetrics(size_t windowSize)
+    : m_windowSize(windowSize > 0 ? windowSize : 1)
+{
+}
+
+void JobMetrics::JobDispatched(const ConversionJob& job)
+{
+    Clock::time_point now = Clock::now();
+    double queueWait = MillisecondsSince(job.enqueuedAt, now);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RunningJob& running = m_jobs[job.jobId];
+    running = RunningJob();
+    running.type = job.type;
+    running.submittedAt = job.enqueuedAt;
+    running.dispatchedAt = now;
+    running.dispatched = true;
+    running.stageMs[static_cast<size_t>(JobStage::QueueWait)] = queueWait;
+    running.stageSeen[static_cast<size_t>(JobStage::QueueWait)] = true;
+    AddSample(job.type, JobStage::QueueWait, queueWait);
+}
+
+void JobMetrics::JobStarted(const std::string& jobId, JobType type)
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        RunningJob& running = m_jobs[jobId];
+        running.type = type;
+        running.submittedAt = now;
+        running.startedAt = now;
+        running.started = true;
+        return;
+    }
+
+    RunningJob& running = it->second;
+    running.startedAt = now;
+    running.started = true;
+    if (running.dispatched) {
+        double dispatch = MillisecondsSince(running.dispatchedAt, now);
+        running.stageMs[static_cast<size_t>(JobStage::Dispatch)] = dispatch;
+        running.stageSeen[static_cast<size_t>(JobStage::Dispatch)] = true;
+        running.dispatched = false;
+        AddSample(running.type, JobStage::Dispatch, dispatch);
+    }
+}
+
+void JobMetrics::Record(const std::string& jobId, JobStage stage, Clock::time_point start)
+{
+    double ms = MillisecondsSince(start, Clock::now());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    it->second.stageMs[static_cast<size_t>(stage)] += ms;
+    it->second.stageSeen[static_cast<size_t>(stage)] = true;
+    AddSample(it->second.type, stage, ms);
+
+    // Staging sits between leaving the queue and the hand-over, so the
+    // dispatch stage starts once it is over
+    if (stage == JobStage::Staging && it->second.dispatched) {
+        it->second.dispatchedAt = Clock::now();
+    }
+}
+
+void JobMetrics::RecordSample(JobType type, JobStage stage, double ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AddSample(type, stage, ms);
+}
+
+bool JobMetrics::GetRunTime(const std::string& jobId, double& ms) const
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end() || !it->second.started) {
+        return false;
+    }
+
+    ms = MillisecondsSince(it->second.startedAt, now);
+    return true;
+}
+
+void JobMetrics::JobFinished(const std::string& jobId)
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    AddSample(it->second.type, JobStage::Total, MillisecondsSince(it->second.submittedAt, now));
+    m_jobs.erase(it);
+}
+
+std::string JobMetrics::FormatJobTimings(const std::string& jobId) const
+{
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return std::string();
+    }
+
+    const RunningJob& running = it->second;
+    JsonWriter writer;
+    writer.BeginObject();
+    for (size_t i = 0; i < static_cast<size_t>(JobStage::Total); ++i) {
+        if (running.stageSeen[i]) {
+            writer.Key(JobStageToString(static_cast<JobStage>(i))).Raw(FormatNumber(running.stageMs[i], 2));
+        }
+    }
+    writer.Key(JobStageToString(JobStage::Total)).Raw(FormatNumber(MillisecondsSince(running.submittedAt, now), 2));
+    writer.EndObject();
+    return writer.ToString();
+}
+
+void JobMetrics::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.clear();
+}
+
+std::string JobMetrics::FormatJson(const std::string& connections, const std::string& memory) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "metrics")
+          .Field("windowSize", m_windowSize)
+          .Field("running", m_jobs.size())
+          .Key("stages").BeginArray();
+    for (const auto& entry : m_stats) {
+        Summary summary = Summarize(entry.second);
+        writer.BeginObject()
+              .Field("jobType", JobTypeLabel(entry.first.first))
+              .Field("stage", JobStageToString(entry.first.second))
+              .Field("count", summary.count)
+              .Key("sumMs").Raw(FormatNumber(summary.sumMs, 1))
+              .Key("p50Ms").Raw(FormatNumber(summary.p50, 1))
+              .Key("p95Ms").Raw(FormatNumber(summary.p95, 1))
+              .Key("p99Ms").Raw(FormatNumber(summary.p99, 1))
+              .EndObject();
+    }
+    writer.EndArray();
+    if (!connections.empty()) {
+        writer.Key("connections").Raw(connections);
+    }
+    if (!memory.empty()) {
+        writer.Key("memory").Raw(memory);
+    }
+    writer.EndObject();
+    return writer.ToString();
+}
+
+std::string JobMetrics::FormatPrometheus() const
+{
+    static const char* kMetric = "ifc_plugin_job_stage_duration_seconds";
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string text;
+    text += "# HELP ifc_plugin_jobs_running Jobs dispatched or running and not finished yet.\n";
+    text += "# TYPE ifc_plugin_jobs_running gauge\n";
+    text += "ifc_plugin_jobs_running " + std::to_string(m_jobs.size()) + "\n";
+
+    text += std::string("# HELP ") + kMetric + " Duration of job stages; quantiles over the last " +
+            std::to_string(m_windowSize) + " samples.\n";
+    text += std::string("# TYPE ") + kMetric + " summary\n";
+
+    for (const auto& entry : m_stats) {
+        Summary summary = Summarize(entry.second);
+        std::string labels = std::string("job_type=\"") + JobTypeLabel(entry.first.first) +
+                             "\",stage=\"" + JobStageToString(entry.first.second) + "\"";
+
+        const std::pair<const char*, double> quantiles[] = {
+            { "0.5", summary.p50 }, { "0.95", summary.p95 }, { "0.99", summary.p99 }
+        };
+        for (const auto& quantile : quantiles) {
+            text += std::string(kMetric) + "{" + labels + ",quantile=\"" + quantile.first + "\"} " +
+                    FormatNumber(quantile.second / 1000.0, 6) + "\n";
+        }
+        text += std::string(kMetric) + "_sum{" + labels + "} " + FormatNumber(summary.sumMs / 1000.0, 6) + "\n";
+        text += std::string(kMetric) + "_count{" + labels + "} " + std::to_string(summary.count) + "\n";
+    }
+    return text;
+}
+
+void JobMetrics::AddSample(JobType type, JobStage stage, double ms)
+{
+    StageStats& stats = m_stats[std::make_pair(type, stage)];
+    if (stats.window.size() < m_windowSize) {
+        stats.window.push_back(ms);
+    } else {
+        stats.window[stats.next] = ms;
+    }
+    stats.next = (stats.next + 1) % m_windowSize;
+    stats.count++;
+    stats.sumMs += ms;
+}
+
+JobMetrics::Summary JobMetrics::Summarize(const StageStats& stats)
+{
+    Summary summary = { stats.count, stats.sumMs, 0.0, 0.0, 0.0 };
+    if (stats.window.empty()) {
+        return summary;
+    }
+
+    std::vector<double> sorted = stats.window;
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest-rank percentile
+    auto percentile = [&sorted](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[rank > 0 ? rank - 1 : 0];
+    };
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
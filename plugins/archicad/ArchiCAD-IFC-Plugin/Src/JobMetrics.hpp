@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_METRICS_HPP
+#define JOB_METRICS_HPP
+
+#include "JobQueue.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Timed stages of a job, from submission to the blank template
+ */
+enum class JobStage {
+    QueueWait,          // Submitted until the scheduler picked it up
+    Staging,            // Waiting for its inputs to be checked/staged after leaving the queue
+    Dispatch,           // Handed to the main thread until it started running
+    Close,              // Closing the previous project
+    Open,               // Opening the input file
+    TranslatorLookup,   // Finding the IFC export translator
+    Save,               // Writing the output file
+    Cleanup,            // Closing the job's project
+    BlankTemplate,      // Opening the blank template afterwards
+    PostProcess,        // Hashing/compressing the output, after the job finished
+    Total,              // Submitted until finished
+    Count
+};
+
+/**
+ * @brief Wire name of a stage ("queue_wait", "open", ...)
+ */
+const char* JobStageToString(JobStage stage);
+
+/**
+ * @brief Per-job stage timings and rolling duration statistics
+ *
+ * Every recorded duration is added to the running job's timings and to a
+ * rolling window (the most recent samples) per job type and stage, from
+ * which p50/p95/p99 are computed on request. Count and sum cover all
+ * samples since the plugin started. A batch adds up the durations of all
+ * its items. Thread-safe.
+ */
+class JobMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param windowSize Samples kept per job type and stage for percentiles
+     */
+    explicit JobMetrics(size_t windowSize = 1024);
+
+    /**
+     * @brief Start timing a job that left the queue; records its queue wait
+     */
+    void JobDispatched(const ConversionJob& job);
+
+    /**
+     * @brief Mark a job as running on the main thread; records the dispatch
+     *        latency. Jobs that did not come through the queue (Add-On
+     *        commands) start their timings here.
+     */
+    void JobStarted(const std::string& jobId, JobType type);
+
+    /**
+     * @brief Record a stage that began at start and ends now
+     *
+     * Ignored for jobs that are not being timed.
+     */
+    void Record(const std::string& jobId, JobStage stage, Clock::time_point start);
+
+    /**
+     * @brief Add a duration to the rolling statistics only
+     *
+     * For stages that run after the job finished (post-processing on a
+     * worker thread), so they do not count towards its total.
+     */
+    void RecordSample(JobType type, JobStage stage, double ms);
+
+    /**
+     * @brief Time since the job started on the main thread
+     * @return false if it is not timed or never started (cache hits)
+     */
+    bool GetRunTime(const std::string& jobId, double& ms) const;
+
+    /**
+     * @brief Record the job's total time and stop timing it
+     */
+    void JobFinished(const std::string& jobId);
+
+    /**
+     * @brief Forget the rolling statistics (jobs being timed carry on)
+     *
+     * Lets a benchmark run report only its own jobs.
+     */
+    void ResetStatistics();
+
+    /**
+     * @brief The job's timings so far as a JSON object ("" if not timed)
+     *
+     * @code
+     * { "queue_wait_ms": 1.2, "dispatch_ms": 0.4, "open_ms": 812.5, ..., "total_ms": 2431.0 }
+     * @endcode
+     */
+    std::string FormatJobTimings(const std::string& jobId) const;
+
+    /**
+     * @brief Statistics as a "metrics" protocol message
+     * @param connections Connection statistics as a JSON object, sent as "connections" ("" for none)
+     * @param memory Process memory state as a JSON object, sent as "memory" ("" for none)
+     */
+    std::string FormatJson(const std::string& connections = std::string(),
+                           const std::string& memory = std::string()) const;
+
+    /**
+     * @brief Statistics in the Prometheus text exposition format
+     */
+    std::string FormatPrometheus() const;
+
+private:
+    struct RunningJob {
+        JobType type = JobType::PlnToIfc;
+        Clock::time_point submittedAt;
+        Clock::time_point dispatchedAt;
+        Clock::time_point startedAt;
+        bool dispatched = false;
+        bool started = false;
+        double stageMs[static_cast<size_t>(JobStage::Count)] = {};
+        bool stageSeen[static_cast<size_t>(JobStage::Count)] = {};
+    };
+
+    struct StageStats {
+        std::vector<double> window;     // Ring buffer of recent samples
+        size_t next = 0;
+        uint64_t count = 0;
+        double sumMs = 0.0;
+    };
+
+    struct Summary {
+        uint64_t count;
+        double sumMs;
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    void AddSample(JobType type, JobStage stage, double ms);
+    static Summary Summarize(const StageStats& stats);
+
+    mutable std::mutex m_mutex;
+    size_t m_windowSize;
+    std::map<std::string, RunningJob> m_jobs;
+    std::map<std::pair<JobType, JobStage>, StageStats> m_stats;
+};
+
+#endif // JOB_METRICS_HPP
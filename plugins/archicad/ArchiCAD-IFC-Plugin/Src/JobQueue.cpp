@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JobQueue.hpp"
+
+#include <algorithm>
+
+// Number of finished jobs remembered for status queries
+static const size_t kFinishedHistorySize = 256;
+
+const char* JobStateToString(JobState state)
+{
+    switch (state) {
+        case JobState::Queued:    return "queued";
+        case JobState::Running:   return "processing";
+        case JobState::Done:      return "completed";
+        case JobState::Failed:    return "error";
+        case JobState::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+const char* JobTypeToCommandName(JobType type)
+{
+    switch (type) {
+        case JobType::PlnToIfc: return "ConvertPlnToIfc";
+        case JobType::IfcToPln: return "ConvertIfcToPln";
+        case JobType::LoadIfc:  return "LoadIfc";
+        case JobType::Batch:    return "ConvertBatch";
+    }
+    return "";
+}
+
+bool SchedulingPolicyFromString(const std::string& name, SchedulingPolicy& policy)
+{
+    if (name == "fifo") {
+        policy = SchedulingPolicy::Fifo;
+    } else if (name == "sjf" || name == "shortest") {
+        policy = SchedulingPolicy::ShortestFirst;
+    } else if (name == "fair" || name == "wfq") {
+        policy = SchedulingPolicy::FairShare;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* SchedulingPolicyToString(SchedulingPolicy policy)
+{
+    switch (policy) {
+        case SchedulingPolicy::Fifo:          return "fifo";
+        case SchedulingPolicy::ShortestFirst: return "sjf";
+        case SchedulingPolicy::FairShare:     return "fair";
+    }
+    return "fifo";
+}
+
+static double MillisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+JobQueue::JobQueue(size_t maxDepth)
+    : m_policy(SchedulingPolicy::Fifo)
+    , m_aging(1.0)
+    , m_virtualTime(0.0)
+    , m_hasRunning(false)
+    , m_maxDepth(maxDepth)
+    , m_nextSequence(0)
+{
+}
+
+JobQueue::EnqueueResult JobQueue::Enqueue(ConversionJob job, size_t& position)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if ((m_hasRunning && m_running.jobId == job.jobId) || FindQueued(job.jobId) != m_queued.end()) {
+        return EnqueueResult::Duplicate;
+    }
+
+    if (m_queued.size() >= m_maxDepth) {
+        return EnqueueResult::QueueFull;
+    }
+
+    job.state = JobState::Queued;
+    job.sequence = m_nextSequence++;
+    job.enqueuedAt = std::chrono::steady_clock::now();
+
+    // Fair share: a tenant's jobs follow each other in virtual time, each
+    // taking its predicted run time divided by the tenant's weight
+    auto weight = m_tenantWeights.find(job.tenant);
+    double share = weight != m_tenantWeights.end() ? weight->second : 1.0;
+    double& tenantFinish = m_tenantFinish[job.tenant];
+    job.fairStart = std::max(m_virtualTime, tenantFinish);
+    job.fairFinish = job.fairStart + std::max(job.predictedMs, 1.0) / share;
+    tenantFinish = job.fairFinish;
+
+    m_queued.push_back(std::move(job));
+
+    std::vector<size_t> order = OrderLocked(m_queued.back().enqueuedAt);
+    position = static_cast<size_t>(std::find(order.begin(), order.end(), m_queued.size() - 1) - order.begin()) + 1;
+    return EnqueueResult::Accepted;
+}
+
+bool JobQueue::PopNext(ConversionJob& job)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_hasRunning || m_queued.empty()) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    size_t next = OrderLocked(now).front();
+    m_running = std::move(m_queued[next]);
+    m_queued.erase(m_queued.begin() + static_cast<std::ptrdiff_t>(next));
+    m_running.state = JobState::Running;
+    m_running.startedAt = now;
+    m_hasRunning = true;
+    m_virtualTime = std::max(m_virtualTime, m_running.fairStart);
+
+    job = m_running;
+    return true;
+}
+
+bool JobQueue::Finish(const std::string& jobId, JobState finalState, ConversionJob* finished)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_hasRunning || m_running.jobId != jobId) {
+        return false;
+    }
+
+    if (finished != nullptr) {
+        *finished = m_running;
+    }
+    m_hasRunning = false;
+    RememberFinished(m_running.jobId, finalState);
+    m_running = ConversionJob();
+    return true;
+}
+
+bool JobQueue::CancelQueued(const std::string& jobId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = FindQueued(jobId);
+    if (it == m_queued.end()) {
+        return false;
+    }
+
+    RememberFinished(it->jobId, JobState::Cancelled);
+    m_queued.erase(it);
+    return true;
+}
+
+bool JobQueue::GetState(const std::string& jobId, JobState& state, size_t& position) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    position = 0;
+
+    if (m_hasRunning && m_running.jobId == jobId) {
+        state = JobState::Running;
+        return true;
+    }
+
+    std::vector<size_t> order = OrderLocked(std::chrono::steady_clock::now());
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (m_queued[order[i]].jobId == jobId) {
+            state = JobState::Queued;
+            position = i + 1;
+            return true;
+        }
+    }
+
+    // Most recent entries are at the back
+    for (auto it = m_finished.rbegin(); it != m_finished.rend(); ++it) {
+        if (it->first == jobId) {
+            state = it->second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<ConversionJob> JobQueue::GetQueuedJobs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<ConversionJob> jobs;
+    jobs.reserve(m_queued.size());
+    for (size_t index : OrderLocked(std::chrono::steady_clock::now())) {
+        jobs.push_back(m_queued[index]);
+    }
+    return jobs;
+}
+
+bool JobQueue::GetEta(const std::string& jobId, double& etaMs) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto now = std::chrono::steady_clock::now();
+    double total = RunningRemainingLocked(now);
+    if (m_hasRunning && m_running.jobId == jobId) {
+        etaMs = total;
+        return true;
+    }
+
+    for (size_t index : OrderLocked(now)) {
+        total += m_queued[index].predictedMs;
+        if (m_queued[index].jobId == jobId) {
+            etaMs = total;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobQueue::SetPolicy(SchedulingPolicy policy, double aging)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy = policy;
+    m_aging = std::max(aging, 0.0);
+}
+
+void JobQueue::SetTenantWeight(const std::string& tenant, double weight)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tenantWeights[tenant] = weight > 0.0 ? weight : 1.0;
+}
+
+bool JobQueue::GetRunningJob(ConversionJob& job) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_hasRunning) {
+        job = m_running;
+    }
+    return m_hasRunning;
+}
+
+bool JobQueue::HasRunningJob() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hasRunning;
+}
+
+size_t JobQueue::GetQueuedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queued.size();
+}
+
+size_t JobQueue::GetMaxDepth() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxDepth;
+}
+
+void JobQueue::SetMaxDepth(size_t maxDepth)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxDepth = maxDepth;
+}
+
+void JobQueue::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queued.clear();
+    m_finished.clear();
+    m_tenantFinish.clear();
+    m_virtualTime = 0.0;
+    m_hasRunning = false;
+    m_running = ConversionJob();
+}
+
+std::vector<ConversionJob>::iterator JobQueue::FindQueued(const std::string& jobId)
+{
+    return std::find_if(m_queued.begin(), m_queued.end(),
+        [&jobId](const ConversionJob& job) {
+            return job.jobId == jobId;
+        });
+}
+
+void JobQueue::RememberFinished(const std::string& jobId, JobState state)
+{
+    m_finished.emplace_back(jobId, state);
+    while (m_finished.size() > kFinishedHistorySize) {
+        m_finished.pop_front();
+    }
+}
+
+std::vector<size_t> JobQueue::OrderLocked(std::chrono::steady_clock::time_point now) const
+{
+    // Sort key inside a priority; lower runs first
+    std::vector<double> keys(m_queued.size());
+    for (size_t i = 0; i < m_queued.size(); ++i) {
+        const ConversionJob& job = m_queued[i];
+        switch (m_policy) {
+            case SchedulingPolicy::Fifo:
+                keys[i] = 0.0;
+                break;
+            case SchedulingPolicy::ShortestFirst:
+                keys[i] = job.predictedMs - m_aging * MillisecondsBetween(job.enqueuedAt, now);
+                break;
+            case SchedulingPolicy::FairShare:
+                keys[i] = job.fairFinish;
+                break;
+        }
+    }
+
+    std::vector<size_t> order(m_queued.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this, &keys](size_t a, size_t b) {
+        const ConversionJob& first = m_queued[a];
+        const ConversionJob& second = m_queued[b];
+        if (first.priority != second.priority) {
+            return first.priority > second.priority;
+        }
+        if (keys[a] != keys[b]) {
+            return keys[a] < keys[b];
+        }
+        return first.sequence < second.sequence;
+    });
+    return order;
+}
+
+double JobQueue::RunningRemainingLocked(std::chrono::steady_clock::time_point now) const
+{
+    if (!m_hasRunning) {
+        return 0.0;
+    }
+    return std::max(m_running.predictedMs - MillisecondsBetween(m_running.startedAt, now), 0.0);
+}
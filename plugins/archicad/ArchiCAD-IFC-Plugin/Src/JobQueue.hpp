@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_QUEUE_HPP
+#define JOB_QUEUE_HPP
+
+#include "ElementFilter.hpp"
+#include "ArtifactProcessor.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Kind of work a job performs on the Archicad main thread
+ */
+enum class JobType {
+    PlnToIfc,
+    IfcToPln,
+    LoadIfc,
+    Batch
+};
+
+/**
+ * @brief Job lifecycle: Queued -> Running -> Done | Failed | Cancelled
+ */
+enum class JobState {
+    Queued,
+    Running,
+    Done,
+    Failed,
+    Cancelled
+};
+
+/**
+ * @brief Returns the wire name of a job state (e.g. "queued", "processing")
+ */
+const char* JobStateToString(JobState state);
+
+/**
+ * @brief Returns the Add-On command name that executes a job type
+ */
+const char* JobTypeToCommandName(JobType type);
+
+/**
+ * @brief One conversion inside a batch job
+ */
+struct BatchItem {
+    JobType type = JobType::PlnToIfc;       // PlnToIfc or IfcToPln
+    std::string inputPath;
+    std::string outputPath;
+    std::string translator;                 // IFC export translator name, "" for the first one
+    ElementFilter filter;                   // PlnToIfc: elements to export, empty for all
+    std::string sourcePath;                 // Original input when inputPath is a staged copy, else ""
+};
+
+/**
+ * @brief A single unit of work submitted through the WebSocket
+ */
+struct ConversionJob {
+    std::string jobId;
+    JobType type = JobType::PlnToIfc;
+    std::string inputPath;
+    std::string outputPath;
+    std::string sourcePath;                 // Original input when inputPath is a staged copy, else ""
+    std::string translator;                 // PlnToIfc: export translator name, "" for the first one
+    ElementFilter filter;                   // PlnToIfc: elements to export, empty for all
+    ArtifactOptions artifact;               // Post-processing of the output file
+    bool liveOutput = false;                // PlnToIfc streamOutput: downloadable while it is written
+    uint64_t inputBytes = 0;                // Input size, 0 if not known yet
+    uint64_t entityCount = 0;               // IFC inputs: entity instances, 0 if not scanned
+    std::vector<BatchItem> items;           // JobType::Batch only, run in order
+    int priority = 0;                       // Higher runs first
+    std::string tenant;                     // Fair-share group, "" for the default one
+    double predictedMs = 0.0;               // Expected run time (JobCostModel)
+    JobState state = JobState::Queued;
+    uint64_t sequence = 0;                  // FIFO tie-break inside a priority
+    double fairStart = 0.0;                 // Fair-share virtual start and finish tags
+    double fairFinish = 0.0;
+    std::chrono::steady_clock::time_point enqueuedAt;
+    std::chrono::steady_clock::time_point startedAt;    // Left the queue
+};
+
+/**
+ * @brief Order of queued jobs with the same priority
+ */
+enum class SchedulingPolicy {
+    Fifo,               // Submission order
+    ShortestFirst,      // Smallest predicted run time first, with aging
+    FairShare           // Weighted fair queuing between tenants
+};
+
+/**
+ * @brief Parse "fifo", "sjf" or "fair"
+ * @return false for an unknown name
+ */
+bool SchedulingPolicyFromString(const std::string& name, SchedulingPolicy& policy);
+
+const char* SchedulingPolicyToString(SchedulingPolicy policy);
+
+/**
+ * @brief Thread-safe, bounded priority queue of conversion jobs
+ *
+ * Jobs with a higher priority run first. Inside a priority the policy
+ * decides: submission order, shortest predicted run time first (a job's
+ * prediction shrinks by `aging` ms per ms waited, so large jobs are not
+ * starved), or weighted fair queuing, where every tenant gets a share of
+ * Archicad time proportional to its weight. At most one job is Running at
+ * any time, since Archicad can only hold one project open.
+ *
+ * The queue also remembers the final state of recently finished jobs so
+ * that get_status can answer after a job has left the queue.
+ */
+class JobQueue {
+public:
+    enum class EnqueueResult {
+        Accepted,
+        Duplicate,
+        QueueFull
+    };
+
+    /**
+     * @param maxDepth Maximum number of queued (not running) jobs
+     */
+    explicit JobQueue(size_t maxDepth = 64);
+
+    /**
+     * @brief Add a job to the queue
+     * @param job Job to enqueue (state and sequence are assigned here)
+     * @param position Receives the 1-based queue position on success
+     * @return Accepted, or the reason the job was rejected
+     */
+    EnqueueResult Enqueue(ConversionJob job, size_t& position);
+
+    /**
+     * @brief Take the next job and mark it Running
+     * @param job Receives the job
+     * @return false if the queue is empty or a job is already running
+     */
+    bool PopNext(ConversionJob& job);
+
+    /**
+     * @brief Move the running job to a terminal state
+     * @param jobId Job identifier (ignored if it is not the running job)
+     * @param finalState Done, Failed or Cancelled
+     * @param finished Receives the finished job, may be nullptr
+     * @return true if the running job was finished by this call
+     */
+    bool Finish(const std::string& jobId, JobState finalState, ConversionJob* finished = nullptr);
+
+    /**
+     * @brief Remove a job that has not started yet
+     * @return true if the job was queued and is now Cancelled
+     */
+    bool CancelQueued(const std::string& jobId);
+
+    /**
+     * @brief Look up the current state of a job
+     * @param jobId Job identifier
+     * @param state Receives the state
+     * @param position Receives the 1-based queue position (0 unless Queued)
+     * @return false if the job is unknown
+     */
+    bool GetState(const std::string& jobId, JobState& state, size_t& position) const;
+
+    /**
+     * @brief Snapshot of queued jobs in execution order
+     */
+    std::vector<ConversionJob> GetQueuedJobs() const;
+
+    /**
+     * @brief Predicted time until a job finishes
+     * @param etaMs Receives the rest of the running job, the jobs ahead and
+     *        the job itself, from their predicted run times
+     * @return false unless the job is queued or running
+     */
+    bool GetEta(const std::string& jobId, double& etaMs) const;
+
+    /**
+     * @brief Choose how jobs of the same priority are ordered
+     * @param aging ShortestFirst: ms taken off a prediction per ms waited
+     */
+    void SetPolicy(SchedulingPolicy policy, double aging = 1.0);
+
+    /**
+     * @brief Share of a tenant under FairShare (default 1)
+     */
+    void SetTenantWeight(const std::string& tenant, double weight);
+
+    /**
+     * @brief Copy of the running job
+     * @return false if no job is running
+     */
+    bool GetRunningJob(ConversionJob& job) const;
+
+    bool HasRunningJob() const;
+    size_t GetQueuedCount() const;
+    size_t GetMaxDepth() const;
+    void SetMaxDepth(size_t maxDepth);
+
+    /**
+     * @brief Drop every queued job and forget finished-job history
+     */
+    void Clear();
+
+private:
+    std::vector<ConversionJob>::iterator FindQueued(const std::string& jobId);
+    void RememberFinished(const std::string& jobId, JobState state);
+
+    /**
+     * @brief Indices into m_queued in execution order
+     */
+    std::vector<size_t> OrderLocked(std::chrono::steady_clock::time_point now) const;
+
+    double RunningRemainingLocked(std::chrono::steady_clock::time_point now) const;
+
+    mutable std::mutex m_mutex;
+    std::vector<ConversionJob> m_queued;    // Submission order; see OrderLocked()
+    SchedulingPolicy m_policy;
+    double m_aging;
+    std::map<std::string, double> m_tenantWeights;
+    std::map<std::string, double> m_tenantFinish;   // Last virtual finish tag per tenant
+    double m_virtualTime;
+    ConversionJob m_running;
+    bool m_hasRunning;
+    std::deque<std::pair<std::string, JobState>> m_finished;
+    size_t m_maxDepth;
+    uint64_t m_nextSequence;
+};
+
+#endif // JOB_QUEUE_HPP
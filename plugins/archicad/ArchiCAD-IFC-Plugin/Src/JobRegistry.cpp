@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JobRegistry.hpp"
+#include "JsonParser.hpp"
+
+JobRegistry::JobRegistry(size_t maxFinished)
+    : m_maxFinished(maxFinished)
+    , m_active(0)
+{
+}
+
+JobRegistry::Claim JobRegistry::ClaimJob(const std::string& jobId, const std::string& fingerprint, bool rerun,
+                                         JobRecord& existing)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(jobId);
+    if (it != m_jobs.end()) {
+        const JobRecord& record = it->second;
+        if (!record.finished) {
+            existing = record;
+            return record.fingerprint == fingerprint ? Claim::Attached : Claim::Conflict;
+        }
+        if (record.fingerprint == fingerprint && record.status == "completed" && !rerun) {
+            existing = record;
+            return Claim::Attached;
+        }
+        // A failed job retried, a finished one asked for again, or the id reused for other work
+        DropFinishedLocked(jobId);
+    }
+
+    JobRecord& record = m_jobs[jobId];
+    record = JobRecord();
+    record.jobId = jobId;
+    record.fingerprint = fingerprint;
+    record.submittedAt = std::chrono::system_clock::now();
+    m_active++;
+    return Claim::New;
+}
+
+void JobRegistry::Forget(const std::string& jobId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(jobId);
+    if (it != m_jobs.end()) {
+        if (it->second.finished) {
+            DropFinishedLocked(jobId);
+        } else {
+            m_active--;
+        }
+        m_jobs.erase(it);
+    }
+}
+
+void JobRegistry::RecordEvent(const std::string& jobId, const JsonPayload& payload, bool final)
+{
+    // Parsed outside the lock; only terminal events are looked into
+    std::string status;
+    if (final && payload) {
+        JsonValue event;
+        std::string error;
+        if (JsonParser::Parse(*payload, event, error)) {
+            status = event.GetString({ "status" });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end() || it->second.finished) {
+        return;
+    }
+
+    JobRecord& record = it->second;
+    record.lastEvent = payload;
+    if (final) {
+        record.status = status;
+        record.finished = true;
+        record.finishedAt = std::chrono::system_clock::now();
+        m_active--;
+        m_finished.push_back(jobId);
+        TrimLocked();
+    }
+}
+
+bool JobRegistry::Find(const std::string& jobId, JobRecord& record) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+void JobRegistry::SetMaxFinished(size_t maxFinished)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxFinished = maxFinished;
+    TrimLocked();
+}
+
+size_t JobRegistry::GetActiveCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_active;
+}
+
+size_t JobRegistry::GetFinishedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size() - m_active;
+}
+
+void JobRegistry::TrimLocked()
+{
+    while (m_finished.size() > m_maxFinished) {
+        m_jobs.erase(m_finished.front());
+        m_finished.pop_front();
+    }
+}
+
+void JobRegistry::DropFinishedLocked(const std::string& jobId)
+{
+    for (auto it = m_finished.begin(); it != m_finished.end(); ++it) {
+        if (*it == jobId) {
+            m_finished.erase(it);
+            return;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_REGISTRY_HPP
+#define JOB_REGISTRY_HPP
+
+#include "JsonWriter.hpp"
+
+#include <string>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+/**
+ * @brief What the registry knows about one submitted job
+ */
+struct JobRecord {
+    std::string jobId;
+    std::string fingerprint;        // What the submission asked for, see JobRegistry::Claim()
+    bool finished = false;
+    std::string status;             // "status" of the terminal event ("completed", "error", "cancelled")
+    JsonPayload lastEvent;          // Terminal event once finished, else the latest one (nullptr before any)
+    std::chrono::system_clock::time_point submittedAt;
+    std::chrono::system_clock::time_point finishedAt;
+};
+
+/**
+ * @brief Submitted jobs by jobId, so a resubmission attaches instead of running again
+ *
+ * A job is claimed when it is accepted for execution. From then on every
+ * event sent for it is recorded: the latest one while it runs, and its
+ * terminal event (completed, error, cancelled, batch_completed) once it
+ * is over. A client that lost its connection can reattach to a running
+ * job or have the terminal event replayed instead of converting again.
+ * A job that failed or was cancelled runs again when it is resubmitted.
+ *
+ * Running jobs are always kept; finished ones are kept up to a limit,
+ * oldest forgotten first. Thread-safe.
+ */
+class JobRegistry {
+public:
+    enum class Claim {
+        New,            // Not known, failed, or finished and rerun: run it
+        Attached,       // Same job already running or completed
+        Conflict        // Running with a different fingerprint
+    };
+
+    explicit JobRegistry(size_t maxFinished = 512);
+
+    /**
+     * @brief Claim a jobId for a submission
+     * @param jobId Job identifier
+     * @param fingerprint Identifies what the job does (command, outputs); a
+     *        finished job submitted with another fingerprint runs again
+     * @param rerun Run a finished job again even with the same fingerprint
+     * @param existing Receives the known job when Attached or Conflict
+     */
+    Claim ClaimJob(const std::string& jobId, const std::string& fingerprint, bool rerun, JobRecord& existing);
+
+    /**
+     * @brief Drop a claimed job whose submission was rejected after all
+     */
+    void Forget(const std::string& jobId);
+
+    /**
+     * @brief Record an event sent for a job; ignored for unclaimed or finished jobs
+     * @param final True for the job's terminal event
+     */
+    void RecordEvent(const std::string& jobId, const JsonPayload& payload, bool final);
+
+    /**
+     * @brief Look a job up
+     * @return false if the job was never claimed or has been forgotten
+     */
+    bool Find(const std::string& jobId, JobRecord& record) const;
+
+    /**
+     * @brief Number of finished jobs kept; 0 keeps none
+     */
+    void SetMaxFinished(size_t maxFinished);
+
+    size_t GetActiveCount() const;
+    size_t GetFinishedCount() const;
+
+private:
+    void TrimLocked();
+    void DropFinishedLocked(const std::string& jobId);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, JobRecord> m_jobs;
+    std::deque<std::string> m_finished;     // Finished job ids, oldest first
+    size_t m_maxFinished;
+    size_t m_active;
+};
+
+#endif // JOB_REGISTRY_HPP
@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JobStager.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <set>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#else
+#include <sys/vfs.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Bytes copied per step; the abort flag is checked between blocks
+static const size_t kCopyBlockSize = 1 << 20;
+
+// Scratch directories of earlier runs older than this are removed at start
+static const std::chrono::hours kLeftoverAge(24);
+
+// Inputs of a job, without duplicates (a fan-out export opens one project)
+static std::vector<std::string> JobInputs(const ConversionJob& job)
+{
+    std::vector<std::string> inputs;
+    if (job.type == JobType::Batch) {
+        for (const BatchItem& item : job.items) {
+            if (std::find(inputs.begin(), inputs.end(), item.inputPath) == inputs.end()) {
+                inputs.push_back(item.inputPath);
+            }
+        }
+    } else {
+        inputs.push_back(job.inputPath);
+    }
+    return inputs;
+}
+
+static std::vector<std::string> JobOutputs(const ConversionJob& job)
+{
+    std::vector<std::string> outputs;
+    if (job.type == JobType::Batch) {
+        for (const BatchItem& item : job.items) {
+            outputs.push_back(item.outputPath);
+        }
+    } else if (job.type != JobType::LoadIfc) {
+        outputs.push_back(job.outputPath);
+    }
+    return outputs;
+}
+
+// Checks that an input is a regular file that can be opened for reading
+static bool CheckInput(const std::string& path, std::string& error)
+{
+    std::error_code ec;
+    fs::file_status status = fs::status(fs::u8path(path), ec);
+    if (ec || !fs::exists(status)) {
+        error = "Input file not found: " + path;
+        return false;
+    }
+    if (!fs::is_regular_file(status)) {
+        error = "Input is not a file: " + path;
+        return false;
+    }
+
+    std::ifstream file(fs::u8path(path), std::ios::binary);
+    if (!file) {
+        error = "Cannot read input file: " + path;
+        return false;
+    }
+    return true;
+}
+
+// Creates the directory an output file will be written to
+static bool PrepareOutputDirectory(const std::string& outputPath, std::string& error)
+{
+    fs::path directory = fs::u8path(outputPath).parent_path();
+    if (directory.empty()) {
+        return true;
+    }
+
+    std::error_code ec;
+    if (fs::is_directory(directory, ec)) {
+        return true;
+    }
+    if (fs::exists(directory, ec)) {
+        error = "Output directory is not a directory: " + directory.u8string();
+        return false;
+    }
+    if (!fs::create_directories(directory, ec) && !fs::is_directory(directory)) {
+        error = "Cannot create output directory " + directory.u8string() + ": " + ec.message();
+        return false;
+    }
+
+    LOG_DEBUG("Created output directory " << directory.u8string());
+    return true;
+}
+
+JobStager::JobStager()
+    : m_abort(false)
+    , m_nextDir(0)
+    , m_running(false)
+{
+}
+
+JobStager::~JobStager()
+{
+    Stop();
+}
+
+bool JobStager::Start(const StagingOptions& options)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return !m_scratchRoot.empty();
+    }
+
+    m_options = options;
+    m_options.threads = std::max<size_t>(m_options.threads, 1);
+    m_scratchRoot.clear();
+
+    if (m_options.mode != StagingMode::Never) {
+        std::error_code ec;
+        fs::path base = m_options.directory.empty()
+                      ? fs::temp_directory_path(ec) / "ifc-plugin-staging"
+                      : fs::u8path(m_options.directory);
+
+        // Copies left behind by an instance that did not shut down cleanly
+        for (fs::directory_iterator it(base, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code timeEc;
+            fs::file_time_type modified = fs::last_write_time(it->path(), timeEc);
+            if (!timeEc && fs::file_time_type::clock::now() - modified > kLeftoverAge) {
+                std::error_code removeEc;
+                fs::remove_all(it->path(), removeEc);
+            }
+        }
+
+        // One directory per run, so instances sharing the scratch volume stay apart
+        uint64_t stamp = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000;
+        fs::path root = base / ("run-" + std::to_string(stamp) + "-" + std::to_string(thread));
+
+        ec.clear();
+        if (fs::create_directories(root, ec) || fs::is_directory(root)) {
+            m_scratchRoot = root.u8string();
+        } else {
+            LOG_WARN("Input staging disabled: cannot create " << root.u8string() << ": " << ec.message());
+        }
+    }
+
+    m_abort = false;
+    m_running = true;
+    for (size_t i = 0; i < m_options.threads; ++i) {
+        m_threads.emplace_back(&JobStager::Run, this);
+    }
+
+    if (!m_scratchRoot.empty()) {
+        LOG_INFO("✓ Input staging in " << m_scratchRoot << " (" << m_options.threads << " threads, prefetch "
+                 << m_options.prefetchDepth << ")");
+    }
+    return !m_scratchRoot.empty();
+}
+
+void JobStager::Stop()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_abort = true;
+        m_pending.clear();
+        threads.swap(m_threads);
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::string root;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_leftovers.clear();
+        root.swap(m_scratchRoot);
+    }
+    m_done.notify_all();
+
+    if (!root.empty()) {
+        std::error_code ec;
+        fs::remove_all(fs::u8path(root), ec);
+    }
+}
+
+void JobStager::Prefetch(const ConversionJob& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || m_entries.count(job.jobId) > 0) {
+            return;
+        }
+
+        Entry entry;
+        entry.job = job;
+        m_entries.emplace(job.jobId, entry);
+        m_pending.push_back(job.jobId);
+    }
+    m_wake.notify_one();
+}
+
+bool JobStager::Acquire(const ConversionJob& job, ConversionJob& ready, std::string& error)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        auto it = m_entries.find(job.jobId);
+        if (it == m_entries.end()) {
+            Entry entry;
+            entry.job = job;
+            it = m_entries.emplace(job.jobId, entry).first;
+        }
+
+        if (it->second.state == EntryState::Staging) {
+            // A worker is on it; the entry cannot go away while it stages
+            m_done.wait(lock, [this, &job]() {
+                auto current = m_entries.find(job.jobId);
+                return current == m_entries.end() || current->second.state != EntryState::Staging;
+            });
+            continue;
+        }
+
+        if (it->second.state == EntryState::Pending) {
+            // Nobody got to it yet: stage it here
+            m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), job.jobId), m_pending.end());
+            it->second.state = EntryState::Staging;
+            std::string scratchDir = m_scratchRoot.empty() ? std::string()
+                                   : (fs::u8path(m_scratchRoot) / std::to_string(++m_nextDir)).u8string();
+
+            lock.unlock();
+            Entry result;
+            result.job = job;
+            StageEntry(result, scratchDir);
+            lock.lock();
+
+            Entry& entry = m_entries[job.jobId];
+            entry.ok = result.ok;
+            entry.error = result.error;
+            entry.scratchDir = result.scratchDir;
+            entry.staged = result.staged;
+            entry.state = EntryState::Done;
+            m_done.notify_all();
+        }
+
+        break;
+    }
+
+    Entry& entry = m_entries[job.jobId];
+    entry.released = false;
+    if (!entry.ok) {
+        error = entry.error;
+        return false;
+    }
+
+    ready = job;
+    if (ready.type == JobType::Batch) {
+        for (BatchItem& item : ready.items) {
+            auto staged = entry.staged.find(item.inputPath);
+            if (staged != entry.staged.end()) {
+                item.sourcePath = item.inputPath;
+                item.inputPath = staged->second;
+            }
+        }
+    } else {
+        auto staged = entry.staged.find(ready.inputPath);
+        if (staged != entry.staged.end()) {
+            ready.sourcePath = ready.inputPath;
+            ready.inputPath = staged->second;
+        }
+    }
+    return true;
+}
+
+void JobStager::Release(const std::string& jobId)
+{
+    std::vector<std::string> remove;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(jobId);
+        if (it != m_entries.end()) {
+            if (it->second.state == EntryState::Staging) {
+                // The worker removes it when the copy is done
+                it->second.released = true;
+            } else {
+                if (!it->second.scratchDir.empty()) {
+                    remove.push_back(it->second.scratchDir);
+                }
+                m_entries.erase(it);
+                m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), jobId), m_pending.end());
+            }
+        }
+
+        // Copies still open in Archicad last time (warm sessions) are retried
+        remove.insert(remove.end(), m_leftovers.begin(), m_leftovers.end());
+        m_leftovers.clear();
+    }
+
+    for (const std::string& scratchDir : remove) {
+        RemoveScratch(scratchDir);
+    }
+}
+
+size_t JobStager::GetPrefetchDepth() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running ? m_options.prefetchDepth : 0;
+}
+
+void JobStager::Run()
+{
+    for (;;) {
+        std::string jobId;
+        std::string scratchDir;
+        Entry result;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_running || !m_pending.empty(); });
+            if (!m_running) {
+                return;
+            }
+
+            jobId = m_pending.front();
+            m_pending.pop_front();
+            auto it = m_entries.find(jobId);
+            if (it == m_entries.end() || it->second.state != EntryState::Pending) {
+                continue;
+            }
+            it->second.state = EntryState::Staging;
+            result.job = it->second.job;
+            if (!m_scratchRoot.empty()) {
+                scratchDir = (fs::u8path(m_scratchRoot) / std::to_string(++m_nextDir)).u8string();
+            }
+        }
+
+        StageEntry(result, scratchDir);
+
+        std::string remove;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(jobId);
+            if (it != m_entries.end()) {
+                Entry& entry = it->second;
+                entry.ok = result.ok;
+                entry.error = result.error;
+                entry.scratchDir = result.scratchDir;
+                entry.staged = result.staged;
+                entry.state = EntryState::Done;
+                if (entry.released) {
+                    remove = entry.scratchDir;
+                    m_entries.erase(it);
+                }
+            } else {
+                remove = result.scratchDir;
+            }
+        }
+        m_done.notify_all();
+
+        if (!remove.empty()) {
+            RemoveScratch(remove);
+        }
+    }
+}
+
+void JobStager::StageEntry(Entry& entry, const std::string& scratchDir)
+{
+    const ConversionJob& job = entry.job;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    entry.ok = false;
+    for (const std::string& input : JobInputs(job)) {
+        if (!CheckInput(input, entry.error)) {
+            LOG_WARN("✗ Job " << job.jobId << ": " << entry.error);
+            return;
+        }
+    }
+    for (const std::string& output : JobOutputs(job)) {
+        if (!PrepareOutputDirectory(output, entry.error)) {
+            LOG_WARN("✗ Job " << job.jobId << ": " << entry.error);
+            return;
+        }
+    }
+    entry.ok = true;
+
+    // Load IFC hands the model to the user, so it keeps its real source
+    if (scratchDir.empty() || job.type == JobType::LoadIfc) {
+        return;
+    }
+
+    std::vector<std::string> inputs = JobInputs(job);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const std::string& input = inputs[i];
+        if (m_options.mode == StagingMode::Remote && !IsRemotePath(input)) {
+            continue;
+        }
+
+        std::string staged;
+        std::string itemDir = (fs::u8path(scratchDir) / std::to_string(i)).u8string();
+        entry.scratchDir = scratchDir;
+        if (CopyToScratch(input, itemDir, staged)) {
+            entry.staged[input] = staged;
+        }
+    }
+
+    if (!entry.staged.empty()) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("✓ Staged job " << job.jobId << " (" << entry.staged.size() << " input"
+                 << (entry.staged.size() == 1 ? "" : "s") << ", " << static_cast<int64_t>(ms) << " ms)");
+    }
+}
+
+bool JobStager::CopyToScratch(const std::string& source, const std::string& scratchDir, std::string& staged)
+{
+    fs::path sourcePath = fs::u8path(source);
+    fs::path target = fs::u8path(scratchDir) / sourcePath.filename();
+    fs::path partial = target;
+    partial += ".part";
+
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+
+    bool copied = false;
+    {
+        std::ifstream in(sourcePath, std::ios::binary);
+        std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+        if (in && out) {
+            std::vector<char> buffer(kCopyBlockSize);
+            while (!m_abort) {
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                std::streamsize count = in.gcount();
+                if (count > 0 && !out.write(buffer.data(), count)) {
+                    break;
+                }
+                if (!in) {
+                    copied = in.eof();
+                    break;
+                }
+            }
+            copied = copied && static_cast<bool>(out.flush());
+        }
+    }
+
+    if (copied) {
+        fs::rename(partial, target, ec);
+        copied = !ec;
+    }
+    if (!copied) {
+        fs::remove(partial, ec);
+        if (!m_abort) {
+            LOG_WARN("Could not stage " << source << ", the job reads it in place");
+        }
+        return false;
+    }
+
+    staged = target.u8string();
+    LOG_DEBUG("Staged " << source << " -> " << staged);
+    return true;
+}
+
+void JobStager::RemoveScratch(const std::string& scratchDir)
+{
+    std::error_code ec;
+    fs::remove_all(fs::u8path(scratchDir), ec);
+    if (ec) {
+        // Still open (a warm session keeps the last model open): try again later
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) {
+            m_leftovers.push_back(scratchDir);
+        }
+    }
+}
+
+bool JobStager::IsRemotePath(const std::string& path)
+{
+#ifdef _WIN32
+    std::wstring wide = fs::u8path(path).wstring();
+    if (wide.size() >= 2 && (wide[0] == L'\\' || wide[0] == L'/') && (wide[1] == L'\\' || wide[1] == L'/')) {
+        return true;    // UNC path
+    }
+
+    std::wstring root = fs::u8path(path).root_path().wstring();
+    if (root.empty()) {
+        return false;
+    }
+    if (root.back() != L'\\' && root.back() != L'/') {
+        root += L'\\';
+    }
+    return GetDriveTypeW(root.c_str()) == DRIVE_REMOTE;
+#elif defined(__APPLE__)
+    struct statfs info;
+    return statfs(path.c_str(), &info) == 0 && (info.f_flags & MNT_LOCAL) == 0;
+#else
+    // NFS, SMB, CIFS/SMB2, Coda, AFS
+    static const std::set<long> kNetworkFilesystems = {
+        0x6969, 0x517B, static_cast<long>(0xFF534D42), static_cast<long>(0xFE534D42), 0x73757245, 0x5346414F
+    };
+    struct statfs info;
+    return statfs(path.c_str(), &info) == 0 && kNetworkFilesystems.count(static_cast<long>(info.f_type)) > 0;
+#endif
+}
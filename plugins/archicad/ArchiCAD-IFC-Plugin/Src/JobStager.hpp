@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_STAGER_HPP
+#define JOB_STAGER_HPP
+
+#include "JobQueue.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief When a job's input is copied to local scratch before it runs
+ */
+enum class StagingMode {
+    Never,      // Inputs are only checked
+    Remote,     // Inputs on network volumes are copied
+    Always      // Every input is copied
+};
+
+struct StagingOptions {
+    StagingMode mode = StagingMode::Remote;
+    std::string directory;          // Scratch directory, "" for <temp>/ifc-plugin-staging
+    size_t threads = 2;             // Jobs staged at the same time
+    size_t prefetchDepth = 2;       // Queued jobs staged ahead of the scheduler
+};
+
+/**
+ * @brief Prepares queued jobs off the main thread so Archicad only gets jobs it can open
+ *
+ * While job N runs, worker threads take the next jobs in scheduling order
+ * and check that their inputs exist and can be read, copy inputs that sit
+ * on a network share to local scratch and create the output directories.
+ * The scheduler then collects a prepared job with Acquire(), which waits
+ * for a staging in progress or stages the job on the calling thread when
+ * nobody got to it yet.
+ *
+ * A staged copy keeps its file name and lives in its own directory under
+ * the scratch directory until Release(). Load IFC inputs are never copied,
+ * since the loaded model stays with the user. A copy that fails leaves the
+ * job on its original input.
+ */
+class JobStager {
+public:
+    JobStager();
+    ~JobStager();
+
+    JobStager(const JobStager&) = delete;
+    JobStager& operator=(const JobStager&) = delete;
+
+    /**
+     * @brief Start the worker threads
+     * @return false if the scratch directory cannot be created (inputs are then only checked)
+     */
+    bool Start(const StagingOptions& options);
+
+    /**
+     * @brief Stop the worker threads and remove every staged copy
+     */
+    void Stop();
+
+    /**
+     * @brief Queue a job for staging; ignored if it is already known
+     */
+    void Prefetch(const ConversionJob& job);
+
+    /**
+     * @brief Collect a staged job, staging it now if needed
+     * @param job Job as it left the queue
+     * @param ready Receives the job with inputs pointing at their staged copies
+     * @param error Why the job cannot run
+     * @return false if an input is missing or an output directory cannot be created
+     */
+    bool Acquire(const ConversionJob& job, ConversionJob& ready, std::string& error);
+
+    /**
+     * @brief Forget a job and remove its staged copies
+     */
+    void Release(const std::string& jobId);
+
+    size_t GetPrefetchDepth() const;
+
+    /**
+     * @brief Whether a path is on a network volume (UNC/SMB/NFS/AFP mounts)
+     */
+    static bool IsRemotePath(const std::string& path);
+
+private:
+    enum class EntryState {
+        Pending,
+        Staging,
+        Done
+    };
+
+    struct Entry {
+        ConversionJob job;
+        EntryState state = EntryState::Pending;
+        bool released = false;
+        bool ok = false;
+        std::string error;
+        std::string scratchDir;                         // This job's directory, "" if nothing was copied
+        std::map<std::string, std::string> staged;      // Original input -> staged copy
+    };
+
+    void Run();
+    void StageEntry(Entry& entry, const std::string& scratchDir);
+    bool CopyToScratch(const std::string& source, const std::string& scratchDir, std::string& staged);
+    void RemoveScratch(const std::string& scratchDir);
+
+    StagingOptions m_options;
+    std::string m_scratchRoot;              // "" if copying is unavailable
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;         // Workers: pending jobs or stop
+    std::condition_variable m_done;         // Acquire(): a staging finished
+    std::map<std::string, Entry> m_entries;
+    std::deque<std::string> m_pending;      // Job ids in prefetch order
+    std::vector<std::string> m_leftovers;   // Scratch directories that could not be removed yet
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_abort;
+    uint64_t m_nextDir;
+    bool m_running;
+};
+
+#endif // JOB_STAGER_HPP
@@ -0,0 +1,505 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JsonParser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Nesting limit, protects the recursive parser's stack
+static const int kMaxDepth = 64;
+
+// ========================================
+// JsonValue Implementation
+// ========================================
+
+JsonValue::JsonValue()
+    : m_type(Type::Null)
+    , m_bool(false)
+    , m_isInteger(false)
+    , m_number(0.0)
+    , m_integer(0)
+{
+}
+
+bool JsonValue::AsBool(bool defaultValue) const
+{
+    return m_type == Type::Bool ? m_bool : defaultValue;
+}
+
+double JsonValue::AsNumber(double defaultValue) const
+{
+    return m_type == Type::Number ? m_number : defaultValue;
+}
+
+int64_t JsonValue::AsInt(int64_t defaultValue) const
+{
+    if (m_type != Type::Number) {
+        return defaultValue;
+    }
+    return m_isInteger ? m_integer : static_cast<int64_t>(m_number);
+}
+
+const std::string& JsonValue::AsString() const
+{
+    static const std::string empty;
+    return m_type == Type::String ? m_string : empty;
+}
+
+const JsonValue* JsonValue::Find(const char* key) const
+{
+    if (m_type != Type::Object) {
+        return nullptr;
+    }
+
+    for (const JsonValue& item : m_items) {
+        if (item.m_key == key) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue* JsonValue::Find(std::initializer_list<const char*> keys) const
+{
+    for (const char* key : keys) {
+        if (const JsonValue* value = Find(key)) {
+            return value;
+        }
+    }
+    return nullptr;
+}
+
+std::string JsonValue::GetString(std::initializer_list<const char*> keys, const std::string& defaultValue) const
+{
+    const JsonValue* value = Find(keys);
+    return (value != nullptr && value->IsString()) ? value->m_string : defaultValue;
+}
+
+int64_t JsonValue::GetInt(const char* key, int64_t defaultValue) const
+{
+    const JsonValue* value = Find(key);
+    return value != nullptr ? value->AsInt(defaultValue) : defaultValue;
+}
+
+bool JsonValue::GetBool(const char* key, bool defaultValue) const
+{
+    const JsonValue* value = Find(key);
+    return value != nullptr ? value->AsBool(defaultValue) : defaultValue;
+}
+
+// ========================================
+// JsonParser Implementation
+// ========================================
+
+JsonParser::JsonParser(const char* begin, const char* end, std::vector<JsonValue>& stack)
+    : m_begin(begin)
+    , m_pos(begin)
+    , m_end(end)
+    , m_depth(0)
+    , m_stack(stack)
+{
+}
+
+bool JsonParser::Parse(const std::string& text, JsonValue& out, std::string& error)
+{
+    // Keeps its capacity between messages; empty outside Parse()
+    thread_local std::vector<JsonValue> stack;
+
+    JsonParser parser(text.data(), text.data() + text.size(), stack);
+    out = JsonValue();
+
+    parser.SkipWhitespace();
+    bool ok = parser.ParseValue(out);
+    if (ok) {
+        parser.SkipWhitespace();
+        if (parser.m_pos != parser.m_end) {
+            ok = parser.Fail("unexpected data after JSON value");
+        }
+    }
+
+    if (!ok) {
+        error = parser.m_error;
+        stack.clear();
+    }
+    return ok;
+}
+
+void JsonParser::PopItems(size_t base, JsonValue& container)
+{
+    container.m_items.reserve(m_stack.size() - base);
+    for (size_t i = base; i < m_stack.size(); ++i) {
+        container.m_items.push_back(std::move(m_stack[i]));
+    }
+    m_stack.resize(base);
+}
+
+bool JsonParser::Fail(const char* message)
+{
+    if (m_error.empty()) {
+        m_error = std::string(message) + " at offset " + std::to_string(m_pos - m_begin);
+    }
+    return false;
+}
+
+void JsonParser::SkipWhitespace()
+{
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r')) {
+        ++m_pos;
+    }
+}
+
+bool JsonParser::ParseValue(JsonValue& out)
+{
+    if (m_pos >= m_end) {
+        return Fail("unexpected end of input");
+    }
+
+    switch (*m_pos) {
+        case '{':
+            return ParseObject(out);
+        case '[':
+            return ParseArray(out);
+        case '"':
+            out.m_type = JsonValue::Type::String;
+            return ParseString(out.m_string);
+        case 't':
+            out.m_type = JsonValue::Type::Bool;
+            out.m_bool = true;
+            return ParseLiteral("true", 4);
+        case 'f':
+            out.m_type = JsonValue::Type::Bool;
+            out.m_bool = false;
+            return ParseLiteral("false", 5);
+        case 'n':
+            out.m_type = JsonValue::Type::Null;
+            return ParseLiteral("null", 4);
+        default:
+            return ParseNumber(out);
+    }
+}
+
+bool JsonParser::ParseLiteral(const char* literal, size_t length)
+{
+    if (static_cast<size_t>(m_end - m_pos) < length || std::memcmp(m_pos, literal, length) != 0) {
+        return Fail("invalid literal");
+    }
+    m_pos += length;
+    return true;
+}
+
+bool JsonParser::ParseObject(JsonValue& out)
+{
+    if (++m_depth > kMaxDepth) {
+        return Fail("nesting too deep");
+    }
+
+    out.m_type = JsonValue::Type::Object;
+    ++m_pos;    // '{'
+    SkipWhitespace();
+
+    if (m_pos < m_end && *m_pos == '}') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    // Members are parsed on their own: the stack may grow under a nested value
+    size_t base = m_stack.size();
+    while (true) {
+        if (m_pos >= m_end || *m_pos != '"') {
+            return Fail("expected member name");
+        }
+
+        JsonValue member;
+        if (!ParseString(member.m_key)) {
+            return false;
+        }
+
+        SkipWhitespace();
+        if (m_pos >= m_end || *m_pos != ':') {
+            return Fail("expected ':'");
+        }
+        ++m_pos;
+        SkipWhitespace();
+
+        if (!ParseValue(member)) {
+            return false;
+        }
+        m_stack.push_back(std::move(member));
+
+        SkipWhitespace();
+        if (m_pos < m_end && *m_pos == ',') {
+            ++m_pos;
+            SkipWhitespace();
+            continue;
+        }
+        if (m_pos < m_end && *m_pos == '}') {
+            ++m_pos;
+            --m_depth;
+            PopItems(base, out);
+            return true;
+        }
+        return Fail("expected ',' or '}'");
+    }
+}
+
+bool JsonParser::ParseArray(JsonValue& out)
+{
+    if (++m_depth > kMaxDepth) {
+        return Fail("nesting too deep");
+    }
+
+    out.m_type = JsonValue::Type::Array;
+    ++m_pos;    // '['
+    SkipWhitespace();
+
+    if (m_pos < m_end && *m_pos == ']') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    size_t base = m_stack.size();
+    while (true) {
+        JsonValue item;
+        if (!ParseValue(item)) {
+            return false;
+        }
+        m_stack.push_back(std::move(item));
+
+        SkipWhitespace();
+        if (m_pos < m_end && *m_pos == ',') {
+            ++m_pos;
+            SkipWhitespace();
+            continue;
+        }
+        if (m_pos < m_end && *m_pos == ']') {
+            ++m_pos;
+            --m_depth;
+            PopItems(base, out);
+            return true;
+        }
+        return Fail("expected ',' or ']'");
+    }
+}
+
+bool JsonParser::ParseHex4(uint32_t& code)
+{
+    if (m_end - m_pos < 4) {
+        return Fail("truncated \\u escape");
+    }
+
+    code = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = *m_pos++;
+        code <<= 4;
+        if (c >= '0' && c <= '9') {
+            code |= static_cast<uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            code |= static_cast<uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            code |= static_cast<uint32_t>(c - 'A' + 10);
+        } else {
+            return Fail("invalid \\u escape");
+        }
+    }
+    return true;
+}
+
+bool JsonParser::ParseString(std::string& out)
+{
+    ++m_pos;    // opening quote
+
+    // Copy unescaped runs in one go
+    const char* runStart = m_pos;
+    while (m_pos < m_end) {
+        char c = *m_pos;
+
+        if (c == '"') {
+            out.append(runStart, m_pos);
+            ++m_pos;
+            return true;
+        }
+
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return Fail("control character in string");
+        }
+
+        if (c != '\\') {
+            ++m_pos;
+            continue;
+        }
+
+        // An escaped string is never longer than its source: make room
+        // for all of it on the first escape instead of growing per run
+        if (out.empty()) {
+            const char* scan = m_pos;
+            while (scan < m_end && *scan != '"') {
+                scan += (*scan == '\\') ? 2 : 1;
+            }
+            out.reserve(static_cast<size_t>(std::min(scan, m_end) - runStart));
+        }
+        out.append(runStart, m_pos);
+        ++m_pos;
+        if (m_pos >= m_end) {
+            break;
+        }
+
+        char escape = *m_pos++;
+        switch (escape) {
+            case '"':  out += '"';  break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/';  break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                uint32_t code = 0;
+                if (!ParseHex4(code)) {
+                    return false;
+                }
+
+                // Combine UTF-16 surrogate pairs
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (m_end - m_pos < 2 || m_pos[0] != '\\' || m_pos[1] != 'u') {
+                        return Fail("unpaired surrogate");
+                    }
+                    m_pos += 2;
+                    if (!ParseHex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return Fail("invalid surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return Fail("unpaired surrogate");
+                }
+
+                // Encode as UTF-8
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                return Fail("invalid escape");
+        }
+
+        runStart = m_pos;
+    }
+
+    return Fail("unterminated string");
+}
+
+bool JsonParser::ParseNumber(JsonValue& out)
+{
+    bool negative = false;
+
+    if (m_pos < m_end && *m_pos == '-') {
+        negative = true;
+        ++m_pos;
+    }
+
+    if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') {
+        return Fail("invalid value");
+    }
+
+    // Integer part; a leading zero must stand alone
+    uint64_t integer = 0;
+    bool overflow = false;
+    double mantissa = 0.0;
+    if (*m_pos == '0') {
+        ++m_pos;
+    } else {
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            unsigned digit = static_cast<unsigned>(*m_pos - '0');
+            if (integer > (UINT64_MAX - digit) / 10) {
+                overflow = true;
+            } else {
+                integer = integer * 10 + digit;
+            }
+            mantissa = mantissa * 10.0 + digit;
+            ++m_pos;
+        }
+    }
+
+    bool isInteger = true;
+    int exponent = 0;
+
+    if (m_pos < m_end && *m_pos == '.') {
+        isInteger = false;
+        ++m_pos;
+        if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') {
+            return Fail("invalid fraction");
+        }
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            mantissa = mantissa * 10.0 + (*m_pos - '0');
+            --exponent;
+            ++m_pos;
+        }
+    }
+
+    if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+        isInteger = false;
+        ++m_pos;
+        bool negativeExponent = false;
+        if (m_pos < m_end && (*m_pos == '+' || *m_pos == '-')) {
+            negativeExponent = (*m_pos == '-');
+            ++m_pos;
+        }
+        if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') {
+            return Fail("invalid exponent");
+        }
+        int explicitExponent = 0;
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            if (explicitExponent < 10000) {
+                explicitExponent = explicitExponent * 10 + (*m_pos - '0');
+            }
+            ++m_pos;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    out.m_type = JsonValue::Type::Number;
+    out.m_number = (negative ? -mantissa : mantissa) * std::pow(10.0, exponent);
+
+    // Keep integers exact when they fit
+    if (isInteger && !overflow && integer <= static_cast<uint64_t>(INT64_MAX)) {
+        out.m_isInteger = true;
+        out.m_integer = negative ? -static_cast<int64_t>(integer) : static_cast<int64_t>(integer);
+    }
+
+    return true;
+}
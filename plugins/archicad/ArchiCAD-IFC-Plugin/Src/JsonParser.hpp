@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSON_PARSER_HPP
+#define JSON_PARSER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+
+/**
+ * @brief Parsed JSON value (small DOM)
+ *
+ * Object members keep their document order; lookups are linear, which is
+ * the fastest option for the handful of fields a protocol message has.
+ * A member carries its own name, so an object is a single allocation.
+ */
+class JsonValue {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    JsonValue();
+
+    Type GetType() const { return m_type; }
+    bool IsNull() const { return m_type == Type::Null; }
+    bool IsBool() const { return m_type == Type::Bool; }
+    bool IsNumber() const { return m_type == Type::Number; }
+    bool IsString() const { return m_type == Type::String; }
+    bool IsArray() const { return m_type == Type::Array; }
+    bool IsObject() const { return m_type == Type::Object; }
+
+    /**
+     * @brief True for numbers written without fraction or exponent that fit in 64 bits
+     */
+    bool IsInteger() const { return m_type == Type::Number && m_isInteger; }
+
+    bool AsBool(bool defaultValue = false) const;
+    double AsNumber(double defaultValue = 0.0) const;
+    int64_t AsInt(int64_t defaultValue = 0) const;
+
+    /**
+     * @brief String value, or an empty string for other types
+     */
+    const std::string& AsString() const;
+
+    /**
+     * @brief Number of array items or object members
+     */
+    size_t Size() const { return m_items.size(); }
+
+    /**
+     * @brief Array item or object member value by index
+     */
+    const JsonValue& At(size_t index) const { return m_items[index]; }
+
+    /**
+     * @brief Object member name by index
+     */
+    const std::string& KeyAt(size_t index) const { return m_items[index].m_key; }
+
+    /**
+     * @brief Find an object member
+     * @return nullptr if this is not an object or the key is missing
+     */
+    const JsonValue* Find(const char* key) const;
+
+    /**
+     * @brief Find the first member present among several aliases
+     */
+    const JsonValue* Find(std::initializer_list<const char*> keys) const;
+
+    /**
+     * @brief Member string value, or defaultValue if missing / not a string
+     */
+    std::string GetString(std::initializer_list<const char*> keys, const std::string& defaultValue = std::string()) const;
+
+    /**
+     * @brief Member integer value, or defaultValue if missing / not a number
+     */
+    int64_t GetInt(const char* key, int64_t defaultValue = 0) const;
+
+    /**
+     * @brief Member boolean value, or defaultValue if missing / not a bool
+     */
+    bool GetBool(const char* key, bool defaultValue = false) const;
+
+private:
+    friend class JsonParser;
+
+    Type m_type;
+    bool m_bool;
+    bool m_isInteger;
+    double m_number;
+    int64_t m_integer;
+    std::string m_string;
+    std::string m_key;                  // Member name inside an object, else ""
+    std::vector<JsonValue> m_items;     // Array items or object member values
+};
+
+/**
+ * @brief Single-pass recursive-descent JSON parser
+ *
+ * Parses RFC 8259 JSON in one pass over the input, decoding string escapes
+ * (including \uXXXX surrogate pairs) as it goes. Number parsing does not
+ * depend on the C locale.
+ *
+ * Array items and object members are collected on a per-thread scratch
+ * stack and moved into a vector of the exact size once the container is
+ * closed, so each container costs one allocation however many items it has.
+ */
+class JsonParser {
+public:
+    /**
+     * @brief Parse a complete JSON document
+     * @param text UTF-8 JSON text
+     * @param out Receives the parsed value
+     * @param error Receives a description with the byte offset on failure
+     * @return true on success
+     */
+    static bool Parse(const std::string& text, JsonValue& out, std::string& error);
+
+private:
+    JsonParser(const char* begin, const char* end, std::vector<JsonValue>& stack);
+
+    bool ParseValue(JsonValue& out);
+    bool ParseObject(JsonValue& out);
+    bool ParseArray(JsonValue& out);
+    bool ParseString(std::string& out);
+    bool ParseNumber(JsonValue& out);
+    bool ParseLiteral(const char* literal, size_t length);
+    bool ParseHex4(uint32_t& code);
+    void SkipWhitespace();
+    bool Fail(const char* message);
+
+    /**
+     * @brief Move the items pushed since base into container
+     */
+    void PopItems(size_t base, JsonValue& container);
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    int m_depth;
+    std::vector<JsonValue>& m_stack;    // Items of the containers being parsed
+    std::string m_error;
+};
+
+#endif // JSON_PARSER_HPP
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JsonWriter.hpp"
+
+#include <vector>
+#include <cstring>
+#include <charconv>
+
+// Capacity a fresh buffer starts with; typical protocol messages fit
+static const size_t kInitialCapacity = 512;
+
+// Buffers that grew beyond this (large status dumps) are not kept
+static const size_t kMaxPooledCapacity = 64 * 1024;
+
+// Buffers kept per thread (more than one is needed when writers nest)
+static const size_t kMaxPooledBuffers = 4;
+
+static std::vector<std::string>& BufferPool()
+{
+    thread_local std::vector<std::string> pool;
+    return pool;
+}
+
+// For each byte: 0 = copy as-is, 'u' = \u00XX, other = two-char escape
+static const char* EscapeTable()
+{
+    static const char* table = []() {
+        static char t[256] = {};
+        for (int c = 0; c < 0x20; ++c) {
+            t[c] = 'u';
+        }
+        t[static_cast<unsigned char>('"')] = '"';
+        t[static_cast<unsigned char>('\\')] = '\\';
+        t[static_cast<unsigned char>('\b')] = 'b';
+        t[static_cast<unsigned char>('\f')] = 'f';
+        t[static_cast<unsigned char>('\n')] = 'n';
+        t[static_cast<unsigned char>('\r')] = 'r';
+        t[static_cast<unsigned char>('\t')] = 't';
+        return t;
+    }();
+    return table;
+}
+
+JsonWriter::JsonWriter()
+    : m_needComma(false)
+{
+    std::vector<std::string>& pool = BufferPool();
+    if (!pool.empty()) {
+        m_buffer = std::move(pool.back());
+        pool.pop_back();
+        m_buffer.clear();
+    } else {
+        m_buffer.reserve(kInitialCapacity);
+    }
+}
+
+JsonWriter::~JsonWriter()
+{
+    std::vector<std::string>& pool = BufferPool();
+    if (pool.size() < kMaxPooledBuffers && m_buffer.capacity() <= kMaxPooledCapacity) {
+        pool.push_back(std::move(m_buffer));
+    }
+}
+
+void JsonWriter::Separate()
+{
+    if (m_needComma) {
+        m_buffer += ',';
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject()
+{
+    Separate();
+    m_buffer += '{';
+    m_needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject()
+{
+    m_buffer += '}';
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray()
+{
+    Separate();
+    m_buffer += '[';
+    m_needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray()
+{
+    m_buffer += ']';
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(const char* key)
+{
+    Separate();
+    m_buffer += '"';
+    AppendEscaped(m_buffer, key, std::strlen(key));
+    m_buffer += "\":";
+    m_needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(const std::string& value)
+{
+    Separate();
+    m_buffer += '"';
+    AppendEscaped(m_buffer, value.data(), value.size());
+    m_buffer += '"';
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(const char* value)
+{
+    Separate();
+    m_buffer += '"';
+    AppendEscaped(m_buffer, value, std::strlen(value));
+    m_buffer += '"';
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Int(int64_t value)
+{
+    Separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr);
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::UInt(uint64_t value)
+{
+    Separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr);
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value)
+{
+    Separate();
+    m_buffer += value ? "true" : "false";
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Null()
+{
+    Separate();
+    m_buffer += "null";
+    m_needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Raw(const std::string& json)
+{
+    Separate();
+    m_buffer += json;
+    m_needComma = true;
+    return *this;
+}
+
+JsonPayload JsonWriter::ToPayload() const
+{
+    return std::make_shared<const std::string>(m_buffer);
+}
+
+void JsonWriter::AppendEscaped(std::string& out, const char* str, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    const char* table = EscapeTable();
+
+    const char* runStart = str;
+    const char* end = str + length;
+
+    for (const char* p = str; p != end; ++p) {
+        char escape = table[static_cast<unsigned char>(*p)];
+        if (escape == 0) {
+            continue;
+        }
+
+        out.append(runStart, p);
+        if (escape == 'u') {
+            unsigned char c = static_cast<unsigned char>(*p);
+            char sequence[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0x0F] };
+            out.append(sequence, sizeof(sequence));
+        } else {
+            out += '\\';
+            out += escape;
+        }
+        runStart = p + 1;
+    }
+
+    out.append(runStart, end);
+}
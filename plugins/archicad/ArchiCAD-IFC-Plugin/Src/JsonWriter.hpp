@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Immutable serialized message, shared by every session it is sent to
+ */
+using JsonPayload = std::shared_ptr<const std::string>;
+
+/**
+ * @brief Append-only JSON serializer
+ *
+ * Writes straight into a buffer taken from a small per-thread pool, so a
+ * message costs no allocation beyond the final payload once the pool is warm.
+ * Commas between members and items are inserted automatically; the caller
+ * is responsible for balancing Begin/End calls.
+ *
+ * @code
+ * JsonWriter writer;
+ * writer.BeginObject()
+ *       .Field("type", "progress")
+ *       .Field("progress", 42)
+ *       .EndObject();
+ * JsonPayload payload = writer.ToPayload();
+ * @endcode
+ */
+class JsonWriter {
+public:
+    JsonWriter();
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+
+    /**
+     * @brief Write an object member name; the next call writes its value
+     */
+    JsonWriter& Key(const char* key);
+
+    JsonWriter& String(const std::string& value);
+    JsonWriter& String(const char* value);
+    JsonWriter& Int(int64_t value);
+    JsonWriter& UInt(uint64_t value);
+    JsonWriter& Bool(bool value);
+    JsonWriter& Null();
+
+    /**
+     * @brief Write an already serialized JSON value as-is
+     */
+    JsonWriter& Raw(const std::string& json);
+
+    JsonWriter& Field(const char* key, const std::string& value) { return Key(key).String(value); }
+    JsonWriter& Field(const char* key, const char* value) { return Key(key).String(value); }
+    JsonWriter& Field(const char* key, int value) { return Key(key).Int(value); }
+    JsonWriter& Field(const char* key, long value) { return Key(key).Int(value); }
+    JsonWriter& Field(const char* key, long long value) { return Key(key).Int(value); }
+    JsonWriter& Field(const char* key, unsigned int value) { return Key(key).UInt(value); }
+    JsonWriter& Field(const char* key, unsigned long value) { return Key(key).UInt(value); }
+    JsonWriter& Field(const char* key, unsigned long long value) { return Key(key).UInt(value); }
+    JsonWriter& Field(const char* key, bool value) { return Key(key).Bool(value); }
+
+    /**
+     * @brief The text written so far
+     */
+    const std::string& GetString() const { return m_buffer; }
+
+    /**
+     * @brief Copy the text into a string sized exactly to fit
+     */
+    std::string ToString() const { return m_buffer; }
+
+    /**
+     * @brief Copy the text into an immutable shared payload
+     */
+    JsonPayload ToPayload() const;
+
+    /**
+     * @brief Append str to out as JSON string content (without quotes)
+     *
+     * Runs of characters that need no escaping are copied in one step.
+     */
+    static void AppendEscaped(std::string& out, const char* str, size_t length);
+
+private:
+    void Separate();
+
+    std::string m_buffer;
+    bool m_needComma;
+};
+
+#endif // JSON_WRITER_HPP
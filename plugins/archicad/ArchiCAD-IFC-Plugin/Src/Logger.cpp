@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Logger.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <ctime>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+// Static member initialization
+std::atomic<int> Logger::s_level(static_cast<int>(LogLevel::Info));
+std::atomic<bool> Logger::s_running(false);
+std::atomic<bool> Logger::s_writerIdle(false);
+std::atomic<uint64_t> Logger::s_dropped(0);
+std::atomic<size_t> Logger::s_payloadLimit(512);
+
+std::unique_ptr<Logger::Slot[]> Logger::s_ring;
+size_t Logger::s_mask = 0;
+std::atomic<size_t> Logger::s_enqueuePos(0);
+size_t Logger::s_dequeuePos = 0;
+
+LoggerConfig Logger::s_config;
+std::mutex Logger::s_sinkMutex;
+std::mutex Logger::s_wakeMutex;
+std::condition_variable Logger::s_wakeCv;
+std::thread Logger::s_writer;
+bool Logger::s_stopWriter = false;
+
+// File sink state, guarded by s_sinkMutex
+static std::ofstream s_file;
+static uint64_t s_fileBytes = 0;
+
+// How long the idle writer sleeps when a wake-up is missed
+static const int kWriterIdleMs = 50;
+
+const char* LogLevelToString(LogLevel level)
+{
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO ";
+        case LogLevel::Warn:  return "WARN ";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off:   return "OFF  ";
+    }
+    return "?    ";
+}
+
+bool LogLevelFromString(const std::string& name, LogLevel& level)
+{
+    static const struct {
+        const char* name;
+        LogLevel level;
+    } kLevels[] = {
+        { "trace", LogLevel::Trace },
+        { "debug", LogLevel::Debug },
+        { "info",  LogLevel::Info },
+        { "warn",  LogLevel::Warn },
+        { "warning", LogLevel::Warn },
+        { "error", LogLevel::Error },
+        { "off",   LogLevel::Off },
+    };
+
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Helper to format "YYYY-MM-DD HH:MM:SS.mmm" in local time
+static std::string FormatTimestamp(std::chrono::system_clock::time_point time)
+{
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        time.time_since_epoch()).count() % 1000);
+
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    char text[64];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                  local.tm_hour, local.tm_min, local.tm_sec, millis);
+    return text;
+}
+
+void Logger::Start(const LoggerConfig& config)
+{
+    Stop();
+
+    std::lock_guard<std::mutex> lock(s_sinkMutex);
+    s_config = config;
+    s_level.store(static_cast<int>(config.level), std::memory_order_relaxed);
+    s_payloadLimit.store(config.payloadLimit, std::memory_order_relaxed);
+
+    if (!s_ring) {
+        size_t capacity = 2;
+        while (capacity < config.queueCapacity) {
+            capacity <<= 1;
+        }
+        s_ring.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            s_ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        s_mask = capacity - 1;
+    }
+
+    if (!s_config.filePath.empty()) {
+        std::error_code ec;
+        uint64_t existing = std::filesystem::file_size(std::filesystem::u8path(s_config.filePath), ec);
+        s_file.open(std::filesystem::u8path(s_config.filePath), std::ios::out | std::ios::app | std::ios::binary);
+        s_fileBytes = ec ? 0 : existing;
+        if (!s_file.is_open()) {
+            std::cerr << "✗ Cannot open log file " << s_config.filePath << std::endl;
+        }
+    }
+
+    s_stopWriter = false;
+    s_writer = std::thread(&Logger::WriterLoop);
+    s_running.store(true, std::memory_order_release);
+}
+
+void Logger::Stop()
+{
+    if (!s_writer.joinable()) {
+        return;
+    }
+
+    s_running.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(s_wakeMutex);
+        s_stopWriter = true;
+    }
+    s_wakeCv.notify_all();
+    s_writer.join();
+
+    std::lock_guard<std::mutex> lock(s_sinkMutex);
+    if (s_file.is_open()) {
+        s_file.close();
+    }
+}
+
+void Logger::SetLevel(LogLevel level)
+{
+    s_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::GetLevel()
+{
+    return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed));
+}
+
+void Logger::Write(LogLevel level, std::string message)
+{
+    Record record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.message = std::move(message);
+
+    if (!s_running.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(s_sinkMutex);
+        WriteToSinks(record);
+        return;
+    }
+
+    if (!Push(record)) {
+        // Warnings and errors are never lost: write them here instead
+        if (level >= LogLevel::Warn) {
+            std::lock_guard<std::mutex> lock(s_sinkMutex);
+            WriteToSinks(record);
+        } else {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // Only wake the writer when it is waiting; a missed wake-up costs at
+    // most kWriterIdleMs
+    if (s_writerIdle.load(std::memory_order_acquire)) {
+        s_wakeCv.notify_one();
+    }
+}
+
+std::string Logger::Truncate(const std::string& text)
+{
+    size_t limit = s_payloadLimit.load(std::memory_order_relaxed);
+    if (limit == 0 || text.size() <= limit) {
+        return text;
+    }
+    return text.substr(0, limit) + "... (" + std::to_string(text.size()) + " bytes)";
+}
+
+std::ostringstream& Logger::Stream()
+{
+    thread_local std::ostringstream stream;
+    stream.str(std::string());
+    stream.clear();
+    return stream;
+}
+
+uint64_t Logger::GetDroppedCount()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+bool Logger::Push(Record& record)
+{
+    size_t pos = s_enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    while (true) {
+        slot = &s_ring[pos & s_mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the writer has not consumed this slot's previous record
+            return false;
+        } else {
+            pos = s_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool Logger::Pop(Record& record)
+{
+    Slot& slot = s_ring[s_dequeuePos & s_mask];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(s_dequeuePos + 1) < 0) {
+        return false;
+    }
+
+    record = std::move(slot.record);
+    slot.record.message.clear();
+    slot.sequence.store(s_dequeuePos + s_mask + 1, std::memory_order_release);
+    ++s_dequeuePos;
+    return true;
+}
+
+void Logger::WriterLoop()
+{
+    uint64_t reportedDrops = s_dropped.load(std::memory_order_relaxed);
+
+    while (true) {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(s_wakeMutex);
+            stopping = s_stopWriter;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_sinkMutex);
+            Record record;
+            bool wrote = false;
+            while (Pop(record)) {
+                WriteToSinks(record);
+                wrote = true;
+            }
+
+            uint64_t drops = s_dropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops) {
+                Record notice;
+                notice.level = LogLevel::Warn;
+                notice.time = std::chrono::system_clock::now();
+                notice.message = "Logger: " + std::to_string(drops - reportedDrops) + " messages dropped (queue full)";
+                WriteToSinks(notice);
+                reportedDrops = drops;
+                wrote = true;
+            }
+
+            if (wrote) {
+                std::cout.flush();
+                if (s_file.is_open()) {
+                    s_file.flush();
+                }
+            }
+        }
+
+        // The last drain ran after the stop request was seen
+        if (stopping) {
+            return;
+        }
+
+        // Any notification (a new record or Stop) ends the wait
+        std::unique_lock<std::mutex> lock(s_wakeMutex);
+        if (!s_stopWriter) {
+            s_writerIdle.store(true, std::memory_order_release);
+            s_wakeCv.wait_for(lock, std::chrono::milliseconds(kWriterIdleMs));
+            s_writerIdle.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void Logger::WriteToSinks(const Record& record)
+{
+    std::string line = FormatTimestamp(record.time);
+    line += ' ';
+    line += LogLevelToString(record.level);
+    line += ' ';
+    line += record.message;
+    line += '\n';
+
+    if (s_config.console) {
+        if (record.level >= LogLevel::Warn) {
+            std::cerr << line;
+        } else {
+            std::cout << line;
+        }
+    }
+
+#ifdef _WIN32
+    if (s_config.debugger) {
+        OutputDebugStringA(("[ARCHICAD] " + record.message + "\n").c_str());
+    }
+#endif
+
+    if (s_file.is_open()) {
+        WriteToFile(line);
+    }
+}
+
+void Logger::WriteToFile(const std::string& line)
+{
+    if (s_config.maxFileBytes > 0 && s_fileBytes > 0 && s_fileBytes + line.size() > s_config.maxFileBytes) {
+        RotateFile();
+        if (!s_file.is_open()) {
+            return;
+        }
+    }
+
+    s_file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    s_fileBytes += line.size();
+}
+
+void Logger::RotateFile()
+{
+    s_file.close();
+
+    // file.log -> file.log.1 -> ... -> file.log.N (dropped)
+    std::filesystem::path path = std::filesystem::u8path(s_config.filePath);
+    std::error_code ec;
+    if (s_config.maxFiles > 0) {
+        std::filesystem::path oldest = path;
+        oldest += "." + std::to_string(s_config.maxFiles);
+        std::filesystem::remove(oldest, ec);
+
+        for (int i = s_config.maxFiles - 1; i >= 1; --i) {
+            std::filesystem::path from = path;
+            from += "." + std::to_string(i);
+            std::filesystem::path to = path;
+            to += "." + std::to_string(i + 1);
+            std::filesystem::rename(from, to, ec);
+        }
+
+        std::filesystem::path first = path;
+        first += ".1";
+        std::filesystem::rename(path, first, ec);
+    }
+
+    s_file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    s_fileBytes = 0;
+}
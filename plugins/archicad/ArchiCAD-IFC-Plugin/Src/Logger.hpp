@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <string>
+#include <sstream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Severity of a log message, in increasing order
+ */
+enum class LogLevel {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5
+};
+
+/**
+ * @brief Fixed-width level name for log lines ("INFO ", "ERROR", ...)
+ */
+const char* LogLevelToString(LogLevel level);
+
+/**
+ * @brief Parse a level name ("trace", "debug", "info", "warn", "error", "off")
+ * @return false if the name is unknown
+ */
+bool LogLevelFromString(const std::string& name, LogLevel& level);
+
+/**
+ * @brief Logger settings
+ */
+struct LoggerConfig {
+    LogLevel level = LogLevel::Info;
+    bool console = true;                // Info and below to stdout, Warn and above to stderr
+    bool debugger = true;               // OutputDebugString on Windows
+    std::string filePath;               // Rotating file sink, "" to disable
+    uint64_t maxFileBytes = 10 << 20;   // Rotate once the file would grow past this
+    int maxFiles = 5;                   // Rotated files kept (file.1 ... file.N)
+    size_t payloadLimit = 512;          // Characters kept by Logger::Truncate
+    size_t queueCapacity = 8192;        // Messages buffered for the writer thread (first Start() only)
+};
+
+/**
+ * @brief Asynchronous, leveled logger shared by the plugin and the tools
+ *
+ * Callers format the message and push it into a bounded lock-free ring
+ * buffer; a background thread writes it to the sinks, so logging never
+ * blocks the WebSocket I/O thread or the Archicad main thread on console
+ * or file I/O. When the ring is full the message is dropped and counted.
+ * Before Start() (and after Stop()) messages are written synchronously.
+ *
+ * Use the LOG_* macros: disabled levels cost one atomic load, their
+ * arguments are not evaluated, and levels below IFC_LOG_COMPILE_LEVEL are
+ * compiled out entirely.
+ *
+ * @code
+ * LOG_INFO("✓ Client connected (total: " << count << ")");
+ * LOG_DEBUG("Raw message: " << Logger::Truncate(message));
+ * @endcode
+ */
+class Logger {
+public:
+    /**
+     * @brief Start the writer thread (restarts it with a new configuration)
+     */
+    static void Start(const LoggerConfig& config);
+
+    /**
+     * @brief Write every buffered message and stop the writer thread
+     */
+    static void Stop();
+
+    static void SetLevel(LogLevel level);
+    static LogLevel GetLevel();
+
+    static bool IsEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Queue a message for the sinks
+     */
+    static void Write(LogLevel level, std::string message);
+
+    /**
+     * @brief Shorten a payload to the configured limit, noting its full size
+     */
+    static std::string Truncate(const std::string& text);
+
+    /**
+     * @brief This thread's formatting stream, emptied (used by the LOG_* macros)
+     */
+    static std::ostringstream& Stream();
+
+    /**
+     * @brief Messages dropped because the ring buffer was full
+     */
+    static uint64_t GetDroppedCount();
+
+private:
+    struct Record {
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
+    // Bounded multi-producer ring (Vyukov): a slot's sequence tells
+    // producers and the consumer whose turn it is
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    static bool Push(Record& record);
+    static bool Pop(Record& record);
+    static void WriterLoop();
+    static void WriteToSinks(const Record& record);
+    static void WriteToFile(const std::string& line);
+    static void RotateFile();
+
+    static std::atomic<int> s_level;
+    static std::atomic<bool> s_running;
+    static std::atomic<bool> s_writerIdle;
+    static std::atomic<uint64_t> s_dropped;
+    static std::atomic<size_t> s_payloadLimit;
+
+    static std::unique_ptr<Slot[]> s_ring;     // Allocated once, by the first Start()
+    static size_t s_mask;
+    static std::atomic<size_t> s_enqueuePos;
+    static size_t s_dequeuePos;
+
+    static LoggerConfig s_config;
+    static std::mutex s_sinkMutex;              // Sinks, file state and the synchronous path
+    static std::mutex s_wakeMutex;
+    static std::condition_variable s_wakeCv;
+    static std::thread s_writer;
+    static bool s_stopWriter;
+};
+
+// Levels below this are compiled out (0 = trace ... 5 = off)
+#ifndef IFC_LOG_COMPILE_LEVEL
+#define IFC_LOG_COMPILE_LEVEL 0
+#endif
+
+#define IFC_LOG(level, expr) \
+    do { \
+        if (Logger::IsEnabled(level)) { \
+            std::ostringstream& ifcLogStream = Logger::Stream(); \
+            ifcLogStream << expr; \
+            Logger::Write(level, ifcLogStream.str()); \
+        } \
+    } while (0)
+
+#define IFC_LOG_DISABLED() do { } while (0)
+
+#if IFC_LOG_COMPILE_LEVEL <= 0
+#define LOG_TRACE(expr) IFC_LOG(LogLevel::Trace, expr)
+#else
+#define LOG_TRACE(expr) IFC_LOG_DISABLED()
+#endif
+
+#if IFC_LOG_COMPILE_LEVEL <= 1
+#define LOG_DEBUG(expr) IFC_LOG(LogLevel::Debug, expr)
+#else
+#define LOG_DEBUG(expr) IFC_LOG_DISABLED()
+#endif
+
+#if IFC_LOG_COMPILE_LEVEL <= 2
+#define LOG_INFO(expr) IFC_LOG(LogLevel::Info, expr)
+#else
+#define LOG_INFO(expr) IFC_LOG_DISABLED()
+#endif
+
+#if IFC_LOG_COMPILE_LEVEL <= 3
+#define LOG_WARN(expr) IFC_LOG(LogLevel::Warn, expr)
+#else
+#define LOG_WARN(expr) IFC_LOG_DISABLED()
+#endif
+
+#if IFC_LOG_COMPILE_LEVEL <= 4
+#define LOG_ERROR(expr) IFC_LOG(LogLevel::Error, expr)
+#else
+#define LOG_ERROR(expr) IFC_LOG_DISABLED()
+#endif
+
+#endif // LOGGER_HPP
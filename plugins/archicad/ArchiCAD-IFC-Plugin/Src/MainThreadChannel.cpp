@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MainThreadChannel.hpp"
+#include "APIEnvir.h"
+#include "MDIDs_APICD.h"    // Same identifiers the 'MDID' resource is built from
+#include "Logger.hpp"
+
+// Module command used as the doorbell (only ever called by ourselves)
+static const GSType kDoorbellCommandId = 'MTCH';
+static const Int32 kDoorbellCommandVersion = 1;
+
+MainThreadChannel::Node MainThreadChannel::s_stub;
+std::atomic<MainThreadChannel::Node*> MainThreadChannel::s_head(&MainThreadChannel::s_stub);
+MainThreadChannel::Node* MainThreadChannel::s_tail = &MainThreadChannel::s_stub;
+std::atomic<bool> MainThreadChannel::s_doorbellPending(false);
+std::atomic<bool> MainThreadChannel::s_accepting(true);
+
+GSErrCode MainThreadChannel::Register()
+{
+    return ACAPI_AddOnAddOnCommunication_RegisterSupportedService(kDoorbellCommandId, kDoorbellCommandVersion);
+}
+
+GSErrCode MainThreadChannel::Install()
+{
+    s_stub.next.store(nullptr);
+    s_accepting = true;
+    return ACAPI_AddOnAddOnCommunication_InstallModulCommandHandler(kDoorbellCommandId, kDoorbellCommandVersion, OnMainThread);
+}
+
+bool MainThreadChannel::Post(Task task)
+{
+    if (!s_accepting) {
+        return false;
+    }
+
+    Node* node = new Node();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->task = std::move(task);
+    Push(node);
+
+    return RingDoorbell();
+}
+
+void MainThreadChannel::Shutdown()
+{
+    s_accepting = false;
+
+    // Runs on the main thread (FreeData), so it is safe to act as consumer
+    Task task;
+    while (Pop(task) == PopResult::Item) {
+        task = nullptr;
+    }
+}
+
+void MainThreadChannel::Push(Node* node)
+{
+    Node* prev = s_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+MainThreadChannel::PopResult MainThreadChannel::Pop(Task& task)
+{
+    Node* tail = s_tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &s_stub) {
+        if (next == nullptr) {
+            return s_head.load(std::memory_order_acquire) == tail ? PopResult::Empty : PopResult::Retry;
+        }
+        s_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+        s_tail = next;
+        task = std::move(tail->task);
+        delete tail;
+        return PopResult::Item;
+    }
+
+    if (tail != s_head.load(std::memory_order_acquire)) {
+        return PopResult::Retry;
+    }
+
+    // Last real node: put the stub back behind it so it can be released
+    s_stub.next.store(nullptr, std::memory_order_relaxed);
+    Push(&s_stub);
+
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        s_tail = next;
+        task = std::move(tail->task);
+        delete tail;
+        return PopResult::Item;
+    }
+
+    return PopResult::Retry;
+}
+
+bool MainThreadChannel::RingDoorbell()
+{
+    if (s_doorbellPending.exchange(true)) {
+        return true;    // Already rung, the pending drain will pick the task up
+    }
+
+    API_ModulID mdid;
+    BNZeroMemory(&mdid, sizeof(API_ModulID));
+    mdid.developerID = DEVELOPER_ID;
+    mdid.localID = ADDON_ID;
+
+    GSErrCode err = ACAPI_AddOnAddOnCommunication_CallFromEventLoop(&mdid, kDoorbellCommandId, kDoorbellCommandVersion, nullptr, true, nullptr);
+    if (err != NoError) {
+        LOG_ERROR("✗ MainThreadChannel: CallFromEventLoop failed. Code: " << err);
+        s_doorbellPending = false;
+        return false;
+    }
+
+    return true;
+}
+
+GSErrCode __ACENV_CALL MainThreadChannel::OnMainThread(GSHandle /*paramsHandle*/, GSPtr /*resultData*/, bool /*silentMode*/)
+{
+    // Clear first: anything pushed from now on rings again
+    s_doorbellPending = false;
+
+    Task task;
+    while (true) {
+        PopResult result = Pop(task);
+
+        if (result == PopResult::Empty) {
+            break;
+        }
+
+        if (result == PopResult::Retry) {
+            // A producer is mid-push; come back on the next event loop turn
+            RingDoorbell();
+            break;
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("✗ MainThreadChannel task exception: " << e.what());
+        } catch (...) {
+            LOG_ERROR("✗ MainThreadChannel task: unknown exception");
+        }
+        task = nullptr;
+    }
+
+    return NoError;
+}
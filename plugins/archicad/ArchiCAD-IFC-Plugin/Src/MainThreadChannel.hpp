@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAIN_THREAD_CHANNEL_HPP
+#define MAIN_THREAD_CHANNEL_HPP
+
+#include "ACAPinc.h"
+#include <functional>
+#include <atomic>
+
+/**
+ * @brief In-process handoff of work to the Archicad main thread
+ *
+ * Any thread can Post() a task. Tasks go into a lock-free multi-producer,
+ * single-consumer queue; the first producer to find the channel idle rings
+ * a "doorbell" with ACAPI_AddOnAddOnCommunication_CallFromEventLoop, and
+ * Archicad then calls our module command handler from its event loop, where
+ * every pending task is drained in order.
+ *
+ * Post() never blocks and never waits for the task to run, so the
+ * WebSocket thread stays free to serve cancel_job / get_status while a
+ * conversion is running.
+ */
+class MainThreadChannel {
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief Register the doorbell service (call from RegisterInterface)
+     */
+    static GSErrCode Register();
+
+    /**
+     * @brief Install the doorbell handler (call from Initialize)
+     */
+    static GSErrCode Install();
+
+    /**
+     * @brief Queue a task for execution on the main thread
+     * @param task Task to run
+     * @return false if the channel is shut down or the doorbell failed
+     */
+    static bool Post(Task task);
+
+    /**
+     * @brief Stop accepting tasks and drop the ones not yet run
+     */
+    static void Shutdown();
+
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        Task task;
+    };
+
+    enum class PopResult {
+        Item,
+        Empty,
+        Retry       // A producer is between its two push steps
+    };
+
+    static void Push(Node* node);
+    static PopResult Pop(Task& task);
+    static bool RingDoorbell();
+    static GSErrCode __ACENV_CALL OnMainThread(GSHandle paramsHandle, GSPtr resultData, bool silentMode);
+
+    static Node s_stub;
+    static std::atomic<Node*> s_head;       // Producers push here
+    static Node* s_tail;                    // Consumer (main thread) pops here
+    static std::atomic<bool> s_doorbellPending;
+    static std::atomic<bool> s_accepting;
+};
+
+#endif // MAIN_THREAD_CHANNEL_HPP
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MemoryPolicy.hpp"
+#include "ProcessStats.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+static uint64_t ToMegabytes(uint64_t bytes)
+{
+    return bytes / (1024 * 1024);
+}
+
+std::string JobMemory::ToJson() const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("rssBeforeBytes", rssBeforeBytes)
+          .Field("rssAfterBytes", rssAfterBytes)
+          .Field("rssDeltaBytes", static_cast<long long>(rssAfterBytes) - static_cast<long long>(rssBeforeBytes))
+          .Field("peakRssBytes", peakRssBytes)
+          .EndObject();
+    return writer.ToString();
+}
+
+MemoryPolicy::MemoryPolicy()
+    : m_jobs(0)
+    , m_lastRssBytes(0)
+    , m_peakRssBytes(0)
+    , m_deepCleanups(0)
+    , m_lastCleanupFreedBytes(0)
+    , m_pendingAction(MemoryAction::None)
+    , m_recycleRequested(false)
+{
+}
+
+void MemoryPolicy::Configure(const MemoryPolicyConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_config = config;
+}
+
+void MemoryPolicy::JobStarted(const std::string& jobId)
+{
+    ProcessMemory memory;
+    GetProcessMemory(memory);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_startRss[jobId] = memory.rssBytes;
+    m_lastRssBytes = memory.rssBytes;
+    m_peakRssBytes = memory.peakRssBytes;
+}
+
+JobMemory MemoryPolicy::JobFinished(const std::string& jobId)
+{
+    JobMemory memory;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto started = m_startRss.find(jobId);
+    if (started == m_startRss.end()) {
+        return memory;
+    }
+
+    ProcessMemory now;
+    GetProcessMemory(now);
+
+    memory.valid = true;
+    memory.rssBeforeBytes = started->second;
+    memory.rssAfterBytes = now.rssBytes;
+    memory.peakRssBytes = now.peakRssBytes;
+    m_startRss.erase(started);
+
+    ++m_jobs;
+    m_lastRssBytes = now.rssBytes;
+    m_peakRssBytes = now.peakRssBytes;
+
+    LOG_DEBUG("Job " << jobId << " memory: " << ToMegabytes(memory.rssBeforeBytes) << " -> "
+              << ToMegabytes(memory.rssAfterBytes) << " MB (peak " << ToMegabytes(memory.peakRssBytes) << " MB)");
+
+    if (m_pendingAction == MemoryAction::None && !m_recycleRequested) {
+        if (m_config.deepCleanupBytes > 0 && now.rssBytes >= m_config.deepCleanupBytes) {
+            m_pendingAction = MemoryAction::DeepCleanup;
+        } else {
+            m_pendingAction = CheckRecycle(now.rssBytes);
+        }
+    }
+    return memory;
+}
+
+MemoryAction MemoryPolicy::TakePendingAction()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MemoryAction action = m_pendingAction;
+    m_pendingAction = MemoryAction::None;
+    return action;
+}
+
+MemoryAction MemoryPolicy::CleanupDone(uint64_t rssBeforeBytes)
+{
+    ProcessMemory now;
+    GetProcessMemory(now);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_deepCleanups;
+    m_lastCleanupFreedBytes = rssBeforeBytes > now.rssBytes ? rssBeforeBytes - now.rssBytes : 0;
+    m_lastRssBytes = now.rssBytes;
+    m_peakRssBytes = now.peakRssBytes;
+
+    LOG_INFO("✓ Deep cleanup freed " << ToMegabytes(m_lastCleanupFreedBytes) << " MB (now "
+             << ToMegabytes(now.rssBytes) << " MB)");
+
+    if (m_recycleRequested) {
+        return MemoryAction::None;
+    }
+    return CheckRecycle(now.rssBytes);
+}
+
+MemoryAction MemoryPolicy::CheckRecycle(uint64_t rssBytes)
+{
+    if (m_config.recycleAfterJobs > 0 && m_jobs >= m_config.recycleAfterJobs) {
+        m_recycleReason = "ran " + std::to_string(m_jobs) + " jobs";
+    } else if (m_config.recycleBytes > 0 && rssBytes >= m_config.recycleBytes) {
+        m_recycleReason = "resident set " + std::to_string(ToMegabytes(rssBytes)) + " MB exceeds " +
+                          std::to_string(ToMegabytes(m_config.recycleBytes)) + " MB";
+    } else {
+        return MemoryAction::None;
+    }
+
+    m_recycleRequested = true;
+    return MemoryAction::Recycle;
+}
+
+bool MemoryPolicy::IsRecycleRequested() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recycleRequested;
+}
+
+std::string MemoryPolicy::GetRecycleReason() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recycleReason;
+}
+
+std::string MemoryPolicy::FormatJson() const
+{
+    ProcessMemory now;
+    GetProcessMemory(now);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("rssBytes", now.rssBytes)
+          .Field("peakRssBytes", now.peakRssBytes)
+          .Field("jobs", m_jobs)
+          .Field("deepCleanups", m_deepCleanups)
+          .Field("lastCleanupFreedBytes", m_lastCleanupFreedBytes)
+          .Field("recycleRequested", m_recycleRequested);
+    if (m_recycleRequested) {
+        writer.Field("recycleReason", m_recycleReason);
+    }
+    writer.Key("thresholds").BeginObject()
+              .Field("deepCleanupBytes", m_config.deepCleanupBytes)
+              .Field("recycleBytes", m_config.recycleBytes)
+              .Field("recycleAfterJobs", m_config.recycleAfterJobs)
+          .EndObject()
+          .EndObject();
+    return writer.ToString();
+}
+
+std::string MemoryPolicy::FormatPrometheus() const
+{
+    ProcessMemory now;
+    GetProcessMemory(now);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string text;
+    text += "# HELP ifc_plugin_process_resident_bytes Resident set of the Archicad process.\n"
+            "# TYPE ifc_plugin_process_resident_bytes gauge\n"
+            "ifc_plugin_process_resident_bytes " + std::to_string(now.rssBytes) + "\n";
+    text += "# HELP ifc_plugin_process_resident_peak_bytes Largest resident set since Archicad started.\n"
+            "# TYPE ifc_plugin_process_resident_peak_bytes gauge\n"
+            "ifc_plugin_process_resident_peak_bytes " + std::to_string(now.peakRssBytes) + "\n";
+    text += "# HELP ifc_plugin_deep_cleanups_total Deep cleanups run by the memory policy.\n"
+            "# TYPE ifc_plugin_deep_cleanups_total counter\n"
+            "ifc_plugin_deep_cleanups_total " + std::to_string(m_deepCleanups) + "\n";
+    text += "# HELP ifc_plugin_recycle_requested 1 once the instance asked to be recycled.\n"
+            "# TYPE ifc_plugin_recycle_requested gauge\n"
+            "ifc_plugin_recycle_requested " + std::string(m_recycleRequested ? "1" : "0") + "\n";
+    return text;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORY_POLICY_HPP
+#define MEMORY_POLICY_HPP
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Memory thresholds; 0 disables a rule
+ */
+struct MemoryPolicyConfig {
+    uint64_t deepCleanupBytes = 0;      // Resident set after a job that triggers a deep cleanup
+    uint64_t recycleBytes = 0;          // Resident set (after any cleanup) that asks for a new worker
+    uint64_t recycleAfterJobs = 0;      // Jobs after which a new worker is asked for
+};
+
+/**
+ * @brief What the main thread should do after a job
+ */
+enum class MemoryAction {
+    None,
+    DeepCleanup,    // Reset the project state and release freed heap
+    Recycle         // Ask the coordinator/supervisor to replace this instance
+};
+
+/**
+ * @brief Resident set around one job
+ */
+struct JobMemory {
+    bool valid = false;
+    uint64_t rssBeforeBytes = 0;        // When the job started on the main thread
+    uint64_t rssAfterBytes = 0;         // After its project was closed
+    uint64_t peakRssBytes = 0;          // Process peak so far
+
+    std::string ToJson() const;
+};
+
+/**
+ * @brief Tracks Archicad's memory across jobs and decides when to clean up or recycle
+ *
+ * Samples the process resident set when a job starts and after it finished
+ * (its project closed), then checks the thresholds. A deep cleanup comes
+ * first when it is enabled; if memory is still above the recycle threshold
+ * afterwards, or the job limit is reached, the instance asks to be recycled
+ * once. Thread-safe.
+ */
+class MemoryPolicy {
+public:
+    MemoryPolicy();
+
+    void Configure(const MemoryPolicyConfig& config);
+
+    /**
+     * @brief Sample memory before a job runs
+     */
+    void JobStarted(const std::string& jobId);
+
+    /**
+     * @brief Sample memory after a job and decide on the action
+     * @return The job's memory; invalid if JobStarted was not called or it was already sampled
+     *
+     * The decision is kept until TakePendingAction().
+     */
+    JobMemory JobFinished(const std::string& jobId);
+
+    /**
+     * @brief The action decided by the last JobFinished(), once
+     */
+    MemoryAction TakePendingAction();
+
+    /**
+     * @brief Record a finished deep cleanup
+     * @param rssBeforeBytes Resident set before the cleanup
+     * @return Recycle if memory is still above the recycle threshold
+     */
+    MemoryAction CleanupDone(uint64_t rssBeforeBytes);
+
+    bool IsRecycleRequested() const;
+    std::string GetRecycleReason() const;
+
+    /**
+     * @brief Current state as a JSON object (sent as "memory" in metrics)
+     */
+    std::string FormatJson() const;
+
+    /**
+     * @brief Current state in the Prometheus text exposition format
+     */
+    std::string FormatPrometheus() const;
+
+private:
+    MemoryAction CheckRecycle(uint64_t rssBytes);
+
+    mutable std::mutex m_mutex;
+    MemoryPolicyConfig m_config;
+    std::map<std::string, uint64_t> m_startRss;     // Running jobs -> resident set at start
+    uint64_t m_jobs;
+    uint64_t m_lastRssBytes;
+    uint64_t m_peakRssBytes;
+    uint64_t m_deepCleanups;
+    uint64_t m_lastCleanupFreedBytes;
+    MemoryAction m_pendingAction;
+    bool m_recycleRequested;
+    std::string m_recycleReason;
+};
+
+#endif // MEMORY_POLICY_HPP
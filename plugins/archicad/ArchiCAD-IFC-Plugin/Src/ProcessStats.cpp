@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ProcessStats.hpp"
+#include "JsonWriter.hpp"
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#else
+#include <fstream>
+#include <malloc.h>
+#endif
+
+std::string ProcessMemory::ToJson() const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("rssBytes", rssBytes)
+          .Field("peakRssBytes", peakRssBytes)
+          .EndObject();
+    return writer.ToString();
+}
+
+bool GetProcessMemory(ProcessMemory& memory)
+{
+    memory = ProcessMemory();
+
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return false;
+    }
+    memory.rssBytes = counters.WorkingSetSize;
+    memory.peakRssBytes = counters.PeakWorkingSetSize;
+    return true;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return false;
+    }
+    memory.rssBytes = info.resident_size;
+    memory.peakRssBytes = info.resident_size_max;
+    return true;
+#else
+    // VmRSS / VmHWM lines of /proc/self/status, in kB
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    bool found = false;
+    while (std::getline(status, line)) {
+        uint64_t* target = nullptr;
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            target = &memory.rssBytes;
+        } else if (line.compare(0, 6, "VmHWM:") == 0) {
+            target = &memory.peakRssBytes;
+        }
+        if (target != nullptr) {
+            *target = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+            found = true;
+        }
+    }
+    return found;
+#endif
+}
+
+void ReleaseFreeMemory()
+{
+#ifdef _WIN32
+    _heapmin();
+#elif defined(__APPLE__)
+    malloc_zone_pressure_relief(nullptr, 0);
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
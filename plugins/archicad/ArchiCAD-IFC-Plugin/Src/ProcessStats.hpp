@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCESS_STATS_HPP
+#define PROCESS_STATS_HPP
+
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Memory use of the current process (the Archicad instance hosting the plugin)
+ */
+struct ProcessMemory {
+    uint64_t rssBytes = 0;          // Resident set / working set now
+    uint64_t peakRssBytes = 0;      // Largest resident set since the process started
+
+    std::string ToJson() const;
+};
+
+/**
+ * @brief Read the current process's memory use
+ * @return false if the platform does not report it
+ */
+bool GetProcessMemory(ProcessMemory& memory);
+
+/**
+ * @brief Hand heap memory that was freed but kept by the allocator back to the system
+ *
+ * Lowers the resident set after a large project was closed; does nothing
+ * where the C runtime offers no way to do it.
+ */
+void ReleaseFreeMemory();
+
+#endif // PROCESS_STATS_HPP
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ProgressAggregator.hpp"
+#include <vector>
+#include <algorithm>
+
+ProgressAggregator::ProgressAggregator()
+    : m_interval(std::chrono::milliseconds(100))
+    , m_coalesced(0)
+    , m_running(false)
+{
+}
+
+ProgressAggregator::~ProgressAggregator()
+{
+    Stop();
+}
+
+void ProgressAggregator::SetPublisher(Publisher publisher)
+{
+    m_publisher = std::move(publisher);
+}
+
+void ProgressAggregator::Start(int maxRateHz)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || maxRateHz <= 0) {
+        return;
+    }
+
+    m_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / maxRateHz));
+    m_running = true;
+    m_thread = std::thread(&ProgressAggregator::Run, this);
+}
+
+void ProgressAggregator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // Whatever is still pending goes out now
+    PublishDue(true);
+}
+
+void ProgressAggregator::Post(const std::string& jobId, int progress, const std::string& status, const std::string& message)
+{
+    bool running;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        running = m_running;
+        if (running) {
+            Slot& slot = m_slots[jobId];
+            if (slot.pending) {
+                m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.latest.jobId = jobId;
+            slot.latest.progress = progress;
+            slot.latest.status = status;
+            slot.latest.message = message;
+
+            // The publisher sleeps while nothing is pending; an update after a
+            // quiet period goes out without waiting for a tick
+            wake = !slot.pending;
+            slot.pending = true;
+        }
+    }
+
+    if (wake) {
+        m_wake.notify_one();
+        return;
+    }
+
+    if (!running && m_publisher) {
+        ProgressUpdate update;
+        update.jobId = jobId;
+        update.progress = progress;
+        update.status = status;
+        update.message = message;
+
+        std::lock_guard<std::mutex> publishLock(m_publishMutex);
+        m_publisher(update);
+    }
+}
+
+void ProgressAggregator::Finish(const std::string& jobId, const std::function<void()>& sendFinal)
+{
+    std::lock_guard<std::mutex> publishLock(m_publishMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slots.erase(jobId);
+    }
+    sendFinal();
+}
+
+void ProgressAggregator::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        // Sleep until the earliest pending update is due
+        auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
+        for (const auto& entry : m_slots) {
+            if (entry.second.pending) {
+                next = std::min(next, entry.second.lastPublished + m_interval);
+            }
+        }
+
+        if (next > now) {
+            if (next == std::chrono::steady_clock::time_point::max()) {
+                m_wake.wait(lock);
+            } else {
+                m_wake.wait_until(lock, next);
+            }
+            continue;
+        }
+
+        lock.unlock();
+        PublishDue(false);
+        lock.lock();
+    }
+}
+
+void ProgressAggregator::PublishDue(bool all)
+{
+    std::lock_guard<std::mutex> publishLock(m_publishMutex);
+
+    std::vector<ProgressUpdate> due;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = m_slots.begin(); it != m_slots.end();) {
+            Slot& slot = it->second;
+            if (slot.pending && (all || now - slot.lastPublished >= m_interval)) {
+                due.push_back(slot.latest);
+                slot.pending = false;
+                slot.lastPublished = now;
+            }
+
+            // Jobs that went quiet are forgotten; their next update goes out at once
+            if (!slot.pending && now - slot.lastPublished >= 10 * m_interval) {
+                it = m_slots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (m_publisher) {
+        for (const ProgressUpdate& update : due) {
+            m_publisher(update);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROGRESS_AGGREGATOR_HPP
+#define PROGRESS_AGGREGATOR_HPP
+
+#include <string>
+#include <map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Latest progress of a job
+ */
+struct ProgressUpdate {
+    std::string jobId;
+    int progress = 0;
+    std::string status;
+    std::string message;
+};
+
+/**
+ * @brief Rate-limits progress events between the job and the clients
+ *
+ * Post() only stores the job's latest update (a map assignment under a
+ * short lock), so progress callbacks on the main thread cost the same
+ * however many clients listen. A publisher thread sends each job's latest
+ * update at most maxRateHz times per second; an update arriving after a
+ * quiet period goes out at once.
+ *
+ * Final events go through Finish(), which drops the job's pending update
+ * and sends the final event while no publication is in flight, so nothing
+ * published later can overtake it.
+ *
+ * Until Start() (or with a rate of 0) every update is published right away
+ * on the calling thread.
+ */
+class ProgressAggregator {
+public:
+    using Publisher = std::function<void(const ProgressUpdate& update)>;
+
+    ProgressAggregator();
+    ~ProgressAggregator();
+
+    ProgressAggregator(const ProgressAggregator&) = delete;
+    ProgressAggregator& operator=(const ProgressAggregator&) = delete;
+
+    /**
+     * @brief Set the function that sends an update (call before Start())
+     */
+    void SetPublisher(Publisher publisher);
+
+    /**
+     * @brief Start the publisher thread
+     * @param maxRateHz Updates per second and job; 0 publishes every update right away
+     */
+    void Start(int maxRateHz);
+
+    /**
+     * @brief Publish what is pending and stop the publisher thread
+     */
+    void Stop();
+
+    /**
+     * @brief Store a job's latest progress (replaces an unpublished one)
+     */
+    void Post(const std::string& jobId, int progress, const std::string& status, const std::string& message);
+
+    /**
+     * @brief Forget the job's pending update and send its final event
+     * @param sendFinal Sends the final event; runs on the calling thread
+     */
+    void Finish(const std::string& jobId, const std::function<void()>& sendFinal);
+
+    /**
+     * @brief Updates replaced before they were published
+     */
+    uint64_t GetCoalescedCount() const { return m_coalesced; }
+
+private:
+    struct Slot {
+        ProgressUpdate latest;
+        bool pending = false;
+        std::chrono::steady_clock::time_point lastPublished;
+    };
+
+    void Run();
+    void PublishDue(bool all);
+
+    Publisher m_publisher;
+    std::map<std::string, Slot> m_slots;
+    std::mutex m_mutex;                 // Guards m_slots and m_running
+    std::mutex m_publishMutex;          // Held while anything is being sent
+    std::condition_variable m_wake;
+    std::thread m_thread;
+    std::chrono::steady_clock::duration m_interval;
+    std::atomic<uint64_t> m_coalesced;
+    bool m_running;
+};
+
+#endif // PROGRESS_AGGREGATOR_HPP
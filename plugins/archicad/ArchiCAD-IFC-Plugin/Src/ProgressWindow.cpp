@@ -17,7 +17,7 @@
 
 #include "ProgressWindow.hpp"
 #include "DG.h"
-#include <iostream>
+#include "Logger.hpp"
 
 // Dialog item IDs
 enum {
@@ -34,7 +34,7 @@ bool ProgressWindow::s_isShown = false;
 void ProgressWindow::Show(const std::string& title, const std::string& initialMessage)
 {
     if (s_isShown) {
-        std::cerr << "Progress window already shown" << std::endl;
+        LOG_WARN("Progress window already shown");
         return;
     }
 
@@ -46,7 +46,7 @@ void ProgressWindow::Show(const std::string& title, const std::string& initialMe
     // creating a proper resource-based dialog later if needed
 
     s_isShown = true;
-    std::cout << "Progress Window: " << title << " - " << initialMessage << std::endl;
+    LOG_INFO("Progress Window: " << title << " - " << initialMessage);
 }
 
 void ProgressWindow::UpdateProgress(int progress, const std::string& message)
@@ -59,7 +59,7 @@ void ProgressWindow::UpdateProgress(int progress, const std::string& message)
     if (progress < 0) progress = 0;
     if (progress > 100) progress = 100;
 
-    std::cout << "Progress: " << progress << "% - " << message << std::endl;
+    LOG_DEBUG("Progress: " << progress << "% - " << message);
 
     // If progress is 100%, close the window
     if (progress >= 100) {
@@ -73,7 +73,7 @@ void ProgressWindow::SetJobId(const std::string& jobId)
         return;
     }
 
-    std::cout << "Job ID: " << jobId << std::endl;
+    LOG_DEBUG("Job ID: " << jobId);
 }
 
 void ProgressWindow::Close()
@@ -82,7 +82,7 @@ void ProgressWindow::Close()
         return;
     }
 
-    std::cout << "Closing progress window" << std::endl;
+    LOG_INFO("Closing progress window");
     s_isShown = false;
     s_dialogId = 0;
 }
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ResultCache.hpp"
+#include "FileHash.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <initializer_list>
+
+namespace fs = std::filesystem;
+
+// Bump whenever the key layout or the meaning of cached files changes
+static const char* kCacheKeyVersion = "v1";
+
+static const char* kEntryExtension = ".result";
+
+ResultCache::ResultCache()
+    : m_maxBytes(0)
+    , m_totalBytes(0)
+{
+}
+
+bool ResultCache::Open(const std::string& directory, uint64_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_directory.clear();
+    m_lru.clear();
+    m_entries.clear();
+    m_totalBytes = 0;
+    m_maxBytes = maxBytes;
+
+    if (maxBytes == 0 || directory.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path root = fs::u8path(directory);
+    fs::create_directories(root, ec);
+    if (!fs::is_directory(root, ec)) {
+        LOG_ERROR("✗ Result cache directory unusable: " << directory);
+        return false;
+    }
+
+    // Index existing entries, most recently used first
+    struct Found {
+        std::string key;
+        std::string path;
+        uint64_t size;
+        fs::file_time_type time;
+    };
+    std::vector<Found> found;
+
+    for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path& path = it->path();
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        if (path.extension() != kEntryExtension) {
+            // Leftover from an interrupted Store
+            if (path.extension() == ".tmp") {
+                fs::remove(path, ec);
+            }
+            continue;
+        }
+        found.push_back({ path.stem().u8string(), path.u8string(), it->file_size(ec), it->last_write_time(ec) });
+    }
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.time > b.time; });
+
+    for (const Found& item : found) {
+        m_lru.push_back(item.key);
+        Entry entry;
+        entry.path = item.path;
+        entry.size = item.size;
+        entry.lruPos = std::prev(m_lru.end());
+        m_entries[item.key] = entry;
+        m_totalBytes += item.size;
+    }
+
+    m_directory = root.u8string();
+    EvictLocked(0);
+
+    LOG_INFO("✓ Result cache: " << m_entries.size() << " entries, " << (m_totalBytes >> 20) << " MB in " << m_directory);
+    return true;
+}
+
+void ResultCache::Close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory.clear();
+    m_lru.clear();
+    m_entries.clear();
+    m_totalBytes = 0;
+}
+
+bool ResultCache::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_directory.empty();
+}
+
+std::string ResultCache::MakeKey(const std::string& inputHash, const std::string& jobKind,
+                                 const std::string& translator, const std::string& options)
+{
+    // Length-prefix every part so different splits never collide
+    std::string material = kCacheKeyVersion;
+    for (const std::string* part : { &jobKind, &inputHash, &translator, &options }) {
+        material += "|" + std::to_string(part->size()) + ":" + *part;
+    }
+    return Sha256::HashString(material);
+}
+
+bool ResultCache::Fetch(const std::string& key, const std::string& outputPath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(key);
+    if (m_directory.empty() || it == m_entries.end()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path entryPath = fs::u8path(it->second.path);
+
+    // An entry that changed size was modified through a hard-linked output;
+    // it can no longer be trusted
+    if (fs::file_size(entryPath, ec) != it->second.size || ec) {
+        LOG_WARN("Result cache: dropping damaged entry " << key);
+        RemoveLocked(it);
+        return false;
+    }
+
+    fs::path target = fs::u8path(outputPath);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+    }
+    fs::remove(target, ec);
+
+    ec.clear();
+    fs::create_hard_link(entryPath, target, ec);
+    if (ec) {
+        ec.clear();
+        fs::copy_file(entryPath, target, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            LOG_WARN("Result cache: could not place " << key << " at " << outputPath << ": " << ec.message());
+            return false;
+        }
+    }
+
+    // Mark as most recently used, in memory and on disk
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    fs::last_write_time(entryPath, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool ResultCache::Store(const std::string& key, const std::string& resultPath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_directory.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path source = fs::u8path(resultPath);
+    uint64_t size = fs::file_size(source, ec);
+    if (ec || size > m_maxBytes) {
+        return false;
+    }
+
+    auto existing = m_entries.find(key);
+    if (existing != m_entries.end()) {
+        RemoveLocked(existing);
+    }
+
+    EvictLocked(size);
+
+    // Copy under a temporary name so a crash never leaves a partial entry
+    fs::path root = fs::u8path(m_directory);
+    fs::path entryPath = root / fs::u8path(key + kEntryExtension);
+    fs::path tempPath = root / fs::u8path(key + ".tmp");
+
+    fs::copy_file(source, tempPath, fs::copy_options::overwrite_existing, ec);
+    if (!ec) {
+        fs::rename(tempPath, entryPath, ec);
+    }
+    if (ec) {
+        LOG_WARN("Result cache: could not store " << resultPath << ": " << ec.message());
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    m_lru.push_front(key);
+    Entry entry;
+    entry.path = entryPath.u8string();
+    entry.size = size;
+    entry.lruPos = m_lru.begin();
+    m_entries[key] = entry;
+    m_totalBytes += size;
+    return true;
+}
+
+uint64_t ResultCache::GetSizeBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalBytes;
+}
+
+size_t ResultCache::GetEntryCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void ResultCache::EvictLocked(uint64_t incomingBytes)
+{
+    while (!m_lru.empty() && m_totalBytes + incomingBytes > m_maxBytes) {
+        auto it = m_entries.find(m_lru.back());
+        if (it == m_entries.end()) {
+            m_lru.pop_back();
+            continue;
+        }
+        RemoveLocked(it);
+    }
+}
+
+void ResultCache::RemoveLocked(std::map<std::string, Entry>::iterator it)
+{
+    // Hard-linked outputs keep their data; only the cache's name goes away
+    std::error_code ec;
+    fs::remove(fs::u8path(it->second.path), ec);
+
+    m_totalBytes -= (std::min)(m_totalBytes, it->second.size);
+    m_lru.erase(it->second.lruPos);
+    m_entries.erase(it);
+}
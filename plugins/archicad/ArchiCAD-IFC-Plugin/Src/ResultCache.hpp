@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <string>
+#include <list>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Size-bounded, on-disk cache of conversion results
+ *
+ * Entries are addressed by a key derived from the input file contents and
+ * everything else that influences the output (job type, translator, export
+ * options). Each entry is a single file named after its key; the least
+ * recently used entries are evicted once the cache grows beyond its limit.
+ * Recency survives restarts through the files' modification times.
+ *
+ * All methods are thread-safe and do not use the Archicad API.
+ */
+class ResultCache {
+public:
+    ResultCache();
+
+    /**
+     * @brief Open (or create) a cache directory and index its entries
+     * @param directory UTF-8 path of the cache directory
+     * @param maxBytes Size limit; 0 disables the cache
+     * @return false if the cache is disabled or the directory is unusable
+     */
+    bool Open(const std::string& directory, uint64_t maxBytes);
+
+    /**
+     * @brief Disable the cache (files on disk are kept)
+     */
+    void Close();
+
+    bool IsEnabled() const;
+
+    /**
+     * @brief Build a cache key
+     * @param inputHash SHA-256 of the input file
+     * @param jobKind Conversion direction (e.g. "pln-to-ifc")
+     * @param translator Translator identity ("" for the project default)
+     * @param options Any other settings that change the output
+     */
+    static std::string MakeKey(const std::string& inputHash, const std::string& jobKind,
+                               const std::string& translator, const std::string& options);
+
+    /**
+     * @brief Place a cached result at outputPath
+     * @param key Cache key
+     * @param outputPath UTF-8 destination path
+     * @return true on a hit; the output is hard-linked to the cache entry
+     *         when possible and copied otherwise
+     */
+    bool Fetch(const std::string& key, const std::string& outputPath);
+
+    /**
+     * @brief Add a conversion result to the cache
+     * @param key Cache key
+     * @param resultPath UTF-8 path of the produced file (copied, not moved)
+     * @return true if the entry was stored
+     */
+    bool Store(const std::string& key, const std::string& resultPath);
+
+    uint64_t GetSizeBytes() const;
+    size_t GetEntryCount() const;
+
+private:
+    struct Entry {
+        std::string path;
+        uint64_t size = 0;
+        std::list<std::string>::iterator lruPos;   // Position in m_lru
+    };
+
+    void EvictLocked(uint64_t incomingBytes);
+    void RemoveLocked(std::map<std::string, Entry>::iterator it);
+
+    mutable std::mutex m_mutex;
+    std::string m_directory;
+    uint64_t m_maxBytes;
+    uint64_t m_totalBytes;
+    std::list<std::string> m_lru;                      // Most recent first
+    std::map<std::string, Entry> m_entries;
+};
+
+#endif // RESULT_CACHE_HPP
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TranslatorCache.hpp"
+#include "APIEnvir.h"
+#include "FileHash.hpp"
+#include "Logger.hpp"
+#include <cctype>
+
+// Static member initialization
+GS::Array<API_IFCTranslatorIdentifier> TranslatorCache::s_translators;
+std::map<std::string, UInt32> TranslatorCache::s_byName;
+bool TranslatorCache::s_loaded = false;
+
+// Helper to fold a translator name for case-insensitive lookups
+static std::string LowerName(const std::string& name)
+{
+    std::string lower = name;
+    for (char& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return lower;
+}
+
+GSErrCode TranslatorCache::Install()
+{
+    return ACAPI_ProjectOperation_CatchProjectEvent(
+        APINotify_New | APINotify_NewAndReset | APINotify_Open | APINotify_Close | APINotify_Quit,
+        OnProjectEvent);
+}
+
+void TranslatorCache::Prewarm()
+{
+    std::string errorMsg;
+    if (Load(errorMsg)) {
+        LOG_INFO("✓ IFC translators cached (" << s_translators.GetSize() << ")");
+    } else {
+        LOG_WARN("Could not prewarm IFC translators: " << errorMsg);
+    }
+}
+
+bool TranslatorCache::Resolve(const std::string& name, API_IFCTranslatorIdentifier& translator, std::string& errorMsg)
+{
+    if (!s_loaded && !Load(errorMsg)) {
+        LOG_ERROR(errorMsg);
+        return false;
+    }
+    if (Find(name, translator)) {
+        return true;
+    }
+
+    // Translators can be added to the open project without a project event
+    if (!Load(errorMsg)) {
+        LOG_ERROR(errorMsg);
+        return false;
+    }
+    if (Find(name, translator)) {
+        return true;
+    }
+
+    std::string available;
+    for (const API_IFCTranslatorIdentifier& candidate : s_translators) {
+        available += (available.empty() ? "" : ", ") + std::string(candidate.name.ToCStr().Get());
+    }
+    errorMsg = "Error: IFC translator '" + name + "' not found (available: " + available + ")";
+    LOG_ERROR(errorMsg);
+    return false;
+}
+
+std::string TranslatorCache::Identify(const std::string& name)
+{
+    UInt32 index = 0;
+    if (!s_loaded || !FindIndex(name, index)) {
+        return std::string();
+    }
+
+    // Length-prefixed names, in list order
+    std::string list;
+    for (const API_IFCTranslatorIdentifier& candidate : s_translators) {
+        std::string candidateName = candidate.name.ToCStr().Get();
+        list += std::to_string(candidateName.size()) + ':' + candidateName + ';';
+    }
+    return "#" + std::to_string(index) + "/" + std::to_string(s_translators.GetSize()) + ":" + Sha256::HashString(list);
+}
+
+void TranslatorCache::Invalidate()
+{
+    s_translators.Clear();
+    s_byName.clear();
+    s_loaded = false;
+}
+
+bool TranslatorCache::Load(std::string& errorMsg)
+{
+    Invalidate();
+
+    GSErrCode err = ACAPI_IFC_GetIFCExportTranslatorsList(s_translators);
+    if (err != NoError || s_translators.IsEmpty()) {
+        s_translators.Clear();
+        errorMsg = "Error: No IFC translators available";
+        return false;
+    }
+
+    // The first of several translators with the same name wins, as before
+    for (UInt32 i = 0; i < s_translators.GetSize(); ++i) {
+        s_byName.emplace(LowerName(s_translators[i].name.ToCStr().Get()), i);
+    }
+    s_loaded = true;
+    return true;
+}
+
+bool TranslatorCache::Find(const std::string& name, API_IFCTranslatorIdentifier& translator)
+{
+    UInt32 index = 0;
+    if (!FindIndex(name, index)) {
+        return false;
+    }
+    translator = s_translators[index];
+    return true;
+}
+
+bool TranslatorCache::FindIndex(const std::string& name, UInt32& index)
+{
+    if (name.empty()) {
+        index = 0;
+        return true;
+    }
+
+    auto it = s_byName.find(LowerName(name));
+    if (it == s_byName.end()) {
+        return false;
+    }
+    index = it->second;
+    return true;
+}
+
+GSErrCode __ACENV_CALL TranslatorCache::OnProjectEvent(API_NotifyEventID notifID, Int32 /*param*/)
+{
+    if (s_loaded) {
+        LOG_DEBUG("Project event " << static_cast<int>(notifID) << ", dropping cached IFC translators");
+    }
+    Invalidate();
+    return NoError;
+}
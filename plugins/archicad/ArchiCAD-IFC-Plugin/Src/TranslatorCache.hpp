@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSLATOR_CACHE_HPP
+#define TRANSLATOR_CACHE_HPP
+
+#include "ACAPinc.h"
+#include <string>
+#include <map>
+
+/**
+ * @brief IFC export translators of the open project, looked up by name
+ *
+ * IFC translators belong to the project, so ACAPI_IFC_GetIFCExportTranslatorsList
+ * is asked once per opened project instead of once per export: a fan-out
+ * or a batch saving the same model several times resolves every translator
+ * from the cache. The list is dropped when Archicad reports a project
+ * change (new, open, close) and reloaded when a name is not found, in case
+ * translators were edited without a project event.
+ *
+ * Main thread only, like every project operation.
+ */
+class TranslatorCache {
+public:
+    /**
+     * @brief Watch project events (call from Initialize)
+     */
+    static GSErrCode Install();
+
+    /**
+     * @brief Load the open project's translators now
+     *
+     * The first call also loads Archicad's IFC module, which would
+     * otherwise slow down the first export after startup.
+     */
+    static void Prewarm();
+
+    /**
+     * @brief Pick a translator by name, ignoring ASCII case
+     * @param name Translator name, "" for the project's first translator
+     * @param translator Receives the translator
+     * @param errorMsg Receives the reason (with the available names) on failure
+     */
+    static bool Resolve(const std::string& name, API_IFCTranslatorIdentifier& translator, std::string& errorMsg);
+
+    /**
+     * @brief Identity of the translator a name resolves to, for result cache keys
+     *
+     * Names need not be unique and the API exposes no translator settings:
+     * the identity is the translator's position in the open project's list
+     * plus a digest of the whole list, so the same name picking another
+     * translator, or an added, renamed or reordered one, changes it. The
+     * settings themselves are saved in the project, which the key already
+     * covers with the input file's hash. Call after Resolve() succeeded.
+     */
+    static std::string Identify(const std::string& name);
+
+    /**
+     * @brief Forget the cached list (the open project changed)
+     */
+    static void Invalidate();
+
+private:
+    static bool Load(std::string& errorMsg);
+    static bool Find(const std::string& name, API_IFCTranslatorIdentifier& translator);
+    static bool FindIndex(const std::string& name, UInt32& index);
+    static GSErrCode __ACENV_CALL OnProjectEvent(API_NotifyEventID notifID, Int32 param);
+
+    static GS::Array<API_IFCTranslatorIdentifier> s_translators;
+    static std::map<std::string, UInt32> s_byName;     // Lower-case name -> index
+    static bool s_loaded;
+};
+
+#endif // TRANSLATOR_CACHE_HPP
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WebSocketCommand.hpp"
+#include "ElementFilter.hpp"
+
+CommandType CommandTypeFromName(const std::string& name)
+{
+    static const struct {
+        const char* name;
+        CommandType type;
+    } kCommands[] = {
+        { "start_conversion", CommandType::StartConversion },
+        { "start_batch",      CommandType::StartBatch },
+        { "cancel_job",       CommandType::CancelJob },
+        { "get_status",       CommandType::GetStatus },
+        { "load_ifc",         CommandType::LoadIfc },
+        { "get_worker_info",  CommandType::GetWorkerInfo },
+        { "register_worker",  CommandType::RegisterWorker },
+        { "get_pool_status",  CommandType::GetPoolStatus },
+        { "get_metrics",      CommandType::GetMetrics },
+        { "subscribe",        CommandType::Subscribe },
+        { "unsubscribe",      CommandType::Unsubscribe },
+        { "upload_begin",     CommandType::UploadBegin },
+        { "download",         CommandType::Download },
+        { "download_ack",     CommandType::DownloadAck },
+        { "cancel_transfer",  CommandType::CancelTransfer },
+        { "hello",            CommandType::Hello },
+        { "benchmark",        CommandType::Benchmark },
+        { "resume",           CommandType::Resume },
+    };
+
+    for (const auto& entry : kCommands) {
+        if (name == entry.name) {
+            return entry.type;
+        }
+    }
+    return CommandType::Unknown;
+}
+
+bool ParseWebSocketCommand(const std::string& payload, WebSocketCommand& command, std::string& error)
+{
+    command = WebSocketCommand();
+
+    if (!JsonParser::Parse(payload, command.body, error)) {
+        return false;
+    }
+
+    if (!command.body.IsObject()) {
+        error = "message is not a JSON object";
+        return false;
+    }
+
+    const JsonValue* name = command.body.Find("command");
+    if (name == nullptr || !name->IsString() || name->AsString().empty()) {
+        error = "missing 'command' field";
+        return false;
+    }
+
+    command.name = name->AsString();
+    command.type = CommandTypeFromName(command.name);
+    command.jobId = command.body.GetString({ "jobId", "job_id" });
+    command.plnPath = command.body.GetString({ "plnPath", "pln_path" });
+    command.ifcPath = command.body.GetString({ "ifcPath", "ifc_path" });
+    command.outputPath = command.body.GetString({ "outputPath", "output_path" });
+    command.priority = static_cast<int>(command.body.GetInt("priority", 0));
+    command.tenant = command.body.GetString({ "tenant" });
+    command.payload = payload;
+    return true;
+}
+
+// Appends one field, length-prefixed so that no value can imitate a separator
+static void AppendField(std::string& fingerprint, const std::string& value)
+{
+    fingerprint += std::to_string(value.size()) + ':' + value + ';';
+}
+
+// Canonical form of an optional "filter" member; a malformed filter is
+// rejected before the job runs, so its raw text is good enough
+static std::string FingerprintFilter(const JsonValue& body)
+{
+    const JsonValue* value = body.Find("filter");
+    if (value == nullptr) {
+        return std::string();
+    }
+
+    ElementFilter filter;
+    std::string error;
+    if (!ParseElementFilter(*value, filter, error)) {
+        return "invalid:" + error;
+    }
+    return DescribeElementFilter(filter);
+}
+
+std::string SubmissionFingerprint(const WebSocketCommand& command)
+{
+    const JsonValue& body = command.body;
+
+    std::string fingerprint;
+    AppendField(fingerprint, command.name);
+    AppendField(fingerprint, command.plnPath);
+    AppendField(fingerprint, command.ifcPath);
+    AppendField(fingerprint, command.outputPath);
+    AppendField(fingerprint, body.GetString({ "inputTransfer", "input_transfer" }));
+    AppendField(fingerprint, body.GetString({ "translator" }));
+    AppendField(fingerprint, FingerprintFilter(body));
+    AppendField(fingerprint, std::to_string(command.priority));
+    AppendField(fingerprint, command.tenant);
+
+    // Output options
+    AppendField(fingerprint, body.GetBool("checksum") ? "1" : "0");
+    AppendField(fingerprint, body.GetString({ "compress" }));
+    AppendField(fingerprint, (body.GetBool("streamOutput") || body.GetBool("stream_output")) ? "1" : "0");
+    AppendField(fingerprint, (body.GetBool("liveOutput") || body.GetBool("live_output")) ? "1" : "0");
+
+    for (const char* list : { "exports", "items" }) {
+        const JsonValue* entries = body.Find(list);
+        if (entries == nullptr || !entries->IsArray()) {
+            continue;
+        }
+
+        AppendField(fingerprint, list);
+        for (size_t i = 0; i < entries->Size(); ++i) {
+            const JsonValue& entry = entries->At(i);
+            // The input path also decides the item's direction
+            AppendField(fingerprint, entry.GetString({ "plnPath", "pln_path" }));
+            AppendField(fingerprint, entry.GetString({ "ifcPath", "ifc_path" }));
+            AppendField(fingerprint, entry.GetString({ "outputPath", "output_path" }));
+            AppendField(fingerprint, entry.GetString({ "translator" }));
+            AppendField(fingerprint, FingerprintFilter(entry));
+        }
+    }
+    return fingerprint;
+}
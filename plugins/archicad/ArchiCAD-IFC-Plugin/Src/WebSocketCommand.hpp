@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEBSOCKET_COMMAND_HPP
+#define WEBSOCKET_COMMAND_HPP
+
+#include "JsonParser.hpp"
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Commands understood on the WebSocket protocol
+ */
+enum class CommandType {
+    Unknown,
+    StartConversion,
+    StartBatch,
+    CancelJob,
+    GetStatus,
+    LoadIfc,
+    GetWorkerInfo,
+    RegisterWorker,
+    GetPoolStatus,
+    GetMetrics,
+    Subscribe,
+    Unsubscribe,
+    UploadBegin,
+    Download,
+    DownloadAck,
+    CancelTransfer,
+    Hello,
+    Benchmark,
+    Resume
+};
+
+/**
+ * @brief Maps a wire command name (e.g. "start_conversion") to its type
+ */
+CommandType CommandTypeFromName(const std::string& name);
+
+/**
+ * @brief A protocol message, parsed once when it arrives
+ *
+ * The common fields are resolved here (including their snake_case
+ * aliases); anything command-specific can be read from body.
+ */
+struct WebSocketCommand {
+    CommandType type = CommandType::Unknown;
+    std::string name;           // "command" as sent
+    std::string jobId;          // "jobId" / "job_id"
+    std::string plnPath;        // "plnPath" / "pln_path"
+    std::string ifcPath;        // "ifcPath" / "ifc_path"
+    std::string outputPath;     // "outputPath" / "output_path"
+    int priority = 0;
+    std::string tenant;         // "tenant", fair-share group
+    JsonValue body;             // The whole message
+    std::string payload;        // Raw text, for forwarding
+    uint64_t sessionId = 0;     // Session it arrived on, for direct replies
+};
+
+/**
+ * @brief Parse a protocol message
+ * @param payload JSON text
+ * @param command Receives the parsed command
+ * @param error Receives a description on failure
+ * @return false if the message is not a JSON object with a "command" string
+ */
+bool ParseWebSocketCommand(const std::string& payload, WebSocketCommand& command, std::string& error);
+
+/**
+ * @brief What a start command asks for, to tell a resubmission from other work under the same jobId
+ *
+ * Covers every field that shapes the job: the command, its input and
+ * output paths, the uploaded input, translator, filter, priority, tenant
+ * and output options, plus each "exports"/"items" entry's paths,
+ * translator and filter.
+ */
+std::string SubmissionFingerprint(const WebSocketCommand& command);
+
+#endif // WEBSOCKET_COMMAND_HPP
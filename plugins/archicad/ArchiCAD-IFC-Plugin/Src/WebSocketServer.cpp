@@ -19,38 +19,226 @@
 
 #ifdef WEBSOCKET_ENABLED
 
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "CborEncoder.hpp"
+#include "Logger.hpp"
+#include <boost/version.hpp>
+#include <cstdio>
+
+// Seconds a client has to send its upgrade request
+static const int kUpgradeTimeoutSeconds = 30;
+
+// Helper to raise an atomic maximum
+static void RaisePeak(std::atomic<uint64_t>& peak, uint64_t value)
+{
+    uint64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// ========================================
+// SessionQueueStats Implementation
+// ========================================
+
+std::string SessionQueueStats::ToJson() const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("sessions", sessions)
+          .Field("queuedBytes", queuedBytes)
+          .Field("queuedFrames", queuedFrames)
+          .Field("peakSessionBytes", peakBytes)
+          .Field("peakSessionFrames", peakFrames)
+          .Field("highWatermarkBytes", highWatermarkBytes)
+          .Field("lowWatermarkBytes", lowWatermarkBytes)
+          .Field("coalesced", coalesced)
+          .Field("saturations", saturations)
+          .Field("saturationDisconnects", disconnects)
+          .EndObject();
+    return writer.ToString();
+}
+
+std::string SessionQueueStats::ToPrometheus() const
+{
+    const struct {
+        const char* name;
+        const char* type;
+        const char* help;
+        uint64_t value;
+    } kMetrics[] = {
+        { "ifc_plugin_ws_sessions", "gauge", "Connected WebSocket sessions.", sessions },
+        { "ifc_plugin_ws_queued_bytes", "gauge", "Bytes waiting in session write queues.", queuedBytes },
+        { "ifc_plugin_ws_queued_frames", "gauge", "Frames waiting in session write queues.", queuedFrames },
+        { "ifc_plugin_ws_peak_session_queued_bytes", "gauge", "Largest write queue of a single session, in bytes.", peakBytes },
+        { "ifc_plugin_ws_coalesced_total", "counter", "Updates that replaced an undelivered one.", coalesced },
+        { "ifc_plugin_ws_saturations_total", "counter", "Times a session crossed the high watermark.", saturations },
+        { "ifc_plugin_ws_saturation_disconnects_total", "counter", "Sessions dropped for staying saturated or a full queue.", disconnects },
+    };
+
+    std::string text;
+    for (const auto& metric : kMetrics) {
+        text += std::string("# HELP ") + metric.name + " " + metric.help + "\n";
+        text += std::string("# TYPE ") + metric.name + " " + metric.type + "\n";
+        text += std::string(metric.name) + " " + std::to_string(metric.value) + "\n";
+    }
+    return text;
+}
+
+// ========================================
+// OutgoingMessage Implementation
+// ========================================
+
+OutgoingMessage::OutgoingMessage(JsonPayload json)
+    : m_json(std::move(json))
+    , m_cborFailed(false)
+{
+}
+
+const JsonPayload& OutgoingMessage::Get(MessageEncoding encoding, bool& binary)
+{
+    binary = false;
+    if (encoding != MessageEncoding::Cbor || m_cborFailed || !m_json) {
+        return m_json;
+    }
+
+    if (!m_cbor) {
+        std::string cbor;
+        std::string error;
+        if (!JsonToCbor(*m_json, cbor, error)) {
+            // Relayed text that is not JSON still reaches the client, as text
+            LOG_WARN("Sending message as text, not valid JSON: " << error);
+            m_cborFailed = true;
+            return m_json;
+        }
+        m_cbor = std::make_shared<const std::string>(std::move(cbor));
+    }
+
+    binary = true;
+    return m_cbor;
+}
+
+// First of our subprotocols in a Sec-WebSocket-Protocol list, "" if none
+static std::string ChooseSubprotocol(beast::string_view offered)
+{
+    std::string json;
+    size_t start = 0;
+    while (start <= offered.size()) {
+        size_t end = offered.find(',', start);
+        if (end == beast::string_view::npos) {
+            end = offered.size();
+        }
+
+        beast::string_view token = offered.substr(start, end - start);
+        while (!token.empty() && (token.front() == ' ' || token.front() == '\t')) {
+            token.remove_prefix(1);
+        }
+        while (!token.empty() && (token.back() == ' ' || token.back() == '\t')) {
+            token.remove_suffix(1);
+        }
+
+        if (token == kCborSubprotocol) {
+            return kCborSubprotocol;
+        }
+        if (token == kJsonSubprotocol) {
+            json = kJsonSubprotocol;
+        }
+        start = end + 1;
+    }
+    return json;
+}
 
 // ========================================
 // WebSocketSession Implementation
 // ========================================
 
-WebSocketSession::WebSocketSession(tcp::socket socket)
+WebSocketSession::WebSocketSession(tcp::socket socket, uint64_t id, const WebSocketCompression& compression,
+                                   const SessionQueueLimits& limits, std::shared_ptr<SessionQueueCounters> counters)
     : m_ws(std::move(socket))
+    , m_compression(compression)
+    , m_queuedBytes(0)
+    , m_limits(limits)
+    , m_counters(std::move(counters))
+    , m_saturated(false)
     , m_open(false)
+    , m_closedReported(false)
+    , m_encoding(MessageEncoding::Json)
+    , m_id(id)
 {
 }
 
 WebSocketSession::~WebSocketSession()
 {
-    Close();
+    // Frames never written no longer count as queued
+    AddQueued(-static_cast<int64_t>(m_queuedBytes), -static_cast<int64_t>(m_writeQueue.size()));
 }
 
 void WebSocketSession::Run()
 {
+    // The stream may only be used on the session's strand
+    net::dispatch(m_ws.get_executor(), [self = shared_from_this()]() {
+        self->DoReadUpgrade();
+    });
+}
+
+void WebSocketSession::DoReadUpgrade()
+{
+    // Read the HTTP upgrade request ourselves, to see the subprotocols offered
+    beast::get_lowest_layer(m_ws).expires_after(std::chrono::seconds(kUpgradeTimeoutSeconds));
+
+    beast::http::async_read(
+        beast::get_lowest_layer(m_ws),
+        m_buffer,
+        m_upgrade,
+        beast::bind_front_handler(
+            &WebSocketSession::OnReadUpgrade,
+            shared_from_this()));
+}
+
+void WebSocketSession::OnReadUpgrade(beast::error_code ec, std::size_t bytes_transferred)
+{
+    boost::ignore_unused(bytes_transferred);
+
+    if (ec) {
+        LOG_ERROR("WebSocket upgrade read error: " << ec.message());
+        ReportClosed();
+        return;
+    }
+
+    // The websocket stream keeps its own timers from here on
+    beast::get_lowest_layer(m_ws).expires_never();
+
+    std::string subprotocol = ChooseSubprotocol(m_upgrade[beast::http::field::sec_websocket_protocol]);
+    if (subprotocol == kCborSubprotocol) {
+        m_encoding = MessageEncoding::Cbor;
+    }
+
     // Set suggested timeout settings for the websocket
     m_ws.set_option(
         websocket::stream_base::timeout::suggested(
             beast::role_type::server));
 
-    // Set a decorator to change the Server of the handshake
+    // Offer permessage-deflate; the client decides whether to use it
+    if (m_compression.enabled) {
+        websocket::permessage_deflate deflate;
+        deflate.server_enable = true;
+        deflate.compLevel = m_compression.level;
+        deflate.memLevel = m_compression.memLevel;
+        deflate.server_max_window_bits = m_compression.windowBits;
+#if BOOST_VERSION >= 108100
+        deflate.msg_size_threshold = m_compression.minMessageBytes;
+#endif
+        m_ws.set_option(deflate);
+    }
+
+    // Set a decorator to change the Server of the handshake and confirm
+    // the subprotocol we picked
     m_ws.set_option(websocket::stream_base::decorator(
-        [](websocket::response_type& res)
+        [subprotocol](websocket::response_type& res)
         {
             res.set(beast::http::field::server,
                 std::string("Archicad-Plugin-Beast"));
+            if (!subprotocol.empty()) {
+                res.set(beast::http::field::sec_websocket_protocol, subprotocol);
+            }
         }));
 
     // Accept the websocket handshake
@@ -59,7 +247,9 @@ void WebSocketSession::Run()
 
 void WebSocketSession::DoAccept()
 {
+    // Answers 400 by itself if the request was not a WebSocket upgrade
     m_ws.async_accept(
+        m_upgrade,
         beast::bind_front_handler(
             &WebSocketSession::OnAccept,
             shared_from_this()));
@@ -68,12 +258,17 @@ void WebSocketSession::DoAccept()
 void WebSocketSession::OnAccept(beast::error_code ec)
 {
     if (ec) {
-        std::cerr << "WebSocket accept error: " << ec.message() << std::endl;
+        LOG_ERROR("WebSocket accept error: " << ec.message());
+        ReportClosed();
         return;
     }
 
     m_open = true;
-    std::cout << "✓ WebSocket session accepted" << std::endl;
+    LOG_INFO("✓ WebSocket session accepted" << (m_encoding == MessageEncoding::Cbor ? " (CBOR events)" : ""));
+
+    if (m_openedCallback) {
+        m_openedCallback();
+    }
 
     // Read a message
     DoRead();
@@ -94,14 +289,16 @@ void WebSocketSession::OnRead(beast::error_code ec, std::size_t bytes_transferre
 
     // This indicates that the session was closed
     if (ec == websocket::error::closed) {
-        std::cout << "WebSocket connection closed by client" << std::endl;
+        LOG_INFO("WebSocket connection closed by client");
         m_open = false;
+        ReportClosed();
         return;
     }
 
     if (ec) {
-        std::cerr << "WebSocket read error: " << ec.message() << std::endl;
+        LOG_ERROR("WebSocket read error: " << ec.message());
         m_open = false;
+        ReportClosed();
         return;
     }
 
@@ -109,16 +306,17 @@ void WebSocketSession::OnRead(beast::error_code ec, std::size_t bytes_transferre
     std::string message = beast::buffers_to_string(m_buffer.data());
     m_buffer.consume(m_buffer.size());
 
-    std::cout << "=== WebSocket Message Received ===" << std::endl;
-    std::cout << "Raw message: " << message << std::endl;
-    std::cout << "Message length: " << message.length() << std::endl;
+    // The payload is logged once, here (truncated; file chunks only by size)
+    if (m_ws.got_binary()) {
+        LOG_TRACE("WebSocket binary frame received (" << message.length() << " bytes)");
+    } else {
+        LOG_DEBUG("WebSocket message received (" << message.length() << " bytes): " << Logger::Truncate(message));
+    }
 
     if (m_messageCallback) {
-        std::cout << "Calling message callback..." << std::endl;
-        m_messageCallback(message);
-        std::cout << "Message callback completed" << std::endl;
+        m_messageCallback(std::move(message), m_ws.got_binary());
     } else {
-        std::cout << "WARNING: No message callback registered!" << std::endl;
+        LOG_WARN("No message callback registered!");
     }
 
     // Read another message
@@ -126,31 +324,174 @@ void WebSocketSession::OnRead(beast::error_code ec, std::size_t bytes_transferre
 }
 
 void WebSocketSession::Send(const std::string& message)
+{
+    Send(std::make_shared<const std::string>(message));
+}
+
+void WebSocketSession::Send(JsonPayload payload)
+{
+    if (!payload) {
+        return;
+    }
+
+    OutgoingMessage message(std::move(payload));
+    Send(message);
+}
+
+void WebSocketSession::Send(OutgoingMessage& message)
+{
+    if (!m_open) {
+        return;
+    }
+
+    Frame frame;
+    frame.data = message.Get(m_encoding, frame.binary);
+    frame.coalesceKey = message.GetCoalesceKey();
+    QueueFrame(std::move(frame));
+}
+
+void WebSocketSession::SendBinary(JsonPayload data)
 {
     if (!m_open) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(m_writeMutex);
+    Frame frame;
+    frame.data = std::move(data);
+    frame.binary = true;
+    QueueFrame(std::move(frame));
+}
 
-    // Always add to queue and post
-    bool writing = !m_writeQueue.empty();
-    m_writeQueue.push_back(message);
+void WebSocketSession::QueueFrame(Frame frame)
+{
+    if (!frame.data) {
+        return;
+    }
 
-    // If not already writing, start
-    if (!writing) {
-        DoWrite();
+    // Senders run on any thread; the write queue is only touched on the
+    // session's strand
+    net::post(m_ws.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        if (!self->m_open) {
+            return;
+        }
+
+        // A newer update replaces the undelivered one in place, keeping its
+        // place in the queue
+        if (!frame.coalesceKey.empty()) {
+            auto pending = self->m_pendingUpdates.find(frame.coalesceKey);
+            if (pending != self->m_pendingUpdates.end()) {
+                Frame& queued = *pending->second;
+                self->AddQueued(static_cast<int64_t>(frame.data->size()) - static_cast<int64_t>(queued.data->size()), 0);
+                queued.data = std::move(frame.data);
+                queued.binary = frame.binary;
+                self->m_counters->coalesced.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        bool writing = !self->m_writeQueue.empty();
+        int64_t size = static_cast<int64_t>(frame.data->size());
+
+        // Producers cannot be held back (one is Archicad's main thread), so
+        // a client that lets the queue reach its hard limit is dropped now
+        // rather than after the saturation timeout. A frame larger than the
+        // limit still goes out on an idle session.
+        if (writing && (self->m_queuedBytes + frame.data->size() > self->m_limits.hardLimitBytes ||
+                        self->m_writeQueue.size() >= self->m_limits.hardLimitFrames)) {
+            self->Disconnect("write queue full");
+            return;
+        }
+
+        self->m_writeQueue.push_back(std::move(frame));
+        self->AddQueued(size, 1);
+
+        // If not already writing, start
+        if (!writing) {
+            self->DoWrite();
+            return;
+        }
+
+        // Deque elements stay put while others are added or removed at the ends
+        Frame& queued = self->m_writeQueue.back();
+        if (!queued.coalesceKey.empty()) {
+            self->m_pendingUpdates[queued.coalesceKey] = &queued;
+        }
+        self->CheckSaturation();
+    });
+}
+
+// Account for frames added to (positive) or removed from the queue
+void WebSocketSession::AddQueued(int64_t bytes, int64_t frames)
+{
+    m_queuedBytes = static_cast<size_t>(static_cast<int64_t>(m_queuedBytes) + bytes);
+
+    // Unsigned wrap-around makes negative deltas subtract
+    m_counters->queuedBytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed);
+    m_counters->queuedFrames.fetch_add(static_cast<uint64_t>(frames), std::memory_order_relaxed);
+    if (bytes > 0 || frames > 0) {
+        RaisePeak(m_counters->peakBytes, m_queuedBytes);
+        RaisePeak(m_counters->peakFrames, m_writeQueue.size());
     }
 }
 
-void WebSocketSession::DoWrite()
+void WebSocketSession::CheckSaturation()
+{
+    bool over = m_queuedBytes > m_limits.highWatermarkBytes || m_writeQueue.size() > m_limits.maxFrames;
+
+    if (!m_saturated) {
+        if (over) {
+            m_saturated = true;
+            m_saturatedSince = std::chrono::steady_clock::now();
+            m_counters->saturations.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("Session " << m_id << " is not keeping up (" << m_writeQueue.size() << " frames, "
+                     << m_queuedBytes << " bytes queued)");
+        }
+        return;
+    }
+
+    if (m_queuedBytes <= m_limits.lowWatermarkBytes && m_writeQueue.size() <= m_limits.maxFrames / 2) {
+        m_saturated = false;
+        LOG_INFO("Session " << m_id << " caught up");
+        return;
+    }
+
+    auto saturatedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_saturatedSince).count();
+    if (saturatedMs > m_limits.saturatedTimeoutMs) {
+        Disconnect("write queue saturated");
+    }
+}
+
+void WebSocketSession::Disconnect(const char* reason)
 {
-    if (m_writeQueue.empty()) {
+    if (!m_open.exchange(false)) {
         return;
     }
 
+    LOG_WARN("Disconnecting session " << m_id << ": " << reason << " (" << m_writeQueue.size() << " frames, "
+             << m_queuedBytes << " bytes queued)");
+    m_counters->disconnects.fetch_add(1, std::memory_order_relaxed);
+
+    // No close handshake: the client is not reading. The pending read and
+    // write fail and report the session closed.
+    beast::get_lowest_layer(m_ws).close();
+}
+
+void WebSocketSession::DoWrite()
+{
+    Frame& frame = m_writeQueue.front();
+
+    // Being written: later updates must queue behind it, not replace it
+    if (!frame.coalesceKey.empty()) {
+        auto pending = m_pendingUpdates.find(frame.coalesceKey);
+        if (pending != m_pendingUpdates.end() && pending->second == &frame) {
+            m_pendingUpdates.erase(pending);
+        }
+    }
+
+    m_ws.binary(frame.binary);
     m_ws.async_write(
-        net::buffer(m_writeQueue.front()),
+        net::buffer(*frame.data),
         beast::bind_front_handler(
             &WebSocketSession::OnWrite,
             shared_from_this()));
@@ -161,33 +502,46 @@ void WebSocketSession::OnWrite(beast::error_code ec, std::size_t bytes_transferr
     boost::ignore_unused(bytes_transferred);
 
     if (ec) {
-        std::cerr << "WebSocket write error: " << ec.message() << std::endl;
+        LOG_ERROR("WebSocket write error: " << ec.message());
         m_open = false;
+        ReportClosed();
         return;
     }
 
-    std::lock_guard<std::mutex> lock(m_writeMutex);
-    m_writeQueue.erase(m_writeQueue.begin());
+    AddQueued(-static_cast<int64_t>(m_writeQueue.front().data->size()), -1);
+    m_writeQueue.pop_front();
+
+    if (m_saturated) {
+        CheckSaturation();
+    }
 
-    if (!m_writeQueue.empty()) {
+    if (!m_writeQueue.empty() && m_open) {
         DoWrite();
     }
 }
 
 void WebSocketSession::Close()
 {
-    if (!m_open) {
-        return;
-    }
-
-    m_open = false;
+    net::post(m_ws.get_executor(), [self = shared_from_this()]() {
+        if (!self->m_open.exchange(false)) {
+            // Still in the handshake (or already lost): drop the connection
+            beast::get_lowest_layer(self->m_ws).close();
+            return;
+        }
 
-    beast::error_code ec;
-    m_ws.close(websocket::close_code::normal, ec);
+        // Don't wait long for the client's close frame; the pending read
+        // completes (and reports the session closed) either way
+        websocket::stream_base::timeout timeout;
+        self->m_ws.get_option(timeout);
+        timeout.handshake_timeout = std::chrono::seconds(1);
+        self->m_ws.set_option(timeout);
 
-    if (ec) {
-        std::cerr << "WebSocket close error: " << ec.message() << std::endl;
-    }
+        self->m_ws.async_close(websocket::close_code::normal, [self](beast::error_code ec) {
+            if (ec) {
+                LOG_DEBUG("WebSocket close error: " << ec.message());
+            }
+        });
+    });
 }
 
 bool WebSocketSession::IsOpen() const
@@ -200,15 +554,45 @@ void WebSocketSession::SetMessageCallback(MessageCallback callback)
     m_messageCallback = callback;
 }
 
+void WebSocketSession::SetOpenedCallback(OpenedCallback callback)
+{
+    m_openedCallback = std::move(callback);
+}
+
+void WebSocketSession::SetClosedCallback(ClosedCallback callback)
+{
+    m_closedCallback = callback;
+}
+
+void WebSocketSession::ReportClosed()
+{
+    // Read and write errors can both fire for the same connection
+    if (m_closedReported.exchange(true)) {
+        return;
+    }
+
+    if (m_closedCallback) {
+        m_closedCallback();
+    }
+}
+
 // ========================================
 // ArchicadWebSocketServer Implementation
 // ========================================
 
 ArchicadWebSocketServer::ArchicadWebSocketServer()
-    : m_acceptor(m_ioc)
+    : m_acceptor(net::make_strand(m_ioc))
+    , m_threadCount(2)
+    , m_queueCounters(std::make_shared<SessionQueueCounters>())
+    , m_nextSessionId(1)
+    , m_progressRateHz(10)
     , m_running(false)
     , m_port(8081)
 {
+    m_transfers.SetSenders(
+        [this](uint64_t sessionId, JsonPayload payload) { SendToSession(sessionId, std::move(payload)); },
+        [this](uint64_t sessionId, JsonPayload frame) { SendBinaryToSession(sessionId, std::move(frame)); });
+    m_progress.SetPublisher([this](const ProgressUpdate& update) { PublishProgress(update); });
 }
 
 ArchicadWebSocketServer::~ArchicadWebSocketServer()
@@ -216,61 +600,92 @@ ArchicadWebSocketServer::~ArchicadWebSocketServer()
     Stop();
 }
 
-bool ArchicadWebSocketServer::Start(int port)
+bool ArchicadWebSocketServer::Start(int port, const std::string& bindAddress)
 {
     if (m_running) {
-        std::cerr << "WebSocket server already running" << std::endl;
+        LOG_ERROR("WebSocket server already running");
         return false;
     }
 
     m_port = port;
 
     try {
+        beast::error_code ec;
+
         tcp::endpoint endpoint{tcp::v4(), static_cast<unsigned short>(port)};
+        if (!bindAddress.empty()) {
+            net::ip::address address = net::ip::make_address(bindAddress, ec);
+            if (ec) {
+                LOG_ERROR("✗ Invalid bind address '" << bindAddress << "': " << ec.message());
+                return false;
+            }
+            endpoint = tcp::endpoint{address, static_cast<unsigned short>(port)};
+        }
 
-        beast::error_code ec;
+        // Close the acceptor again on failure so Start() can retry another port
+        auto fail = [this](const char* what, const beast::error_code& error) {
+            LOG_ERROR("✗ Failed to " << what << ": " << error.message());
+            beast::error_code ignored;
+            m_acceptor.close(ignored);
+            return false;
+        };
 
         // Open the acceptor
         m_acceptor.open(endpoint.protocol(), ec);
         if (ec) {
-            std::cerr << "✗ Failed to open acceptor: " << ec.message() << std::endl;
-            return false;
+            return fail("open acceptor", ec);
         }
 
-        // Allow address reuse
+#ifndef _WIN32
+        // Allow address reuse. Not on Windows: there SO_REUSEADDR lets a second
+        // Archicad instance bind the same port instead of moving to the next one.
         m_acceptor.set_option(net::socket_base::reuse_address(true), ec);
         if (ec) {
-            std::cerr << "✗ Failed to set reuse_address: " << ec.message() << std::endl;
-            return false;
+            return fail("set reuse_address", ec);
         }
+#endif
 
         // Bind to the server address
         m_acceptor.bind(endpoint, ec);
         if (ec) {
-            std::cerr << "✗ Failed to bind: " << ec.message() << std::endl;
-            return false;
+            return fail("bind", ec);
         }
 
         // Start listening for connections
         m_acceptor.listen(net::socket_base::max_listen_connections, ec);
         if (ec) {
-            std::cerr << "✗ Failed to listen: " << ec.message() << std::endl;
-            return false;
+            return fail("listen", ec);
         }
 
         m_running = true;
 
+        // Commands run on their own thread, one at a time in arrival order,
+        // so a slow handler never holds up reads, writes or new connections
+        m_commandIoc.restart();
+        m_commandWork = std::make_unique<net::executor_work_guard<net::io_context::executor_type>>(
+            m_commandIoc.get_executor());
+        m_commandThread = std::thread([this]() { m_commandIoc.run(); });
+
+        // Progress events leave at most m_progressRateHz times per second and job
+        m_progress.Start(m_progressRateHz);
+
         // Start accepting connections
         DoAccept();
 
-        // Run the I/O service on a background thread
-        m_serverThread = std::thread([this]() { RunServer(); });
+        // Run the I/O service on a pool of background threads (restart()
+        // allows a server that was stopped to be started again). Each
+        // session runs on its own strand.
+        m_ioc.restart();
+        for (size_t i = 0; i < m_threadCount; ++i) {
+            m_ioThreads.emplace_back([this]() { RunServer(); });
+        }
 
-        std::cout << "✓ WebSocket server started on port " << m_port << std::endl;
+        LOG_INFO("✓ WebSocket server started on " << endpoint.address().to_string() << ":" << m_port
+                 << " (" << m_threadCount << " I/O threads)");
         return true;
 
     } catch (const std::exception& e) {
-        std::cerr << "✗ Failed to start WebSocket server: " << e.what() << std::endl;
+        LOG_ERROR("✗ Failed to start WebSocket server: " << e.what());
         return false;
     }
 }
@@ -281,36 +696,53 @@ void ArchicadWebSocketServer::Stop()
         return;
     }
 
-    std::cout << "Stopping WebSocket server..." << std::endl;
+    LOG_INFO("Stopping WebSocket server...");
 
     m_running = false;
 
+    // Send the progress still pending while the sessions are open
+    m_progress.Stop();
+
     try {
-        // Close all sessions
+        // Stop the acceptor (on its strand, where the accept loop runs)
+        net::post(m_acceptor.get_executor(), [this]() {
+            beast::error_code ec;
+            m_acceptor.close(ec);
+        });
+
+        // Close all sessions; each one reports back through RemoveSession
+        // once its connection is gone
         {
-            std::lock_guard<std::mutex> lock(m_sessionMutex);
-            for (auto& session : m_sessions) {
-                session->Close();
+            std::unique_lock<std::mutex> lock(m_sessionMutex);
+            m_subscriptions.clear();
+            for (auto& entry : m_sessions) {
+                entry.second->Close();
             }
+            m_sessionsClosed.wait_for(lock, std::chrono::seconds(2), [this]() { return m_sessions.empty(); });
             m_sessions.clear();
         }
 
-        // Stop the acceptor
-        beast::error_code ec;
-        m_acceptor.close(ec);
-
         // Stop the io_context
         m_ioc.stop();
 
-        // Wait for the thread
-        if (m_serverThread.joinable()) {
-            m_serverThread.join();
+        // Wait for the I/O threads
+        for (std::thread& thread : m_ioThreads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
         }
+        m_ioThreads.clear();
 
-        std::cout << "✓ WebSocket server stopped" << std::endl;
+        // Let the command thread finish the commands it already has
+        m_commandWork.reset();
+        if (m_commandThread.joinable()) {
+            m_commandThread.join();
+        }
+
+        LOG_INFO("✓ WebSocket server stopped");
 
     } catch (const std::exception& e) {
-        std::cerr << "Error stopping WebSocket server: " << e.what() << std::endl;
+        LOG_ERROR("Error stopping WebSocket server: " << e.what());
     }
 }
 
@@ -319,7 +751,7 @@ void ArchicadWebSocketServer::RunServer()
     try {
         m_ioc.run();
     } catch (const std::exception& e) {
-        std::cerr << "Server error: " << e.what() << std::endl;
+        LOG_ERROR("Server error: " << e.what());
     }
 
     m_running = false;
@@ -336,27 +768,46 @@ void ArchicadWebSocketServer::DoAccept()
 
 void ArchicadWebSocketServer::OnAccept(beast::error_code ec, tcp::socket socket)
 {
-    if (ec) {
-        std::cerr << "Accept error: " << ec.message() << std::endl;
+    if (ec == net::error::operation_aborted) {
+        LOG_DEBUG("Accept cancelled");
+    } else if (ec) {
+        LOG_ERROR("Accept error: " << ec.message());
     } else {
-        // Create session
-        auto session = std::make_shared<WebSocketSession>(std::move(socket));
+        uint64_t sessionId;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            sessionId = m_nextSessionId++;
+        }
 
-        // Set callback
-        session->SetMessageCallback([this](const std::string& msg) {
-            HandleMessage(msg);
+        // Create session
+        auto session = std::make_shared<WebSocketSession>(std::move(socket), sessionId, m_compression,
+                                                          m_queueLimits, m_queueCounters);
+
+        // Set callbacks; messages are handled on the command thread
+        session->SetMessageCallback([this, sessionId](std::string msg, bool binary) {
+            net::post(m_commandIoc, [this, sessionId, msg = std::move(msg), binary]() {
+                HandleMessage(sessionId, msg, binary);
+            });
+        });
+        session->SetClosedCallback([this, sessionId]() {
+            RemoveSession(sessionId);
         });
+        if (m_helloProvider) {
+            session->SetOpenedCallback([this, sessionId]() {
+                SendToSession(sessionId, m_helloProvider());
+            });
+        }
 
         // Store session
         {
             std::lock_guard<std::mutex> lock(m_sessionMutex);
-            m_sessions.push_back(session);
+            m_sessions[sessionId] = session;
         }
 
         // Run the session
         session->Run();
 
-        std::cout << "✓ Client connected (total: " << GetConnectionCount() << ")" << std::endl;
+        LOG_INFO("✓ Client connected (total: " << GetConnectionCount() << ")");
     }
 
     // Accept another connection
@@ -365,70 +816,93 @@ void ArchicadWebSocketServer::OnAccept(beast::error_code ec, tcp::socket socket)
     }
 }
 
-void ArchicadWebSocketServer::HandleMessage(const std::string& message)
+void ArchicadWebSocketServer::HandleMessage(uint64_t sessionId, const std::string& message, bool binary)
 {
-    std::cout << "=== HandleMessage Called ===" << std::endl;
-    std::cout << "Message: " << message << std::endl;
-    
     try {
-        HandleCommand(message);
-        std::cout << "HandleCommand completed successfully" << std::endl;
+        // Binary frames are file chunks, everything else is a JSON command
+        if (binary) {
+            m_transfers.HandleChunk(sessionId, message);
+            return;
+        }
+        HandleCommand(sessionId, message);
     } catch (const std::exception& e) {
-        std::cerr << "Error handling message: " << e.what() << std::endl;
+        LOG_ERROR("Error handling message: " << e.what());
     }
 }
 
-void ArchicadWebSocketServer::HandleCommand(const std::string& jsonPayload)
+void ArchicadWebSocketServer::HandleCommand(uint64_t sessionId, const std::string& jsonPayload)
 {
-    std::cout << "=== HandleCommand Called ===" << std::endl;
-    std::cout << "JSON Payload: " << jsonPayload << std::endl;
-    
-    // Simple JSON parsing (basic implementation)
-    std::string command;
-    std::string jobId;
-
-    // Extract "command" field
-    size_t cmdPos = jsonPayload.find("\"command\"");
-    if (cmdPos != std::string::npos) {
-        size_t colonPos = jsonPayload.find(":", cmdPos);
-        size_t quoteStart = jsonPayload.find("\"", colonPos);
-        size_t quoteEnd = jsonPayload.find("\"", quoteStart + 1);
+    // Parse once; the callback dispatches on the typed command
+    WebSocketCommand command;
+    std::string error;
+    if (!ParseWebSocketCommand(jsonPayload, command, error)) {
+        LOG_WARN("Invalid command message: " << error);
+        return;
+    }
 
-        if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-            command = jsonPayload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-            std::cout << "Extracted command: '" << command << "'" << std::endl;
+    LOG_DEBUG("Parsed command: '" << command.name << "', jobId: '" << command.jobId << "' (session " << sessionId << ")");
+
+    command.sessionId = sessionId;
+
+    switch (command.type) {
+        case CommandType::Subscribe:
+        case CommandType::Unsubscribe: {
+            // Handled here; the callback never sees subscription commands
+            bool subscribe = command.type == CommandType::Subscribe;
+            JsonWriter writer;
+            writer.BeginObject();
+            if (command.jobId.empty()) {
+                writer.Field("type", "error")
+                      .Field("jobId", "")
+                      .Field("error", "Missing jobId")
+                      .Field("status", "error");
+            } else {
+                if (subscribe) {
+                    Subscribe(command.jobId, sessionId);
+                } else {
+                    Unsubscribe(command.jobId, sessionId);
+                }
+                writer.Field("type", subscribe ? "subscribed" : "unsubscribed")
+                      .Field("jobId", command.jobId);
+            }
+            writer.EndObject();
+            SendToSession(sessionId, writer.ToPayload());
+            return;
         }
-    } else {
-        std::cout << "WARNING: 'command' field not found in JSON" << std::endl;
-    }
 
-    // Extract "jobId" field
-    size_t jobPos = jsonPayload.find("\"jobId\"");
-    if (jobPos != std::string::npos) {
-        size_t colonPos = jsonPayload.find(":", jobPos);
-        size_t quoteStart = jsonPayload.find("\"", colonPos);
-        size_t quoteEnd = jsonPayload.find("\"", quoteStart + 1);
+        case CommandType::Resume:
+            // Answered from the job registry, so it works while the main thread is busy
+            ResumeJobs(command);
+            return;
+
+        case CommandType::UploadBegin:
+        case CommandType::Download:
+        case CommandType::DownloadAck:
+        case CommandType::CancelTransfer:
+            // File transfers are handled here as well
+            m_transfers.HandleCommand(command);
+            return;
+
+        case CommandType::StartConversion:
+        case CommandType::StartBatch:
+        case CommandType::LoadIfc:
+        case CommandType::CancelJob:
+        case CommandType::GetStatus:
+            // The sender wants this job's events (including the reply)
+            if (!command.jobId.empty()) {
+                Subscribe(command.jobId, sessionId);
+            }
+            break;
 
-        if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-            jobId = jsonPayload.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-            std::cout << "Extracted jobId: '" << jobId << "'" << std::endl;
-        }
-    } else {
-        std::cout << "WARNING: 'jobId' field not found in JSON" << std::endl;
+        default:
+            break;
     }
 
     // Call callback if set
-    if (m_commandCallback && !command.empty()) {
-        std::cout << "Calling command callback with command='" << command << "', jobId='" << jobId << "'" << std::endl;
-        m_commandCallback(command, jobId, jsonPayload);
-        std::cout << "Command callback completed" << std::endl;
+    if (m_commandCallback) {
+        m_commandCallback(command);
     } else {
-        if (!m_commandCallback) {
-            std::cout << "ERROR: Command callback not set!" << std::endl;
-        }
-        if (command.empty()) {
-            std::cout << "ERROR: Command is empty!" << std::endl;
-        }
+        LOG_ERROR("Command callback not set!");
     }
 }
 
@@ -438,66 +912,480 @@ bool ArchicadWebSocketServer::IsRunning() const
 }
 
 void ArchicadWebSocketServer::BroadcastMessage(const std::string& message)
+{
+    BroadcastMessage(std::make_shared<const std::string>(message));
+}
+
+void ArchicadWebSocketServer::BroadcastMessage(JsonPayload payload)
+{
+    OutgoingMessage message(std::move(payload));
+
+    // Queue outside the lock, so sending never holds up other senders
+    std::vector<std::shared_ptr<WebSocketSession>> recipients;
+    {
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+
+        // Lost sessions are removed by RemoveSession, no sweep needed here
+        recipients.reserve(m_sessions.size());
+        for (auto& entry : m_sessions) {
+            if (entry.second->IsOpen()) {
+                recipients.push_back(entry.second);
+            }
+        }
+    }
+
+    for (const auto& session : recipients) {
+        session->Send(message);
+    }
+}
+
+void ArchicadWebSocketServer::SendToJob(const std::string& jobId, JsonPayload payload, bool final,
+                                        const std::string& coalesceKey)
+{
+    // Kept for clients that reconnect and resume the job
+    m_jobRegistry.RecordEvent(jobId, payload, final);
+
+    OutgoingMessage message(std::move(payload));
+    message.SetCoalesceKey(coalesceKey);
+
+    std::vector<std::shared_ptr<WebSocketSession>> recipients;
+    std::unique_lock<std::mutex> lock(m_sessionMutex);
+
+    auto job = m_subscriptions.find(jobId);
+    auto all = m_subscriptions.find("*");
+
+    auto sendTo = [this, &recipients](uint64_t sessionId) {
+        auto session = m_sessions.find(sessionId);
+        if (session != m_sessions.end() && session->second->IsOpen()) {
+            recipients.push_back(session->second);
+        }
+    };
+
+    if (job != m_subscriptions.end()) {
+        for (uint64_t sessionId : job->second) {
+            sendTo(sessionId);
+        }
+    }
+
+    // Sessions subscribed to "*" see every job, each event once
+    if (all != m_subscriptions.end() && all != job) {
+        for (uint64_t sessionId : all->second) {
+            if (job == m_subscriptions.end() || job->second.count(sessionId) == 0) {
+                sendTo(sessionId);
+            }
+        }
+    }
+
+    if (final && job != m_subscriptions.end() && job != all) {
+        m_subscriptions.erase(job);
+    }
+
+    lock.unlock();
+    for (const auto& session : recipients) {
+        session->Send(message);
+    }
+}
+
+void ArchicadWebSocketServer::SendToSession(uint64_t sessionId, const std::string& message)
+{
+    SendToSession(sessionId, std::make_shared<const std::string>(message));
+}
+
+void ArchicadWebSocketServer::SendToSession(uint64_t sessionId, JsonPayload payload)
+{
+    std::shared_ptr<WebSocketSession> session = FindSession(sessionId);
+    if (session) {
+        session->Send(std::move(payload));
+    }
+}
+
+void ArchicadWebSocketServer::SendBinaryToSession(uint64_t sessionId, JsonPayload frame)
+{
+    std::shared_ptr<WebSocketSession> session = FindSession(sessionId);
+    if (session) {
+        session->SendBinary(std::move(frame));
+    }
+}
+
+std::shared_ptr<WebSocketSession> ArchicadWebSocketServer::FindSession(uint64_t sessionId) const
+{
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+
+    auto session = m_sessions.find(sessionId);
+    if (session == m_sessions.end() || !session->second->IsOpen()) {
+        return nullptr;
+    }
+    return session->second;
+}
+
+void ArchicadWebSocketServer::Subscribe(const std::string& jobId, uint64_t sessionId)
+{
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    if (m_sessions.count(sessionId) != 0) {
+        m_subscriptions[jobId].insert(sessionId);
+    }
+}
+
+bool ArchicadWebSocketServer::ClaimSubmission(const WebSocketCommand& command)
+{
+    if (command.jobId.empty()) {
+        return true;
+    }
+
+    JobRecord existing;
+    bool rerun = command.body.GetBool("rerun");
+    switch (m_jobRegistry.ClaimJob(command.jobId, SubmissionFingerprint(command), rerun, existing)) {
+        case JobRegistry::Claim::New:
+            return true;
+
+        case JobRegistry::Claim::Attached: {
+            LOG_INFO("Job " << command.jobId << " resubmitted, attaching (" << (existing.finished ? "finished" : "running") << ")");
+            JsonWriter writer;
+            writer.BeginObject()
+                  .Field("type", "attached")
+                  .Field("jobId", command.jobId)
+                  .Field("finished", existing.finished)
+                  .EndObject();
+            SendToSession(command.sessionId, writer.ToPayload());
+            if (existing.lastEvent) {
+                SendToSession(command.sessionId, existing.lastEvent);
+            }
+            return false;
+        }
+
+        case JobRegistry::Claim::Conflict: {
+            // Only to the sender: an error sent to the job would end it for its subscribers
+            LOG_WARN("Job " << command.jobId << " is already running with other parameters");
+            JsonWriter writer;
+            writer.BeginObject()
+                  .Field("type", "error")
+                  .Field("jobId", command.jobId)
+                  .Field("error", "Job is already running with other parameters")
+                  .Field("status", "error")
+                  .EndObject();
+            SendToSession(command.sessionId, writer.ToPayload());
+            return false;
+        }
+    }
+    return false;
+}
+
+void ArchicadWebSocketServer::RejectSubmission(const std::string& jobId, const std::string& error)
+{
+    m_jobRegistry.Forget(jobId);
+    SendError(jobId, error);
+}
+
+void ArchicadWebSocketServer::ResumeJobs(const WebSocketCommand& command)
+{
+    // { "command": "resume", "jobIds": ["a", "b"] } or a single "jobId"
+    std::vector<std::string> jobIds;
+    const JsonValue* ids = command.body.Find("jobIds");
+    if (ids != nullptr && ids->IsArray()) {
+        for (size_t i = 0; i < ids->Size(); ++i) {
+            if (ids->At(i).IsString() && !ids->At(i).AsString().empty()) {
+                jobIds.push_back(ids->At(i).AsString());
+            }
+        }
+    } else if (!command.jobId.empty()) {
+        jobIds.push_back(command.jobId);
+    }
+
+    for (const std::string& jobId : jobIds) {
+        // Subscribe before the lookup, so a job finishing in between still
+        // reaches this session (at worst its terminal event arrives twice)
+        Subscribe(jobId, command.sessionId);
+
+        JobRecord record;
+        bool known = m_jobRegistry.Find(jobId, record);
+        if (!known || record.finished) {
+            Unsubscribe(jobId, command.sessionId);
+        }
+
+        if (!known) {
+            // Never accepted here (or forgotten): the client has to submit it again
+            JsonWriter writer;
+            writer.BeginObject()
+                  .Field("type", "error")
+                  .Field("jobId", jobId)
+                  .Field("error", "Unknown job")
+                  .Field("status", "unknown")
+                  .EndObject();
+            SendToSession(command.sessionId, writer.ToPayload());
+            continue;
+        }
+
+        JsonWriter writer;
+        writer.BeginObject()
+              .Field("type", "resumed")
+              .Field("jobId", jobId)
+              .Field("finished", record.finished)
+              .EndObject();
+        SendToSession(command.sessionId, writer.ToPayload());
+        if (record.lastEvent) {
+            SendToSession(command.sessionId, record.lastEvent);
+        }
+    }
+}
+
+void ArchicadWebSocketServer::Unsubscribe(const std::string& jobId, uint64_t sessionId)
 {
     std::lock_guard<std::mutex> lock(m_sessionMutex);
 
-    // Clean up closed sessions
-    m_sessions.erase(
-        std::remove_if(m_sessions.begin(), m_sessions.end(),
-            [](const std::shared_ptr<WebSocketSession>& session) {
-                return !session->IsOpen();
-            }),
-        m_sessions.end());
+    auto job = m_subscriptions.find(jobId);
+    if (job != m_subscriptions.end()) {
+        job->second.erase(sessionId);
+        if (job->second.empty()) {
+            m_subscriptions.erase(job);
+        }
+    }
+}
+
+void ArchicadWebSocketServer::RemoveSession(uint64_t sessionId)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+
+        if (m_sessions.erase(sessionId) == 0) {
+            return;
+        }
 
-    // Broadcast to all open sessions
-    for (auto& session : m_sessions) {
-        if (session->IsOpen()) {
-            session->Send(message);
+        if (m_sessions.empty()) {
+            m_sessionsClosed.notify_all();
+        }
+
+        for (auto job = m_subscriptions.begin(); job != m_subscriptions.end();) {
+            job->second.erase(sessionId);
+            if (job->second.empty()) {
+                job = m_subscriptions.erase(job);
+            } else {
+                ++job;
+            }
         }
+
+        LOG_INFO("Client disconnected (total: " << m_sessions.size() << ")");
     }
+
+    // Outside the session lock: the transfer manager sends while holding its own
+    m_transfers.SessionClosed(sessionId);
 }
 
 void ArchicadWebSocketServer::SendProgress(const std::string& jobId, int progress, const std::string& status, const std::string& message)
 {
-    std::ostringstream oss;
-    oss << "{"
-        << "\"type\":\"progress\","
-        << "\"jobId\":\"" << EscapeJson(jobId) << "\","
-        << "\"progress\":" << progress << ","
-        << "\"status\":\"" << EscapeJson(status) << "\","
-        << "\"message\":\"" << EscapeJson(message) << "\""
-        << "}";
+    bool final = status == "completed" || status == "error" || status == "cancelled" || status == "idle";
 
-    BroadcastMessage(oss.str());
+    // Intermediate updates are rate-limited; terminal ones go out at once
+    if (final) {
+        SendFinal(jobId, FormatProgress(jobId, progress, status, message, true));
+    } else {
+        m_progress.Post(jobId, progress, status, message);
+    }
+}
+
+void ArchicadWebSocketServer::SendStageProgress(const std::string& jobId, int progress, const std::string& message)
+{
+    m_progress.Post(jobId, progress, "processing", message);
+}
+
+void ArchicadWebSocketServer::SendFinal(const std::string& jobId, JsonPayload payload)
+{
+    m_progress.Finish(jobId, [this, &jobId, &payload]() {
+        SendToJob(jobId, std::move(payload), true);
+    });
+}
+
+void ArchicadWebSocketServer::PublishProgress(const ProgressUpdate& update)
+{
+    // A slow client only needs the latest percentage
+    SendToJob(update.jobId, FormatProgress(update.jobId, update.progress, update.status, update.message, false),
+              false, "progress:" + update.jobId);
+}
+
+JsonPayload ArchicadWebSocketServer::FormatProgress(const std::string& jobId, int progress, const std::string& status,
+                                                    const std::string& message, bool final) const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "progress")
+          .Field("jobId", jobId)
+          .Field("progress", progress)
+          .Field("status", status)
+          .Field("message", message);
+    double etaMs = 0.0;
+    if (!final && m_etaProvider && m_etaProvider(jobId, etaMs)) {
+        writer.Field("etaMs", static_cast<int64_t>(etaMs + 0.5));
+    }
+    writer.EndObject();
+    return writer.ToPayload();
+}
+
+void ArchicadWebSocketServer::SendQueued(const std::string& jobId, size_t position, size_t queueDepth)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "Job queued (position %zu)", position);
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "queued")
+          .Field("jobId", jobId)
+          .Field("status", "queued")
+          .Field("progress", 0)
+          .Field("position", position)
+          .Field("queueDepth", queueDepth)
+          .Field("message", text);
+    double etaMs = 0.0;
+    if (m_etaProvider && m_etaProvider(jobId, etaMs)) {
+        writer.Field("etaMs", static_cast<int64_t>(etaMs + 0.5));
+    }
+    writer.EndObject();
+
+    SendToJob(jobId, writer.ToPayload(), false, "queued:" + jobId);
+}
+
+void ArchicadWebSocketServer::SendPreflight(const std::string& jobId, bool ok, const std::string& report)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "preflight")
+          .Field("jobId", jobId)
+          .Field("status", ok ? "validated" : "rejected")
+          .Key("preflight").Raw(report)
+          .EndObject();
+
+    SendToJob(jobId, writer.ToPayload());
+}
+
+void ArchicadWebSocketServer::SendOutputStream(const std::string& jobId, const std::string& download)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "output_stream")
+          .Field("jobId", jobId)
+          .Field("status", "processing")
+          .Key("download").Raw(download)
+          .EndObject();
+
+    SendToJob(jobId, writer.ToPayload());
 }
 
 void ArchicadWebSocketServer::SendError(const std::string& jobId, const std::string& error)
 {
-    std::ostringstream oss;
-    oss << "{"
-        << "\"type\":\"error\","
-        << "\"jobId\":\"" << EscapeJson(jobId) << "\","
-        << "\"error\":\"" << EscapeJson(error) << "\","
-        << "\"status\":\"error\""
-        << "}";
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "error")
+          .Field("jobId", jobId)
+          .Field("error", error)
+          .Field("status", "error")
+          .EndObject();
+
+    SendFinal(jobId, writer.ToPayload());
+}
+
+void ArchicadWebSocketServer::SendCompletion(const std::string& jobId, const std::string& outputPath,
+                                             const std::string& timings, const std::string& download,
+                                             const std::string& artifact, const std::string& memory)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "completed")
+          .Field("jobId", jobId)
+          .Field("status", "completed")
+          .Field("message", "Conversion completed successfully")
+          .Key("result").BeginObject()
+              .Field("outputPath", outputPath)
+          .EndObject();
+    if (!timings.empty()) {
+        writer.Key("timingsMs").Raw(timings);
+    }
+    if (!download.empty()) {
+        writer.Key("download").Raw(download);
+    }
+    if (!artifact.empty()) {
+        writer.Key("artifact").Raw(artifact);
+    }
+    if (!memory.empty()) {
+        writer.Key("memory").Raw(memory);
+    }
+    writer.EndObject();
+
+    SendFinal(jobId, writer.ToPayload());
+}
+
+// Helper to write one batch item's fields into an open object
+static void WriteBatchItem(JsonWriter& writer, const BatchItemReport& report)
+{
+    writer.Field("status", report.status)
+          .Field("inputPath", report.inputPath)
+          .Field("outputPath", report.outputPath);
+    if (!report.translator.empty()) {
+        writer.Field("translator", report.translator);
+    }
+    if (!report.error.empty()) {
+        writer.Field("error", report.error);
+    }
+}
 
-    BroadcastMessage(oss.str());
+void ArchicadWebSocketServer::SendBatchItem(const std::string& jobId, size_t index, size_t total, const BatchItemReport& report)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "batch_item")
+          .Field("jobId", jobId)
+          .Field("index", index)
+          .Field("total", total);
+    WriteBatchItem(writer, report);
+    writer.EndObject();
+
+    SendToJob(jobId, writer.ToPayload());
 }
 
-void ArchicadWebSocketServer::SendCompletion(const std::string& jobId, const std::string& outputPath)
+void ArchicadWebSocketServer::SendBatchSummary(const std::string& jobId, const std::string& status, const std::vector<BatchItemReport>& items,
+                                               const std::string& timings)
 {
-    std::ostringstream oss;
-    oss << "{"
-        << "\"type\":\"completed\","
-        << "\"jobId\":\"" << EscapeJson(jobId) << "\","
-        << "\"status\":\"completed\","
-        << "\"message\":\"Conversion completed successfully\","
-        << "\"result\":{"
-        << "\"outputPath\":\"" << EscapeJson(outputPath) << "\""
-        << "}"
-        << "}";
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t cancelled = 0;
+    for (const BatchItemReport& report : items) {
+        if (report.status == "completed") {
+            ++succeeded;
+        } else if (report.status == "cancelled") {
+            ++cancelled;
+        } else {
+            ++failed;
+        }
+    }
 
-    BroadcastMessage(oss.str());
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "batch_completed")
+          .Field("jobId", jobId)
+          .Field("status", status)
+          .Field("succeeded", succeeded)
+          .Field("failed", failed)
+          .Field("cancelled", cancelled)
+          .Key("items").BeginArray();
+    for (const BatchItemReport& report : items) {
+        writer.BeginObject();
+        WriteBatchItem(writer, report);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    if (!timings.empty()) {
+        writer.Key("timingsMs").Raw(timings);
+    }
+    writer.EndObject();
+
+    SendFinal(jobId, writer.ToPayload());
+}
+
+void ArchicadWebSocketServer::SetThreadCount(size_t threads)
+{
+    m_threadCount = threads > 0 ? threads : 1;
+}
+
+void ArchicadWebSocketServer::SetCompression(const WebSocketCompression& compression)
+{
+    m_compression = compression;
 }
 
 void ArchicadWebSocketServer::SetCommandCallback(CommandCallback callback)
@@ -505,33 +1393,51 @@ void ArchicadWebSocketServer::SetCommandCallback(CommandCallback callback)
     m_commandCallback = callback;
 }
 
+void ArchicadWebSocketServer::SetProgressRate(int maxRateHz)
+{
+    m_progressRateHz = maxRateHz;
+}
+
+void ArchicadWebSocketServer::SetQueueLimits(const SessionQueueLimits& limits)
+{
+    m_queueLimits = limits;
+}
+
+SessionQueueStats ArchicadWebSocketServer::GetQueueStats() const
+{
+    SessionQueueStats stats;
+    stats.sessions = GetConnectionCount();
+    stats.queuedBytes = m_queueCounters->queuedBytes.load(std::memory_order_relaxed);
+    stats.queuedFrames = m_queueCounters->queuedFrames.load(std::memory_order_relaxed);
+    stats.peakBytes = m_queueCounters->peakBytes.load(std::memory_order_relaxed);
+    stats.peakFrames = m_queueCounters->peakFrames.load(std::memory_order_relaxed);
+    stats.coalesced = m_queueCounters->coalesced.load(std::memory_order_relaxed);
+    stats.saturations = m_queueCounters->saturations.load(std::memory_order_relaxed);
+    stats.disconnects = m_queueCounters->disconnects.load(std::memory_order_relaxed);
+    stats.highWatermarkBytes = m_queueLimits.highWatermarkBytes;
+    stats.lowWatermarkBytes = m_queueLimits.lowWatermarkBytes;
+    return stats;
+}
+
+void ArchicadWebSocketServer::SetHelloProvider(HelloProvider provider)
+{
+    m_helloProvider = std::move(provider);
+}
+
+void ArchicadWebSocketServer::SetEtaProvider(EtaProvider provider)
+{
+    m_etaProvider = provider;
+}
+
+int ArchicadWebSocketServer::GetPort() const
+{
+    return m_port;
+}
+
 size_t ArchicadWebSocketServer::GetConnectionCount() const
 {
     std::lock_guard<std::mutex> lock(m_sessionMutex);
     return m_sessions.size();
 }
 
-std::string ArchicadWebSocketServer::EscapeJson(const std::string& str) const
-{
-    std::ostringstream oss;
-    for (char c : str) {
-        switch (c) {
-            case '"':  oss << "\\\""; break;
-            case '\\': oss << "\\\\"; break;
-            case '\b': oss << "\\b"; break;
-            case '\f': oss << "\\f"; break;
-            case '\n': oss << "\\n"; break;
-            case '\r': oss << "\\r"; break;
-            case '\t': oss << "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
-                } else {
-                    oss << c;
-                }
-        }
-    }
-    return oss.str();
-}
-
 #endif // WEBSOCKET_ENABLED
@@ -20,22 +20,35 @@
 
 #ifdef WEBSOCKET_ENABLED
 
+#include "WebSocketCommand.hpp"
+#include "JsonWriter.hpp"
+#include "FileTransfer.hpp"
+#include "ProgressAggregator.hpp"
+#include "JobRegistry.hpp"
 #include <string>
 #include <thread>
 #include <functional>
 #include <vector>
+#include <deque>
+#include <map>
+#include <set>
 #include <mutex>
+#include <condition_variable>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
 // Suppress Boost warnings
 #pragma warning(push)
 #pragma warning(disable: 4996 4267 4244 4100 4702)
 
 #include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/dispatch.hpp>
 
 #pragma warning(pop)
 
@@ -44,36 +57,238 @@ namespace websocket = beast::websocket;
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
+/**
+ * @brief Outcome of one batch item, as reported to clients
+ */
+struct BatchItemReport {
+    std::string inputPath;
+    std::string outputPath;
+    std::string translator;     // IFC export translator, empty for the default
+    std::string status;         // "completed", "error" or "cancelled"
+    std::string error;          // Failure reason, empty on success
+};
+
+/**
+ * @brief Encoding of the messages the server sends to a session
+ *
+ * Clients ask for CBOR by offering the "ifc-plugin.cbor" subprotocol in the
+ * handshake; everything else gets JSON text frames. Commands from clients
+ * are always JSON text.
+ */
+enum class MessageEncoding {
+    Json,
+    Cbor
+};
+
+/**
+ * @brief Subprotocol names offered in Sec-WebSocket-Protocol
+ */
+const char* const kJsonSubprotocol = "ifc-plugin.json";
+const char* const kCborSubprotocol = "ifc-plugin.cbor";
+
+/**
+ * @brief permessage-deflate settings offered to clients
+ */
+struct WebSocketCompression {
+    bool enabled = true;
+    size_t minMessageBytes = 256;   // Smaller messages are sent uncompressed (Boost 1.81+)
+    int level = 6;                  // Deflate level, 0..9
+    int memLevel = 4;               // Deflate memory level, 1..9
+    int windowBits = 15;            // Server window bits, 9..15
+};
+
+/**
+ * @brief Bounds on what one session may have waiting to be written
+ *
+ * A client that reads slower than events are produced is saturated once
+ * its queue passes the high watermark, and recovers below the low one.
+ * A client saturated for longer than saturatedTimeoutMs is disconnected.
+ * A frame that would take the queue past a hard limit disconnects the
+ * client at once, however long it has been saturated.
+ */
+struct SessionQueueLimits {
+    size_t highWatermarkBytes = 8u << 20;
+    size_t lowWatermarkBytes = 2u << 20;
+    size_t maxFrames = 4096;                // Frames count towards saturation too
+    int saturatedTimeoutMs = 10000;
+    size_t hardLimitBytes = 32u << 20;      // Never queued beyond these
+    size_t hardLimitFrames = 16384;
+};
+
+/**
+ * @brief Write queue counters shared by all sessions (updated from their strands)
+ */
+struct SessionQueueCounters {
+    std::atomic<uint64_t> queuedBytes{0};
+    std::atomic<uint64_t> queuedFrames{0};
+    std::atomic<uint64_t> peakBytes{0};     // Largest queue of a single session
+    std::atomic<uint64_t> peakFrames{0};
+    std::atomic<uint64_t> coalesced{0};     // Updates that replaced an undelivered one
+    std::atomic<uint64_t> saturations{0};   // Times a session crossed the high watermark
+    std::atomic<uint64_t> disconnects{0};   // Sessions dropped for staying saturated or a full queue
+};
+
+/**
+ * @brief Snapshot of the session write queues (get_metrics "connections")
+ */
+struct SessionQueueStats {
+    size_t sessions = 0;
+    uint64_t queuedBytes = 0;
+    uint64_t queuedFrames = 0;
+    uint64_t peakBytes = 0;
+    uint64_t peakFrames = 0;
+    uint64_t coalesced = 0;
+    uint64_t saturations = 0;
+    uint64_t disconnects = 0;
+    size_t highWatermarkBytes = 0;
+    size_t lowWatermarkBytes = 0;
+
+    std::string ToJson() const;
+
+    /**
+     * @brief Prometheus text exposition lines (ifc_plugin_ws_*)
+     */
+    std::string ToPrometheus() const;
+};
+
+/**
+ * @brief One outgoing message in the encodings its sessions use
+ *
+ * The CBOR form is converted from the JSON text on first use, so a fan-out
+ * to many CBOR sessions converts once. Not thread-safe; build one per send.
+ */
+class OutgoingMessage {
+public:
+    explicit OutgoingMessage(JsonPayload json);
+
+    /**
+     * @brief Payload for a session
+     * @param encoding The session's encoding
+     * @param binary Set to true if the payload must go out as a binary frame
+     */
+    const JsonPayload& Get(MessageEncoding encoding, bool& binary);
+
+    /**
+     * @brief Mark the message as an update that supersedes undelivered ones with the same key
+     */
+    void SetCoalesceKey(std::string key) { m_coalesceKey = std::move(key); }
+    const std::string& GetCoalesceKey() const { return m_coalesceKey; }
+
+private:
+    JsonPayload m_json;
+    JsonPayload m_cbor;
+    bool m_cborFailed;
+    std::string m_coalesceKey;
+};
+
 /**
  * @brief WebSocket session - handles individual client connection
+ *
+ * The socket lives on its own strand. Send() and Close() may be called from
+ * any thread; they post to the strand, which alone touches the stream and
+ * the write queue.
+ *
+ * The write queue is bounded by SessionQueueLimits: an update with a
+ * coalesce key replaces the undelivered update with the same key (only the
+ * latest progress of a job is kept), nothing else is ever dropped, and a
+ * client that stays saturated or reaches a hard limit is disconnected.
  */
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
 public:
-    WebSocketSession(tcp::socket socket);
+    WebSocketSession(tcp::socket socket, uint64_t id, const WebSocketCompression& compression,
+                     const SessionQueueLimits& limits, std::shared_ptr<SessionQueueCounters> counters);
     ~WebSocketSession();
 
+    uint64_t GetId() const { return m_id; }
+
     void Run();
     void Send(const std::string& message);
+
+    /**
+     * @brief Queue a shared payload; the session keeps a reference until written
+     */
+    void Send(JsonPayload payload);
+
+    /**
+     * @brief Queue a message in this session's encoding
+     */
+    void Send(OutgoingMessage& message);
+
+    /**
+     * @brief Queue a binary frame as-is (file chunks)
+     */
+    void SendBinary(JsonPayload frame);
     void Close();
     bool IsOpen() const;
 
-    using MessageCallback = std::function<void(const std::string&)>;
+    /**
+     * @brief Encoding negotiated in the handshake (Json until then)
+     */
+    MessageEncoding GetEncoding() const { return m_encoding; }
+
+    /**
+     * @brief Called on the session's strand with every message received
+     * @param binary True for binary frames (file chunks)
+     */
+    using MessageCallback = std::function<void(std::string message, bool binary)>;
     void SetMessageCallback(MessageCallback callback);
 
+    /**
+     * @brief Called once when the connection is lost (handshake, read or write error)
+     *
+     * Not called by Close(), whose caller already knows.
+     */
+    using ClosedCallback = std::function<void()>;
+    void SetClosedCallback(ClosedCallback callback);
+
+    /**
+     * @brief Called once on the session's strand when the handshake completes
+     *
+     * Messages sent from it are the first the client receives.
+     */
+    using OpenedCallback = std::function<void()>;
+    void SetOpenedCallback(OpenedCallback callback);
+
 private:
+    void DoReadUpgrade();
+    void OnReadUpgrade(beast::error_code ec, std::size_t bytes_transferred);
     void DoAccept();
     void DoRead();
     void DoWrite();
     void OnAccept(beast::error_code ec);
     void OnRead(beast::error_code ec, std::size_t bytes_transferred);
     void OnWrite(beast::error_code ec, std::size_t bytes_transferred);
+    void ReportClosed();
+
+    struct Frame {
+        JsonPayload data;
+        bool binary = false;
+        std::string coalesceKey;    // Empty: never replaced
+    };
+
+    void QueueFrame(Frame frame);
+    void AddQueued(int64_t bytes, int64_t frames);
+    void CheckSaturation();
+    void Disconnect(const char* reason);
 
     websocket::stream<beast::tcp_stream> m_ws;
     beast::flat_buffer m_buffer;
-    std::vector<std::string> m_writeQueue;
+    beast::http::request<beast::http::string_body> m_upgrade;
+    WebSocketCompression m_compression;
+    std::deque<Frame> m_writeQueue;
+    std::map<std::string, Frame*> m_pendingUpdates;    // Coalesce key -> queued frame not being written yet
+    size_t m_queuedBytes;
+    SessionQueueLimits m_limits;
+    std::shared_ptr<SessionQueueCounters> m_counters;
+    bool m_saturated;
+    std::chrono::steady_clock::time_point m_saturatedSince;
     MessageCallback m_messageCallback;
-    std::mutex m_writeMutex;
+    ClosedCallback m_closedCallback;
+    OpenedCallback m_openedCallback;
     std::atomic<bool> m_open;
+    std::atomic<bool> m_closedReported;
+    std::atomic<MessageEncoding> m_encoding;
+    uint64_t m_id;
 };
 
 /**
@@ -82,17 +297,34 @@ private:
  * This server runs on port 8081 and allows bidirectional communication
  * between the Archicad plugin and the backend.
  *
+ * Job events go only to the sessions subscribed to that job. A session is
+ * subscribed when it submits or queries a job, or with an explicit
+ * subscribe command (jobId "*" subscribes to every job).
+ *
+ * Socket I/O runs on a pool of threads (SetThreadCount). Commands are
+ * handled on a separate command thread, in arrival order, so the command
+ * callback may block without stalling other sessions.
+ *
  * Uses Boost.Beast - modern, secure, and well-maintained.
  */
 class ArchicadWebSocketServer {
 public:
     /**
      * @brief Command callback function type
-     * @param command The command name (e.g., "start_conversion")
-     * @param jobId Unique job identifier
-     * @param payload Full JSON payload as string
+     * @param command The parsed message (type, jobId, paths, full body)
+     */
+    using CommandCallback = std::function<void(const WebSocketCommand& command)>;
+
+    /**
+     * @brief Predicted milliseconds until a job finishes
+     * @return false if there is no prediction for the job
+     */
+    using EtaProvider = std::function<bool(const std::string& jobId, double& etaMs)>;
+
+    /**
+     * @brief Builds the "hello" message every session receives on connect
      */
-    using CommandCallback = std::function<void(const std::string& command, const std::string& jobId, const std::string& payload)>;
+    using HelloProvider = std::function<std::string()>;
 
     ArchicadWebSocketServer();
     ~ArchicadWebSocketServer();
@@ -100,9 +332,10 @@ public:
     /**
      * @brief Start the WebSocket server on specified port
      * @param port Port number (default: 8081)
+     * @param bindAddress IPv4 or IPv6 address to listen on ("" for every IPv4 interface)
      * @return true if started successfully, false otherwise
      */
-    bool Start(int port = 8081);
+    bool Start(int port = 8081, const std::string& bindAddress = std::string());
 
     /**
      * @brief Stop the WebSocket server
@@ -121,8 +354,44 @@ public:
      */
     void BroadcastMessage(const std::string& message);
 
+    /**
+     * @brief Send one serialized payload to all connected clients
+     * @param payload Immutable message shared by every session (no per-client copy)
+     */
+    void BroadcastMessage(JsonPayload payload);
+
+    /**
+     * @brief Send a job event to the job's subscribers
+     * @param jobId Job the event belongs to
+     * @param payload Serialized event
+     * @param final True for the job's last event; drops its subscriptions afterwards
+     * @param coalesceKey Non-empty for updates that replace an undelivered one with the same key
+     */
+    void SendToJob(const std::string& jobId, JsonPayload payload, bool final = false,
+                   const std::string& coalesceKey = std::string());
+
+    /**
+     * @brief Reply to the session a command arrived on
+     * @param sessionId WebSocketCommand::sessionId
+     * @param payload Serialized reply
+     */
+    void SendToSession(uint64_t sessionId, JsonPayload payload);
+    void SendToSession(uint64_t sessionId, const std::string& message);
+
+    /**
+     * @brief Send a binary frame to one session, whatever its encoding
+     */
+    void SendBinaryToSession(uint64_t sessionId, JsonPayload frame);
     /**
      * @brief Send progress update
+     *
+     * Intermediate updates are rate-limited per job (SetProgressRate): a
+     * job's unpublished update is replaced by the next one. Terminal
+     * statuses ("completed", "error", "cancelled", "idle") are sent at once
+     * and end the job: its subscriptions are dropped and the registry keeps
+     * the update as its last event. Stages of a job that ends with
+     * SendCompletion() or SendError() go through SendStageProgress().
+     *
      * @param jobId Job identifier
      * @param progress Progress percentage (0-100)
      * @param status Status string (e.g., "processing", "completed")
@@ -130,6 +399,38 @@ public:
      */
     void SendProgress(const std::string& jobId, int progress, const std::string& status, const std::string& message);
 
+    /**
+     * @brief Send the progress of a conversion stage
+     *
+     * Always "processing" and rate-limited like SendProgress(), whatever the
+     * percentage: a stage at 0 (failed) or 100 (done) leaves the job open for
+     * the completion or error that ends it.
+     */
+    void SendStageProgress(const std::string& jobId, int progress, const std::string& message);
+
+    /**
+     * @brief Send queue acknowledgement / position update
+     * @param jobId Job identifier
+     * @param position 1-based position in the queue
+     * @param queueDepth Number of jobs currently waiting
+     */
+    void SendQueued(const std::string& jobId, size_t position, size_t queueDepth);
+
+    /**
+     * @brief Send the result of an IFC pre-flight scan
+     * @param jobId Job identifier
+     * @param ok Whether the file passed
+     * @param report Scan report as a JSON object, sent as "preflight"
+     */
+    void SendPreflight(const std::string& jobId, bool ok, const std::string& report);
+
+    /**
+     * @brief Announce an output that can be downloaded while it is written
+     * @param jobId Job identifier
+     * @param download Live download description as a JSON object
+     */
+    void SendOutputStream(const std::string& jobId, const std::string& download);
+
     /**
      * @brief Send error notification
      * @param jobId Job identifier
@@ -141,15 +442,119 @@ public:
      * @brief Send completion notification
      * @param jobId Job identifier
      * @param outputPath Path to generated file
+     * @param timings Stage timings as a JSON object, sent as "timingsMs" ("" for none)
+     * @param download Output offered for download as a JSON object, sent as "download" ("" for none)
+     * @param artifact Post-processing result as a JSON object, sent as "artifact" ("" for none)
+     * @param memory Process memory around the job as a JSON object, sent as "memory" ("" for none)
+     */
+    void SendCompletion(const std::string& jobId, const std::string& outputPath,
+                        const std::string& timings = std::string(),
+                        const std::string& download = std::string(),
+                        const std::string& artifact = std::string(),
+                        const std::string& memory = std::string());
+
+    /**
+     * @brief Send the outcome of one batch item
+     * @param jobId Batch job identifier
+     * @param index 0-based item index
+     * @param total Number of items in the batch
+     * @param report Item outcome
+     */
+    void SendBatchItem(const std::string& jobId, size_t index, size_t total, const BatchItemReport& report);
+
+    /**
+     * @brief Send the final summary of a batch (its last event)
+     * @param jobId Batch job identifier
+     * @param status "completed" if every item succeeded, "error" or "cancelled" otherwise
+     * @param items Outcome of every item, in batch order
+     * @param timings Stage timings summed over all items as a JSON object ("" for none)
+     */
+    void SendBatchSummary(const std::string& jobId, const std::string& status, const std::vector<BatchItemReport>& items,
+                          const std::string& timings = std::string());
+
+    /**
+     * @brief Set the number of I/O threads used by the next Start()
+     * @param threads Threads running the io_context (at least 1, default 2)
+     */
+    void SetThreadCount(size_t threads);
+
+    /**
+     * @brief Set the permessage-deflate offer (call before Start())
+     */
+    void SetCompression(const WebSocketCompression& compression);
+
+    /**
+     * @brief Set how often a job's progress may be published (call before Start())
+     * @param maxRateHz Updates per second and job, 0 to send every update (default 10)
+     */
+    void SetProgressRate(int maxRateHz);
+
+    /**
+     * @brief Set the per-session write queue bounds for sessions accepted from now on
      */
-    void SendCompletion(const std::string& jobId, const std::string& outputPath);
+    void SetQueueLimits(const SessionQueueLimits& limits);
+
+    /**
+     * @brief Current write queue totals and watermarks
+     */
+    SessionQueueStats GetQueueStats() const;
 
     /**
      * @brief Set callback for incoming commands
-     * @param callback Function to call when command is received
+     * @param callback Function to call when command is received (on the command thread)
      */
     void SetCommandCallback(CommandCallback callback);
 
+    /**
+     * @brief Set where progress and queued events get their "etaMs" (call before Start())
+     */
+    void SetEtaProvider(EtaProvider provider);
+
+    /**
+     * @brief Set the greeting sent to each session once its handshake completes (call before Start())
+     */
+    void SetHelloProvider(HelloProvider provider);
+
+    /**
+     * @brief Chunked uploads and downloads (upload_begin, download, ...)
+     *
+     * Disabled until FileTransferManager::Open() is called.
+     */
+    FileTransferManager& GetTransfers() { return m_transfers; }
+
+    /**
+     * @brief Jobs claimed by submissions, with the events sent for them
+     *
+     * Every job event sent through SendToJob() is recorded for claimed
+     * jobs; "resume" replays the latest one (the terminal event once the
+     * job finished) to a reconnected client.
+     */
+    JobRegistry& GetJobRegistry() { return m_jobRegistry; }
+
+    /**
+     * @brief Claim a start command's jobId in the job registry
+     *
+     * A job that is already running or finished with the same fingerprint
+     * (see SubmissionFingerprint()) is not run again: the session gets an
+     * "attached" message and the job's latest event (its terminal event
+     * once finished). "rerun": true runs a finished job again.
+     *
+     * @return true if the job should be run; false if the command was answered
+     */
+    bool ClaimSubmission(const WebSocketCommand& command);
+
+    /**
+     * @brief Release a claimed jobId whose submission failed, and send the error
+     *
+     * The client can submit the job again once the problem is fixed.
+     */
+    void RejectSubmission(const std::string& jobId, const std::string& error);
+
+    /**
+     * @brief Get the port the server is (or was last) listening on
+     */
+    int GetPort() const;
+
     /**
      * @brief Get number of connected clients
      * @return Number of active connections
@@ -170,29 +575,71 @@ private:
     /**
      * @brief Handle message from client
      */
-    void HandleMessage(const std::string& message);
+    void HandleMessage(uint64_t sessionId, const std::string& message, bool binary);
 
     /**
      * @brief Parse and handle JSON command
      */
-    void HandleCommand(const std::string& jsonPayload);
+    void HandleCommand(uint64_t sessionId, const std::string& jsonPayload);
 
     /**
-     * @brief Server run loop (runs in separate thread)
+     * @brief Forget a session whose connection was lost, with its subscriptions
      */
-    void RunServer();
+    void RemoveSession(uint64_t sessionId);
+
+    /**
+     * @brief Send a job's last event; a rate-limited progress update can no longer follow it
+     */
+    void SendFinal(const std::string& jobId, JsonPayload payload);
+
+    /**
+     * @brief Send a progress update released by the aggregator
+     */
+    void PublishProgress(const ProgressUpdate& update);
+
+    JsonPayload FormatProgress(const std::string& jobId, int progress, const std::string& status,
+                               const std::string& message, bool final) const;
+
+    /**
+     * @brief Open session by id, nullptr if gone
+     */
+    std::shared_ptr<WebSocketSession> FindSession(uint64_t sessionId) const;
+
+    void Subscribe(const std::string& jobId, uint64_t sessionId);
+    void Unsubscribe(const std::string& jobId, uint64_t sessionId);
 
     /**
-     * @brief Escape JSON string
+     * @brief Answer "resume": subscribe to each job and replay its latest event
      */
-    std::string EscapeJson(const std::string& str) const;
+    void ResumeJobs(const WebSocketCommand& command);
+
+    /**
+     * @brief Server run loop (runs on each I/O thread)
+     */
+    void RunServer();
 
     net::io_context m_ioc;
     tcp::acceptor m_acceptor;
-    std::thread m_serverThread;
-    std::vector<std::shared_ptr<WebSocketSession>> m_sessions;
+    std::vector<std::thread> m_ioThreads;
+    size_t m_threadCount;
+    WebSocketCompression m_compression;
+    SessionQueueLimits m_queueLimits;
+    std::shared_ptr<SessionQueueCounters> m_queueCounters;
+    net::io_context m_commandIoc;
+    std::unique_ptr<net::executor_work_guard<net::io_context::executor_type>> m_commandWork;
+    std::thread m_commandThread;
+    std::map<uint64_t, std::shared_ptr<WebSocketSession>> m_sessions;
+    std::map<std::string, std::set<uint64_t>> m_subscriptions;   // jobId -> session ids
+    uint64_t m_nextSessionId;
     mutable std::mutex m_sessionMutex;
+    std::condition_variable m_sessionsClosed;      // Signalled when the last session is removed
     CommandCallback m_commandCallback;
+    EtaProvider m_etaProvider;
+    HelloProvider m_helloProvider;
+    FileTransferManager m_transfers;
+    JobRegistry m_jobRegistry;
+    ProgressAggregator m_progress;
+    int m_progressRateHz;
     std::atomic<bool> m_running;
     int m_port;
 };
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerRegistration.hpp"
+
+#ifdef WEBSOCKET_ENABLED
+
+#include "WebSocketServer.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+#include <chrono>
+#include <algorithm>
+
+std::string FormatWorkerInfo(const WorkerInfo& info, const char* type)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", type)
+          .Field("command", type)
+          .Field("workerId", info.workerId)
+          .Field("host", info.host)
+          .Field("port", info.port)
+          .Field("capacity", info.capacity)
+          .Field("archicadVersion", info.archicadVersion)
+          .Field("running", info.running)
+          .Field("queued", info.queued)
+          .Field("load", info.running + info.queued)
+          .Field("recycle", info.recycle);
+    if (info.recycle) {
+        writer.Field("recycleReason", info.recycleReason);
+    }
+    writer.EndObject();
+    return writer.ToString();
+}
+
+WorkerRegistration::WorkerRegistration()
+    : m_intervalSeconds(30)
+    , m_stop(false)
+{
+}
+
+WorkerRegistration::~WorkerRegistration()
+{
+    Stop();
+}
+
+bool WorkerRegistration::Start(const std::string& coordinatorUrl, InfoProvider provider, int intervalSeconds)
+{
+    if (m_thread.joinable()) {
+        return false;
+    }
+
+    // Accept "ws://host:port/path" as well as plain "host:port"
+    std::string rest = coordinatorUrl;
+    const std::string scheme = "ws://";
+    if (rest.compare(0, scheme.size(), scheme) == 0) {
+        rest = rest.substr(scheme.size());
+    }
+
+    size_t slash = rest.find('/');
+    m_path = (slash == std::string::npos) ? "/" : rest.substr(slash);
+    rest = rest.substr(0, slash);
+
+    size_t colon = rest.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= rest.size()) {
+        LOG_ERROR("✗ Invalid coordinator URL: " << coordinatorUrl);
+        return false;
+    }
+
+    m_host = rest.substr(0, colon);
+    m_port = rest.substr(colon + 1);
+    m_provider = provider;
+    m_intervalSeconds = intervalSeconds > 0 ? intervalSeconds : 30;
+    m_stop = false;
+
+    m_thread = std::thread([this]() { Run(); });
+
+    LOG_INFO("✓ Registering with coordinator " << m_host << ":" << m_port);
+    return true;
+}
+
+void WorkerRegistration::Stop()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void WorkerRegistration::Run()
+{
+    int retryDelay = 1;
+
+    while (true) {
+        bool registered = RegisterOnce();
+
+        // Retry quickly (with backoff) until the coordinator answers, then
+        // fall back to the regular refresh interval
+        int delay = registered ? m_intervalSeconds : retryDelay;
+        retryDelay = registered ? 1 : (std::min)(retryDelay * 2, m_intervalSeconds);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_cv.wait_for(lock, std::chrono::seconds(delay), [this] { return m_stop; })) {
+            return;
+        }
+    }
+}
+
+bool WorkerRegistration::RegisterOnce()
+{
+    try {
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        websocket::stream<beast::tcp_stream> ws(ioc);
+
+        auto const results = resolver.resolve(m_host, m_port);
+        beast::get_lowest_layer(ws).connect(results);
+
+        WorkerInfo info = m_provider ? m_provider() : WorkerInfo();
+
+        // Without an explicit host, advertise the local address the
+        // coordinator is reachable from
+        if (info.host.empty()) {
+            info.host = beast::get_lowest_layer(ws).socket().local_endpoint().address().to_string();
+        }
+        if (info.workerId.empty()) {
+            info.workerId = info.host + ":" + std::to_string(info.port);
+        }
+
+        ws.handshake(m_host + ":" + m_port, m_path);
+        ws.write(net::buffer(FormatWorkerInfo(info, "register_worker")));
+
+        beast::error_code ec;
+        ws.close(websocket::close_code::normal, ec);
+        return true;
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Worker registration failed: " << e.what());
+        return false;
+    }
+}
+
+#endif // WEBSOCKET_ENABLED
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKER_REGISTRATION_HPP
+#define WORKER_REGISTRATION_HPP
+
+#ifdef WEBSOCKET_ENABLED
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @brief What a plugin instance advertises to the worker coordinator
+ */
+struct WorkerInfo {
+    std::string workerId;           // Stable name, defaults to host:port
+    std::string host;               // Address the coordinator should dial
+    int port = 0;                   // WebSocket port of this instance
+    int capacity = 1;               // Jobs that can run at the same time
+    std::string archicadVersion;
+    size_t running = 0;             // Jobs currently running
+    size_t queued = 0;              // Jobs waiting in the queue
+    bool recycle = false;           // Asks to be replaced by a fresh instance
+    std::string recycleReason;
+};
+
+/**
+ * @brief Serialize worker info as a JSON message
+ * @param info Worker description
+ * @param type Message type ("register_worker", "worker_info" or "worker_recycle")
+ */
+std::string FormatWorkerInfo(const WorkerInfo& info, const char* type);
+
+/**
+ * @brief Announces this plugin instance to a worker coordinator
+ *
+ * Runs a background thread that connects to the coordinator, sends a
+ * register_worker message and disconnects. The registration is repeated
+ * periodically so a restarted coordinator rediscovers its workers; the
+ * coordinator then connects back to the advertised port like any other
+ * backend client.
+ */
+class WorkerRegistration {
+public:
+    typedef std::function<WorkerInfo()> InfoProvider;
+
+    WorkerRegistration();
+    ~WorkerRegistration();
+
+    /**
+     * @brief Start registering with a coordinator
+     * @param coordinatorUrl "ws://host:port[/path]" or "host:port"
+     * @param provider Returns the current worker info
+     * @param intervalSeconds Seconds between registrations
+     * @return false if the URL is invalid or registration is already running
+     */
+    bool Start(const std::string& coordinatorUrl, InfoProvider provider, int intervalSeconds = 30);
+
+    /**
+     * @brief Stop the registration thread
+     */
+    void Stop();
+
+private:
+    void Run();
+    bool RegisterOnce();
+
+    std::string m_host;
+    std::string m_port;
+    std::string m_path;
+    InfoProvider m_provider;
+    int m_intervalSeconds;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+};
+
+#endif // WEBSOCKET_ENABLED
+
+#endif // WORKER_REGISTRATION_HPP
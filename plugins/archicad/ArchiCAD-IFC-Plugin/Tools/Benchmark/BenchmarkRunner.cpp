@@ -0,0 +1,584 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkRunner.hpp"
+#include "JsonParser.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <ctime>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+using Clock = std::chrono::steady_clock;
+
+// Helper to format a number with a fixed number of decimals
+static std::string FormatNumber(double value, int decimals)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+static double MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Nearest-rank percentile of an unsorted sample
+static double Percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(values.size()) + 0.999999);
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static void WriteDistribution(JsonWriter& writer, const std::vector<double>& values)
+{
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    writer.BeginObject()
+          .Key("p50").Raw(FormatNumber(Percentile(values, 0.50), 2))
+          .Key("p95").Raw(FormatNumber(Percentile(values, 0.95), 2))
+          .Key("max").Raw(FormatNumber(Percentile(values, 1.0), 2))
+          .Key("mean").Raw(FormatNumber(values.empty() ? 0.0 : sum / static_cast<double>(values.size()), 2))
+          .EndObject();
+}
+
+// Summary of the jobs of one type ("" = all jobs)
+static void WriteSummary(JsonWriter& writer, const std::vector<BenchmarkJob>& jobs, const std::string& type, double wallMs)
+{
+    std::vector<double> latencies;
+    std::map<std::string, std::vector<double>> stages;
+    size_t count = 0;
+    size_t cached = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    for (const BenchmarkJob& job : jobs) {
+        if (!type.empty() && job.type != type) {
+            continue;
+        }
+        ++count;
+        if (job.status != "completed") {
+            continue;
+        }
+        cached += job.cached ? 1 : 0;
+        latencies.push_back(job.latencyMs);
+        inputBytes += job.inputBytes;
+        outputBytes += job.outputBytes;
+        for (const auto& timing : job.timingsMs) {
+            stages[timing.first].push_back(timing.second);
+        }
+    }
+
+    double hours = wallMs / 3600000.0;
+    writer.BeginObject()
+          .Field("count", count)
+          .Field("completed", latencies.size())
+          .Field("failed", count - latencies.size())
+          .Field("cached", cached)
+          .Key("jobsPerHour").Raw(FormatNumber(hours > 0.0 ? static_cast<double>(latencies.size()) / hours : 0.0, 1))
+          .Field("inputBytes", inputBytes)
+          .Field("outputBytes", outputBytes)
+          .Key("latencyMs");
+    WriteDistribution(writer, latencies);
+    writer.Key("stagesMs").BeginObject();
+    for (const auto& stage : stages) {
+        writer.Key(stage.first.c_str());
+        WriteDistribution(writer, stage.second);
+    }
+    writer.EndObject()
+          .EndObject();
+}
+
+std::string BenchmarkResult::ToJson() const
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("format", "ifc-plugin-benchmark")
+          .Field("version", 1)
+          .Field("label", label)
+          .Field("startedAt", startedAt)
+          .Key("plugin").BeginObject()
+              .Field("workerId", workerId)
+              .Field("archicadVersion", archicadVersion)
+              .Field("warmSession", warmSession)
+          .EndObject()
+          .Key("wallMs").Raw(FormatNumber(wallMs, 2))
+          .Key("process").BeginObject()
+              .Field("rssStartBytes", rssStartBytes)
+              .Field("rssEndBytes", rssEndBytes)
+              .Field("peakRssBytes", peakRssBytes)
+          .EndObject();
+
+    writer.Key("summary").BeginObject()
+          .Key("overall");
+    WriteSummary(writer, jobs, "", wallMs);
+    for (const char* type : { "pln_to_ifc", "ifc_to_pln" }) {
+        writer.Key(type);
+        WriteSummary(writer, jobs, type, wallMs);
+    }
+    writer.EndObject();
+
+    writer.Key("jobs").BeginArray();
+    for (const BenchmarkJob& job : jobs) {
+        writer.BeginObject()
+              .Field("jobId", job.jobId)
+              .Field("file", job.name)
+              .Field("type", job.type)
+              .Field("iteration", job.iteration)
+              .Field("status", job.status)
+              .Field("inputBytes", job.inputBytes)
+              .Field("outputBytes", job.outputBytes)
+              .Field("cached", job.cached)
+              .Key("latencyMs").Raw(FormatNumber(job.latencyMs, 2));
+        if (!job.message.empty()) {
+            writer.Field("message", job.message);
+        }
+        writer.Key("timingsMs").BeginObject();
+        for (const auto& timing : job.timingsMs) {
+            writer.Key(timing.first.c_str()).Raw(FormatNumber(timing.second, 2));
+        }
+        writer.EndObject()
+              .EndObject();
+    }
+    writer.EndArray();
+
+    if (!pluginReport.empty()) {
+        writer.Key("pluginReport").Raw(pluginReport);
+    }
+    writer.EndObject();
+    return writer.ToString();
+}
+
+// Number at a key path, or nullptr
+static const JsonValue* FindPath(const JsonValue& root, std::initializer_list<const char*> path)
+{
+    const JsonValue* value = &root;
+    for (const char* key : path) {
+        value = value->IsObject() ? value->Find(key) : nullptr;
+        if (value == nullptr) {
+            return nullptr;
+        }
+    }
+    return value->IsNumber() ? value : nullptr;
+}
+
+static void PrintDelta(const char* name, const JsonValue* current, const JsonValue* baseline, bool higherIsBetter)
+{
+    if (current == nullptr || baseline == nullptr) {
+        return;
+    }
+
+    double now = current->AsNumber();
+    double before = baseline->AsNumber();
+    std::string change = "n/a";
+    const char* verdict = "";
+    if (before != 0.0) {
+        double percent = (now - before) / before * 100.0;
+        change = (percent >= 0.0 ? "+" : "") + FormatNumber(percent, 1) + "%";
+        // Within 5% is treated as noise
+        if (percent > 5.0 || percent < -5.0) {
+            verdict = ((percent > 0.0) == higherIsBetter) ? "  ✓ better" : "  ✗ worse";
+        }
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-28s %14s %14s %9s", name,
+                  FormatNumber(before, 1).c_str(), FormatNumber(now, 1).c_str(), change.c_str());
+    std::cout << line << verdict << std::endl;
+}
+
+void PrintComparison(const JsonValue& current, const JsonValue& baseline)
+{
+    std::cout << "Comparison with baseline '" << baseline.GetString({ "label" }) << "' ("
+              << baseline.GetString({ "startedAt" }) << "):" << std::endl;
+
+    char header[256];
+    std::snprintf(header, sizeof(header), "  %-28s %14s %14s %9s", "metric", "baseline", "current", "change");
+    std::cout << header << std::endl;
+
+    PrintDelta("jobsPerHour", FindPath(current, { "summary", "overall", "jobsPerHour" }),
+               FindPath(baseline, { "summary", "overall", "jobsPerHour" }), true);
+    PrintDelta("latencyMs p50", FindPath(current, { "summary", "overall", "latencyMs", "p50" }),
+               FindPath(baseline, { "summary", "overall", "latencyMs", "p50" }), false);
+    PrintDelta("latencyMs p95", FindPath(current, { "summary", "overall", "latencyMs", "p95" }),
+               FindPath(baseline, { "summary", "overall", "latencyMs", "p95" }), false);
+    PrintDelta("peakRssBytes", FindPath(current, { "process", "peakRssBytes" }),
+               FindPath(baseline, { "process", "peakRssBytes" }), false);
+
+    const JsonValue* stages = current.Find("summary");
+    stages = stages ? stages->Find("overall") : nullptr;
+    stages = stages ? stages->Find("stagesMs") : nullptr;
+    if (stages == nullptr || !stages->IsObject()) {
+        return;
+    }
+    for (size_t i = 0; i < stages->Size(); ++i) {
+        const char* stage = stages->KeyAt(i).c_str();
+        std::string name = stages->KeyAt(i) + " p50";
+        PrintDelta(name.c_str(), FindPath(current, { "summary", "overall", "stagesMs", stage, "p50" }),
+                   FindPath(baseline, { "summary", "overall", "stagesMs", stage, "p50" }), false);
+    }
+}
+
+// Output path for a job: <out>/<iteration>-<stem><suffix>
+static std::string MakeOutputPath(const std::string& directory, int iteration, const std::string& inputPath,
+                                  const std::string& suffix)
+{
+    std::string stem = fs::u8path(inputPath).stem().u8string();
+    return (fs::u8path(directory) / fs::u8path(std::to_string(iteration) + "-" + stem + suffix)).u8string();
+}
+
+static std::string CurrentUtcTime()
+{
+    std::time_t now = std::time(nullptr);
+    std::tm utc {};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+BenchmarkRunner::BenchmarkRunner(BenchmarkOptions options)
+    : m_options(std::move(options))
+    , m_ws(m_ioc)
+    , m_sampleTimer(m_ioc)
+    , m_result(nullptr)
+    , m_nextJob(0)
+    , m_ending(false)
+    , m_closed(false)
+{
+}
+
+bool BenchmarkRunner::Run(const std::vector<CorpusFile>& corpus, BenchmarkResult& result, std::string& error)
+{
+    m_result = &result;
+    m_startedAt = Clock::now();
+    result.label = m_options.label;
+    result.startedAt = CurrentUtcTime();
+
+    std::error_code fsError;
+    fs::create_directories(fs::u8path(m_options.outputDirectory), fsError);
+    if (fsError) {
+        error = "Cannot create " + m_options.outputDirectory + ": " + fsError.message();
+        return false;
+    }
+
+    for (int iteration = 1; iteration <= m_options.repeat; ++iteration) {
+        for (const CorpusFile& file : corpus) {
+            BenchmarkJob job;
+            job.name = file.name;
+            job.type = file.isIfc ? "ifc_to_pln" : "pln_to_ifc";
+            job.inputPath = file.path;
+            job.outputPath = MakeOutputPath(m_options.outputDirectory, iteration, file.path, file.isIfc ? ".pln" : ".ifc");
+            job.iteration = iteration;
+            job.inputBytes = file.bytes;
+            m_pending.push_back(job);
+        }
+    }
+
+    // Connect and read the hello synchronously; everything after runs on the io_context
+    beast::error_code ec;
+    tcp::resolver resolver(m_ioc);
+    auto endpoints = resolver.resolve(m_options.host, std::to_string(m_options.port), ec);
+    if (!ec) {
+        beast::get_lowest_layer(m_ws).expires_after(std::chrono::seconds(10));
+        beast::get_lowest_layer(m_ws).connect(endpoints, ec);
+    }
+    if (!ec) {
+        beast::get_lowest_layer(m_ws).expires_never();
+        m_ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        m_ws.handshake(m_options.host + ":" + std::to_string(m_options.port), "/", ec);
+    }
+    if (!ec) {
+        m_ws.read(m_buffer, ec);
+    }
+    if (ec) {
+        error = "Cannot reach the plugin at " + m_options.host + ":" + std::to_string(m_options.port) + ": " + ec.message();
+        return false;
+    }
+
+    JsonValue hello;
+    std::string parseError;
+    if (JsonParser::Parse(beast::buffers_to_string(m_buffer.data()), hello, parseError) &&
+        hello.GetString({ "type" }) == "hello") {
+        result.workerId = hello.GetString({ "workerId" });
+        result.archicadVersion = hello.GetString({ "archicadVersion" });
+    }
+    m_buffer.consume(m_buffer.size());
+
+    Send("{\"command\":\"benchmark\",\"action\":\"begin\"}");
+    DoRead();
+    m_ioc.run();
+
+    if (!m_error.empty()) {
+        error = m_error;
+        return false;
+    }
+    return true;
+}
+
+void BenchmarkRunner::Send(std::string message)
+{
+    if (m_closed) {
+        return;
+    }
+    m_writeQueue.push_back(std::move(message));
+    if (m_writeQueue.size() == 1) {
+        DoWrite();
+    }
+}
+
+void BenchmarkRunner::DoWrite()
+{
+    m_ws.async_write(net::buffer(m_writeQueue.front()), [this](beast::error_code ec, std::size_t) {
+        if (ec) {
+            return Shutdown("write: " + ec.message());
+        }
+        m_writeQueue.pop_front();
+        if (!m_writeQueue.empty() && !m_closed) {
+            DoWrite();
+        }
+    });
+}
+
+void BenchmarkRunner::DoRead()
+{
+    m_ws.async_read(m_buffer, [this](beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (!m_closed) {
+                Shutdown("read: " + ec.message());
+            }
+            return;
+        }
+        std::string text = beast::buffers_to_string(m_buffer.data());
+        m_buffer.consume(m_buffer.size());
+        HandleMessage(text);
+        if (!m_closed) {
+            DoRead();
+        }
+    });
+}
+
+void BenchmarkRunner::ScheduleSample()
+{
+    m_sampleTimer.expires_after(std::chrono::milliseconds(m_options.sampleIntervalMs));
+    m_sampleTimer.async_wait([this](beast::error_code ec) {
+        if (ec || m_closed || m_ending) {
+            return;
+        }
+        Send("{\"command\":\"benchmark\",\"action\":\"sample\"}");
+        CheckTimeouts();
+        ScheduleSample();
+    });
+}
+
+void BenchmarkRunner::HandleMessage(const std::string& text)
+{
+    JsonValue message;
+    std::string parseError;
+    if (!JsonParser::Parse(text, message, parseError)) {
+        LOG_WARN("✗ Unparsable message from plugin: " << parseError);
+        return;
+    }
+
+    std::string type = message.GetString({ "type" });
+    std::string jobId = message.GetString({ "jobId" });
+    if (type == "benchmark") {
+        HandleBenchmarkReply(message, text);
+    } else if (type == "completed") {
+        FinishJob(jobId, "completed", "", &message);
+    } else if (type == "error") {
+        FinishJob(jobId, "error", message.GetString({ "error", "message" }), &message);
+    } else if (type == "progress") {
+        std::string status = message.GetString({ "status" });
+        if (status == "error" || status == "cancelled") {
+            FinishJob(jobId, status, message.GetString({ "message" }), &message);
+        }
+    }
+}
+
+void BenchmarkRunner::HandleBenchmarkReply(const JsonValue& message, const std::string& text)
+{
+    const JsonValue* process = message.Find("process");
+    uint64_t rss = 0;
+    if (process != nullptr) {
+        rss = static_cast<uint64_t>(process->Find("rssBytes") ? process->Find("rssBytes")->AsInt() : 0);
+        uint64_t peak = static_cast<uint64_t>(process->Find("peakRssBytes") ? process->Find("peakRssBytes")->AsInt() : 0);
+        m_result->peakRssBytes = std::max({ m_result->peakRssBytes, rss, peak });
+    }
+
+    std::string action = message.GetString({ "action" });
+    if (action == "begin") {
+        m_result->rssStartBytes = rss;
+        m_result->warmSession = message.Find("warmSession") && message.Find("warmSession")->AsBool();
+        if (m_result->archicadVersion.empty()) {
+            m_result->archicadVersion = message.GetString({ "archicadVersion" });
+        }
+
+        LOG_INFO("✓ Benchmark started: " << m_pending.size() << " jobs, concurrency " << m_options.concurrency);
+        m_startedAt = Clock::now();
+        SubmitJobs();
+        ScheduleSample();
+    } else if (action == "end") {
+        m_result->rssEndBytes = rss;
+        m_result->pluginReport = text;
+        m_closed = true;
+        m_sampleTimer.cancel();
+        m_ws.async_close(websocket::close_code::normal, [](beast::error_code) {});
+    }
+}
+
+void BenchmarkRunner::FinishJob(const std::string& jobId, const std::string& status, const std::string& message,
+                                const JsonValue* event)
+{
+    auto it = std::find_if(m_running.begin(), m_running.end(),
+                           [&jobId](const BenchmarkJob& job) { return job.jobId == jobId; });
+    if (it == m_running.end()) {
+        return;
+    }
+
+    BenchmarkJob job = *it;
+    m_running.erase(it);
+    job.status = status;
+    job.message = message;
+    job.latencyMs = MillisecondsSince(job.submittedAt);
+
+    const JsonValue* timings = event ? event->Find("timingsMs") : nullptr;
+    if (timings != nullptr && timings->IsObject()) {
+        for (size_t i = 0; i < timings->Size(); ++i) {
+            job.timingsMs.emplace_back(timings->KeyAt(i), timings->At(i).AsNumber());
+        }
+        // A cached result never opens the input
+        job.cached = status == "completed" &&
+            std::none_of(job.timingsMs.begin(), job.timingsMs.end(),
+                         [](const std::pair<std::string, double>& timing) { return timing.first == "open"; });
+    }
+
+    if (status == "completed") {
+        std::error_code ec;
+        job.outputBytes = fs::file_size(fs::u8path(job.outputPath), ec);
+        if (ec) {
+            job.outputBytes = 0;
+        }
+        LOG_INFO("✓ " << job.name << " (" << job.type << ", pass " << job.iteration << "): "
+                 << FormatNumber(job.latencyMs / 1000.0, 1) << " s, " << job.outputBytes << " bytes");
+
+        // Round trip: the PLN just written goes back through the exporter
+        if (m_options.roundTrip && job.type == "ifc_to_pln" && job.outputBytes > 0) {
+            BenchmarkJob back;
+            back.name = job.name;
+            back.type = "pln_to_ifc";
+            back.inputPath = job.outputPath;
+            back.outputPath = MakeOutputPath(m_options.outputDirectory, job.iteration, job.outputPath, ".roundtrip.ifc");
+            back.iteration = job.iteration;
+            back.inputBytes = job.outputBytes;
+            m_pending.push_front(back);
+        }
+    } else {
+        LOG_WARN("✗ " << job.name << " (" << job.type << ", pass " << job.iteration << "): "
+                 << status << (message.empty() ? "" : " - " + message));
+    }
+
+    m_result->jobs.push_back(job);
+    SubmitJobs();
+}
+
+void BenchmarkRunner::SubmitJobs()
+{
+    while (!m_pending.empty() && static_cast<int>(m_running.size()) < m_options.concurrency) {
+        BenchmarkJob job = m_pending.front();
+        m_pending.pop_front();
+        job.jobId = "bench-" + std::to_string(++m_nextJob);
+        job.submittedAt = Clock::now();
+
+        JsonWriter writer;
+        writer.BeginObject()
+              .Field("command", "start_conversion")
+              .Field("jobId", job.jobId)
+              .Field(job.type == "pln_to_ifc" ? "plnPath" : "ifcPath", job.inputPath)
+              .Field("outputPath", job.outputPath);
+        if (job.type == "pln_to_ifc" && !m_options.translator.empty()) {
+            writer.Field("translator", m_options.translator);
+        }
+        writer.EndObject();
+
+        m_running.push_back(job);
+        Send(writer.ToString());
+    }
+
+    if (m_pending.empty() && m_running.empty() && !m_ending) {
+        m_ending = true;
+        m_result->wallMs = MillisecondsSince(m_startedAt);
+        m_sampleTimer.cancel();
+        Send("{\"command\":\"benchmark\",\"action\":\"end\"}");
+    }
+}
+
+void BenchmarkRunner::CheckTimeouts()
+{
+    Clock::time_point deadline = Clock::now() - std::chrono::seconds(m_options.jobTimeoutSeconds);
+    std::vector<std::string> expired;
+    for (const BenchmarkJob& job : m_running) {
+        if (job.submittedAt < deadline) {
+            expired.push_back(job.jobId);
+        }
+    }
+    for (const std::string& jobId : expired) {
+        Send("{\"command\":\"cancel_job\",\"jobId\":\"" + jobId + "\"}");
+        FinishJob(jobId, "timeout", "No final event within " + std::to_string(m_options.jobTimeoutSeconds) + " s", nullptr);
+    }
+}
+
+void BenchmarkRunner::Shutdown(const std::string& reason)
+{
+    if (m_closed) {
+        return;
+    }
+    m_closed = true;
+    m_error = "Connection to the plugin lost (" + reason + ")";
+    m_sampleTimer.cancel();
+
+    // Whatever was still in flight did not finish
+    for (BenchmarkJob& job : m_running) {
+        job.status = "error";
+        job.message = "Connection lost";
+        job.latencyMs = MillisecondsSince(job.submittedAt);
+        m_result->jobs.push_back(job);
+    }
+    m_running.clear();
+    if (!m_ending) {
+        m_result->wallMs = MillisecondsSince(m_startedAt);
+    }
+
+    beast::error_code ec;
+    beast::get_lowest_layer(m_ws).socket().close(ec);
+}
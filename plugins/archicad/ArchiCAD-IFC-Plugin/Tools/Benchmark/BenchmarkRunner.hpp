@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARK_RUNNER_HPP
+#define BENCHMARK_RUNNER_HPP
+
+#include "SyntheticCorpus.hpp"
+#include "WebSocketServer.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+
+class JsonValue;
+
+/**
+ * @brief Settings of one benchmark run
+ */
+struct BenchmarkOptions {
+    std::string host = "127.0.0.1";
+    int port = 8081;
+    std::string outputDirectory;        // Where converted files are written
+    std::string label;                  // Free text, e.g. the commit under test
+    std::string translator;             // IFC translator for PLN -> IFC ("" = plugin default)
+    int repeat = 1;                     // Passes over the corpus
+    int concurrency = 1;                // Jobs submitted at a time
+    bool roundTrip = false;             // Convert every IFC -> PLN result back to IFC
+    int sampleIntervalMs = 2000;        // Memory sampling period
+    int jobTimeoutSeconds = 3600;       // A job running longer is cancelled
+};
+
+/**
+ * @brief One conversion of the run and what was measured for it
+ */
+struct BenchmarkJob {
+    std::string jobId;
+    std::string name;                   // Corpus file name
+    std::string type;                   // "pln_to_ifc" or "ifc_to_pln"
+    std::string inputPath;
+    std::string outputPath;
+    int iteration = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    std::string status;                 // "completed", "error", "cancelled" or "timeout"
+    std::string message;
+    bool cached = false;                // Served from the result cache (no open stage)
+    double latencyMs = 0.0;             // Submitted until the final event arrived
+    std::vector<std::pair<std::string, double>> timingsMs;  // Plugin stage timings
+    std::chrono::steady_clock::time_point submittedAt;
+};
+
+/**
+ * @brief Everything a run produced, written as the results document
+ */
+struct BenchmarkResult {
+    std::string label;
+    std::string startedAt;              // UTC, ISO 8601
+    std::string workerId;
+    std::string archicadVersion;
+    bool warmSession = false;
+    double wallMs = 0.0;                // First submission until the last job finished
+    uint64_t rssStartBytes = 0;
+    uint64_t rssEndBytes = 0;
+    uint64_t peakRssBytes = 0;          // Highest sample or the plugin's own peak
+    std::string pluginReport;           // The plugin's "end" reply, JSON
+    std::vector<BenchmarkJob> jobs;
+
+    /**
+     * @brief Results document: run info, every job and a summary per job type
+     *
+     * The summary has count, completed, jobsPerHour, latencyMs and per-stage
+     * p50/p95, so files from different commits or Archicad versions can be
+     * compared key by key.
+     */
+    std::string ToJson() const;
+};
+
+/**
+ * @brief Print the relative change of the headline numbers against a baseline
+ * @param current Parsed results document of the run just finished
+ * @param baseline Parsed results document of an earlier run
+ */
+void PrintComparison(const JsonValue& current, const JsonValue& baseline);
+
+/**
+ * @brief Replays a corpus through a plugin's WebSocket port
+ *
+ * Submits start_conversion jobs exactly like a backend would, keeping up to
+ * `concurrency` jobs in flight, and times each one until its final event.
+ * The plugin's `benchmark` command brackets the run: "begin" clears its
+ * stage statistics, periodic "sample" requests track its memory and "end"
+ * returns the statistics for the run. Single-threaded; Run blocks until all
+ * jobs have finished.
+ */
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(BenchmarkOptions options);
+
+    /**
+     * @brief Run every corpus file `repeat` times
+     * @param error Receives the reason if the plugin could not be reached
+     * @return false if the run could not start; failed jobs are reported in the result
+     */
+    bool Run(const std::vector<CorpusFile>& corpus, BenchmarkResult& result, std::string& error);
+
+private:
+    void Send(std::string message);
+    void DoWrite();
+    void DoRead();
+    void ScheduleSample();
+    void HandleMessage(const std::string& text);
+    void HandleBenchmarkReply(const JsonValue& message, const std::string& text);
+    void FinishJob(const std::string& jobId, const std::string& status, const std::string& message,
+                   const JsonValue* event);
+    void SubmitJobs();
+    void CheckTimeouts();
+    void Shutdown(const std::string& reason);
+
+    BenchmarkOptions m_options;
+    net::io_context m_ioc;
+    websocket::stream<beast::tcp_stream> m_ws;
+    net::steady_timer m_sampleTimer;
+    beast::flat_buffer m_buffer;
+    std::deque<std::string> m_writeQueue;
+
+    std::deque<BenchmarkJob> m_pending;
+    std::vector<BenchmarkJob> m_running;
+    BenchmarkResult* m_result;
+    std::chrono::steady_clock::time_point m_startedAt;
+    int m_nextJob;
+    bool m_ending;
+    bool m_closed;
+    std::string m_error;
+};
+
+#endif // BENCHMARK_RUNNER_HPP
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkRunner.hpp"
+#include "SyntheticCorpus.hpp"
+#include "JsonParser.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--url <host:port>] [--corpus <dir>] [--synthesize <dir>] [options]" << std::endl
+              << std::endl
+              << "  --url <host:port>     Plugin (or coordinator) WebSocket port (default: 127.0.0.1:8081)" << std::endl
+              << "  --corpus <dir>        Directory with the .pln/.ifc/.ifczip files to convert" << std::endl
+              << "  --synthesize <dir>    Write synthetic small/medium/large IFC files first;" << std::endl
+              << "                        used as the corpus when --corpus is not given" << std::endl
+              << "  --out-dir <dir>       Where converted files go (default: <temp>/ifc-plugin-benchmark)" << std::endl
+              << "  --output <file>       Results document (default: benchmark-results.json)" << std::endl
+              << "  --repeat <n>          Passes over the corpus (default: 1)" << std::endl
+              << "  --concurrency <n>     Jobs submitted at a time (default: 1)" << std::endl
+              << "  --round-trip          Convert every IFC -> PLN result back to IFC" << std::endl
+              << "  --translator <name>   IFC translator for PLN -> IFC jobs" << std::endl
+              << "  --label <text>        Stored in the results, e.g. the commit under test" << std::endl
+              << "  --baseline <file>     Results of an earlier run to compare with" << std::endl
+              << "  --timeout <seconds>   Cancel a job running longer (default: 3600)" << std::endl
+              << "  --log-level <level>   trace, debug, info, warn, error or off (default: info)" << std::endl
+              << std::endl
+              << "The plugin must be running with its WebSocket server started. Set" << std::endl
+              << "ARCHICAD_RESULT_CACHE_MB=0 on the plugin to time real conversions on every pass." << std::endl;
+}
+
+static bool ReadFile(const std::string& path, std::string& text)
+{
+    std::ifstream in(fs::u8path(path), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    options.outputDirectory = (fs::temp_directory_path() / "ifc-plugin-benchmark").u8string();
+
+    LoggerConfig logConfig;
+    std::string corpusDirectory;
+    std::string synthesizeDirectory;
+    std::string outputFile = "benchmark-results.json";
+    std::string baselineFile;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--url") == 0 && i + 1 < argc) {
+            std::string url = argv[++i];
+            if (url.rfind("ws://", 0) == 0) {
+                url = url.substr(5);
+            }
+            size_t colon = url.rfind(':');
+            if (colon == std::string::npos || colon == 0) {
+                std::cerr << "✗ Invalid address: " << argv[i] << std::endl;
+                return 1;
+            }
+            options.host = url.substr(0, colon);
+            options.port = std::atoi(url.c_str() + colon + 1);
+        } else if (std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            corpusDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--synthesize") == 0 && i + 1 < argc) {
+            synthesizeDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            options.outputDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+            options.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--round-trip") == 0) {
+            options.roundTrip = true;
+        } else if (std::strcmp(argv[i], "--translator") == 0 && i + 1 < argc) {
+            options.translator = argv[++i];
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            options.label = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselineFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            options.jobTimeoutSeconds = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            if (!LogLevelFromString(argv[++i], logConfig.level)) {
+                std::cerr << "✗ Invalid log level: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (options.port <= 0 || options.port > 65535) {
+        std::cerr << "✗ Invalid port: " << options.port << std::endl;
+        return 1;
+    }
+
+    if (!synthesizeDirectory.empty()) {
+        std::string error;
+        if (!SynthesizeCorpus(synthesizeDirectory, error)) {
+            std::cerr << "✗ " << error << std::endl;
+            return 1;
+        }
+        std::cout << "✓ Synthetic corpus written to " << synthesizeDirectory << std::endl;
+        if (corpusDirectory.empty()) {
+            corpusDirectory = synthesizeDirectory;
+        }
+    }
+
+    if (corpusDirectory.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<CorpusFile> corpus = ScanCorpus(corpusDirectory);
+    if (corpus.empty()) {
+        std::cerr << "✗ No .pln, .ifc or .ifczip files in " << corpusDirectory << std::endl;
+        return 1;
+    }
+
+    // Read the baseline up front so a typo does not surface after an hour of converting
+    JsonValue baseline;
+    if (!baselineFile.empty()) {
+        std::string text, error;
+        if (!ReadFile(baselineFile, text) || !JsonParser::Parse(text, baseline, error)) {
+            std::cerr << "✗ Cannot read baseline " << baselineFile << (error.empty() ? "" : ": " + error) << std::endl;
+            return 1;
+        }
+    }
+
+    Logger::Start(logConfig);
+
+    BenchmarkRunner runner(options);
+    BenchmarkResult result;
+    std::string error;
+    bool ok = runner.Run(corpus, result, error);
+    Logger::Stop();
+
+    if (!ok) {
+        std::cerr << "✗ " << error << std::endl;
+        if (result.jobs.empty()) {
+            return 1;
+        }
+    }
+
+    std::string json = result.ToJson();
+    std::ofstream out(fs::u8path(outputFile), std::ios::binary | std::ios::trunc);
+    out << json << "\n";
+    out.close();
+    if (!out) {
+        std::cerr << "✗ Cannot write " << outputFile << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Results written to " << outputFile << std::endl;
+
+    JsonValue current;
+    std::string parseError;
+    if (JsonParser::Parse(json, current, parseError)) {
+        const JsonValue* overall = current.Find("summary") ? current.Find("summary")->Find("overall") : nullptr;
+        if (overall != nullptr) {
+            std::cout << "  jobs: " << overall->Find("completed")->AsInt() << "/" << overall->Find("count")->AsInt()
+                      << " completed, " << overall->Find("jobsPerHour")->AsNumber() << " jobs/hour, peak RSS "
+                      << result.peakRssBytes / (1024 * 1024) << " MiB" << std::endl;
+        }
+        if (!baselineFile.empty()) {
+            PrintComparison(current, baseline);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
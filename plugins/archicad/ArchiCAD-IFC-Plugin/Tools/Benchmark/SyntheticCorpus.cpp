@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SyntheticCorpus.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+// Corpus written by --synthesize: name and element count per size class
+static const struct {
+    const char* name;
+    int elements;
+} kSizeClasses[] = {
+    { "synthetic-small.ifc", 100 },
+    { "synthetic-medium.ifc", 2000 },
+    { "synthetic-large.ifc", 20000 },
+};
+
+// Deterministic 22-character IFC GlobalId from a counter
+static std::string MakeGlobalId(uint64_t counter)
+{
+    static const char kAlphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
+
+    // Counter in the last 11 characters, a hash of it in front; the first
+    // character carries only 2 bits and stays '0'
+    std::string id(22, '0');
+    uint64_t hash = counter * 0x9E3779B97F4A7C15ull;
+    for (int i = 21; i >= 11; --i) {
+        id[i] = kAlphabet[counter & 63];
+        counter >>= 6;
+    }
+    for (int i = 10; i >= 1; --i) {
+        id[i] = kAlphabet[hash & 63];
+        hash >>= 6;
+    }
+    return id;
+}
+
+bool WriteSyntheticIfc(const std::string& path, int elementCount, std::string& error)
+{
+    std::ofstream out(fs::u8path(path), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "Cannot create " + path;
+        return false;
+    }
+
+    // GlobalIds 1-7 are the spatial structure and its relationships
+    std::string ids[7];
+    for (uint64_t i = 0; i < 7; ++i) {
+        ids[i] = MakeGlobalId(i + 1);
+    }
+    uint64_t guid = 8;
+
+    out << "ISO-10303-21;\n"
+        << "HEADER;\n"
+        << "FILE_DESCRIPTION(('ViewDefinition [ReferenceView]'),'2;1');\n"
+        << "FILE_NAME('" << fs::u8path(path).filename().u8string() << "','2025-01-01T00:00:00',(''),(''),"
+        << "'ConversionBenchmark','ConversionBenchmark','');\n"
+        << "FILE_SCHEMA(('IFC4'));\n"
+        << "ENDSEC;\n"
+        << "DATA;\n"
+        << "#1=IFCPERSON($,'Benchmark',$,$,$,$,$,$);\n"
+        << "#2=IFCORGANIZATION($,'Benchmark',$,$,$);\n"
+        << "#3=IFCPERSONANDORGANIZATION(#1,#2,$);\n"
+        << "#4=IFCAPPLICATION(#2,'1.0','ConversionBenchmark','ConversionBenchmark');\n"
+        << "#5=IFCOWNERHISTORY(#3,#4,$,.ADDED.,$,$,$,1735689600);\n"
+        << "#6=IFCSIUNIT(*,.LENGTHUNIT.,.MILLI.,.METRE.);\n"
+        << "#7=IFCSIUNIT(*,.AREAUNIT.,$,.SQUARE_METRE.);\n"
+        << "#8=IFCSIUNIT(*,.VOLUMEUNIT.,$,.CUBIC_METRE.);\n"
+        << "#9=IFCSIUNIT(*,.PLANEANGLEUNIT.,$,.RADIAN.);\n"
+        << "#10=IFCUNITASSIGNMENT((#6,#7,#8,#9));\n"
+        << "#11=IFCCARTESIANPOINT((0.,0.,0.));\n"
+        << "#12=IFCDIRECTION((0.,0.,1.));\n"
+        << "#13=IFCDIRECTION((1.,0.,0.));\n"
+        << "#14=IFCAXIS2PLACEMENT3D(#11,#12,#13);\n"
+        << "#15=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#14,$);\n"
+        << "#16=IFCGEOMETRICREPRESENTATIONSUBCONTEXT('Body','Model',*,*,*,*,#15,$,.MODEL_VIEW.,$);\n"
+        << "#17=IFCPROJECT('" << ids[0] << "',#5,'Benchmark',$,$,$,$,(#15),#10);\n"
+        << "#18=IFCLOCALPLACEMENT($,#14);\n"
+        << "#19=IFCSITE('" << ids[1] << "',#5,'Site',$,$,#18,$,$,.ELEMENT.,$,$,$,$,$);\n"
+        << "#20=IFCLOCALPLACEMENT(#18,#14);\n"
+        << "#21=IFCBUILDING('" << ids[2] << "',#5,'Building',$,$,#20,$,$,.ELEMENT.,$,$,$);\n"
+        << "#22=IFCLOCALPLACEMENT(#20,#14);\n"
+        << "#23=IFCBUILDINGSTOREY('" << ids[3] << "',#5,'Ground Floor',$,$,#22,$,$,.ELEMENT.,0.);\n"
+        << "#24=IFCRELAGGREGATES('" << ids[4] << "',#5,$,$,#17,(#19));\n"
+        << "#25=IFCRELAGGREGATES('" << ids[5] << "',#5,$,$,#19,(#21));\n"
+        << "#26=IFCRELAGGREGATES('" << ids[6] << "',#5,$,$,#21,(#23));\n"
+        // One box body shared by all elements: 600 x 600 x 3000 mm
+        << "#27=IFCCARTESIANPOINT((0.,0.));\n"
+        << "#28=IFCAXIS2PLACEMENT2D(#27,$);\n"
+        << "#29=IFCRECTANGLEPROFILEDEF(.AREA.,$,#28,600.,600.);\n"
+        << "#30=IFCEXTRUDEDAREASOLID(#29,#14,#12,3000.);\n";
+
+    // Elements on a square grid with 1 m spacing
+    int columns = 1;
+    while (columns * columns < elementCount) {
+        ++columns;
+    }
+
+    int next = 31;
+    std::vector<int> elements;
+    elements.reserve(static_cast<size_t>(elementCount));
+    for (int i = 0; i < elementCount; ++i) {
+        int point = next++;
+        int axis = next++;
+        int placement = next++;
+        int representation = next++;
+        int shape = next++;
+        int element = next++;
+
+        out << "#" << point << "=IFCCARTESIANPOINT((" << (i % columns) * 1000 << ".," << (i / columns) * 1000 << ".,0.));\n"
+            << "#" << axis << "=IFCAXIS2PLACEMENT3D(#" << point << ",$,$);\n"
+            << "#" << placement << "=IFCLOCALPLACEMENT(#22,#" << axis << ");\n"
+            << "#" << representation << "=IFCSHAPEREPRESENTATION(#16,'Body','SweptSolid',(#30));\n"
+            << "#" << shape << "=IFCPRODUCTDEFINITIONSHAPE($,$,(#" << representation << "));\n"
+            << "#" << element << "=IFCBUILDINGELEMENTPROXY('" << MakeGlobalId(guid++) << "',#5,'Proxy " << (i + 1)
+            << "',$,$,#" << placement << ",#" << shape << ",$,.ELEMENT.);\n";
+        elements.push_back(element);
+    }
+
+    if (!elements.empty()) {
+        out << "#" << next << "=IFCRELCONTAINEDINSPATIALSTRUCTURE('" << MakeGlobalId(guid++) << "',#5,$,$,(";
+        for (size_t i = 0; i < elements.size(); ++i) {
+            out << (i > 0 ? ",#" : "#") << elements[i];
+        }
+        out << "),#23);\n";
+    }
+
+    out << "ENDSEC;\n"
+        << "END-ISO-10303-21;\n";
+
+    out.close();
+    if (!out) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool SynthesizeCorpus(const std::string& directory, std::string& error)
+{
+    std::error_code ec;
+    fs::create_directories(fs::u8path(directory), ec);
+    if (ec) {
+        error = "Cannot create " + directory + ": " + ec.message();
+        return false;
+    }
+
+    for (const auto& sizeClass : kSizeClasses) {
+        std::string path = (fs::u8path(directory) / sizeClass.name).u8string();
+        if (!WriteSyntheticIfc(path, sizeClass.elements, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<CorpusFile> ScanCorpus(const std::string& directory)
+{
+    std::vector<CorpusFile> files;
+
+    std::error_code ec;
+    for (fs::directory_iterator it(fs::u8path(directory), ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+
+        std::string extension = it->path().extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension != ".pln" && extension != ".ifc" && extension != ".ifczip") {
+            continue;
+        }
+
+        CorpusFile file;
+        file.path = fs::absolute(it->path(), ec).u8string();
+        file.name = it->path().filename().u8string();
+        file.bytes = it->file_size(ec);
+        file.isIfc = extension != ".pln";
+        files.push_back(file);
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const CorpusFile& a, const CorpusFile& b) { return a.name < b.name; });
+    return files;
+}
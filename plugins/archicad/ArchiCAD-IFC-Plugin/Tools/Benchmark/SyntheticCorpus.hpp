@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYNTHETIC_CORPUS_HPP
+#define SYNTHETIC_CORPUS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief One input file of a benchmark corpus
+ */
+struct CorpusFile {
+    std::string path;               // UTF-8 path
+    std::string name;               // File name, used as the result key
+    uint64_t bytes = 0;             // Size on disk
+    bool isIfc = false;             // .ifc/.ifczip (IFC -> PLN), otherwise .pln (PLN -> IFC)
+};
+
+/**
+ * @brief Write an IFC4 file with a grid of extruded proxy elements
+ * @param path UTF-8 output path
+ * @param elementCount Number of IfcBuildingElementProxy instances
+ * @param error Receives the reason on failure
+ *
+ * Every element has its own placement and a box body; all of them are
+ * contained in one storey, so Archicad imports them as separate objects.
+ */
+bool WriteSyntheticIfc(const std::string& path, int elementCount, std::string& error);
+
+/**
+ * @brief Write the standard small/medium/large synthetic corpus
+ * @param directory UTF-8 directory, created if missing
+ * @param error Receives the reason on failure
+ */
+bool SynthesizeCorpus(const std::string& directory, std::string& error);
+
+/**
+ * @brief List the .pln, .ifc and .ifczip files in a directory, sorted by name
+ */
+std::vector<CorpusFile> ScanCorpus(const std::string& directory);
+
+#endif // SYNTHETIC_CORPUS_HPP
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Counts heap allocations made through the global operator new
+ *
+ * The load test replaces operator new/delete for the whole executable.
+ * Threads marked with ExcludeThisThread() (the load clients) are not
+ * counted, so the count is the server side's allocations only.
+ */
+class AllocationCounter {
+public:
+    /**
+     * @brief Allocations on counted threads since the program started
+     */
+    static uint64_t Count();
+
+    /**
+     * @brief Stop counting allocations made on the calling thread
+     */
+    static void ExcludeThisThread();
+};
+
+#endif // ALLOCATION_COUNTER_HPP
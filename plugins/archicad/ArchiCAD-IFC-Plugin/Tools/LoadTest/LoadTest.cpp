@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LoadTest.hpp"
+#include "AllocationCounter.hpp"
+#include "JsonParser.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+LatencySummary LatencySummary::FromSamples(std::vector<double> samplesUs)
+{
+    LatencySummary summary;
+    summary.count = samplesUs.size();
+    if (samplesUs.empty()) {
+        return summary;
+    }
+
+    // Nearest-rank percentiles
+    std::sort(samplesUs.begin(), samplesUs.end());
+    auto at = [&samplesUs](double fraction) {
+        size_t rank = static_cast<size_t>(fraction * static_cast<double>(samplesUs.size()) + 0.999999);
+        return samplesUs[std::min(samplesUs.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+    summary.p50Us = at(0.50);
+    summary.p95Us = at(0.95);
+    summary.p99Us = at(0.99);
+    summary.maxUs = samplesUs.back();
+    return summary;
+}
+
+/**
+ * @brief Latency samples and a completion count shared by the client threads
+ */
+class SampleCollector {
+public:
+    void Add(double sampleUs)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_samples.push_back(sampleUs);
+        m_lastSampleAt = Clock::now();
+    }
+
+    void Done()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_done;
+        m_changed.notify_all();
+    }
+
+    // Wait until `count` Done() calls, or until nothing happened for `idle`
+    bool WaitFor(size_t count, std::chrono::milliseconds idle)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_done < count) {
+            size_t before = m_done + m_samples.size();
+            m_changed.wait_for(lock, idle, [this, count]() { return m_done >= count; });
+            if (m_done < count && m_done + m_samples.size() == before) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<double> TakeSamples()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::move(m_samples);
+    }
+
+    size_t GetDone()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_done;
+    }
+
+    Clock::time_point GetLastSampleAt()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastSampleAt;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<double> m_samples;
+    size_t m_done = 0;
+    Clock::time_point m_lastSampleAt;
+};
+
+/**
+ * @brief io_context and threads running the load clients
+ */
+class ClientPool {
+public:
+    explicit ClientPool(int threads)
+        : m_work(net::make_work_guard(m_ioc))
+    {
+        for (int i = 0; i < std::max(1, threads); ++i) {
+            m_threads.emplace_back([this]() {
+                AllocationCounter::ExcludeThisThread();
+                m_ioc.run();
+            });
+        }
+    }
+
+    ~ClientPool()
+    {
+        for (const std::shared_ptr<LoadClient>& client : m_clients) {
+            client->Close();
+        }
+        m_work.reset();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    std::vector<std::shared_ptr<LoadClient>>& Create(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            m_clients.push_back(std::make_shared<LoadClient>(m_ioc, i));
+        }
+        return m_clients;
+    }
+
+private:
+    net::io_context m_ioc;
+    net::executor_work_guard<net::io_context::executor_type> m_work;
+    std::vector<std::thread> m_threads;
+    std::vector<std::shared_ptr<LoadClient>> m_clients;
+};
+
+LoadClient::LoadClient(net::io_context& ioc, size_t index)
+    : m_strand(net::make_strand(ioc))
+    , m_resolver(m_strand)
+    , m_ws(m_strand)
+    , m_index(index)
+    , m_helloSeen(false)
+    , m_closed(false)
+{
+}
+
+void LoadClient::Connect(int port, ReadyHandler onReady, MessageHandler onMessage)
+{
+    m_onReady = std::move(onReady);
+    m_onMessage = std::move(onMessage);
+
+    auto self = shared_from_this();
+    m_resolver.async_resolve("127.0.0.1", std::to_string(port),
+        [self, port](beast::error_code ec, tcp::resolver::results_type results) {
+            if (ec) {
+                return self->Fail();
+            }
+            beast::get_lowest_layer(self->m_ws).expires_after(std::chrono::seconds(10));
+            beast::get_lowest_layer(self->m_ws).async_connect(results,
+                [self, port](beast::error_code ec, tcp::resolver::results_type::endpoint_type) {
+                    if (ec) {
+                        return self->Fail();
+                    }
+                    beast::get_lowest_layer(self->m_ws).expires_never();
+                    self->m_ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+                    self->m_ws.async_handshake("127.0.0.1:" + std::to_string(port), "/",
+                        [self](beast::error_code ec) {
+                            if (ec) {
+                                return self->Fail();
+                            }
+                            self->DoRead();
+                        });
+                });
+        });
+}
+
+void LoadClient::Send(std::string message)
+{
+    net::post(m_strand, [self = shared_from_this(), message = std::move(message)]() mutable {
+        if (self->m_closed) {
+            return;
+        }
+        self->m_writeQueue.push_back(std::move(message));
+        if (self->m_writeQueue.size() == 1) {
+            self->DoWrite();
+        }
+    });
+}
+
+void LoadClient::Close()
+{
+    net::post(m_strand, [self = shared_from_this()]() {
+        if (self->m_closed) {
+            return;
+        }
+        self->m_closed = true;
+        if (!self->m_helloSeen) {
+            beast::error_code ec;
+            beast::get_lowest_layer(self->m_ws).socket().close(ec);
+            return;
+        }
+        // A proper close handshake, so the server sees a client that left rather than a read error
+        beast::get_lowest_layer(self->m_ws).expires_after(std::chrono::seconds(2));
+        self->m_ws.async_close(websocket::close_code::normal, [self](beast::error_code) {});
+    });
+}
+
+void LoadClient::DoRead()
+{
+    m_ws.async_read(m_buffer, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+        if (ec) {
+            return self->Fail();
+        }
+        std::string message = beast::buffers_to_string(self->m_buffer.data());
+        self->m_buffer.consume(self->m_buffer.size());
+
+        // The hello is the first message of every session
+        if (!self->m_helloSeen) {
+            self->m_helloSeen = true;
+            if (self->m_onReady) {
+                self->m_onReady(*self, true);
+            }
+        } else if (self->m_onMessage) {
+            self->m_onMessage(*self, message);
+        }
+        self->DoRead();
+    });
+}
+
+void LoadClient::DoWrite()
+{
+    m_ws.async_write(net::buffer(m_writeQueue.front()), [self = shared_from_this()](beast::error_code ec, std::size_t) {
+        if (ec) {
+            return self->Fail();
+        }
+        self->m_writeQueue.pop_front();
+        if (!self->m_writeQueue.empty()) {
+            self->DoWrite();
+        }
+    });
+}
+
+void LoadClient::Fail()
+{
+    bool wasOpen = !m_closed;
+    m_closed = true;
+    m_writeQueue.clear();
+    if (wasOpen && !m_helloSeen && m_onReady) {
+        m_onReady(*this, false);
+    }
+}
+
+void InstallStubCommandHandler(ArchicadWebSocketServer& server)
+{
+    server.SetHelloProvider([]() {
+        return std::string("{\"type\":\"hello\",\"protocol\":1,\"workerId\":\"load-test\",\"ready\":true}");
+    });
+
+    server.SetCommandCallback([&server](const WebSocketCommand& command) {
+        if (command.type != CommandType::GetStatus) {
+            return;
+        }
+        const JsonValue* sent = command.body.Find("t");
+        JsonWriter writer;
+        writer.BeginObject()
+              .Field("type", "status")
+              .Field("jobId", command.jobId)
+              .Field("status", "processing")
+              .Field("t", static_cast<long long>(sent ? sent->AsInt() : 0))
+              .EndObject();
+        server.SendToJob(command.jobId, writer.ToPayload());
+    });
+}
+
+// A start_conversion as a backend sends it
+static const char* kStartConversion =
+    "{\"command\":\"start_conversion\",\"jobId\":\"3f2b8c1e-7d4a-4f0e-9b61-2a8e5c7d9f10\","
+    "\"plnPath\":\"C:\\\\Projects\\\\Tower\\\\Tower A - Level 12.pln\","
+    "\"outputPath\":\"C:\\\\Exports\\\\Tower A - Level 12.ifc\",\"priority\":5,\"tenant\":\"acme\","
+    "\"translator\":\"General Translator\",\"filter\":{\"storeys\":[12],\"types\":[\"Wall\",\"Slab\",\"Column\"]},"
+    "\"artifact\":{\"checksum\":true,\"compress\":false}}";
+
+ScenarioResult RunParseBenchmark(const LoadTestOptions& options)
+{
+    ScenarioResult result;
+    result.name = "command_parse";
+
+    std::string payload = kStartConversion;
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(options.parseIterations));
+
+    uint64_t allocations = AllocationCounter::Count();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.parseIterations; ++i) {
+        Clock::time_point begin = Clock::now();
+        WebSocketCommand command;
+        std::string error;
+        if (!ParseWebSocketCommand(payload, command, error)) {
+            ++result.failures;
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+    }
+    result.seconds = SecondsSince(start);
+
+    // The sample vector was reserved up front and does not count
+    result.operations = static_cast<uint64_t>(options.parseIterations);
+    result.allocationsPerOperation = static_cast<double>(AllocationCounter::Count() - allocations) /
+                                     static_cast<double>(std::max<uint64_t>(result.operations, 1));
+    result.latency = LatencySummary::FromSamples(std::move(samples));
+    return result;
+}
+
+ScenarioResult RunSerializeBenchmark(const LoadTestOptions& options)
+{
+    ScenarioResult result;
+    result.name = "progress_serialize";
+
+    std::string jobId = "3f2b8c1e-7d4a-4f0e-9b61-2a8e5c7d9f10";
+    std::string status = "processing";
+    std::string message = "Exporting IFC (element 1200 of 4800)";
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(options.parseIterations));
+
+    uint64_t allocations = AllocationCounter::Count();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.parseIterations; ++i) {
+        Clock::time_point begin = Clock::now();
+        JsonWriter writer;
+        writer.BeginObject()
+              .Field("type", "progress")
+              .Field("jobId", jobId)
+              .Field("progress", i % 100)
+              .Field("status", status)
+              .Field("message", message)
+              .EndObject();
+        JsonPayload payload = writer.ToPayload();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+    }
+    result.seconds = SecondsSince(start);
+
+    result.operations = static_cast<uint64_t>(options.parseIterations);
+    result.allocationsPerOperation = static_cast<double>(AllocationCounter::Count() - allocations) /
+                                     static_cast<double>(std::max<uint64_t>(result.operations, 1));
+    result.latency = LatencySummary::FromSamples(std::move(samples));
+    return result;
+}
+
+static std::string FormatGetStatus(const std::string& jobId)
+{
+    return "{\"command\":\"get_status\",\"jobId\":\"" + jobId + "\",\"t\":" + std::to_string(NowNs()) + "}";
+}
+
+void RunSessionStorm(const LoadTestOptions& options, int port, std::vector<ScenarioResult>& results)
+{
+    size_t sessionCount = static_cast<size_t>(std::max(1, options.sessions));
+    int commandsPerSession = std::max(1, options.commandsPerSession);
+
+    SampleCollector connects;
+    SampleCollector roundTrips;
+    std::vector<int64_t> connectStarted(sessionCount);
+    std::vector<int> sent(sessionCount, 0);
+
+    ClientPool pool(options.clientThreads);
+    std::vector<std::shared_ptr<LoadClient>>& clients = pool.Create(sessionCount);
+
+    // Each session echoes back its own job; the next command goes out when the reply arrives
+    auto onStatus = [&roundTrips, &sent, commandsPerSession](LoadClient& client, const std::string& message) {
+        JsonValue reply;
+        std::string error;
+        if (!JsonParser::Parse(message, reply, error) || reply.GetString({ "type" }) != "status") {
+            return;
+        }
+        const JsonValue* t = reply.Find("t");
+        roundTrips.Add(static_cast<double>(NowNs() - (t ? t->AsInt() : 0)) / 1000.0);
+
+        size_t index = client.GetIndex();
+        if (++sent[index] < commandsPerSession) {
+            client.Send(FormatGetStatus("storm-" + std::to_string(index)));
+        } else {
+            roundTrips.Done();
+        }
+    };
+
+    // Phase 1: every session connects at once and waits for its hello
+    uint64_t allocations = AllocationCounter::Count();
+    Clock::time_point start = Clock::now();
+    for (const std::shared_ptr<LoadClient>& client : clients) {
+        connectStarted[client->GetIndex()] = NowNs();
+        client->Connect(port,
+            [&connects, &connectStarted](LoadClient& client, bool connected) {
+                if (connected) {
+                    connects.Add(static_cast<double>(NowNs() - connectStarted[client.GetIndex()]) / 1000.0);
+                }
+                connects.Done();
+            },
+            onStatus);
+    }
+    connects.WaitFor(sessionCount, std::chrono::seconds(10));
+
+    ScenarioResult connect;
+    connect.name = "connect";
+    connect.seconds = SecondsSince(start);
+    connect.latency = LatencySummary::FromSamples(connects.TakeSamples());
+    connect.operations = connect.latency.count;
+    connect.failures = sessionCount - connect.latency.count;
+    connect.allocationsPerOperation = static_cast<double>(AllocationCounter::Count() - allocations) /
+                                      static_cast<double>(std::max<uint64_t>(connect.operations, 1));
+    results.push_back(connect);
+
+    // Phase 2: get_status round trips on all connected sessions at once
+    size_t connected = connect.operations;
+    allocations = AllocationCounter::Count();
+    start = Clock::now();
+    for (const std::shared_ptr<LoadClient>& client : clients) {
+        client->Send(FormatGetStatus("storm-" + std::to_string(client->GetIndex())));
+    }
+    roundTrips.WaitFor(connected, std::chrono::seconds(5));
+
+    ScenarioResult command;
+    command.name = "command_roundtrip";
+    command.seconds = SecondsSince(start);
+    command.latency = LatencySummary::FromSamples(roundTrips.TakeSamples());
+    command.operations = command.latency.count;
+    command.failures = connected * static_cast<uint64_t>(commandsPerSession) - std::min<uint64_t>(
+        command.operations, connected * static_cast<uint64_t>(commandsPerSession));
+    command.allocationsPerOperation = static_cast<double>(AllocationCounter::Count() - allocations) /
+                                      static_cast<double>(std::max<uint64_t>(command.operations, 1));
+    results.push_back(command);
+}
+
+ScenarioResult RunProgressFanout(const LoadTestOptions& options, ArchicadWebSocketServer& server)
+{
+    size_t subscriberCount = static_cast<size_t>(std::max(1, options.subscribers));
+    int messages = std::max(1, options.fanoutMessages);
+    int jobs = std::max(1, options.fanoutJobs);
+
+    SampleCollector subscribed;
+    SampleCollector deliveries;
+
+    ClientPool pool(options.clientThreads);
+    std::vector<std::shared_ptr<LoadClient>>& clients = pool.Create(subscriberCount);
+
+    // The send time travels in the message text
+    auto onEvent = [&subscribed, &deliveries](LoadClient&, const std::string& message) {
+        JsonValue event;
+        std::string error;
+        if (!JsonParser::Parse(message, event, error)) {
+            return;
+        }
+        std::string type = event.GetString({ "type" });
+        if (type == "subscribed") {
+            subscribed.Done();
+        } else if (type == "progress") {
+            int64_t sentAt = std::atoll(event.GetString({ "message" }).c_str());
+            deliveries.Add(static_cast<double>(NowNs() - sentAt) / 1000.0);
+        }
+    };
+
+    for (const std::shared_ptr<LoadClient>& client : clients) {
+        client->Connect(server.GetPort(),
+            [](LoadClient& client, bool connected) {
+                if (connected) {
+                    client.Send("{\"command\":\"subscribe\",\"jobId\":\"*\"}");
+                }
+            },
+            onEvent);
+    }
+    subscribed.WaitFor(subscriberCount, std::chrono::seconds(10));
+    size_t listening = subscribed.GetDone();
+
+    std::vector<std::string> jobIds;
+    for (int i = 0; i < jobs; ++i) {
+        jobIds.push_back("fanout-" + std::to_string(i));
+    }
+
+    uint64_t allocations = AllocationCounter::Count();
+    Clock::time_point start = Clock::now();
+    Clock::duration period = options.fanoutRateHz > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.fanoutRateHz))
+        : Clock::duration::zero();
+    for (int i = 0; i < messages; ++i) {
+        server.SendProgress(jobIds[static_cast<size_t>(i % jobs)], i % 100, "processing", std::to_string(NowNs()));
+        if (period > Clock::duration::zero()) {
+            std::this_thread::sleep_until(start + period * (i + 1));
+        }
+    }
+
+    // Drained once nothing has arrived for a second
+    uint64_t expected = static_cast<uint64_t>(messages) * listening;
+    deliveries.WaitFor(static_cast<size_t>(-1), std::chrono::seconds(1));
+
+    ScenarioResult result;
+    result.name = "progress_fanout";
+    std::vector<double> samples = deliveries.TakeSamples();
+    result.seconds = std::chrono::duration<double>(deliveries.GetLastSampleAt() - start).count();
+    result.operations = samples.size();
+    result.coalesced = expected - std::min<uint64_t>(expected, result.operations);
+    result.allocationsPerOperation = static_cast<double>(AllocationCounter::Count() - allocations) /
+                                     static_cast<double>(std::max<uint64_t>(result.operations, 1));
+    result.latency = LatencySummary::FromSamples(std::move(samples));
+    return result;
+}
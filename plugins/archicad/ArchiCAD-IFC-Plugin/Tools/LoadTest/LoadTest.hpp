@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOAD_TEST_HPP
+#define LOAD_TEST_HPP
+
+#include "WebSocketServer.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief Settings of a load test run
+ */
+struct LoadTestOptions {
+    int port = 18600;                   // First port to try for the server under test
+    int serverThreads = 2;              // Server I/O threads
+    int clientThreads = 2;              // Threads running the load clients
+    int sessions = 200;                 // Concurrent sessions of the session storm
+    int commandsPerSession = 50;        // Round trips per storm session
+    int subscribers = 50;               // Sessions receiving the fan-out
+    int fanoutMessages = 5000;          // Progress updates published
+    int fanoutJobs = 16;                // Jobs the updates are spread over
+    int fanoutRateHz = 0;               // Updates per second, 0 = as fast as possible
+    int parseIterations = 200000;       // Iterations of the parse/serialize microbenchmarks
+};
+
+/**
+ * @brief Latency distribution in microseconds
+ */
+struct LatencySummary {
+    size_t count = 0;
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+
+    static LatencySummary FromSamples(std::vector<double> samplesUs);
+};
+
+/**
+ * @brief What one scenario measured
+ */
+struct ScenarioResult {
+    std::string name;
+    uint64_t operations = 0;            // Commands, deliveries or iterations
+    uint64_t failures = 0;              // Operations that never completed
+    uint64_t coalesced = 0;             // Progress updates replaced by newer ones before they were sent
+    double seconds = 0.0;
+    LatencySummary latency;
+    double allocationsPerOperation = 0.0;   // Server-side heap allocations
+
+    double Rate() const { return seconds > 0.0 ? static_cast<double>(operations) / seconds : 0.0; }
+};
+
+/**
+ * @brief A WebSocket client driven by the load scenarios
+ *
+ * Connects, waits for the server's hello and then reports every message.
+ * All socket work runs on the client's strand; Send may be called from any
+ * thread.
+ */
+class LoadClient : public std::enable_shared_from_this<LoadClient> {
+public:
+    using ReadyHandler = std::function<void(LoadClient& client, bool connected)>;
+    using MessageHandler = std::function<void(LoadClient& client, const std::string& message)>;
+
+    LoadClient(net::io_context& ioc, size_t index);
+
+    void Connect(int port, ReadyHandler onReady, MessageHandler onMessage);
+    void Send(std::string message);
+    void Close();
+
+    size_t GetIndex() const { return m_index; }
+
+private:
+    void DoRead();
+    void DoWrite();
+    void Fail();
+
+    net::strand<net::io_context::executor_type> m_strand;
+    tcp::resolver m_resolver;
+    websocket::stream<beast::tcp_stream> m_ws;
+    beast::flat_buffer m_buffer;
+    std::deque<std::string> m_writeQueue;
+    ReadyHandler m_onReady;
+    MessageHandler m_onMessage;
+    size_t m_index;
+    bool m_helloSeen;
+    bool m_closed;
+};
+
+/**
+ * @brief Send a hello on connect and reply to get_status with a "status" event echoing "t"
+ *
+ * Stands in for the Archicad command handler so the round trip covers
+ * parsing, routing and the session write path but no conversion.
+ */
+void InstallStubCommandHandler(ArchicadWebSocketServer& server);
+
+/**
+ * @brief ParseWebSocketCommand on a start_conversion message
+ */
+ScenarioResult RunParseBenchmark(const LoadTestOptions& options);
+
+/**
+ * @brief Build a progress event the way the server does
+ */
+ScenarioResult RunSerializeBenchmark(const LoadTestOptions& options);
+
+/**
+ * @brief Open `sessions` sessions at once, then run get_status round trips on all of them
+ * @param results Receives the "connect" and "command_roundtrip" results
+ */
+void RunSessionStorm(const LoadTestOptions& options, int port, std::vector<ScenarioResult>& results);
+
+/**
+ * @brief Publish progress for several jobs to `subscribers` sessions subscribed to "*"
+ *
+ * Latency is from SendProgress until a subscriber has parsed the event.
+ * Updates still queued for a session when a newer one for the same job
+ * arrives are replaced, as in production; use as many jobs as messages
+ * to deliver every update.
+ */
+ScenarioResult RunProgressFanout(const LoadTestOptions& options, ArchicadWebSocketServer& server);
+
+#endif // LOAD_TEST_HPP
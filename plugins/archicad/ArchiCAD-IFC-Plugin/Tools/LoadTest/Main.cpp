@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LoadTest.hpp"
+#include "JsonWriter.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options]" << std::endl
+              << std::endl
+              << "  --port <port>            First port to try for the server (default: 18600)" << std::endl
+              << "  --server-threads <n>     Server I/O threads (default: 2)" << std::endl
+              << "  --client-threads <n>     Load client threads (default: 2)" << std::endl
+              << "  --sessions <n>           Concurrent sessions in the storm (default: 200)" << std::endl
+              << "  --commands <n>           get_status round trips per session (default: 50)" << std::endl
+              << "  --subscribers <n>        Sessions receiving the progress fan-out (default: 50)" << std::endl
+              << "  --messages <n>           Progress updates published (default: 5000)" << std::endl
+              << "  --jobs <n>               Jobs the updates are spread over (default: 16)" << std::endl
+              << "  --rate <hz>              Updates per second, 0 = as fast as possible (default: 0)" << std::endl
+              << "  --progress-rate <hz>     Server progress rate limit per job, 0 = off (default: 0)" << std::endl
+              << "  --iterations <n>         Parse/serialize microbenchmark iterations (default: 200000)" << std::endl
+              << "  --output <file>          Write the results as JSON" << std::endl
+              << "  --max-p99-us <us>        Fail if a network scenario's p99 latency is higher" << std::endl
+              << "  --log-level <level>      trace, debug, info, warn, error or off (default: warn)" << std::endl
+              << std::endl
+              << "Runs the WebSocket server in-process with a stub command handler; no Archicad needed." << std::endl;
+}
+
+static std::string FormatNumber(double value, int decimals)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+static void PrintResult(const ScenarioResult& result)
+{
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-20s %10llu %12.0f/s %9.1f %9.1f %9.1f %9.1f %8.2f %8llu %9llu",
+                  result.name.c_str(), static_cast<unsigned long long>(result.operations), result.Rate(),
+                  result.latency.p50Us, result.latency.p95Us, result.latency.p99Us, result.latency.maxUs,
+                  result.allocationsPerOperation, static_cast<unsigned long long>(result.failures),
+                  static_cast<unsigned long long>(result.coalesced));
+    std::cout << line << std::endl;
+}
+
+static std::string FormatResults(const LoadTestOptions& options, const std::vector<ScenarioResult>& results,
+                                 const std::string& queueStats)
+{
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("format", "ifc-plugin-loadtest")
+          .Field("version", 1)
+          .Key("options").BeginObject()
+              .Field("serverThreads", options.serverThreads)
+              .Field("sessions", options.sessions)
+              .Field("commandsPerSession", options.commandsPerSession)
+              .Field("subscribers", options.subscribers)
+              .Field("fanoutMessages", options.fanoutMessages)
+              .Field("fanoutJobs", options.fanoutJobs)
+              .Field("fanoutRateHz", options.fanoutRateHz)
+          .EndObject()
+          .Key("scenarios").BeginObject();
+    for (const ScenarioResult& result : results) {
+        writer.Key(result.name.c_str()).BeginObject()
+              .Field("operations", result.operations)
+              .Field("failures", result.failures)
+              .Field("coalesced", result.coalesced)
+              .Key("seconds").Raw(FormatNumber(result.seconds, 4))
+              .Key("ratePerSecond").Raw(FormatNumber(result.Rate(), 1))
+              .Key("allocationsPerOperation").Raw(FormatNumber(result.allocationsPerOperation, 2))
+              .Key("latencyUs").BeginObject()
+                  .Key("p50").Raw(FormatNumber(result.latency.p50Us, 2))
+                  .Key("p95").Raw(FormatNumber(result.latency.p95Us, 2))
+                  .Key("p99").Raw(FormatNumber(result.latency.p99Us, 2))
+                  .Key("max").Raw(FormatNumber(result.latency.maxUs, 2))
+              .EndObject()
+              .EndObject();
+    }
+    writer.EndObject()
+          .Key("queues").Raw(queueStats)
+          .EndObject();
+    return writer.ToString();
+}
+
+int main(int argc, char* argv[])
+{
+    LoadTestOptions options;
+    LoggerConfig logConfig;
+    logConfig.level = LogLevel::Warn;
+    int progressRate = 0;
+    double maxP99Us = 0.0;
+    std::string outputFile;
+
+    auto number = [&argc, &argv](int& i) { return std::max(0, std::atoi(argv[++i])); };
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            options.port = number(i);
+        } else if (std::strcmp(argv[i], "--server-threads") == 0 && hasValue) {
+            options.serverThreads = number(i);
+        } else if (std::strcmp(argv[i], "--client-threads") == 0 && hasValue) {
+            options.clientThreads = number(i);
+        } else if (std::strcmp(argv[i], "--sessions") == 0 && hasValue) {
+            options.sessions = number(i);
+        } else if (std::strcmp(argv[i], "--commands") == 0 && hasValue) {
+            options.commandsPerSession = number(i);
+        } else if (std::strcmp(argv[i], "--subscribers") == 0 && hasValue) {
+            options.subscribers = number(i);
+        } else if (std::strcmp(argv[i], "--messages") == 0 && hasValue) {
+            options.fanoutMessages = number(i);
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && hasValue) {
+            options.fanoutJobs = number(i);
+        } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+            options.fanoutRateHz = number(i);
+        } else if (std::strcmp(argv[i], "--progress-rate") == 0 && hasValue) {
+            progressRate = number(i);
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && hasValue) {
+            options.parseIterations = number(i);
+        } else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+            outputFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-p99-us") == 0 && hasValue) {
+            maxP99Us = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && hasValue) {
+            if (!LogLevelFromString(argv[++i], logConfig.level)) {
+                std::cerr << "✗ Invalid log level: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    Logger::Start(logConfig);
+
+    ArchicadWebSocketServer server;
+    server.SetThreadCount(static_cast<size_t>(std::max(1, options.serverThreads)));
+    server.SetProgressRate(progressRate);
+    InstallStubCommandHandler(server);
+
+    // Like the plugin, move on to the next port when one is taken
+    bool started = false;
+    for (int port = options.port; port < options.port + 10 && !started; ++port) {
+        started = server.Start(port, "127.0.0.1");
+    }
+    if (!started) {
+        std::cerr << "✗ Could not start the server on ports " << options.port << "-" << options.port + 9 << std::endl;
+        Logger::Stop();
+        return 1;
+    }
+
+    std::vector<ScenarioResult> results;
+    results.push_back(RunParseBenchmark(options));
+    results.push_back(RunSerializeBenchmark(options));
+    RunSessionStorm(options, server.GetPort(), results);
+    results.push_back(RunProgressFanout(options, server));
+
+    std::string queueStats = server.GetQueueStats().ToJson();
+    server.Stop();
+    Logger::Stop();
+
+    std::cout << "  scenario               ops         rate    p50 us    p95 us    p99 us    max us  alloc/op failures coalesced" << std::endl;
+    for (const ScenarioResult& result : results) {
+        PrintResult(result);
+    }
+
+    if (!outputFile.empty()) {
+        std::ofstream out(outputFile, std::ios::binary | std::ios::trunc);
+        out << FormatResults(options, results, queueStats) << "\n";
+        if (!out) {
+            std::cerr << "✗ Cannot write " << outputFile << std::endl;
+            return 1;
+        }
+    }
+
+    // Network scenarios only; the microbenchmarks are informational
+    bool ok = true;
+    for (const ScenarioResult& result : results) {
+        bool network = result.name != "command_parse" && result.name != "progress_serialize";
+        if (network && result.failures > 0) {
+            std::cerr << "✗ " << result.name << ": " << result.failures << " operations did not complete" << std::endl;
+            ok = false;
+        }
+        if (network && maxP99Us > 0.0 && result.latency.p99Us > maxP99Us) {
+            std::cerr << "✗ " << result.name << ": p99 " << FormatNumber(result.latency.p99Us, 1)
+                      << " us exceeds " << FormatNumber(maxP99Us, 1) << " us" << std::endl;
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// ArtifactProcessor: checksums and IFCZIP archives that unzip
+
+#include "TestHarness.hpp"
+#include "ArtifactProcessor.hpp"
+#include "FileHash.hpp"
+
+#include <boost/beast/zlib/inflate_stream.hpp>
+#include <boost/crc.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+static std::string IfcText()
+{
+    return "ISO-10303-21;\nHEADER;\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\n"
+           "#1=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Tower',$,$,$,$,$,$);\nENDSEC;\nEND-ISO-10303-21;\n";
+}
+
+static uint32_t ReadLE(const std::string& data, size_t offset, size_t bytes)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+TEST_CASE(ArtifactZipUnzips)
+{
+    fs::path dir = TestDirectory("artifact-zip");
+
+    // Repetitive and incompressible parts, larger than one read block
+    std::string content;
+    uint32_t seed = 12345;
+    while (content.size() < 3 * 1024 * 1024) {
+        content += IfcText();
+        for (int i = 0; i < 512; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            content += static_cast<char>(seed >> 24);
+        }
+    }
+    std::string path = WriteTestFile((dir / "model.ifc").string(), content);
+
+    ArtifactOptions options;
+    options.checksum = true;
+    options.compress = true;
+    ArtifactResult result;
+    ArtifactProcessor::Process(path, options, result);
+    REQUIRE(result.success);
+    CHECK_EQ(result.size, static_cast<uint64_t>(content.size()));
+    CHECK_EQ(result.sha256, Sha256::HashString(content));
+    CHECK_EQ(result.compressedPath, ArtifactProcessor::CompressedPathFor(path));
+    CHECK(!fs::exists(result.compressedPath + ".part"));
+
+    std::string zip = ReadTestFile(result.compressedPath);
+    REQUIRE(zip.size() >= 22);
+    CHECK_EQ(static_cast<uint64_t>(zip.size()), result.compressedSize);
+
+    // End of central directory -> central record -> local header
+    size_t eocd = zip.size() - 22;
+    REQUIRE(ReadLE(zip, eocd, 4) == 0x06054b50u);
+    CHECK_EQ(ReadLE(zip, eocd + 10, 2), 1u);     // One entry
+    size_t central = ReadLE(zip, eocd + 16, 4);
+    REQUIRE(central + 46 <= zip.size());
+    REQUIRE(ReadLE(zip, central, 4) == 0x02014b50u);
+
+    uint32_t method = ReadLE(zip, central + 10, 2);
+    uint32_t crc = ReadLE(zip, central + 16, 4);
+    uint32_t compressedSize = ReadLE(zip, central + 20, 4);
+    uint32_t size = ReadLE(zip, central + 24, 4);
+    uint32_t nameLength = ReadLE(zip, central + 28, 2);
+    size_t local = ReadLE(zip, central + 42, 4);
+    CHECK_EQ(method, 8u);                         // Deflate
+    CHECK_EQ(static_cast<uint64_t>(size), static_cast<uint64_t>(content.size()));
+    CHECK_EQ(zip.substr(central + 46, nameLength), std::string("model.ifc"));
+
+    REQUIRE(local + 30 <= zip.size());
+    REQUIRE(ReadLE(zip, local, 4) == 0x04034b50u);
+    size_t data = local + 30 + ReadLE(zip, local + 26, 2) + ReadLE(zip, local + 28, 2);
+    REQUIRE(data + compressedSize <= central);
+
+    std::string inflated(content.size() + 1, '\0');
+    boost::beast::zlib::z_params params;
+    params.next_in = zip.data() + data;
+    params.avail_in = compressedSize;
+    params.next_out = &inflated[0];
+    params.avail_out = inflated.size();
+    boost::beast::zlib::inflate_stream inflater;
+    inflater.reset(15);
+    boost::system::error_code ec;
+    inflater.write(params, boost::beast::zlib::Flush::sync, ec);
+    CHECK(ec == boost::beast::zlib::error::end_of_stream);
+    inflated.resize(params.total_out);
+    CHECK(inflated == content);
+
+    boost::crc_32_type check;
+    check.process_bytes(content.data(), content.size());
+    CHECK_EQ(crc, static_cast<uint32_t>(check.checksum()));
+}
+
+TEST_CASE(ArtifactRemovesOriginal)
+{
+    fs::path dir = TestDirectory("artifact-remove");
+    std::string path = WriteTestFile((dir / "model.ifc").string(), IfcText());
+
+    ArtifactOptions options;
+    options.compress = true;
+    options.removeOriginal = true;
+    ArtifactResult result;
+    ArtifactProcessor::Process(path, options, result);
+    REQUIRE(result.success);
+    CHECK(result.sha256.empty());
+    CHECK(fs::exists(result.compressedPath));
+    CHECK(!fs::exists(path));
+}
+
+TEST_CASE(ArtifactWorkerReportsEveryFile)
+{
+    fs::path dir = TestDirectory("artifact-worker");
+    std::string first = WriteTestFile((dir / "first.ifc").string(), IfcText());
+    std::string missing = (dir / "missing.ifc").string();
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<ArtifactResult> results;
+    auto collect = [&](const ArtifactResult& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(result);
+        done.notify_all();
+    };
+
+    ArtifactOptions options;
+    options.checksum = true;
+    ArtifactProcessor processor;
+    processor.Start();
+    REQUIRE(processor.Submit(first, options, collect));
+    REQUIRE(processor.Submit(missing, options, collect));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait_for(lock, std::chrono::seconds(10), [&results]() { return results.size() == 2; });
+    }
+    processor.Stop();
+
+    REQUIRE(results.size() == 2);
+    CHECK(results[0].success);                      // In submission order
+    CHECK_EQ(results[0].sha256, Sha256::HashString(IfcText()));
+    CHECK(!results[1].success);
+    CHECK(!results[1].error.empty());
+    CHECK(!processor.Submit(first, options, collect));
+}
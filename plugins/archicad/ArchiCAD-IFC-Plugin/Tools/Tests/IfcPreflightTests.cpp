@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// IfcPreflight: verdicts on valid, truncated, foreign and foreign-schema files
+
+#include "TestHarness.hpp"
+#include "IfcPreflight.hpp"
+
+#include <filesystem>
+#include <string>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+static const char* const kIfcHeader =
+    "ISO-10303-21;\n"
+    "HEADER;\n"
+    "FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+    "FILE_NAME('tower.ifc','2025-01-01T00:00:00',(''),(''),'','Tests','');\n";
+
+static const char* const kIfcData =
+    "ENDSEC;\n"
+    "DATA;\n"
+    "#1=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Tower',$,$,$,$,$,$);\n"
+    "#2=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#3=IFCCARTESIANPOINT((1.,0.,0.));\n"
+    "ENDSEC;\n";
+
+static std::string IfcText(const std::string& schema, bool trailer)
+{
+    std::string text = kIfcHeader;
+    text += "FILE_SCHEMA(('" + schema + "'));\n";
+    text += kIfcData;
+    if (trailer) {
+        text += "END-ISO-10303-21;\n";
+    }
+    return text;
+}
+
+TEST_CASE(PreflightAcceptsValidIfc)
+{
+    fs::path dir = TestDirectory("preflight-valid");
+    IfcPreflightReport report;
+    CHECK(IfcPreflight::Scan(WriteTestFile((dir / "tower.ifc").string(), IfcText("IFC4", true)), report));
+    CHECK_EQ(report.schema, std::string("IFC4"));
+    CHECK_EQ(report.fileName, std::string("tower.ifc"));
+    CHECK_EQ(report.entityCount, static_cast<uint64_t>(3));
+    REQUIRE(!report.entityTypes.empty());
+    CHECK_EQ(report.entityTypes[0].first, std::string("IFCCARTESIANPOINT"));
+    CHECK_EQ(report.entityTypes[0].second, static_cast<uint64_t>(2));
+}
+
+TEST_CASE(PreflightRejectsTruncatedIfc)
+{
+    fs::path dir = TestDirectory("preflight-truncated");
+    IfcPreflightReport report;
+    CHECK(!IfcPreflight::Scan(WriteTestFile((dir / "truncated.ifc").string(), IfcText("IFC4", false)), report));
+    CHECK(report.error.find("truncated") != std::string::npos);
+
+    // Cut inside the DATA section
+    std::string text = IfcText("IFC4", true);
+    CHECK(!IfcPreflight::Scan(WriteTestFile((dir / "cut.ifc").string(), text.substr(0, text.find("#2="))), report));
+
+    CHECK(!IfcPreflight::Scan(WriteTestFile((dir / "empty.ifc").string(), std::string()), report));
+    CHECK(!IfcPreflight::Scan(WriteTestFile((dir / "not-step.ifc").string(), "<?xml version=\"1.0\"?>\n<ifc/>\n"), report));
+    CHECK(!IfcPreflight::Scan((dir / "missing.ifc").string(), report));
+}
+
+TEST_CASE(PreflightRejectsForeignSchema)
+{
+    fs::path dir = TestDirectory("preflight-schema");
+    std::string ifc2x3 = WriteTestFile((dir / "old.ifc").string(), IfcText("IFC2X3", true));
+    std::string ifc4x3 = WriteTestFile((dir / "new.ifc").string(), IfcText("IFC4X3_ADD2", true));
+
+    IfcPreflight::SetSupportedSchemas("IFC4,IFC4X3");
+    IfcPreflightReport report;
+    bool oldAccepted = IfcPreflight::Scan(ifc2x3, report);
+    std::string oldError = report.error;
+    bool newAccepted = IfcPreflight::Scan(ifc4x3, report);
+    IfcPreflight::SetSupportedSchemas("");
+
+    CHECK(!oldAccepted);
+    CHECK(oldError.find("IFC2X3") != std::string::npos);
+    CHECK(newAccepted);                                     // Addenda of a listed schema
+    CHECK(IfcPreflight::Scan(ifc2x3, report));              // Empty list accepts every schema
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// JobQueue: ordering, the single running job and admission; JobCostModel
+
+#include "TestHarness.hpp"
+#include "JobQueue.hpp"
+#include "JobCostModel.hpp"
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+static void EnqueueJob(JobQueue& queue, const std::string& jobId, int priority = 0)
+{
+    ConversionJob job;
+    job.jobId = jobId;
+    job.priority = priority;
+
+    size_t position = 0;
+    REQUIRE(queue.Enqueue(job, position) == JobQueue::EnqueueResult::Accepted);
+}
+
+static std::string PopJobId(JobQueue& queue)
+{
+    ConversionJob job;
+    REQUIRE(queue.PopNext(job));
+    CHECK(job.state == JobState::Running);
+    queue.Finish(job.jobId, JobState::Done);
+    return job.jobId;
+}
+
+TEST_CASE(QueueFifoWithinPriority)
+{
+    JobQueue queue;
+    EnqueueJob(queue, "first");
+    EnqueueJob(queue, "second");
+    EnqueueJob(queue, "urgent", 5);
+    EnqueueJob(queue, "third");
+
+    CHECK_EQ(PopJobId(queue), std::string("urgent"));
+    CHECK_EQ(PopJobId(queue), std::string("first"));
+    CHECK_EQ(PopJobId(queue), std::string("second"));
+    CHECK_EQ(PopJobId(queue), std::string("third"));
+
+    ConversionJob job;
+    CHECK(!queue.PopNext(job));
+}
+
+TEST_CASE(QueueRunsOneJobAtATime)
+{
+    JobQueue queue;
+    EnqueueJob(queue, "a");
+    EnqueueJob(queue, "b");
+
+    ConversionJob running;
+    REQUIRE(queue.PopNext(running));
+    ConversionJob next;
+    CHECK(!queue.PopNext(next));
+    CHECK(queue.HasRunningJob());
+    REQUIRE(queue.GetRunningJob(next));
+    CHECK_EQ(next.jobId, std::string("a"));
+
+    CHECK(!queue.Finish("b", JobState::Done));      // Not the running job
+    CHECK(queue.Finish("a", JobState::Done));
+    CHECK(queue.PopNext(next));
+    CHECK_EQ(next.jobId, std::string("b"));
+
+    // Stopping the scheduler drops the running job with the queued ones
+    queue.Clear();
+    CHECK(!queue.GetRunningJob(next));
+}
+
+TEST_CASE(QueueRejectsDuplicatesAndOverflow)
+{
+    JobQueue queue(2);
+    EnqueueJob(queue, "a");
+
+    ConversionJob job;
+    job.jobId = "a";
+    size_t position = 0;
+    CHECK(queue.Enqueue(job, position) == JobQueue::EnqueueResult::Duplicate);
+
+    job.jobId = "b";
+    CHECK(queue.Enqueue(job, position) == JobQueue::EnqueueResult::Accepted);
+    CHECK_EQ(position, static_cast<size_t>(2));
+
+    job.jobId = "c";
+    CHECK(queue.Enqueue(job, position) == JobQueue::EnqueueResult::QueueFull);
+
+    // The running job does not count against the depth
+    ConversionJob running;
+    REQUIRE(queue.PopNext(running));
+    CHECK(queue.Enqueue(job, position) == JobQueue::EnqueueResult::Accepted);
+}
+
+TEST_CASE(QueueStatesAndCancellation)
+{
+    JobQueue queue;
+    EnqueueJob(queue, "a");
+    EnqueueJob(queue, "b");
+    EnqueueJob(queue, "c");
+
+    JobState state;
+    size_t position = 0;
+    REQUIRE(queue.GetState("c", state, position));
+    CHECK(state == JobState::Queued);
+    CHECK_EQ(position, static_cast<size_t>(3));
+
+    CHECK(queue.CancelQueued("b"));
+    CHECK(!queue.CancelQueued("b"));
+    REQUIRE(queue.GetState("b", state, position));
+    CHECK(state == JobState::Cancelled);
+    REQUIRE(queue.GetState("c", state, position));
+    CHECK_EQ(position, static_cast<size_t>(2));
+
+    CHECK_EQ(PopJobId(queue), std::string("a"));
+    REQUIRE(queue.GetState("a", state, position));
+    CHECK(state == JobState::Done);
+    CHECK(!queue.GetState("unknown", state, position));
+}
+
+static void EnqueueTimedJob(JobQueue& queue, const std::string& jobId, double predictedMs, int priority = 0)
+{
+    ConversionJob job;
+    job.jobId = jobId;
+    job.predictedMs = predictedMs;
+    job.priority = priority;
+
+    size_t position = 0;
+    REQUIRE(queue.Enqueue(job, position) == JobQueue::EnqueueResult::Accepted);
+}
+
+TEST_CASE(QueueShortestFirst)
+{
+    JobQueue queue;
+    queue.SetPolicy(SchedulingPolicy::ShortestFirst, 0.0);
+    EnqueueTimedJob(queue, "long", 60000.0);
+    EnqueueTimedJob(queue, "short", 1000.0);
+    EnqueueTimedJob(queue, "medium", 10000.0);
+    EnqueueTimedJob(queue, "short-2", 1000.0);
+
+    CHECK_EQ(PopJobId(queue), std::string("short"));
+    CHECK_EQ(PopJobId(queue), std::string("short-2"));  // Equal predictions keep submission order
+    CHECK_EQ(PopJobId(queue), std::string("medium"));
+    CHECK_EQ(PopJobId(queue), std::string("long"));
+}
+
+TEST_CASE(QueueShortestFirstAging)
+{
+    // 200 ms of waiting at 1000 ms per ms takes 200 s off the long job's
+    // prediction, so it now goes before a fresh 1 s job
+    JobQueue queue;
+    queue.SetPolicy(SchedulingPolicy::ShortestFirst, 1000.0);
+    EnqueueTimedJob(queue, "long-waiting", 60000.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EnqueueTimedJob(queue, "short-fresh", 1000.0);
+
+    CHECK_EQ(PopJobId(queue), std::string("long-waiting"));
+    CHECK_EQ(PopJobId(queue), std::string("short-fresh"));
+}
+
+TEST_CASE(QueueDefaultsToFifo)
+{
+    // Predictions only reorder jobs once a deployment opts into sjf
+    JobQueue queue;
+    EnqueueTimedJob(queue, "long", 60000.0);
+    EnqueueTimedJob(queue, "short", 1000.0);
+    CHECK_EQ(PopJobId(queue), std::string("long"));
+    CHECK_EQ(PopJobId(queue), std::string("short"));
+}
+
+TEST_CASE(QueueShortestFirstPriorityWins)
+{
+    JobQueue queue;
+    queue.SetPolicy(SchedulingPolicy::ShortestFirst, 0.0);
+    EnqueueTimedJob(queue, "short", 1000.0);
+    EnqueueTimedJob(queue, "urgent-long", 60000.0, 5);
+
+    CHECK_EQ(PopJobId(queue), std::string("urgent-long"));
+    CHECK_EQ(PopJobId(queue), std::string("short"));
+}
+
+TEST_CASE(QueueEtaAddsJobsAhead)
+{
+    JobQueue queue;
+    queue.SetPolicy(SchedulingPolicy::ShortestFirst, 0.0);
+    EnqueueTimedJob(queue, "a", 1000.0);
+    EnqueueTimedJob(queue, "b", 2000.0);
+
+    double etaMs = 0.0;
+    REQUIRE(queue.GetEta("b", etaMs));
+    CHECK(etaMs >= 2999.0 && etaMs <= 3001.0);
+    CHECK(!queue.GetEta("unknown", etaMs));
+}
+
+TEST_CASE(PolicyNames)
+{
+    SchedulingPolicy policy = SchedulingPolicy::Fifo;
+    CHECK(SchedulingPolicyFromString("sjf", policy) && policy == SchedulingPolicy::ShortestFirst);
+    CHECK(SchedulingPolicyFromString("fair", policy) && policy == SchedulingPolicy::FairShare);
+    CHECK(SchedulingPolicyFromString("fifo", policy) && policy == SchedulingPolicy::Fifo);
+    CHECK(!SchedulingPolicyFromString("lifo", policy));
+    CHECK(policy == SchedulingPolicy::Fifo);
+}
+
+TEST_CASE(CostModelLearnsFromRuns)
+{
+    JobCostModel model;
+    double guess = model.Predict(JobType::PlnToIfc, 10 * 1024 * 1024, 0);
+    CHECK(guess > 0.0);
+
+    // 2 s + 1 s per MB
+    for (uint64_t mb : { 1u, 4u, 8u, 16u, 32u }) {
+        model.Observe(JobType::PlnToIfc, mb * 1024 * 1024, 0, 2000.0 + 1000.0 * static_cast<double>(mb));
+    }
+    CHECK_EQ(model.GetSampleCount(JobType::PlnToIfc), static_cast<uint64_t>(5));
+    double predicted = model.Predict(JobType::PlnToIfc, 20 * 1024 * 1024, 0);
+    CHECK(predicted > 20000.0 && predicted < 24000.0);
+
+    // Other types keep their first guess
+    CHECK_EQ(model.GetSampleCount(JobType::IfcToPln), static_cast<uint64_t>(0));
+    CHECK(model.Predict(JobType::IfcToPln, 1024, 0) >= 100.0);
+}
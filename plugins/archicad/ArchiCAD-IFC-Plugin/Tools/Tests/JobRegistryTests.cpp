@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// JobRegistry resubmission and the fingerprints it compares
+
+#include "TestHarness.hpp"
+#include "JobRegistry.hpp"
+#include "JsonWriter.hpp"
+#include "WebSocketCommand.hpp"
+
+#include <string>
+
+static JsonPayload TerminalEvent(const char* status)
+{
+    JsonWriter writer;
+    writer.BeginObject().Field("status", status).EndObject();
+    return writer.ToPayload();
+}
+
+TEST_CASE(RegistryAttachWhileRunning)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    CHECK(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+
+    CHECK(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::Attached);
+    CHECK_EQ(existing.jobId, std::string("job-1"));
+    CHECK(!existing.finished);
+
+    // Rerun cannot start a second copy of a running job
+    CHECK(registry.ClaimJob("job-1", "fp-a", true, existing) == JobRegistry::Claim::Attached);
+}
+
+TEST_CASE(RegistryConflictWhileRunning)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    REQUIRE(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+
+    CHECK(registry.ClaimJob("job-1", "fp-b", false, existing) == JobRegistry::Claim::Conflict);
+    CHECK_EQ(existing.fingerprint, std::string("fp-a"));
+}
+
+TEST_CASE(RegistryAttachToCompleted)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    REQUIRE(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+    registry.RecordEvent("job-1", TerminalEvent("completed"), true);
+
+    CHECK(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::Attached);
+    CHECK(existing.finished);
+    CHECK_EQ(existing.status, std::string("completed"));
+    CHECK(existing.lastEvent != nullptr);
+
+    // Another fingerprint or an explicit rerun runs the finished job again
+    CHECK(registry.ClaimJob("job-1", "fp-b", false, existing) == JobRegistry::Claim::New);
+    registry.RecordEvent("job-1", TerminalEvent("completed"), true);
+    CHECK(registry.ClaimJob("job-1", "fp-b", true, existing) == JobRegistry::Claim::New);
+}
+
+TEST_CASE(RegistryKeepsCompletionAfterStages)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    REQUIRE(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+
+    // A stage at 100% is the latest event, not the job's end
+    JsonWriter stage;
+    stage.BeginObject().Field("type", "progress").Field("progress", 100).Field("status", "processing").EndObject();
+    registry.RecordEvent("job-1", stage.ToPayload(), false);
+    REQUIRE(registry.Find("job-1", existing));
+    CHECK(!existing.finished);
+
+    JsonWriter completion;
+    completion.BeginObject()
+              .Field("type", "completed")
+              .Field("status", "completed")
+              .Key("result").BeginObject().Field("outputPath", "/a.ifc").EndObject()
+              .EndObject();
+    JsonPayload completed = completion.ToPayload();
+    registry.RecordEvent("job-1", completed, true);
+
+    // Resume and attach replay the completion, later events are ignored
+    registry.RecordEvent("job-1", TerminalEvent("error"), true);
+    REQUIRE(registry.Find("job-1", existing));
+    CHECK(existing.finished);
+    CHECK_EQ(existing.status, std::string("completed"));
+    REQUIRE(existing.lastEvent != nullptr);
+    CHECK_EQ(*existing.lastEvent, *completed);
+}
+
+TEST_CASE(RegistryRerunsFailed)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    REQUIRE(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+    registry.RecordEvent("job-1", TerminalEvent("error"), true);
+    CHECK(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+
+    registry.RecordEvent("job-1", TerminalEvent("cancelled"), true);
+    CHECK(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+}
+
+TEST_CASE(RegistryForget)
+{
+    JobRegistry registry;
+    JobRecord existing;
+    REQUIRE(registry.ClaimJob("job-1", "fp-a", false, existing) == JobRegistry::Claim::New);
+    registry.Forget("job-1");
+    CHECK(!registry.Find("job-1", existing));
+    CHECK(registry.ClaimJob("job-1", "fp-b", false, existing) == JobRegistry::Claim::New);
+}
+
+TEST_CASE(FingerprintCoversJobShape)
+{
+    auto fingerprint = [](const std::string& payload) {
+        WebSocketCommand command;
+        std::string error;
+        ParseWebSocketCommand(payload, command, error);
+        return SubmissionFingerprint(command);
+    };
+
+    std::string base = fingerprint(R"({"command":"start_batch","jobId":"b","items":[{"plnPath":"/a.pln","outputPath":"/a.ifc"}]})");
+    CHECK(base != fingerprint(R"({"command":"start_batch","jobId":"b","items":[{"plnPath":"/b.pln","outputPath":"/a.ifc"}]})"));
+    CHECK(base != fingerprint(R"({"command":"start_batch","jobId":"b","items":[{"ifcPath":"/a.pln","outputPath":"/a.ifc"}]})"));
+    CHECK(base != fingerprint(R"({"command":"start_batch","jobId":"b","items":[{"plnPath":"/a.pln","outputPath":"/a.ifc","filter":{"storeys":[1]}}]})"));
+    CHECK(base != fingerprint(R"({"command":"start_batch","jobId":"b","priority":5,"items":[{"plnPath":"/a.pln","outputPath":"/a.ifc"}]})"));
+
+    std::string conversion = fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","outputPath":"/a.ifc"})");
+    CHECK(conversion != fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","outputPath":"/a.ifc","checksum":true})"));
+    CHECK(conversion != fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","outputPath":"/a.ifc","compress":"ifczip"})"));
+    CHECK(conversion != fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","outputPath":"/a.ifc","streamOutput":true})"));
+    CHECK(conversion != fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","outputPath":"/a.ifc","tenant":"t2"})"));
+
+    // Filters compare by content, not by their JSON text
+    CHECK_EQ(fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","filter":{"storeys":[2,1],"elementTypes":["Wall"]}})"),
+             fingerprint(R"({"command":"start_conversion","jobId":"c","plnPath":"/a.pln","filter":{"elementTypes":["wall"],"storeys":[1,2]}})"));
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// JobStager: input checks, output directories and staged copies
+
+#include "TestHarness.hpp"
+#include "JobStager.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static StagingOptions ScratchOptions(const fs::path& dir, StagingMode mode)
+{
+    StagingOptions options;
+    options.mode = mode;
+    options.directory = (dir / "scratch").string();
+    options.threads = 2;
+    return options;
+}
+
+static ConversionJob PlnJob(const std::string& jobId, const std::string& input, const std::string& output)
+{
+    ConversionJob job;
+    job.jobId = jobId;
+    job.type = JobType::PlnToIfc;
+    job.inputPath = input;
+    job.outputPath = output;
+    return job;
+}
+
+TEST_CASE(StagerChecksInputsAndCreatesOutputDirectories)
+{
+    fs::path dir = TestDirectory("stager-check");
+    JobStager stager;
+    stager.Start(ScratchOptions(dir, StagingMode::Never));
+
+    std::string input = WriteTestFile((dir / "model.pln").string(), "pln");
+    std::string output = (dir / "out" / "nested" / "model.ifc").string();
+
+    ConversionJob ready;
+    std::string error;
+    REQUIRE(stager.Acquire(PlnJob("ok", input, output), ready, error));
+    CHECK_EQ(ready.inputPath, input);               // Never: not copied
+    CHECK(ready.sourcePath.empty());
+    CHECK(fs::is_directory(dir / "out" / "nested"));
+    stager.Release("ok");
+
+    CHECK(!stager.Acquire(PlnJob("missing", (dir / "missing.pln").string(), output), ready, error));
+    CHECK(error.find("not found") != std::string::npos);
+    stager.Release("missing");
+
+    CHECK(!stager.Acquire(PlnJob("directory", dir.string(), output), ready, error));
+    CHECK(error.find("not a file") != std::string::npos);
+    stager.Release("directory");
+
+    // The output's parent exists as a file
+    CHECK(!stager.Acquire(PlnJob("blocked", input, (dir / "model.pln" / "x.ifc").string()), ready, error));
+    stager.Stop();
+}
+
+TEST_CASE(StagerCopiesAndReleasesInputs)
+{
+    fs::path dir = TestDirectory("stager-copy");
+    JobStager stager;
+    REQUIRE(stager.Start(ScratchOptions(dir, StagingMode::Always)));
+
+    std::string input = WriteTestFile((dir / "model.pln").string(), "pln contents");
+    ConversionJob job = PlnJob("copy", input, (dir / "model.ifc").string());
+
+    // Staged by a worker ahead of the scheduler
+    stager.Prefetch(job);
+    ConversionJob ready;
+    std::string error;
+    REQUIRE(stager.Acquire(job, ready, error));
+    CHECK_EQ(ready.sourcePath, input);
+    CHECK(ready.inputPath != input);
+    CHECK_EQ(fs::path(ready.inputPath).filename().string(), std::string("model.pln"));
+    CHECK_EQ(ReadTestFile(ready.inputPath), std::string("pln contents"));
+
+    stager.Release("copy");
+    CHECK(!fs::exists(ready.inputPath));
+
+    // Load IFC inputs stay where they are
+    ConversionJob load = PlnJob("load", WriteTestFile((dir / "model.ifc").string(), "ifc"), std::string());
+    load.type = JobType::LoadIfc;
+    REQUIRE(stager.Acquire(load, ready, error));
+    CHECK_EQ(ready.inputPath, load.inputPath);
+    stager.Release("load");
+
+    stager.Stop();
+    CHECK(fs::is_empty(dir / "scratch"));
+}
+
+TEST_CASE(StagerCopiesBatchInputsOnce)
+{
+    fs::path dir = TestDirectory("stager-batch");
+    JobStager stager;
+    REQUIRE(stager.Start(ScratchOptions(dir, StagingMode::Always)));
+
+    std::string input = WriteTestFile((dir / "model.pln").string(), "pln");
+    ConversionJob batch;
+    batch.jobId = "batch";
+    batch.type = JobType::Batch;
+    for (const char* name : { "a.ifc", "b.ifc" }) {
+        BatchItem item;
+        item.inputPath = input;
+        item.outputPath = (dir / name).string();
+        batch.items.push_back(item);
+    }
+
+    ConversionJob ready;
+    std::string error;
+    REQUIRE(stager.Acquire(batch, ready, error));
+    REQUIRE(ready.items.size() == 2);
+    CHECK(ready.items[0].inputPath != input);
+    CHECK_EQ(ready.items[0].inputPath, ready.items[1].inputPath);
+    CHECK_EQ(ready.items[1].sourcePath, input);
+    stager.Release("batch");
+    stager.Stop();
+}
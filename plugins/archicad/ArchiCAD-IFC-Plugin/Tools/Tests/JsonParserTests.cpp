@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// JsonParser and ParseWebSocketCommand: the cases the hand-rolled field
+// scanner used to get wrong
+
+#include "TestHarness.hpp"
+#include "JsonParser.hpp"
+#include "WebSocketCommand.hpp"
+
+#include <string>
+
+static bool ParseCommand(const std::string& payload, WebSocketCommand& command)
+{
+    std::string error;
+    return ParseWebSocketCommand(payload, command, error);
+}
+
+TEST_CASE(JsonEscapedQuotes)
+{
+    JsonValue value;
+    std::string error;
+    REQUIRE(JsonParser::Parse(R"({"message":"say \"hi\"","command":"x"})", value, error));
+    CHECK_EQ(value.GetString({ "message" }), std::string("say \"hi\""));
+    CHECK_EQ(value.GetString({ "command" }), std::string("x"));
+}
+
+TEST_CASE(JsonEscapes)
+{
+    JsonValue value;
+    std::string error;
+    REQUIRE(JsonParser::Parse(R"(["\\ \/ \b\f\n\r\t", "\u00e9", "\u20AC"])", value, error));
+    REQUIRE(value.IsArray() && value.Size() == 3);
+    CHECK_EQ(value.At(0).AsString(), std::string("\\ / \b\f\n\r\t"));
+    CHECK_EQ(value.At(1).AsString(), std::string("\xC3\xA9"));
+    CHECK_EQ(value.At(2).AsString(), std::string("\xE2\x82\xAC"));
+}
+
+TEST_CASE(JsonSurrogatePairs)
+{
+    JsonValue value;
+    std::string error;
+    REQUIRE(JsonParser::Parse(R"("\uD83C\uDFD7")", value, error));
+    CHECK_EQ(value.AsString(), std::string("\xF0\x9F\x8F\x97"));     // U+1F3D7
+
+    CHECK(!JsonParser::Parse(R"("\uD83C")", value, error));          // High surrogate alone
+    CHECK(!JsonParser::Parse(R"("\uDFD7")", value, error));          // Low surrogate alone
+    CHECK(!JsonParser::Parse(R"("\uD83C\u0041")", value, error));    // Not a low surrogate
+}
+
+TEST_CASE(JsonDepthLimit)
+{
+    JsonValue value;
+    std::string error;
+
+    std::string shallow = std::string(64, '[') + std::string(64, ']');
+    CHECK(JsonParser::Parse(shallow, value, error));
+
+    std::string deep = std::string(65, '[') + std::string(65, ']');
+    CHECK(!JsonParser::Parse(deep, value, error));
+
+    // Deep nesting must fail cleanly, not overflow the stack
+    std::string hostile(100000, '[');
+    CHECK(!JsonParser::Parse(hostile, value, error));
+}
+
+TEST_CASE(JsonDuplicateKeys)
+{
+    // The first member wins, for every lookup
+    JsonValue value;
+    std::string error;
+    REQUIRE(JsonParser::Parse(R"({"jobId":"first","jobId":"second"})", value, error));
+    CHECK_EQ(value.GetString({ "jobId" }), std::string("first"));
+    CHECK_EQ(value.Size(), static_cast<size_t>(2));
+}
+
+TEST_CASE(JsonMalformed)
+{
+    JsonValue value;
+    std::string error;
+    CHECK(!JsonParser::Parse(R"({"command":"x")", value, error));
+    CHECK(!JsonParser::Parse(R"({"command":"x"} trailing)", value, error));
+    CHECK(!JsonParser::Parse(R"({"command":"line
+break"})", value, error));
+    CHECK(!JsonParser::Parse(R"({"a":01})", value, error));
+    CHECK(!error.empty());
+}
+
+TEST_CASE(JsonNestedContainers)
+{
+    JsonValue value;
+    std::string error;
+
+    // A failed parse leaves nothing behind for the next one
+    CHECK(!JsonParser::Parse(R"({"a":[1,{"b":[2,3)", value, error));
+
+    REQUIRE(JsonParser::Parse(R"({"a":[1,{"b":[2,3],"c":{}},[]],"d":"e","f":{"g":true}})", value, error));
+    REQUIRE(value.IsObject() && value.Size() == 3);
+    CHECK_EQ(value.KeyAt(0), std::string("a"));
+    CHECK_EQ(value.KeyAt(1), std::string("d"));
+    CHECK_EQ(value.KeyAt(2), std::string("f"));
+
+    const JsonValue* a = value.Find("a");
+    REQUIRE(a != nullptr && a->IsArray() && a->Size() == 3);
+    CHECK_EQ(a->At(0).AsInt(), static_cast<int64_t>(1));
+    REQUIRE(a->At(1).IsObject() && a->At(1).Size() == 2);
+    const JsonValue* b = a->At(1).Find("b");
+    REQUIRE(b != nullptr && b->Size() == 2);
+    CHECK_EQ(b->At(1).AsInt(), static_cast<int64_t>(3));
+    CHECK(a->At(1).Find("c") != nullptr && a->At(1).Find("c")->IsObject());
+    CHECK(a->At(2).IsArray() && a->At(2).Size() == 0);
+
+    // Array items have no names to be found by
+    CHECK(a->Find("b") == nullptr);
+    CHECK_EQ(value.GetString({ "d" }), std::string("e"));
+    CHECK(value.Find("f")->GetBool("g"));
+}
+
+TEST_CASE(CommandNestedKeysAreNotFields)
+{
+    // A nested object that reuses a top-level key must not shadow it
+    WebSocketCommand command;
+    REQUIRE(ParseCommand(R"({"meta":{"command":"cancel_job","jobId":"inner"},"command":"start_conversion","jobId":"outer"})", command));
+    CHECK(command.type == CommandType::StartConversion);
+    CHECK_EQ(command.jobId, std::string("outer"));
+}
+
+TEST_CASE(CommandWindowsPaths)
+{
+    WebSocketCommand command;
+    REQUIRE(ParseCommand(R"({"command":"start_conversion","jobId":"j","pln_path":"C:\\Projects\\\"Tower\"\\model.pln","output_path":"C:\\out\\model.ifc"})", command));
+    CHECK_EQ(command.plnPath, std::string("C:\\Projects\\\"Tower\"\\model.pln"));
+    CHECK_EQ(command.outputPath, std::string("C:\\out\\model.ifc"));
+}
+
+TEST_CASE(CommandAliases)
+{
+    WebSocketCommand camel;
+    WebSocketCommand snake;
+    REQUIRE(ParseCommand(R"({"command":"start_conversion","jobId":"a","plnPath":"/in.pln","outputPath":"/out.ifc"})", camel));
+    REQUIRE(ParseCommand(R"({"command":"start_conversion","job_id":"a","pln_path":"/in.pln","output_path":"/out.ifc"})", snake));
+    CHECK_EQ(camel.jobId, snake.jobId);
+    CHECK_EQ(camel.plnPath, snake.plnPath);
+    CHECK_EQ(camel.outputPath, snake.outputPath);
+}
+
+TEST_CASE(CommandRejectsNonObjects)
+{
+    WebSocketCommand command;
+    CHECK(!ParseCommand(R"(["start_conversion"])", command));
+    CHECK(!ParseCommand(R"({"jobId":"no-command"})", command));
+    CHECK(!ParseCommand(R"({"command":""})", command));
+
+    REQUIRE(ParseCommand(R"({"command":"no_such_command"})", command));
+    CHECK(command.type == CommandType::Unknown);
+}
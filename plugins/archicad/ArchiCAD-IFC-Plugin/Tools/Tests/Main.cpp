@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TestHarness.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <exception>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+static int s_failures = 0;
+
+std::vector<TestCase>& TestRegistry()
+{
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+void ReportFailure(const char* file, int line, const std::string& message)
+{
+    ++s_failures;
+    std::cout << "    ✗ " << fs::path(file).filename().string() << ":" << line << ": " << message << std::endl;
+}
+
+std::string TestDirectory(const std::string& name)
+{
+    fs::path dir = fs::temp_directory_path() / "ifc-plugin-tests" / name;
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    return dir.u8string();
+}
+
+std::string WriteTestFile(const std::string& path, const std::string& content)
+{
+    std::ofstream file(fs::u8path(path), std::ios::binary | std::ios::trunc);
+    file << content;
+    return path;
+}
+
+std::string ReadTestFile(const std::string& path)
+{
+    std::ifstream file(fs::u8path(path), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char* argv[])
+{
+    // Optional filter: run only the test cases whose name contains it
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    Logger::SetLevel(LogLevel::Off);
+
+    int failedCases = 0;
+    int ran = 0;
+    for (const TestCase& test : TestRegistry()) {
+        if (filter != nullptr && std::strstr(test.name, filter) == nullptr) {
+            continue;
+        }
+
+        int before = s_failures;
+        try {
+            test.run();
+        } catch (const RequireFailed&) {
+        } catch (const std::exception& e) {
+            ReportFailure(__FILE__, __LINE__, std::string("unexpected exception: ") + e.what());
+        }
+
+        ++ran;
+        bool passed = (s_failures == before);
+        failedCases += passed ? 0 : 1;
+        std::cout << (passed ? "✓ " : "✗ ") << test.name << std::endl;
+    }
+
+    std::cout << std::endl << ran - failedCases << " of " << ran << " test cases passed" << std::endl;
+    return failedCases == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// ResultCache: keys, hits and least-recently-used eviction
+
+#include "TestHarness.hpp"
+#include "ResultCache.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+TEST_CASE(CacheKeysSeparateEveryPart)
+{
+    std::string key = ResultCache::MakeKey("hash", "pln-to-ifc", "#0/2:list", "options");
+    CHECK_EQ(key, ResultCache::MakeKey("hash", "pln-to-ifc", "#0/2:list", "options"));
+    CHECK(key != ResultCache::MakeKey("hash", "pln-to-ifc", "#1/2:list", "options"));
+    CHECK(key != ResultCache::MakeKey("hash", "ifc-to-pln", "#0/2:list", "options"));
+    CHECK(key != ResultCache::MakeKey("other", "pln-to-ifc", "#0/2:list", "options"));
+    CHECK(key != ResultCache::MakeKey("hash", "pln-to-ifc", "#0/2:list", "options2"));
+
+    // Parts are length-prefixed: moving text from one part to the next is another key
+    CHECK(ResultCache::MakeKey("a", "b", "cd", "") != ResultCache::MakeKey("a", "b", "c", "d"));
+}
+
+TEST_CASE(CacheStoresAndFetches)
+{
+    fs::path dir = TestDirectory("cache-fetch");
+    ResultCache cache;
+    REQUIRE(cache.Open((dir / "cache").string(), 1 << 20));
+
+    std::string result = WriteTestFile((dir / "result.ifc").string(), "ISO-10303-21; cached");
+    std::string key = ResultCache::MakeKey("hash", "pln-to-ifc", "", "");
+    CHECK(!cache.Fetch(key, (dir / "miss.ifc").string()));
+    REQUIRE(cache.Store(key, result));
+    CHECK_EQ(cache.GetEntryCount(), static_cast<size_t>(1));
+
+    std::string output = (dir / "out" / "model.ifc").string();
+    REQUIRE(cache.Fetch(key, output));
+    CHECK_EQ(ReadTestFile(output), std::string("ISO-10303-21; cached"));
+
+    // Entries survive a restart
+    ResultCache reopened;
+    REQUIRE(reopened.Open((dir / "cache").string(), 1 << 20));
+    CHECK_EQ(reopened.GetEntryCount(), static_cast<size_t>(1));
+    CHECK(reopened.Fetch(key, (dir / "again.ifc").string()));
+}
+
+TEST_CASE(CacheDropsDamagedEntries)
+{
+    fs::path dir = TestDirectory("cache-damaged");
+    ResultCache cache;
+    REQUIRE(cache.Open((dir / "cache").string(), 1 << 20));
+
+    std::string key = ResultCache::MakeKey("hash", "pln-to-ifc", "", "");
+    REQUIRE(cache.Store(key, WriteTestFile((dir / "result.ifc").string(), "original")));
+    std::string output = (dir / "model.ifc").string();
+    REQUIRE(cache.Fetch(key, output));
+
+    // Writing through a hard-linked output changes the entry's size
+    WriteTestFile(output, "edited by the client");
+    CHECK(!cache.Fetch(key, (dir / "stale.ifc").string()));
+    CHECK_EQ(cache.GetEntryCount(), static_cast<size_t>(0));
+}
+
+TEST_CASE(CacheEvictsLeastRecentlyUsed)
+{
+    fs::path dir = TestDirectory("cache-evict");
+    ResultCache cache;
+    REQUIRE(cache.Open((dir / "cache").string(), 25));
+
+    std::string content(10, 'x');
+    std::string a = ResultCache::MakeKey("a", "pln-to-ifc", "", "");
+    std::string b = ResultCache::MakeKey("b", "pln-to-ifc", "", "");
+    std::string c = ResultCache::MakeKey("c", "pln-to-ifc", "", "");
+    REQUIRE(cache.Store(a, WriteTestFile((dir / "a.ifc").string(), content)));
+    REQUIRE(cache.Store(b, WriteTestFile((dir / "b.ifc").string(), content)));
+
+    // Using a makes b the oldest entry
+    REQUIRE(cache.Fetch(a, (dir / "a-out.ifc").string()));
+    REQUIRE(cache.Store(c, WriteTestFile((dir / "c.ifc").string(), content)));
+
+    CHECK(cache.GetSizeBytes() <= 25u);
+    CHECK(cache.Fetch(a, (dir / "a-again.ifc").string()));
+    CHECK(!cache.Fetch(b, (dir / "b-again.ifc").string()));
+    CHECK(cache.Fetch(c, (dir / "c-again.ifc").string()));
+
+    // Larger than the whole cache: not stored
+    CHECK(!cache.Store(ResultCache::MakeKey("d", "pln-to-ifc", "", ""), WriteTestFile((dir / "d.ifc").string(), std::string(26, 'x'))));
+}
+
+TEST_CASE(CacheDisabledAtZeroBytes)
+{
+    fs::path dir = TestDirectory("cache-disabled");
+    ResultCache cache;
+    CHECK(!cache.Open((dir / "cache").string(), 0));
+    CHECK(!cache.IsEnabled());
+    CHECK(!cache.Store("key", WriteTestFile((dir / "result.ifc").string(), "x")));
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEST_HARNESS_HPP
+#define TEST_HARNESS_HPP
+
+#include <string>
+#include <vector>
+#include <sstream>
+
+/**
+ * @brief Minimal self-registering test cases for the SDK-free plugin sources
+ *
+ * A TEST_CASE registers itself at static initialisation; CHECK records a
+ * failure and goes on, REQUIRE gives up on the test case.
+ */
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+std::vector<TestCase>& TestRegistry();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { TestRegistry().push_back({ name, run }); }
+};
+
+/**
+ * @brief Record a failed check of the running test case
+ */
+void ReportFailure(const char* file, int line, const std::string& message);
+
+/**
+ * @brief Thrown by REQUIRE to end the running test case
+ */
+struct RequireFailed {};
+
+/**
+ * @brief Scratch directory for a test case, created empty
+ */
+std::string TestDirectory(const std::string& name);
+
+/**
+ * @brief Write a whole file, replacing it
+ * @return path, for use inline
+ */
+std::string WriteTestFile(const std::string& path, const std::string& content);
+
+/**
+ * @brief Read a whole file, "" if it cannot be read
+ */
+std::string ReadTestFile(const std::string& path);
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ReportFailure(__FILE__, __LINE__, #condition); \
+        } \
+    } while (false)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        auto checkActual = (actual); \
+        auto checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            std::ostringstream checkMessage; \
+            checkMessage << #actual << " == " << #expected << " (got '" << checkActual << "', expected '" << checkExpected << "')"; \
+            ReportFailure(__FILE__, __LINE__, checkMessage.str()); \
+        } \
+    } while (false)
+
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) { \
+            ReportFailure(__FILE__, __LINE__, #condition); \
+            throw RequireFailed(); \
+        } \
+    } while (false)
+
+#endif // TEST_HARNESS_HPP
@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// WebSocket server events as a submitting client receives them
+
+#include "TestHarness.hpp"
+#include "WebSocketServer.hpp"
+#include "JsonParser.hpp"
+#include "FileHash.hpp"
+#include "ArtifactProcessor.hpp"
+#include "JobMetrics.hpp"
+#include "MemoryPolicy.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+using tcp = net::ip::tcp;
+
+/**
+ * @brief Blocking WebSocket client with a timeout on every read
+ */
+class TestClient {
+public:
+    TestClient()
+        : m_ws(m_ioc)
+    {
+    }
+
+    bool Connect(int port)
+    {
+        beast::error_code ec;
+        tcp::resolver resolver(m_ioc);
+        auto results = resolver.resolve("127.0.0.1", std::to_string(port), ec);
+        if (!ec) {
+            net::connect(m_ws.next_layer(), results, ec);
+        }
+        if (!ec) {
+            m_ws.handshake("127.0.0.1:" + std::to_string(port), "/", ec);
+        }
+
+        // The hello is the first message of every session
+        std::string hello;
+        return !ec && Read(hello);
+    }
+
+    void Send(const std::string& message)
+    {
+        beast::error_code ec;
+        m_ws.write(net::buffer(message), ec);
+    }
+
+    /**
+     * @return false if no message came within the timeout
+     */
+    bool Read(std::string& message, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+    {
+        beast::flat_buffer buffer;
+        bool done = false;
+        beast::error_code result;
+        m_ws.async_read(buffer, [&done, &result](beast::error_code ec, std::size_t) {
+            result = ec;
+            done = true;
+        });
+
+        m_ioc.restart();
+        m_ioc.run_for(timeout);
+        if (!done) {
+            // Let the read complete as aborted before its buffer goes away
+            beast::error_code ec;
+            m_ws.next_layer().cancel(ec);
+            m_ioc.restart();
+            m_ioc.run();
+            return false;
+        }
+        message = beast::buffers_to_string(buffer.data());
+        return !result;
+    }
+
+    /**
+     * @brief Read until the job's final event
+     * @param seen Receives every message read, the final one last
+     * @return false if the job did not end within the timeout
+     */
+    bool ReadUntilFinal(std::vector<JsonValue>& seen)
+    {
+        std::string message;
+        while (Read(message)) {
+            JsonValue event;
+            std::string error;
+            if (!JsonParser::Parse(message, event, error)) {
+                return false;
+            }
+            seen.push_back(event);
+            std::string status = event.GetString({ "status" });
+            if (status == "completed" || status == "error" || status == "cancelled") {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    net::io_context m_ioc;
+    websocket::stream<tcp::socket> m_ws;
+};
+
+static int StartTestServer(ArchicadWebSocketServer& server)
+{
+    server.SetHelloProvider([]() {
+        return std::string("{\"type\":\"hello\",\"protocol\":1,\"ready\":true}");
+    });
+    for (int port = 18700; port < 18710; ++port) {
+        if (server.Start(port, "127.0.0.1")) {
+            return port;
+        }
+    }
+    return 0;
+}
+
+static const char* kStartConversion =
+    "{\"command\":\"start_conversion\",\"jobId\":\"job-1\","
+    "\"plnPath\":\"/projects/tower.pln\",\"outputPath\":\"/exports/tower.ifc\"}";
+
+// A conversion's stages as the add-on reports them, ending at 100%
+// @return false if the submission did not start a job
+static bool RunStubStages(ArchicadWebSocketServer& server, const WebSocketCommand& command)
+{
+    if (command.type != CommandType::StartConversion || !server.ClaimSubmission(command)) {
+        return false;
+    }
+    server.SendStageProgress(command.jobId, 50, "Exporting to IFC");
+    server.SendStageProgress(command.jobId, 100, "Conversion completed successfully");
+    return true;
+}
+
+static void RunStubConversion(ArchicadWebSocketServer& server, const WebSocketCommand& command)
+{
+    if (RunStubStages(server, command)) {
+        server.SendCompletion(command.jobId, "/exports/tower.ifc");
+    }
+}
+
+TEST_CASE(ServerSubmitterReceivesCompletionAfterStages)
+{
+    ArchicadWebSocketServer server;
+    server.SetCommandCallback([&server](const WebSocketCommand& command) {
+        RunStubConversion(server, command);
+    });
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    TestClient client;
+    REQUIRE(client.Connect(port));
+    client.Send(kStartConversion);
+
+    std::vector<JsonValue> seen;
+    CHECK(client.ReadUntilFinal(seen));
+    REQUIRE(!seen.empty());
+
+    // A stage at 100% is not the job's end: the completion is
+    const JsonValue& last = seen.back();
+    CHECK_EQ(last.GetString({ "type" }), std::string("completed"));
+    const JsonValue* result = last.Find("result");
+    REQUIRE(result != nullptr);
+    CHECK_EQ(result->GetString({ "outputPath" }), std::string("/exports/tower.ifc"));
+    for (size_t i = 0; i + 1 < seen.size(); ++i) {
+        CHECK_EQ(seen[i].GetString({ "status" }), std::string("processing"));
+    }
+
+    server.Stop();
+}
+
+TEST_CASE(ServerReplaysCompletionOnResumeAndAttach)
+{
+    ArchicadWebSocketServer server;
+    server.SetCommandCallback([&server](const WebSocketCommand& command) {
+        RunStubConversion(server, command);
+    });
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    {
+        TestClient submitter;
+        REQUIRE(submitter.Connect(port));
+        submitter.Send(kStartConversion);
+        std::vector<JsonValue> seen;
+        REQUIRE(submitter.ReadUntilFinal(seen));
+    }
+
+    JobRecord record;
+    REQUIRE(server.GetJobRegistry().Find("job-1", record));
+    CHECK(record.finished);
+    CHECK_EQ(record.status, std::string("completed"));
+
+    // A client that reconnects gets the completion, not the last stage
+    TestClient resumer;
+    REQUIRE(resumer.Connect(port));
+    resumer.Send("{\"command\":\"resume\",\"jobIds\":[\"job-1\"]}");
+    std::vector<JsonValue> resumed;
+    CHECK(resumer.ReadUntilFinal(resumed));
+    REQUIRE(resumed.size() == 2);
+    CHECK_EQ(resumed[0].GetString({ "type" }), std::string("resumed"));
+    CHECK_EQ(resumed[1].GetString({ "type" }), std::string("completed"));
+    CHECK(resumed[1].Find("result") != nullptr);
+
+    // So does the same submission again, which attaches instead of rerunning
+    resumer.Send(kStartConversion);
+    std::vector<JsonValue> attached;
+    CHECK(resumer.ReadUntilFinal(attached));
+    REQUIRE(attached.size() == 2);
+    CHECK_EQ(attached[0].GetString({ "type" }), std::string("attached"));
+    CHECK_EQ(attached[1].GetString({ "type" }), std::string("completed"));
+
+    server.Stop();
+}
+
+TEST_CASE(ServerSubmitterCanDownloadStagedOutput)
+{
+    const std::string content = "ISO-10303-21;\nHEADER;\nENDSEC;\nDATA;\nENDSEC;\nEND-ISO-10303-21;\n";
+
+    ArchicadWebSocketServer server;
+    REQUIRE(server.GetTransfers().Open(TestDirectory("server-download"), 1 << 20, 0));
+    server.SetCommandCallback([&server, &content](const WebSocketCommand& command) {
+        if (command.type != CommandType::StartConversion) {
+            // download and download_ack are answered by the transfer manager
+            return;
+        }
+        std::string outputPath = server.GetTransfers().PrepareOutput(command.jobId, "tower.ifc");
+        if (!RunStubStages(server, command)) {
+            return;
+        }
+        WriteTestFile(outputPath, content);
+        std::string download;
+        server.GetTransfers().OfferDownload(command.jobId, outputPath, download);
+        server.SendCompletion(command.jobId, outputPath, std::string(), download);
+    });
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    TestClient client;
+    REQUIRE(client.Connect(port));
+    client.Send(kStartConversion);
+
+    std::vector<JsonValue> seen;
+    REQUIRE(client.ReadUntilFinal(seen));
+    const JsonValue* download = seen.back().Find("download");
+    REQUIRE(download != nullptr);
+    CHECK_EQ(download->GetString({ "transferId" }), std::string("job-1"));
+    CHECK_EQ(download->GetString({ "fileName" }), std::string("tower.ifc"));
+    CHECK_EQ(download->GetInt("size"), static_cast<int64_t>(content.size()));
+
+    // The offer is good for a download on the same session
+    client.Send("{\"command\":\"download\",\"transferId\":\"job-1\",\"offset\":0}");
+    std::string message;
+    REQUIRE(client.Read(message));
+    JsonValue begin;
+    std::string error;
+    REQUIRE(JsonParser::Parse(message, begin, error));
+    CHECK_EQ(begin.GetString({ "type" }), std::string("download_begin"));
+    CHECK_EQ(begin.GetString({ "sha256" }), Sha256::HashString(content));
+
+    // [0x01][id length][transferId][offset: 8 bytes][data]
+    REQUIRE(client.Read(message));
+    const size_t header = 1 + 1 + std::string("job-1").size() + 8;
+    REQUIRE(message.size() > header);
+    CHECK_EQ(message.substr(header), content);
+
+    server.Stop();
+}
+
+TEST_CASE(ServerSubmitterReceivesArtifact)
+{
+    const std::string content = "ISO-10303-21;\nHEADER;\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\nENDSEC;\nEND-ISO-10303-21;\n";
+
+    ArtifactProcessor processor;
+    processor.Start();
+    ArchicadWebSocketServer server;
+    REQUIRE(server.GetTransfers().Open(TestDirectory("server-artifact"), 1 << 20, 0));
+
+    // As the add-on does: the queue slot is released, the output is hashed
+    // and packed on the worker, and the completion goes out from there
+    server.SetCommandCallback([&server, &processor, &content](const WebSocketCommand& command) {
+        if (command.type != CommandType::StartConversion) {
+            return;
+        }
+        std::string outputPath = server.GetTransfers().PrepareOutput(command.jobId, "tower.ifc");
+        if (!RunStubStages(server, command)) {
+            return;
+        }
+        WriteTestFile(outputPath, content);
+        ArtifactOptions options;
+        options.checksum = true;
+        options.compress = true;
+        std::string jobId = command.jobId;
+        processor.Submit(outputPath, options, [&server, jobId, outputPath](const ArtifactResult& result) {
+            std::string download;
+            server.GetTransfers().OfferDownload(jobId, result.compressedPath, download);
+            server.SendCompletion(jobId, outputPath, std::string(), download, result.ToJson());
+        });
+    });
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    TestClient client;
+    REQUIRE(client.Connect(port));
+    client.Send(kStartConversion);
+
+    std::vector<JsonValue> seen;
+    REQUIRE(client.ReadUntilFinal(seen));
+    const JsonValue& completion = seen.back();
+    CHECK_EQ(completion.GetString({ "type" }), std::string("completed"));
+    const JsonValue* artifact = completion.Find("artifact");
+    REQUIRE(artifact != nullptr);
+    CHECK_EQ(artifact->GetString({ "sha256" }), Sha256::HashString(content));
+    CHECK_EQ(artifact->GetInt("size"), static_cast<int64_t>(content.size()));
+    CHECK(artifact->GetString({ "compressedPath" }).size() > 0);
+    const JsonValue* download = completion.Find("download");
+    REQUIRE(download != nullptr);
+    CHECK_EQ(download->GetString({ "fileName" }), std::string("tower.ifczip"));
+
+    // The registry keeps the same completion for resume and attach
+    JobRecord record;
+    REQUIRE(server.GetJobRegistry().Find("job-1", record));
+    REQUIRE(record.lastEvent != nullptr);
+    JsonValue kept;
+    std::string error;
+    REQUIRE(JsonParser::Parse(*record.lastEvent, kept, error));
+    REQUIRE(kept.Find("artifact") != nullptr);
+    CHECK_EQ(kept.Find("artifact")->GetString({ "sha256" }), Sha256::HashString(content));
+
+    processor.Stop();
+    server.Stop();
+}
+
+TEST_CASE(ServerSubmitterReceivesTimingsAndMemory)
+{
+    JobMetrics metrics;
+    MemoryPolicy memoryPolicy;
+    ArchicadWebSocketServer server;
+
+    // Timed and sampled as the add-on does around a job on the main thread
+    server.SetCommandCallback([&server, &metrics, &memoryPolicy](const WebSocketCommand& command) {
+        metrics.JobStarted(command.jobId, JobType::PlnToIfc);
+        memoryPolicy.JobStarted(command.jobId);
+        metrics.Record(command.jobId, JobStage::Open, JobMetrics::Clock::now());
+        if (!RunStubStages(server, command)) {
+            return;
+        }
+        metrics.Record(command.jobId, JobStage::Save, JobMetrics::Clock::now());
+        std::string timings = metrics.FormatJobTimings(command.jobId);
+        JobMemory memory = memoryPolicy.JobFinished(command.jobId);
+        server.SendCompletion(command.jobId, "/exports/tower.ifc", timings, std::string(), std::string(),
+                              memory.valid ? memory.ToJson() : std::string());
+        metrics.JobFinished(command.jobId);
+    });
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    TestClient client;
+    REQUIRE(client.Connect(port));
+    client.Send(kStartConversion);
+
+    std::vector<JsonValue> seen;
+    REQUIRE(client.ReadUntilFinal(seen));
+    const JsonValue& completion = seen.back();
+    CHECK_EQ(completion.GetString({ "type" }), std::string("completed"));
+
+    const JsonValue* timings = completion.Find("timingsMs");
+    REQUIRE(timings != nullptr);
+    CHECK(timings->Find("open") != nullptr);
+    CHECK(timings->Find("save") != nullptr);
+    CHECK(timings->Find("total") != nullptr);
+
+    const JsonValue* memory = completion.Find("memory");
+    REQUIRE(memory != nullptr);
+    CHECK(memory->Find("rssBeforeBytes") != nullptr);
+    CHECK(memory->Find("rssAfterBytes") != nullptr);
+    CHECK(memory->Find("peakRssBytes") != nullptr);
+
+    server.Stop();
+}
+
+TEST_CASE(ServerDropsClientAtHardQueueLimit)
+{
+    ArchicadWebSocketServer server;
+    SessionQueueLimits limits;
+    limits.highWatermarkBytes = 256u << 10;
+    limits.lowWatermarkBytes = 64u << 10;
+    limits.saturatedTimeoutMs = 60000;
+    limits.hardLimitBytes = 1u << 20;
+    server.SetQueueLimits(limits);
+    int port = StartTestServer(server);
+    REQUIRE(port != 0);
+
+    // Connected but not reading: once the socket buffers are full, every
+    // broadcast stays in the session's queue
+    TestClient client;
+    REQUIRE(client.Connect(port));
+    JsonPayload event = std::make_shared<const std::string>(std::string(64u << 10, 'x'));
+    for (int i = 0; i < 1024 && server.GetQueueStats().disconnects == 0; ++i) {
+        server.BroadcastMessage(event);
+    }
+
+    // Long before the saturation timeout
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.GetQueueStats().disconnects == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    SessionQueueStats stats = server.GetQueueStats();
+    CHECK_EQ(stats.disconnects, static_cast<uint64_t>(1));
+    CHECK(stats.peakBytes <= limits.hardLimitBytes);
+
+    server.Stop();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerCoordinator.hpp"
+#include "Logger.hpp"
+
+#include <boost/asio/signal_set.hpp>
+
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--port <port>] [--worker <host:port>]... [--log-level <level>]" << std::endl
+              << std::endl
+              << "  --port <port>         Port backends connect to (default: $COORDINATOR_PORT or 8090)" << std::endl
+              << "  --worker <host:port>  Static worker; repeat for each Archicad instance" << std::endl
+              << "  --log-level <level>   trace, debug, info, warn, error or off (default: $COORDINATOR_LOG_LEVEL or info)" << std::endl
+              << std::endl
+              << "Plugins started with ARCHICAD_COORDINATOR_URL=ws://<this host>:<port> register themselves." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int port = 8090;
+    if (const char* envPort = std::getenv("COORDINATOR_PORT")) {
+        port = std::atoi(envPort);
+    }
+
+    LoggerConfig logConfig;
+    if (const char* envLevel = std::getenv("COORDINATOR_LOG_LEVEL")) {
+        LogLevelFromString(envLevel, logConfig.level);
+    }
+
+    std::vector<std::string> workers;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--worker") == 0 && i + 1 < argc) {
+            workers.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            if (!LogLevelFromString(argv[++i], logConfig.level)) {
+                std::cerr << "✗ Invalid log level: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (port <= 0 || port > 65535) {
+        std::cerr << "✗ Invalid port: " << port << std::endl;
+        return 1;
+    }
+
+    Logger::Start(logConfig);
+
+    WorkerCoordinator coordinator;
+    if (!coordinator.Start(port)) {
+        LOG_ERROR("✗ Failed to start coordinator on port " << port);
+        Logger::Stop();
+        return 1;
+    }
+
+    for (const std::string& worker : workers) {
+        size_t colon = worker.rfind(':');
+        if (colon == std::string::npos || colon == 0) {
+            LOG_WARN("✗ Invalid worker address: " << worker);
+            continue;
+        }
+        coordinator.AddWorker(worker, worker.substr(0, colon), std::atoi(worker.c_str() + colon + 1));
+    }
+
+    // Block until SIGINT/SIGTERM
+    net::io_context signalContext;
+    net::signal_set signals(signalContext, SIGINT, SIGTERM);
+    signals.async_wait([](const beast::error_code&, int) {
+        LOG_INFO("Shutting down coordinator...");
+    });
+    signalContext.run();
+
+    coordinator.Stop();
+    Logger::Stop();
+    return 0;
+}
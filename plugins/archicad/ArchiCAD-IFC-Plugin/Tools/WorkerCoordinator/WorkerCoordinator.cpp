@@ -0,0 +1,603 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerCoordinator.hpp"
+#include "Logger.hpp"
+
+#include <chrono>
+
+// Seconds between get_worker_info polls
+static const int kPollIntervalSeconds = 5;
+
+// Seconds before reconnecting to a worker that went away
+static const int kReconnectDelaySeconds = 3;
+
+static bool IsTerminalMessage(const std::string& type, const std::string& status)
+{
+    return type == "completed" || type == "error" ||
+           status == "completed" || status == "error" || status == "cancelled";
+}
+
+// ========================================
+// WorkerLink Implementation
+// ========================================
+
+WorkerLink::WorkerLink(net::io_context& ioc, std::string workerId, std::string host, int port,
+                       MessageHandler onMessage, StateHandler onState)
+    : m_strand(net::make_strand(ioc))
+    , m_resolver(m_strand)
+    , m_retryTimer(m_strand)
+    , m_workerId(std::move(workerId))
+    , m_host(std::move(host))
+    , m_port(port)
+    , m_onMessage(std::move(onMessage))
+    , m_onState(std::move(onState))
+    , m_connected(false)
+    , m_stopped(false)
+{
+}
+
+void WorkerLink::Start()
+{
+    net::post(m_strand, [self = shared_from_this()]() { self->Connect(); });
+}
+
+void WorkerLink::Stop()
+{
+    m_stopped = true;
+    net::post(m_strand, [self = shared_from_this()]() {
+        self->m_retryTimer.cancel();
+        if (self->m_ws) {
+            beast::get_lowest_layer(*self->m_ws).close();
+        }
+    });
+}
+
+bool WorkerLink::Send(std::string message)
+{
+    if (!m_connected) {
+        return false;
+    }
+
+    net::post(m_strand, [self = shared_from_this(), message = std::move(message)]() mutable {
+        bool writing = !self->m_writeQueue.empty();
+        self->m_writeQueue.push_back(std::move(message));
+        if (!writing) {
+            self->DoWrite();
+        }
+    });
+    return true;
+}
+
+bool WorkerLink::IsConnected() const
+{
+    return m_connected;
+}
+
+const std::string& WorkerLink::GetHost() const
+{
+    return m_host;
+}
+
+int WorkerLink::GetPort() const
+{
+    return m_port;
+}
+
+void WorkerLink::Connect()
+{
+    if (m_stopped) {
+        return;
+    }
+
+    m_ws = std::make_unique<websocket::stream<beast::tcp_stream>>(m_strand);
+    m_buffer.consume(m_buffer.size());
+    m_writeQueue.clear();
+
+    m_resolver.async_resolve(m_host, std::to_string(m_port),
+        beast::bind_front_handler(&WorkerLink::OnResolve, shared_from_this()));
+}
+
+void WorkerLink::OnResolve(beast::error_code ec, tcp::resolver::results_type results)
+{
+    if (ec) {
+        return Disconnected("resolve", ec);
+    }
+
+    beast::get_lowest_layer(*m_ws).expires_after(std::chrono::seconds(10));
+    beast::get_lowest_layer(*m_ws).async_connect(results,
+        beast::bind_front_handler(&WorkerLink::OnConnect, shared_from_this()));
+}
+
+void WorkerLink::OnConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type)
+{
+    if (ec) {
+        return Disconnected("connect", ec);
+    }
+
+    // The websocket stream has its own timeouts once the handshake is done
+    beast::get_lowest_layer(*m_ws).expires_never();
+    m_ws->set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+
+    // Workers are often on other hosts; accept compression if they offer it
+    websocket::permessage_deflate deflate;
+    deflate.client_enable = true;
+    m_ws->set_option(deflate);
+
+    m_ws->async_handshake(m_host + ":" + std::to_string(m_port), "/",
+        beast::bind_front_handler(&WorkerLink::OnHandshake, shared_from_this()));
+}
+
+void WorkerLink::OnHandshake(beast::error_code ec)
+{
+    if (ec) {
+        return Disconnected("handshake", ec);
+    }
+
+    m_connected = true;
+    LOG_INFO("✓ Connected to worker " << m_workerId);
+    if (m_onState) {
+        m_onState(m_workerId, true);
+    }
+
+    DoRead();
+}
+
+void WorkerLink::DoRead()
+{
+    m_ws->async_read(m_buffer,
+        beast::bind_front_handler(&WorkerLink::OnRead, shared_from_this()));
+}
+
+void WorkerLink::OnRead(beast::error_code ec, std::size_t)
+{
+    if (ec) {
+        return Disconnected("read", ec);
+    }
+
+    std::string message = beast::buffers_to_string(m_buffer.data());
+    m_buffer.consume(m_buffer.size());
+
+    if (m_onMessage) {
+        m_onMessage(m_workerId, message);
+    }
+
+    DoRead();
+}
+
+void WorkerLink::DoWrite()
+{
+    if (m_writeQueue.empty() || !m_connected) {
+        return;
+    }
+
+    m_ws->async_write(net::buffer(m_writeQueue.front()),
+        beast::bind_front_handler(&WorkerLink::OnWrite, shared_from_this()));
+}
+
+void WorkerLink::OnWrite(beast::error_code ec, std::size_t)
+{
+    if (ec) {
+        return Disconnected("write", ec);
+    }
+
+    m_writeQueue.pop_front();
+    DoWrite();
+}
+
+void WorkerLink::Disconnected(const char* what, beast::error_code ec)
+{
+    bool wasConnected = m_connected.exchange(false);
+    m_writeQueue.clear();
+
+    if (wasConnected) {
+        LOG_WARN("Worker " << m_workerId << " disconnected (" << what << ": " << ec.message() << ")");
+        if (m_onState) {
+            m_onState(m_workerId, false);
+        }
+    }
+
+    ScheduleReconnect();
+}
+
+void WorkerLink::ScheduleReconnect()
+{
+    if (m_stopped) {
+        return;
+    }
+
+    m_retryTimer.expires_after(std::chrono::seconds(kReconnectDelaySeconds));
+    m_retryTimer.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (!ec) {
+            self->Connect();
+        }
+    });
+}
+
+// ========================================
+// WorkerCoordinator Implementation
+// ========================================
+
+WorkerCoordinator::WorkerCoordinator()
+    : m_work(net::make_work_guard(m_ioc))
+    , m_pollTimer(m_ioc)
+    , m_assignCounter(0)
+{
+}
+
+WorkerCoordinator::~WorkerCoordinator()
+{
+    Stop();
+}
+
+bool WorkerCoordinator::Start(int port)
+{
+    m_front.SetCommandCallback(
+        [this](const WebSocketCommand& command) {
+            HandleFrontCommand(command);
+        });
+
+    if (!m_front.Start(port)) {
+        return false;
+    }
+
+    SchedulePoll();
+    m_thread = std::thread([this]() {
+        try {
+            m_ioc.run();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Coordinator error: " << e.what());
+        }
+    });
+
+    LOG_INFO("✓ Worker coordinator listening on port " << port);
+    return true;
+}
+
+void WorkerCoordinator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_workers) {
+            entry.second.link->Stop();
+        }
+    }
+
+    m_pollTimer.cancel();
+    m_work.reset();
+    m_ioc.stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    m_front.Stop();
+}
+
+void WorkerCoordinator::AddWorker(const std::string& workerId, const std::string& host, int port,
+                                  int capacity, const std::string& archicadVersion)
+{
+    std::shared_ptr<WorkerLink> staleLink;
+    std::shared_ptr<WorkerLink> newLink;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        WorkerState& worker = m_workers[workerId];
+        worker.capacity = capacity > 0 ? capacity : 1;
+        if (!archicadVersion.empty()) {
+            worker.archicadVersion = archicadVersion;
+        }
+
+        // Re-registration with the same address keeps the existing link
+        if (worker.link && worker.link->GetHost() == host && worker.link->GetPort() == port) {
+            return;
+        }
+
+        staleLink = worker.link;
+        worker.link = std::make_shared<WorkerLink>(m_ioc, workerId, host, port,
+            [this](const std::string& id, const std::string& message) { HandleWorkerMessage(id, message); },
+            [this](const std::string& id, bool connected) { HandleWorkerState(id, connected); });
+        newLink = worker.link;
+    }
+
+    if (staleLink) {
+        staleLink->Stop();
+    }
+
+    LOG_INFO("Worker registered: " << workerId << " (" << host << ":" << port << ")");
+    newLink->Start();
+}
+
+void WorkerCoordinator::HandleFrontCommand(const WebSocketCommand& command)
+{
+    const std::string& jobId = command.jobId;
+
+    switch (command.type) {
+        case CommandType::RegisterWorker: {
+            std::string workerId = command.body.GetString({ "workerId" });
+            std::string host = command.body.GetString({ "host" });
+            int port = static_cast<int>(command.body.GetInt("port", 0));
+            if (host.empty() || port <= 0) {
+                LOG_WARN("Ignoring register_worker without host/port");
+                return;
+            }
+            if (workerId.empty()) {
+                workerId = host + ":" + std::to_string(port);
+            }
+            AddWorker(workerId, host, port,
+                      static_cast<int>(command.body.GetInt("capacity", 1)),
+                      command.body.GetString({ "archicadVersion" }));
+            break;
+        }
+
+        case CommandType::StartConversion:
+        case CommandType::StartBatch:
+        case CommandType::LoadIfc:
+            // A resubmission attaches to the job already routed or completed
+            if (!m_front.ClaimSubmission(command)) {
+                break;
+            }
+            if (!RouteNewJob(jobId, command.payload)) {
+                m_front.RejectSubmission(jobId, "No Archicad worker available");
+            }
+            break;
+
+        case CommandType::GetStatus: {
+            // Finished jobs are answered from the registry: their worker may be gone
+            JobRecord record;
+            if (m_front.GetJobRegistry().Find(jobId, record) && record.finished) {
+                m_front.SendToSession(command.sessionId, record.lastEvent);
+            } else if (!RouteToOwner(jobId, command.payload)) {
+                m_front.SendProgress(jobId, 0, "idle", "Coordinator ready");
+            }
+            break;
+        }
+
+        case CommandType::CancelJob:
+            RouteToOwner(jobId, command.payload);
+            break;
+
+        case CommandType::GetPoolStatus:
+        case CommandType::GetWorkerInfo:
+            m_front.SendToSession(command.sessionId, FormatPoolStatus());
+            break;
+
+        default:
+            LOG_WARN("Coordinator: unknown command '" << command.name << "'");
+            break;
+    }
+}
+
+bool WorkerCoordinator::RouteNewJob(const std::string& jobId, const std::string& payload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // A duplicate submission goes to the worker that already has the job
+    auto owner = m_jobOwners.find(jobId);
+    if (owner != m_jobOwners.end()) {
+        auto worker = m_workers.find(owner->second);
+        if (worker != m_workers.end() && worker->second.link->Send(payload)) {
+            return true;
+        }
+        m_jobOwners.erase(owner);
+    }
+
+    // Pick the connected worker with the lowest load per unit of capacity;
+    // between equals, the one that received a job least recently. Draining
+    // workers are used only when no other worker is connected
+    WorkerState* best = nullptr;
+    std::string bestId;
+    double bestScore = 0.0;
+
+    for (auto& entry : m_workers) {
+        WorkerState& worker = entry.second;
+        if (!worker.link->IsConnected()) {
+            continue;
+        }
+
+        size_t load = worker.assigned > worker.reportedLoad ? worker.assigned : worker.reportedLoad;
+        double score = static_cast<double>(load) / worker.capacity;
+
+        bool better = best == nullptr ||
+                      (best->draining && !worker.draining) ||
+                      (best->draining == worker.draining &&
+                       (score < bestScore || (score == bestScore && worker.lastAssigned < best->lastAssigned)));
+        if (better) {
+            best = &worker;
+            bestId = entry.first;
+            bestScore = score;
+        }
+    }
+
+    if (best == nullptr || !best->link->Send(payload)) {
+        return false;
+    }
+
+    best->assigned++;
+    best->lastAssigned = ++m_assignCounter;
+    m_jobOwners[jobId] = bestId;
+
+    LOG_INFO("Job " << jobId << " -> worker " << bestId);
+    return true;
+}
+
+bool WorkerCoordinator::RouteToOwner(const std::string& jobId, const std::string& payload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto owner = m_jobOwners.find(jobId);
+    if (owner == m_jobOwners.end()) {
+        return false;
+    }
+
+    auto worker = m_workers.find(owner->second);
+    return worker != m_workers.end() && worker->second.link->Send(payload);
+}
+
+void WorkerCoordinator::ReleaseJob(const std::string& jobId)
+{
+    // Caller holds m_mutex
+    auto owner = m_jobOwners.find(jobId);
+    if (owner == m_jobOwners.end()) {
+        return;
+    }
+
+    auto worker = m_workers.find(owner->second);
+    if (worker != m_workers.end() && worker->second.assigned > 0) {
+        worker->second.assigned--;
+    }
+    m_jobOwners.erase(owner);
+}
+
+void WorkerCoordinator::HandleWorkerMessage(const std::string& workerId, const std::string& message)
+{
+    JsonValue body;
+    std::string error;
+    if (!JsonParser::Parse(message, body, error) || !body.IsObject()) {
+        LOG_WARN("Worker " << workerId << " sent invalid JSON: " << error);
+        return;
+    }
+
+    std::string type = body.GetString({ "type" });
+
+    // worker_recycle is a worker_info sent unprompted when the worker wants
+    // to be replaced: it gets no new jobs until it comes back without the flag
+    if (type == "worker_info" || type == "worker_recycle") {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto worker = m_workers.find(workerId);
+        if (worker != m_workers.end()) {
+            bool draining = body.GetBool("recycle", false);
+            if (draining && !worker->second.draining) {
+                LOG_WARN("Worker " << workerId << " is draining: " << body.GetString({ "recycleReason" }, "recycle requested"));
+            } else if (!draining && worker->second.draining) {
+                LOG_INFO("✓ Worker " << workerId << " accepts jobs again");
+            }
+            worker->second.draining = draining;
+            worker->second.reportedLoad = static_cast<size_t>(body.GetInt("load", 0));
+            worker->second.capacity = static_cast<int>(body.GetInt("capacity", worker->second.capacity));
+            std::string version = body.GetString({ "archicadVersion" });
+            if (!version.empty()) {
+                worker->second.archicadVersion = version;
+            }
+        }
+        return;
+    }
+
+    std::string jobId = body.GetString({ "jobId" });
+    if (jobId.empty()) {
+        m_front.BroadcastMessage(message);
+        return;
+    }
+
+    bool terminal = IsTerminalMessage(type, body.GetString({ "status" }));
+    if (terminal) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto owner = m_jobOwners.find(jobId);
+        if (owner != m_jobOwners.end() && owner->second == workerId) {
+            ReleaseJob(jobId);
+        }
+    }
+
+    // Relay to the backends that submitted or subscribed to the job
+    m_front.SendToJob(jobId, std::make_shared<const std::string>(message), terminal);
+}
+
+void WorkerCoordinator::HandleWorkerState(const std::string& workerId, bool connected)
+{
+    if (connected) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto worker = m_workers.find(workerId);
+        if (worker != m_workers.end()) {
+            worker->second.link->Send("{\"command\":\"get_worker_info\",\"jobId\":\"coordinator\"}");
+        }
+        return;
+    }
+
+    // Jobs on a lost worker will never report back; fail them now so the
+    // backend can resubmit instead of waiting forever
+    std::vector<std::string> lostJobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_jobOwners.begin(); it != m_jobOwners.end();) {
+            if (it->second == workerId) {
+                lostJobs.push_back(it->first);
+                it = m_jobOwners.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        auto worker = m_workers.find(workerId);
+        if (worker != m_workers.end()) {
+            worker->second.assigned = 0;
+            worker->second.reportedLoad = 0;
+        }
+    }
+
+    for (const std::string& jobId : lostJobs) {
+        m_front.SendError(jobId, "Archicad worker " + workerId + " disconnected");
+    }
+}
+
+std::string WorkerCoordinator::FormatPoolStatus()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    JsonWriter writer;
+    writer.BeginObject()
+          .Field("type", "pool_status")
+          .Key("workers").BeginArray();
+
+    for (const auto& entry : m_workers) {
+        const WorkerState& worker = entry.second;
+        writer.BeginObject()
+              .Field("workerId", entry.first)
+              .Field("host", worker.link->GetHost())
+              .Field("port", worker.link->GetPort())
+              .Field("connected", worker.link->IsConnected())
+              .Field("capacity", worker.capacity)
+              .Field("archicadVersion", worker.archicadVersion)
+              .Field("load", worker.reportedLoad)
+              .Field("assigned", worker.assigned)
+              .Field("draining", worker.draining)
+              .EndObject();
+    }
+
+    writer.EndArray()
+          .Field("jobs", m_jobOwners.size())
+          .EndObject();
+    return writer.ToString();
+}
+
+void WorkerCoordinator::SchedulePoll()
+{
+    m_pollTimer.expires_after(std::chrono::seconds(kPollIntervalSeconds));
+    m_pollTimer.async_wait([this](beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& entry : m_workers) {
+                entry.second.link->Send("{\"command\":\"get_worker_info\",\"jobId\":\"coordinator\"}");
+            }
+        }
+
+        SchedulePoll();
+    });
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2025 Matheus Piovezan Teixeira
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKER_COORDINATOR_HPP
+#define WORKER_COORDINATOR_HPP
+
+#include "WebSocketServer.hpp"
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Client connection from the coordinator to one plugin instance
+ *
+ * Connects to the worker's WebSocket port, reconnects with a delay when the
+ * connection drops, and reports every message it receives. All socket work
+ * runs on the link's strand.
+ */
+class WorkerLink : public std::enable_shared_from_this<WorkerLink> {
+public:
+    using MessageHandler = std::function<void(const std::string& workerId, const std::string& message)>;
+    using StateHandler = std::function<void(const std::string& workerId, bool connected)>;
+
+    WorkerLink(net::io_context& ioc, std::string workerId, std::string host, int port,
+               MessageHandler onMessage, StateHandler onState);
+
+    void Start();
+    void Stop();
+
+    /**
+     * @brief Queue a message for the worker
+     * @return false if the worker is not connected
+     */
+    bool Send(std::string message);
+
+    bool IsConnected() const;
+    const std::string& GetHost() const;
+    int GetPort() const;
+
+private:
+    void Connect();
+    void OnResolve(beast::error_code ec, tcp::resolver::results_type results);
+    void OnConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type endpoint);
+    void OnHandshake(beast::error_code ec);
+    void DoRead();
+    void OnRead(beast::error_code ec, std::size_t bytesTransferred);
+    void DoWrite();
+    void OnWrite(beast::error_code ec, std::size_t bytesTransferred);
+    void Disconnected(const char* what, beast::error_code ec);
+    void ScheduleReconnect();
+
+    net::strand<net::io_context::executor_type> m_strand;
+    tcp::resolver m_resolver;
+    net::steady_timer m_retryTimer;
+    std::unique_ptr<websocket::stream<beast::tcp_stream>> m_ws;
+    beast::flat_buffer m_buffer;
+    std::deque<std::string> m_writeQueue;
+    std::string m_workerId;
+    std::string m_host;
+    int m_port;
+    MessageHandler m_onMessage;
+    StateHandler m_onState;
+    std::atomic<bool> m_connected;
+    std::atomic<bool> m_stopped;
+};
+
+/**
+ * @brief Load-balancing front for a pool of Archicad plugin instances
+ *
+ * Backends connect to the coordinator exactly as they would connect to a
+ * single plugin. Workers announce themselves with register_worker (or are
+ * given on the command line); the coordinator connects to each of them,
+ * polls their load with get_worker_info and sends every new job to the
+ * least-loaded connected worker. Follow-up commands for a job (cancel_job,
+ * get_status) go to the worker that owns it, and worker events are relayed
+ * back to the backends.
+ */
+class WorkerCoordinator {
+public:
+    WorkerCoordinator();
+    ~WorkerCoordinator();
+
+    /**
+     * @brief Start the front server and the worker polling loop
+     * @param port Port backends connect to
+     * @return false if the front server could not be started
+     */
+    bool Start(int port);
+
+    /**
+     * @brief Disconnect from all workers and stop the front server
+     */
+    void Stop();
+
+    /**
+     * @brief Add (or update) a worker
+     * @param workerId Stable worker name
+     * @param host Host the worker listens on
+     * @param port WebSocket port of the worker
+     * @param capacity Number of jobs the worker runs at the same time
+     * @param archicadVersion Reported Archicad version
+     */
+    void AddWorker(const std::string& workerId, const std::string& host, int port,
+                   int capacity = 1, const std::string& archicadVersion = std::string());
+
+private:
+    struct WorkerState {
+        std::shared_ptr<WorkerLink> link;
+        int capacity = 1;
+        std::string archicadVersion;
+        size_t reportedLoad = 0;    // running + queued, from worker_info
+        size_t assigned = 0;        // jobs routed here and not finished yet
+        uint64_t lastAssigned = 0;  // round-robin tie-break
+        bool draining = false;      // worker asked to be recycled (worker_recycle)
+    };
+
+    void HandleFrontCommand(const WebSocketCommand& command);
+    void HandleWorkerMessage(const std::string& workerId, const std::string& message);
+    void HandleWorkerState(const std::string& workerId, bool connected);
+    bool RouteNewJob(const std::string& jobId, const std::string& payload);
+    bool RouteToOwner(const std::string& jobId, const std::string& payload);
+    void ReleaseJob(const std::string& jobId);
+    std::string FormatPoolStatus();
+    void SchedulePoll();
+
+    ArchicadWebSocketServer m_front;
+    net::io_context m_ioc;
+    net::executor_work_guard<net::io_context::executor_type> m_work;
+    net::steady_timer m_pollTimer;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::map<std::string, WorkerState> m_workers;
+    std::map<std::string, std::string> m_jobOwners;     // jobId -> workerId
+    uint64_t m_assignCounter;
+};
+
+#endif // WORKER_COORDINATOR_HPP